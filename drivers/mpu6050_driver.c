@@ -3,13 +3,24 @@
  *
  * This driver provides support for the InvenSense MPU-6050 accelerometer
  * and gyroscope sensor via I2C interface. It creates a character device
- * interface for userspace applications to read sensor data.
+ * interface for userspace applications to read sensor data. Register and
+ * sample I/O is shared with the rest of the module through mpu6050_main.c.
  *
  * Features:
  * - I2C communication with MPU-6050
  * - Character device interface (/dev/mpu6050)
  * - Raw and scaled sensor data reading
  * - Configurable sample rates and ranges
+ * - Hardware FIFO streaming with batched drains
+ * - Timestamped sample buffer shared by all readers
+ * - Read-only mmap() of the sample buffer for lockless consumers
+ * - One character device per probed sensor
+ * - Latest-sample cache so concurrent readers share one bus transfer
+ * - Data-ready interrupt with blocking read() and poll()
+ * - Auxiliary I2C master passthrough for external sensors
+ * - Capture groups merging several sensors into one timestamped stream
+ * - Optional Industrial I/O triggered buffer (CONFIG_MPU6050_IIO)
+ * - Hot path tracepoints and per-device debugfs statistics
  * - IOCTL interface for advanced operations
  * - Comprehensive error handling
  *
@@ -25,250 +36,747 @@
 #include <linux/kernel.h>
 #include <linux/init.h>
 #include <linux/slab.h>
+#include <linux/sched.h>
+#include <linux/sched/signal.h>
+#include <linux/percpu.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/vmalloc.h>
+#include <linux/mm.h>
+#include <linux/log2.h>
+#include <linux/math64.h>
+#include <linux/workqueue.h>
+#include <linux/ktime.h>
 #include <linux/i2c.h>
 #include <linux/mutex.h>
+#include <linux/seqlock.h>
 #include <linux/delay.h>
+#include <linux/iopoll.h>
 #include <linux/cdev.h>
 #include <linux/fs.h>
+#include <linux/file.h>
+#include <linux/kref.h>
 #include <linux/device.h>
+#include <linux/idr.h>
+#include <linux/property.h>
 #include <linux/uaccess.h>
+#include <linux/uio.h>
 #include <linux/of.h>
 #include <linux/of_device.h>
 #include <linux/regmap.h>
+#include <linux/interrupt.h>
+#include <linux/irq.h>
+#include <linux/poll.h>
+#include <linux/pm_runtime.h>
+#include <linux/wait.h>
 #include <asm/byteorder.h>
 
 #include "../include/mpu6050.h"
 
+#define CREATE_TRACE_POINTS
+#include "mpu6050_trace.h"
+
 #define DRIVER_NAME		"mpu6050"
 #define DRIVER_VERSION		"1.0.0"
+#define MPU6050_MAX_DEVICES	16
+
+/* DEVICE_RESET polling, the datasheet gives no typical completion time */
+#define MPU6050_RESET_POLL_US	1000
+#define MPU6050_RESET_TIMEOUT_US	100000
 
-/* Device-specific data structure */
-struct mpu6050_data {
-	struct i2c_client *client;
-	struct mutex lock;
-	struct regmap *regmap;
-	struct mpu6050_config config;
-	
-	/* Character device */
-	struct cdev cdev;
-	dev_t devt;
-	struct class *class;
-	struct device *device;
-	
-	/* Scaling factors */
-	u32 accel_scale;	/* Accelerometer scale factor (ug/LSB) */
-	u32 gyro_scale;		/* Gyroscope scale factor (udps/LSB) */
+/* Per-open-file state */
+/**
+ * struct mpu6050_decim - Per-file CIC decimation state
+ *
+ * A boxcar is the single-stage case. Integrators and combs use wrapping
+ * u64 arithmetic; the comb output is exact as long as it fits, which it
+ * does for 16-bit inputs up to a gain of MPU6050_DECIM_MAX_FACTOR to the
+ * power of MPU6050_DECIM_MAX_ORDER. @factor, @phase and @prime are also
+ * read locklessly by the wakeup conditions.
+ */
+struct mpu6050_decim {
+	u32 factor;			/* Inputs per output, 1 for none */
+	u16 filter;			/* MPU6050_DECIM_* */
+	u16 order;			/* Integrator and comb stages */
+	u32 phase;			/* Inputs accumulated towards the next output */
+	u32 prime;			/* Outputs still discarded while filling */
+	u32 channels;			/* Input layout, 0 until the first input */
+	u32 record_size;
+	u64 lost;			/* pf->lost when the filter last ran */
+	u16 flags;			/* Input flags for the next output */
+	s64 first_ts;			/* First input of the current output */
+	u64 integ[MPU6050_NUM_CHANNELS][MPU6050_DECIM_MAX_ORDER];
+	u64 comb[MPU6050_NUM_CHANNELS][MPU6050_DECIM_MAX_ORDER];
 };
 
-/* Global variables for character device */
-static struct mpu6050_data *mpu6050_dev_data = NULL;
-static int mpu6050_major = 0;
+struct mpu6050_file {
+	struct mpu6050_data *data;
+	struct mutex lock;		/* Serializes readers sharing this file */
+	unsigned int drdy_seen;		/* drdy_seq at the last one-shot read */
+	u32 ring_tail;			/* Sequence number of the next sample */
+	u64 lost;			/* Samples overwritten before being read */
+	bool mapped;			/* poll() is a wakeup for an mmap() user */
+	u32 max_age_ns;			/* Staleness bound, 0 for one period */
+	u32 read_mode;			/* MPU6050_READ_* for one-shot read() */
+	u32 sample_seen;		/* Sequence of the last new-data sample */
+	struct list_head node;		/* Entry in data->files */
+	pid_t pid;			/* Opener, for debugfs */
+	char comm[TASK_COMM_LEN];
+	struct mpu6050_decim decim;	/* Streaming read() and batch filter */
+	struct mpu6050_group *group;	/* Capture group owned by this file */
+};
 
-/* Regmap configuration */
-static const struct regmap_config mpu6050_regmap_config = {
-	.reg_bits = 8,
-	.val_bits = 8,
-	.max_register = MPU6050_REG_WHO_AM_I,
+/**
+ * struct mpu6050_group_member - One sensor of a capture group
+ * @file: Reference to the member's file, NULL for the owner's own sensor
+ * @data: Device data of the sensor
+ * @tail: Group read position in the sensor's ring
+ * @lost: Records overwritten before the group read them
+ * @stage: Records copied out of the ring but not merged yet
+ * @staged: Number of records in @stage
+ * @next: Index of the next record in @stage to merge
+ * @channels: MPU6050_CHAN_* mask of the staged records
+ * @record_size: Size of each staged record in bytes
+ */
+struct mpu6050_group_member {
+	struct file *file;
+	struct mpu6050_data *data;
+	u32 tail;
+	u64 lost;
+	u8 *stage;
+	u32 staged;
+	u32 next;
+	u32 channels;
+	u32 record_size;
 };
 
 /**
- * mpu6050_update_scale_factors - Update scaling factors based on configuration
- * @data: Device data structure
+ * struct mpu6050_group - Capture group owned by one open file
+ * @ref: Held by the owning file and by readers waiting for the group
+ * @count: Number of members
+ * @streaming: FIFOs of all members running
+ * @wait: Woken after every FIFO drain of a member
+ * @member: Members, indexed by sensor number
+ *
+ * Everything but @ref and @wait is protected by the owner's pf->lock and
+ * read locklessly by the wakeup condition. Each member's data->group
+ * points here while it belongs to the group.
+ */
+struct mpu6050_group {
+	struct kref ref;
+	unsigned int count;
+	bool streaming;
+	wait_queue_head_t wait;
+	struct mpu6050_group_member member[MPU6050_GROUP_MAX];
+};
+
+/* Number of records in the sample ring, must be a power of two */
+#define MPU6050_RING_SIZE	2048
+#define MPU6050_BATCH_CHUNK	64	/* Records scaled per bounce buffer */
+
+/* Idle time before the sensor is put to sleep */
+#define MPU6050_AUTOSUSPEND_MS	2000
+
+/* Interrupt sources serviced by the driver */
+#define MPU6050_INT_ENABLE_MASK	(MPU6050_INT_DATA_RDY | MPU6050_INT_FIFO_OFLOW)
+
+/* Maximum number of frames the hardware FIFO can hold, one channel each */
+#define MPU6050_FIFO_MAX_FRAMES	(MPU6050_FIFO_SIZE / 2)
+
+/* Ring slot size, large enough for every channel and all external bytes */
+#define MPU6050_RECORD_MAX_SIZE	\
+	MPU6050_RECORD_EXT_SIZE(MPU6050_NUM_CHANNELS, MPU6050_EXT_DATA_SIZE)
+
+/*
+ * Sensor clock drift tracking. The internal oscillator is specified to
+ * within a few percent; intervals further off than that come from lost
+ * frames or acquisition pauses and only re-anchor the estimate.
+ */
+#define MPU6050_TS_MAX_DRIFT_PPB	50000000
+#define MPU6050_TS_DRIFT_WEIGHT		16	/* Batches averaged by the filter */
+
+/* Character device region and class shared by all instances */
+static dev_t mpu6050_devt;
+static struct class *mpu6050_class;
+
+/* Minor to device map; entries live until the last reference is dropped */
+static DEFINE_IDR(mpu6050_minor_idr);
+static DEFINE_MUTEX(mpu6050_minor_lock);
+static struct dentry *mpu6050_debugfs_root;
+
+static const struct file_operations mpu6050_fops;
+static int mpu6050_group_set_streaming(struct mpu6050_group *group, bool enable);
+static void mpu6050_group_detach(struct mpu6050_file *pf);
+
+/**
+ * mpu6050_max_age_ns - Staleness bound for one-shot reads on a file
+ * @pf: Per-file state
  *
- * This function updates the scaling factors used to convert raw sensor
- * data to meaningful units based on the current configuration.
+ * Returns: the file's bound, or one output data period if it has none
  */
-static void mpu6050_update_scale_factors(struct mpu6050_data *data)
+static u64 mpu6050_max_age_ns(struct mpu6050_file *pf)
 {
-	/* Accelerometer scale factors (micro-g per LSB) */
-	switch (data->config.accel_range) {
-	case MPU6050_ACCEL_FS_2G:
-		data->accel_scale = 61;		/* 61 ug/LSB */
-		break;
-	case MPU6050_ACCEL_FS_4G:
-		data->accel_scale = 122;	/* 122 ug/LSB */
-		break;
-	case MPU6050_ACCEL_FS_8G:
-		data->accel_scale = 244;	/* 244 ug/LSB */
-		break;
-	case MPU6050_ACCEL_FS_16G:
-		data->accel_scale = 488;	/* 488 ug/LSB */
-		break;
-	default:
-		data->accel_scale = 61;
-		break;
-	}
+	u32 max_age_ns = READ_ONCE(pf->max_age_ns);
 	
-	/* Gyroscope scale factors (micro-degrees per second per LSB) */
-	switch (data->config.gyro_range) {
-	case MPU6050_GYRO_FS_250:
-		data->gyro_scale = 7633;	/* 7.633 udps/LSB */
-		break;
-	case MPU6050_GYRO_FS_500:
-		data->gyro_scale = 15267;	/* 15.267 udps/LSB */
-		break;
-	case MPU6050_GYRO_FS_1000:
-		data->gyro_scale = 30518;	/* 30.518 udps/LSB */
-		break;
-	case MPU6050_GYRO_FS_2000:
-		data->gyro_scale = 61035;	/* 61.035 udps/LSB */
-		break;
-	default:
-		data->gyro_scale = 7633;
-		break;
-	}
+	return max_age_ns ?: mpu6050_sample_period_ns(pf->data);
+}
+
+/**
+ * mpu6050_fifo_capacity - Number of frames the hardware FIFO can hold
+ * @data: Device data structure
+ *
+ * Returns: FIFO capacity for the enabled channels, in whole frames
+ */
+static unsigned int mpu6050_fifo_capacity(struct mpu6050_data *data)
+{
+	return MPU6050_FIFO_SIZE / data->fifo_frame_size;
 }
 
 /**
- * mpu6050_read_raw_data - Read raw sensor data from MPU-6050
+ * mpu6050_record_size - Size of a packed ring record
+ * @channels: MPU6050_CHAN_* mask of the channels in the record
+ * @ext_len: Number of external sensor bytes in the record
+ */
+static u32 mpu6050_record_size(u32 channels, u32 ext_len)
+{
+	return MPU6050_RECORD_EXT_SIZE(hweight32(channels), ext_len);
+}
+
+/**
+ * mpu6050_fifo_reset - Flush the hardware FIFO
  * @data: Device data structure
- * @raw_data: Pointer to store raw data
+ *
+ * Must be called with data->lock held.
  *
  * Returns: 0 on success, negative error code on failure
  */
-static int mpu6050_read_raw_data(struct mpu6050_data *data,
-				 struct mpu6050_raw_data *raw_data)
+static int mpu6050_fifo_reset(struct mpu6050_data *data)
 {
-	u8 sensor_data[14];
+	unsigned int status;
 	int ret;
 	
-	mutex_lock(&data->lock);
+	ret = regmap_update_bits(data->regmap, MPU6050_REG_USER_CTRL,
+				 MPU6050_USER_CTRL_FIFO_RESET,
+				 MPU6050_USER_CTRL_FIFO_RESET);
+	if (ret)
+		return ret;
+	
+	/* Reading INT_STATUS clears a stale overflow flag */
+	return regmap_read(data->regmap, MPU6050_REG_INT_STATUS, &status);
+}
+
+/**
+ * mpu6050_fifo_drain - Read buffered frames out of the hardware FIFO
+ * @data: Device data structure
+ * @max_frames: Maximum number of frames to read
+ *
+ * Reads the FIFO fill level and then fetches up to @max_frames whole frames
+ * with a single burst on FIFO_R_W, unpacking them into data->fifo_samples.
+ * A FIFO overflow discards the buffered data, resets the FIFO and is
+ * reported as -EOVERFLOW rather than handing back misaligned frames.
+ *
+ * With an interrupt line INT_STATUS belongs to the IRQ thread, which
+ * latches overflows in data->fifo_overflow; otherwise it is polled here.
+ *
+ * Must be called with data->lock held.
+ *
+ * Returns: number of frames unpacked, or negative error code on failure
+ */
+static int mpu6050_fifo_drain(struct mpu6050_data *data,
+			      unsigned int max_frames)
+{
+	unsigned int status = 0, count, avail, frames;
+	__be16 fifo_count;
+	ktime_t start;
+	int ret;
+	
+	if (!data->irq) {
+		start = ktime_get();
+		ret = regmap_read(data->regmap, MPU6050_REG_INT_STATUS, &status);
+		mpu6050_stats_bus(data, start, ret);
+		if (ret) {
+			dev_err(&data->client->dev, "Failed to read INT_STATUS: %d\n", ret);
+			return ret;
+		}
+	}
+	
+	if ((status & MPU6050_INT_FIFO_OFLOW) || data->fifo_overflow) {
+		dev_warn_ratelimited(&data->client->dev, "FIFO overflow, resetting\n");
+		data->fifo_overflow = false;
+		data->fifo_pending = 0;
+		trace_mpu6050_fifo_drain(&data->client->dev, 0, true);
+		ret = mpu6050_fifo_reset(data);
+		return ret ? ret : -EOVERFLOW;
+	}
 	
-	/* Read all sensor data in one burst (14 bytes starting from ACCEL_XOUT_H) */
-	ret = regmap_bulk_read(data->regmap, MPU6050_REG_ACCEL_XOUT_H,
-			       sensor_data, sizeof(sensor_data));
+	start = ktime_get();
+	ret = regmap_bulk_read(data->regmap, MPU6050_REG_FIFO_COUNTH,
+			       &fifo_count, sizeof(fifo_count));
+	mpu6050_stats_bus(data, start, ret);
 	if (ret) {
-		dev_err(&data->client->dev, "Failed to read sensor data: %d\n", ret);
+		dev_err(&data->client->dev, "Failed to read FIFO count: %d\n", ret);
+		return ret;
+	}
+	
+	count = be16_to_cpu(fifo_count);
+	avail = count / data->fifo_frame_size;
+	frames = min_t(unsigned int, avail,
+		       min_t(unsigned int, max_frames, mpu6050_fifo_capacity(data)));
+	data->fifo_pending = avail - frames;
+	if (!frames)
+		return 0;
+	
+	ret = mpu6050_read_fifo(data, data->fifo_samples, frames);
+	if (ret)
+		return ret;
+	
+	trace_mpu6050_fifo_drain(&data->client->dev,
+				 frames * data->fifo_frame_size, false);
+	return frames;
+}
+
+/**
+ * mpu6050_ring_push - Append a sample to the ring
+ * @data: Device data structure
+ * @raw_data: Sample to store
+ * @ext: External sensor bytes of the sample, ring_hdr->ext_len of them
+ * @timestamp: Acquisition time of the sample
+ *
+ * Only the enabled channels are stored, packed in channel order and
+ * followed by the external sensor bytes. The head
+ * is published after every record and the next overwrite is
+ * ordered after that publication, so a lockless reader that re-reads the
+ * head after copying knows which of the copied records are intact.
+ *
+ * Must be called with data->lock held.
+ */
+static void mpu6050_ring_push(struct mpu6050_data *data,
+			      const struct mpu6050_raw_data *raw_data,
+			      const u8 *ext, ktime_t timestamp)
+{
+	struct mpu6050_ring_header *hdr = data->ring_hdr;
+	u32 seq = hdr->head;
+	struct mpu6050_record *rec = (struct mpu6050_record *)
+		(data->ring + (seq & (MPU6050_RING_SIZE - 1)) * hdr->record_size);
+	int i, n = 0;
+	
+	/* Pairs with smp_rmb() in mpu6050_read_ring() */
+	smp_wmb();
+	
+	rec->timestamp = ktime_to_ns(timestamp);
+	rec->seq = seq;
+	rec->flags = data->ring_flags;
+	for (i = 0; i < MPU6050_NUM_CHANNELS; i++)
+		if (hdr->channels & BIT(i))
+			rec->data[n++] = mpu6050_raw_chan(raw_data, i);
+	memcpy(mpu6050_record_ext(rec, n), ext, hdr->ext_len);
+	
+	data->ring_flags = 0;
+	smp_store_release(&data->ring_hdr->head, seq + 1);
+}
+
+/**
+ * mpu6050_ring_relayout - Switch the ring to the current record layout
+ * @data: Device data structure
+ *
+ * The new layout is published together with a head advanced by all but
+ * one ring slot, so every record of the old layout fails the overwrite
+ * check of readers still copying it. Those records are then skipped via
+ * layout_seq rather than counted as lost. The slots are cleared last so
+ * record padding reads as zero.
+ *
+ * Must be called with data->lock held while not streaming.
+ */
+static void mpu6050_ring_relayout(struct mpu6050_data *data)
+{
+	struct mpu6050_ring_header *hdr = data->ring_hdr;
+	u32 head = hdr->head + MPU6050_RING_SIZE - 1;
+	
+	if (hdr->channels == data->channels && hdr->ext_len == data->ext_len)
+		return;
+	
+	WRITE_ONCE(hdr->channels, data->channels);
+	WRITE_ONCE(hdr->ext_len, data->ext_len);
+	WRITE_ONCE(hdr->record_size,
+		   mpu6050_record_size(data->channels, data->ext_len));
+	WRITE_ONCE(hdr->layout_seq, head);
+	smp_store_release(&hdr->head, head);
+	
+	/* Pairs with smp_rmb() in mpu6050_read_ring() */
+	smp_wmb();
+	memset(data->ring, 0, MPU6050_RING_SIZE * MPU6050_RECORD_MAX_SIZE);
+}
+
+/**
+ * mpu6050_ts_period_ns - Sample period corrected for sensor clock drift
+ * @data: Device data structure
+ *
+ * Returns: the output data period in CLOCK_MONOTONIC nanoseconds
+ */
+static u32 mpu6050_ts_period_ns(struct mpu6050_data *data)
+{
+	u32 period_ns = mpu6050_sample_period_ns(data);
+	
+	return period_ns + div_s64((s64)period_ns * data->clock_drift_ppb,
+				   NSEC_PER_SEC);
+}
+
+/**
+ * mpu6050_ts_update - Measure the sensor clock against a new batch
+ * @data: Device data structure
+ * @anchor: Time of the newest frame in the batch
+ * @frames: Number of frames in the batch
+ *
+ * Without lost frames the interval since the newest frame of the previous
+ * batch spans exactly @frames sample periods. Its deviation from the
+ * nominal period is low-pass filtered into data->clock_drift_ppb, which
+ * averages out interrupt latency, and published in the ring header.
+ *
+ * Must be called with data->lock held.
+ *
+ * Returns: true if the interval is consistent with the sample rate
+ */
+static bool mpu6050_ts_update(struct mpu6050_data *data, ktime_t anchor,
+			      unsigned int frames)
+{
+	s64 expected = (s64)frames * mpu6050_sample_period_ns(data);
+	bool valid = false;
+	s64 diff, drift;
+	
+	if (data->ts_anchor) {
+		diff = ktime_to_ns(ktime_sub(anchor, data->ts_anchor)) - expected;
+		drift = mul_u64_u64_div_u64(abs(diff), NSEC_PER_SEC, expected);
+		if (drift <= MPU6050_TS_MAX_DRIFT_PPB) {
+			if (diff < 0)
+				drift = -drift;
+			data->clock_drift_ppb += (drift - data->clock_drift_ppb) /
+						 MPU6050_TS_DRIFT_WEIGHT;
+			valid = true;
+		}
+	}
+	
+	data->ts_anchor = anchor;
+	WRITE_ONCE(data->ring_hdr->clock_drift_ppb, data->clock_drift_ppb);
+	WRITE_ONCE(data->ring_hdr->period_ns, mpu6050_ts_period_ns(data));
+	return valid;
+}
+
+/**
+ * mpu6050_fifo_acquire - Move buffered FIFO frames into the sample ring
+ * @data: Device data structure
+ * @anchor: Time of the newest buffered frame, the data-ready interrupt
+ *	    that triggered the drain or the drain time when polling
+ *
+ * When the batch lines up with the previous one, the frame timestamps are
+ * interpolated evenly between the two anchors. Otherwise the frames are
+ * spaced back from @anchor by the drift-corrected sample period.
+ *
+ * Must be called with data->lock held.
+ *
+ * Returns: number of samples acquired, or negative error code on failure
+ */
+static int mpu6050_fifo_acquire(struct mpu6050_data *data, ktime_t anchor)
+{
+	ktime_t prev = data->ts_anchor;
+	u64 elapsed_ns;
+	u32 period_ns;
+	bool interp;
+	int frames, i;
+	
+	trace_mpu6050_acquire_start(&data->client->dev, true, data->fifo_pending);
+	
+	frames = mpu6050_fifo_drain(data, mpu6050_fifo_capacity(data));
+	if (frames < 0)
+		data->ts_anchor = 0;
+	if (frames == -EOVERFLOW) {
+		data->ring_flags |= MPU6050_SAMPLE_FIFO_OVERFLOW;
+		WRITE_ONCE(data->ring_hdr->fifo_overflows,
+			   data->ring_hdr->fifo_overflows + 1);
+		frames = 0;
+	}
+	if (frames <= 0)
 		goto out;
+	
+	interp = mpu6050_ts_update(data, anchor, frames);
+	elapsed_ns = ktime_to_ns(ktime_sub(anchor, prev));
+	period_ns = mpu6050_ts_period_ns(data);
+	for (i = 0; i < frames; i++) {
+		/* External sensor bytes close each FIFO frame */
+		const u8 *ext = data->fifo_buf + (i + 1) * data->fifo_frame_size -
+				data->ext_len;
+		ktime_t timestamp;
+		
+		if (interp)
+			timestamp = ktime_add_ns(prev, div_u64(elapsed_ns * (i + 1),
+							       frames));
+		else
+			timestamp = ktime_sub_ns(anchor,
+						 (u64)(frames - 1 - i) * period_ns);
+		
+		mpu6050_ring_push(data, &data->fifo_samples[i], ext, timestamp);
+		mpu6050_iio_push(data, &data->fifo_samples[i], timestamp);
 	}
 	
-	/* Convert big-endian data to host format */
-	raw_data->accel_x = be16_to_cpup((__be16 *)&sensor_data[0]);
-	raw_data->accel_y = be16_to_cpup((__be16 *)&sensor_data[2]);
-	raw_data->accel_z = be16_to_cpup((__be16 *)&sensor_data[4]);
-	raw_data->temp = be16_to_cpup((__be16 *)&sensor_data[6]);
-	raw_data->gyro_x = be16_to_cpup((__be16 *)&sensor_data[8]);
-	raw_data->gyro_y = be16_to_cpup((__be16 *)&sensor_data[10]);
-	raw_data->gyro_z = be16_to_cpup((__be16 *)&sensor_data[12]);
+	/* The newest frame also serves one-shot readers */
+	mpu6050_latest_update(data, &data->fifo_samples[frames - 1], anchor);
+	
+	trace_mpu6050_wakeup(&data->client->dev, true, data->ring_hdr->head);
+	wake_up_interruptible(&data->wait);
+	if (data->group)
+		wake_up_interruptible(&data->group->wait);
 	
 out:
+	trace_mpu6050_acquire_end(&data->client->dev, true, frames);
+	return frames;
+}
+
+/**
+ * mpu6050_poll_interval - FIFO drain interval without an interrupt
+ * @data: Device data structure
+ *
+ * Drain once a watermark worth of frames is due, but at least twice per
+ * FIFO fill time so the FIFO cannot overflow between drains.
+ */
+static unsigned long mpu6050_poll_interval(struct mpu6050_data *data)
+{
+	unsigned int frames = min_t(unsigned int, data->fifo_watermark,
+				    mpu6050_fifo_capacity(data) / 2);
+	u64 interval_ns = (u64)frames * mpu6050_sample_period_ns(data);
+	
+	return max_t(unsigned long, nsecs_to_jiffies(interval_ns), 1);
+}
+
+/**
+ * mpu6050_poll_work - Periodic FIFO drain for devices without an IRQ
+ * @work: Work structure embedded in the device data
+ */
+static void mpu6050_poll_work(struct work_struct *work)
+{
+	struct mpu6050_data *data = container_of(to_delayed_work(work),
+						 struct mpu6050_data, poll_work);
+	
+	mpu6050_lock(data);
+	
+	if (!data->streaming || !data->users) {
+		mutex_unlock(&data->lock);
+		return;
+	}
+	
+	mpu6050_fifo_acquire(data, ktime_get());
+	schedule_delayed_work(&data->poll_work, mpu6050_poll_interval(data));
+	
 	mutex_unlock(&data->lock);
-	return ret;
 }
 
 /**
- * mpu6050_read_scaled_data - Read and scale sensor data
+ * mpu6050_acq_update - Start or stop the acquisition timer
+ * @data: Device data structure
+ *
+ * Acquisition runs while streaming is enabled and the device is open. With
+ * an interrupt line the IRQ thread drives it; otherwise a delayed work item
+ * drains the FIFO. The work item stops itself once it is no longer needed.
+ *
+ * Must be called with data->lock held.
+ */
+static void mpu6050_acq_update(struct mpu6050_data *data)
+{
+	if (data->irq || data->dead)
+		return;
+	
+	if (data->streaming && data->users)
+		mod_delayed_work(system_wq, &data->poll_work,
+				 mpu6050_poll_interval(data));
+}
+
+/**
+ * mpu6050_fifo_stop - Stop feeding the hardware FIFO and flush it
  * @data: Device data structure
- * @scaled_data: Pointer to store scaled data
+ *
+ * Must be called with data->lock held.
  *
  * Returns: 0 on success, negative error code on failure
  */
-static int mpu6050_read_scaled_data(struct mpu6050_data *data,
-				    struct mpu6050_scaled_data *scaled_data)
+static int mpu6050_fifo_stop(struct mpu6050_data *data)
 {
-	struct mpu6050_raw_data raw_data;
 	int ret;
 	
-	ret = mpu6050_read_raw_data(data, &raw_data);
+	/* A removed sensor was stopped by remove(), its bus may be gone */
+	if (data->dead)
+		goto out;
+	
+	/* Stop feeding the FIFO before touching it */
+	ret = regmap_write(data->regmap, MPU6050_REG_FIFO_EN, 0);
 	if (ret)
 		return ret;
 	
-	/* Scale accelerometer data to milli-g */
-	scaled_data->accel_x = ((s32)raw_data.accel_x * data->accel_scale) / 1000;
-	scaled_data->accel_y = ((s32)raw_data.accel_y * data->accel_scale) / 1000;
-	scaled_data->accel_z = ((s32)raw_data.accel_z * data->accel_scale) / 1000;
-	
-	/* Scale gyroscope data to milli-degrees per second */
-	scaled_data->gyro_x = ((s32)raw_data.gyro_x * data->gyro_scale) / 1000000;
-	scaled_data->gyro_y = ((s32)raw_data.gyro_y * data->gyro_scale) / 1000000;
-	scaled_data->gyro_z = ((s32)raw_data.gyro_z * data->gyro_scale) / 1000000;
+	ret = regmap_update_bits(data->regmap, MPU6050_REG_USER_CTRL,
+				 MPU6050_USER_CTRL_FIFO_EN, 0);
+	if (ret)
+		return ret;
 	
-	/* Convert temperature to degrees Celsius * 100 */
-	/* Temperature formula: Temperature = (TEMP_OUT/340) + 36.53 */
-	scaled_data->temp = (raw_data.temp * 100) / 340 + 3653;
+	ret = mpu6050_fifo_reset(data);
+	if (ret)
+		return ret;
 	
+out:
+	data->fifo_pending = 0;
+	data->fifo_overflow = false;
+	data->ts_anchor = 0;
 	return 0;
 }
 
 /**
- * mpu6050_set_config - Configure MPU-6050 settings
+ * mpu6050_fifo_arm - Prepare a stopped FIFO for streaming
  * @data: Device data structure
- * @config: Configuration parameters
+ *
+ * Switches the ring to the current record layout and enables the FIFO.
+ * FIFO_EN still selects no sources, so nothing is buffered until it is
+ * written with data->fifo_en.
+ *
+ * Must be called with data->lock held.
  *
  * Returns: 0 on success, negative error code on failure
  */
-static int mpu6050_set_config(struct mpu6050_data *data,
-			      const struct mpu6050_config *config)
+static int mpu6050_fifo_arm(struct mpu6050_data *data)
+{
+	mpu6050_ring_relayout(data);
+	
+	return regmap_update_bits(data->regmap, MPU6050_REG_USER_CTRL,
+				  MPU6050_USER_CTRL_FIFO_EN,
+				  MPU6050_USER_CTRL_FIFO_EN);
+}
+
+/**
+ * mpu6050_set_streaming - Enable or disable FIFO streaming
+ * @data: Device data structure
+ * @enable: True to start streaming, false to stop
+ *
+ * Returns: 0 on success, -EBUSY while the sensor belongs to a capture
+ * group, negative error code on failure
+ */
+static int mpu6050_set_streaming(struct mpu6050_data *data, bool enable)
 {
 	int ret;
 	
 	mutex_lock(&data->lock);
 	
-	/* Set sample rate divider */
-	ret = regmap_write(data->regmap, MPU6050_REG_SMPLRT_DIV,
-			   config->sample_rate_div);
-	if (ret) {
-		dev_err(&data->client->dev, "Failed to set sample rate: %d\n", ret);
-		goto out;
-	}
-	
-	/* Configure DLPF */
-	ret = regmap_write(data->regmap, MPU6050_REG_CONFIG, config->dlpf_cfg);
-	if (ret) {
-		dev_err(&data->client->dev, "Failed to set DLPF config: %d\n", ret);
+	/* The FIFO runs at the sample rate, which cycle mode does not keep */
+	if ((enable && data->cycle) || data->group) {
+		ret = -EBUSY;
 		goto out;
 	}
 	
-	/* Configure gyroscope full scale range */
-	ret = regmap_write(data->regmap, MPU6050_REG_GYRO_CONFIG,
-			   (config->gyro_range << 3) & MPU6050_GYRO_FS_SEL_MASK);
-	if (ret) {
-		dev_err(&data->client->dev, "Failed to set gyro config: %d\n", ret);
+	ret = mpu6050_fifo_stop(data);
+	if (ret)
 		goto out;
-	}
 	
-	/* Configure accelerometer full scale range */
-	ret = regmap_write(data->regmap, MPU6050_REG_ACCEL_CONFIG,
-			   (config->accel_range << 3) & MPU6050_ACCEL_FS_SEL_MASK);
-	if (ret) {
-		dev_err(&data->client->dev, "Failed to set accel config: %d\n", ret);
-		goto out;
+	if (enable) {
+		ret = mpu6050_fifo_arm(data);
+		if (ret)
+			goto out;
+		
+		ret = regmap_write(data->regmap, MPU6050_REG_FIFO_EN,
+				   data->fifo_en);
+		if (ret)
+			goto out;
 	}
 	
-	/* Update local configuration and scaling factors */
-	data->config = *config;
-	mpu6050_update_scale_factors(data);
+	WRITE_ONCE(data->streaming, enable);
+	mpu6050_acq_update(data);
 	
 out:
+	if (ret)
+		dev_err(&data->client->dev, "Failed to %s FIFO streaming: %d\n",
+			enable ? "enable" : "disable", ret);
 	mutex_unlock(&data->lock);
 	return ret;
 }
 
 /**
- * mpu6050_reset - Reset the MPU-6050 device
+ * mpu6050_reset_done - Check whether a device reset has completed
+ * @data: Device data structure
+ *
+ * The part may not answer on the bus while it resets, so read errors just
+ * mean "not yet". Must be called with the register cache bypassed.
+ *
+ * Returns: true once DEVICE_RESET has cleared
+ */
+static bool mpu6050_reset_done(struct mpu6050_data *data)
+{
+	unsigned int val;
+	
+	if (regmap_read(data->regmap, MPU6050_REG_PWR_MGMT_1, &val))
+		return false;
+	
+	return !(val & MPU6050_PWR1_DEVICE_RESET);
+}
+
+/**
+ * mpu6050_reset_device - Reset the MPU-6050 device
  * @data: Device data structure
  *
+ * Completion is detected by polling DEVICE_RESET rather than sleeping for
+ * a fixed time. The configuration, interrupt setup and streaming state are
+ * then restored from the register cache in one pass. Streaming readers see
+ * MPU6050_SAMPLE_FIFO_OVERFLOW on the first record after the reset.
+ *
  * Returns: 0 on success, negative error code on failure
  */
-static int mpu6050_reset(struct mpu6050_data *data)
+int mpu6050_reset_device(struct mpu6050_data *data)
 {
+	bool done;
 	int ret;
 	
 	mutex_lock(&data->lock);
 	
-	/* Trigger device reset */
+	/* DEVICE_RESET is self-clearing and must neither be cached nor read from it */
+	regcache_cache_bypass(data->regmap, true);
 	ret = regmap_write(data->regmap, MPU6050_REG_PWR_MGMT_1,
 			   MPU6050_PWR1_DEVICE_RESET);
+	if (!ret)
+		ret = read_poll_timeout(mpu6050_reset_done, done, done,
+					MPU6050_RESET_POLL_US,
+					MPU6050_RESET_TIMEOUT_US, true, data);
+	regcache_cache_bypass(data->regmap, false);
 	if (ret) {
 		dev_err(&data->client->dev, "Failed to reset device: %d\n", ret);
 		goto out;
 	}
 	
-	/* Wait for reset to complete */
-	msleep(100);
+	/* Every register is back at its reset value; restore the cached ones */
+	regcache_mark_dirty(data->regmap);
+	ret = regcache_sync(data->regmap);
+	if (ret) {
+		dev_err(&data->client->dev, "Failed to restore registers: %d\n", ret);
+		goto out;
+	}
 	
-	/* Re-initialize the device with default settings */
-	ret = mpu6050_set_config(data, &data->config);
+	/* USER_CTRL is volatile, so the FIFO has to be re-enabled by hand */
+	if (data->streaming) {
+		data->fifo_pending = 0;
+		data->fifo_overflow = false;
+		data->ring_flags |= MPU6050_SAMPLE_FIFO_OVERFLOW;
+		ret = regmap_update_bits(data->regmap, MPU6050_REG_USER_CTRL,
+					 MPU6050_USER_CTRL_FIFO_EN,
+					 MPU6050_USER_CTRL_FIFO_EN);
+		if (ret) {
+			dev_err(&data->client->dev, "Failed to restart FIFO: %d\n", ret);
+			goto out;
+		}
+	}
+	
+	/* The same goes for the auxiliary I2C master */
+	if (data->ext_len) {
+		ret = regmap_update_bits(data->regmap, MPU6050_REG_USER_CTRL,
+					 MPU6050_USER_CTRL_I2C_MST_EN,
+					 MPU6050_USER_CTRL_I2C_MST_EN);
+		if (ret) {
+			dev_err(&data->client->dev, "Failed to restart aux I2C master: %d\n", ret);
+			goto out;
+		}
+	}
+	
+	mpu6050_latest_invalidate(data);
 	
 out:
 	mutex_unlock(&data->lock);
@@ -276,169 +784,2220 @@ out:
 }
 
 /**
- * mpu6050_init_device - Initialize MPU-6050 device
+ * mpu6050_irq_enable - Enable or disable the interrupt sources
  * @data: Device data structure
+ * @enable: True to enable DATA_RDY and FIFO overflow interrupts
+ *
+ * Interrupts are only enabled while the device is open so an idle sensor
+ * does not generate bus traffic. Must be called with data->lock held.
  *
  * Returns: 0 on success, negative error code on failure
  */
-static int mpu6050_init_device(struct mpu6050_data *data)
+static int mpu6050_irq_enable(struct mpu6050_data *data, bool enable)
 {
-	unsigned int val;
+	unsigned int status;
 	int ret;
 	
-	/* Check WHO_AM_I register */
-	ret = regmap_read(data->regmap, MPU6050_REG_WHO_AM_I, &val);
-	if (ret) {
-		dev_err(&data->client->dev, "Failed to read WHO_AM_I: %d\n", ret);
-		return ret;
-	}
-	
-	if (val != MPU6050_WHO_AM_I_VAL) {
-		dev_err(&data->client->dev, "Invalid WHO_AM_I value: 0x%02x\n", val);
-		return -ENODEV;
-	}
-	
-	dev_info(&data->client->dev, "MPU-6050 detected (WHO_AM_I: 0x%02x)\n", val);
-	
-	/* Wake up from sleep mode and set clock source */
-	ret = regmap_write(data->regmap, MPU6050_REG_PWR_MGMT_1,
-			   MPU6050_CLKSEL_PLL_XGYRO);
-	if (ret) {
-		dev_err(&data->client->dev, "Failed to wake up device: %d\n", ret);
-		return ret;
-	}
-	
-	/* Wait for device to stabilize */
-	msleep(50);
-	
-	/* Set default configuration */
-	data->config.sample_rate_div = MPU6050_DEFAULT_SMPLRT_DIV;
-	data->config.gyro_range = MPU6050_GYRO_FS_250;
-	data->config.accel_range = MPU6050_ACCEL_FS_2G;
-	data->config.dlpf_cfg = 0x00;  /* No DLPF */
+	if (!data->irq)
+		return 0;
 	
-	ret = mpu6050_set_config(data, &data->config);
+	ret = regmap_write(data->regmap, MPU6050_REG_INT_ENABLE,
+			   enable ? MPU6050_INT_ENABLE_MASK : 0);
 	if (ret) {
-		dev_err(&data->client->dev, "Failed to set default config: %d\n", ret);
+		dev_err(&data->client->dev, "Failed to %s interrupts: %d\n",
+			enable ? "enable" : "disable", ret);
 		return ret;
 	}
 	
-	dev_info(&data->client->dev, "MPU-6050 initialized successfully\n");
-	return 0;
+	/* Drop any status latched before the change */
+	return regmap_read(data->regmap, MPU6050_REG_INT_STATUS, &status);
 }
 
-/* Character device file operations */
+/**
+ * mpu6050_acq_get - Register a consumer of acquired samples
+ * @data: Device data structure
+ *
+ * Open files and an enabled IIO buffer are consumers. The first one wakes
+ * the sensor through runtime PM and turns the interrupt sources on; the
+ * runtime PM callbacks do not take data->lock.
+ *
+ * Must be called with data->lock held.
+ *
+ * Returns: 0 on success, negative error code on failure
+ */
+int mpu6050_acq_get(struct mpu6050_data *data)
+{
+	struct device *dev = &data->client->dev;
+	int ret;
+	
+	if (data->dead)
+		return -ENODEV;
+	
+	if (data->users == 0) {
+		ret = pm_runtime_resume_and_get(dev);
+		if (ret)
+			return ret;
+		
+		ret = mpu6050_irq_enable(data, true);
+		if (ret) {
+			pm_runtime_put_autosuspend(dev);
+			return ret;
+		}
+	}
+	
+	data->users++;
+	mpu6050_acq_update(data);
+	return 0;
+}
+
+/**
+ * mpu6050_acq_stop - Turn the interrupt sources off and let the sensor sleep
+ * @data: Device data structure
+ *
+ * Undoes what mpu6050_acq_get() did for the first consumer. Must be called
+ * with data->lock held.
+ */
+static void mpu6050_acq_stop(struct mpu6050_data *data)
+{
+	struct device *dev = &data->client->dev;
+	
+	mpu6050_irq_enable(data, false);
+	pm_runtime_mark_last_busy(dev);
+	pm_runtime_put_autosuspend(dev);
+}
+
+/**
+ * mpu6050_acq_put - Drop a consumer registered with mpu6050_acq_get()
+ * @data: Device data structure
+ *
+ * The sensor goes to sleep MPU6050_AUTOSUSPEND_MS after the last one. Once
+ * the device is removed acquisition is already stopped, and consumers that
+ * are still around only drop their count.
+ *
+ * Must be called with data->lock held.
+ */
+void mpu6050_acq_put(struct mpu6050_data *data)
+{
+	if (--data->users || data->dead)
+		return;
+	
+	mpu6050_acq_stop(data);
+}
+
+/**
+ * mpu6050_irq_handler - Hard interrupt handler
+ * @irq: Interrupt number
+ * @dev_id: Device data structure
+ *
+ * Only takes the timestamp, as close to the data-ready edge as possible.
+ * The line stays masked until the thread is done, so the thread always
+ * sees the timestamp of the interrupt it services.
+ */
+static irqreturn_t mpu6050_irq_handler(int irq, void *dev_id)
+{
+	struct mpu6050_data *data = dev_id;
+	
+	data->irq_timestamp = ktime_get();
+	trace_mpu6050_irq(&data->client->dev, irq);
+	return IRQ_WAKE_THREAD;
+}
+
+/**
+ * mpu6050_irq_thread - Threaded interrupt handler
+ * @irq: Interrupt number
+ * @dev_id: Device data structure
+ *
+ * Reading INT_STATUS acknowledges the latched interrupt. DATA_RDY bumps the
+ * sample sequence and wakes one-shot readers. While streaming it counts
+ * FIFO frames instead, and the FIFO is drained into the sample ring once
+ * the watermark is reached or an overflow needs handling.
+ */
+static irqreturn_t mpu6050_irq_thread(int irq, void *dev_id)
+{
+	struct mpu6050_data *data = dev_id;
+	struct mpu6050_raw_data raw_data;
+	ktime_t now = data->irq_timestamp, start;
+	unsigned int status, capacity;
+	bool wake = false;
+	int ret;
+	
+	mpu6050_lock(data);
+	
+	start = ktime_get();
+	ret = regmap_read(data->regmap, MPU6050_REG_INT_STATUS, &status);
+	mpu6050_stats_bus(data, start, ret);
+	if (ret) {
+		mutex_unlock(&data->lock);
+		dev_err_ratelimited(&data->client->dev,
+				    "Failed to read INT_STATUS: %d\n", ret);
+		return IRQ_HANDLED;
+	}
+	
+	if (!(status & MPU6050_INT_ENABLE_MASK)) {
+		mutex_unlock(&data->lock);
+		return IRQ_NONE;
+	}
+	
+	if (status & MPU6050_INT_FIFO_OFLOW)
+		data->fifo_overflow = true;
+	
+	capacity = mpu6050_fifo_capacity(data);
+	if (status & MPU6050_INT_DATA_RDY) {
+		/* Refresh the cache before telling readers the sample is there */
+		if (!data->streaming) {
+			data->sample_seq++;
+			mpu6050_fetch_sample(data, &raw_data);
+		}
+		
+		WRITE_ONCE(data->drdy_seq, data->drdy_seq + 1);
+		if (!data->streaming)
+			wake = true;
+		else if (data->fifo_pending < capacity)
+			data->fifo_pending++;
+	}
+	
+	if (data->streaming &&
+	    (data->fifo_overflow ||
+	     data->fifo_pending >= min(data->fifo_watermark, capacity)))
+		mpu6050_fifo_acquire(data, now);
+	
+	mutex_unlock(&data->lock);
+	
+	/* One-shot data ready; FIFO drains feed the IIO buffer directly */
+	if (wake) {
+		trace_mpu6050_wakeup(&data->client->dev, false,
+				     READ_ONCE(data->drdy_seq));
+		wake_up_interruptible(&data->wait);
+		mpu6050_iio_trigger(data, now);
+	}
+	
+	return IRQ_HANDLED;
+}
+
+/**
+ * mpu6050_setup_irq - Configure the INT pin and request the interrupt
+ * @data: Device data structure
+ *
+ * The INT pin is latched until INT_STATUS is read, and its polarity follows
+ * the trigger type given for the interrupt in the device tree.
+ *
+ * Returns: 0 on success, negative error code on failure
+ */
+static int mpu6050_setup_irq(struct mpu6050_data *data)
+{
+	struct i2c_client *client = data->client;
+	unsigned int pin_cfg = MPU6050_INT_PIN_CFG_LATCH_INT_EN;
+	u32 irq_type;
+	int ret;
+	
+	irq_type = irq_get_trigger_type(client->irq);
+	if (irq_type == IRQ_TYPE_LEVEL_LOW || irq_type == IRQ_TYPE_EDGE_FALLING)
+		pin_cfg |= MPU6050_INT_PIN_CFG_INT_LEVEL;
+	
+	ret = regmap_write(data->regmap, MPU6050_REG_INT_PIN_CFG, pin_cfg);
+	if (ret) {
+		dev_err(&client->dev, "Failed to configure INT pin: %d\n", ret);
+		return ret;
+	}
+	
+	ret = devm_request_threaded_irq(&client->dev, client->irq,
+					mpu6050_irq_handler, mpu6050_irq_thread,
+					IRQF_ONESHOT,
+					dev_name(&client->dev), data);
+	if (ret) {
+		dev_err(&client->dev, "Failed to request IRQ %d: %d\n",
+			client->irq, ret);
+		return ret;
+	}
+	
+	data->irq = client->irq;
+	dev_info(&client->dev, "Using data-ready interrupt %d\n", data->irq);
+	return 0;
+}
+
+/**
+ * mpu6050_init_device - Initialize MPU-6050 device
+ * @data: Device data structure
+ *
+ * Returns: 0 on success, negative error code on failure
+ */
+static int mpu6050_init_device(struct mpu6050_data *data)
+{
+	unsigned int val;
+	int ret;
+	
+	/* Check WHO_AM_I register */
+	ret = regmap_read(data->regmap, MPU6050_REG_WHO_AM_I, &val);
+	if (ret) {
+		dev_err(&data->client->dev, "Failed to read WHO_AM_I: %d\n", ret);
+		return ret;
+	}
+	
+	if (val != MPU6050_WHO_AM_I_VAL) {
+		dev_err(&data->client->dev, "Invalid WHO_AM_I value: 0x%02x\n", val);
+		return -ENODEV;
+	}
+	
+	dev_info(&data->client->dev, "MPU-6050 detected (WHO_AM_I: 0x%02x)\n", val);
+	
+	/* Wake up from sleep mode and set clock source */
+	ret = regmap_write(data->regmap, MPU6050_REG_PWR_MGMT_1,
+			   MPU6050_CLKSEL_PLL_XGYRO);
+	if (ret) {
+		dev_err(&data->client->dev, "Failed to wake up device: %d\n", ret);
+		return ret;
+	}
+	
+	/*
+	 * Set default configuration. Registers accept writes as soon as the
+	 * part leaves sleep, so there is no need to wait for it to settle.
+	 */
+	data->config.sample_rate_div = MPU6050_DEFAULT_SMPLRT_DIV;
+	data->config.gyro_range = MPU6050_GYRO_FS_250;
+	data->config.accel_range = MPU6050_ACCEL_FS_2G;
+	data->config.dlpf_cfg = 0x00;  /* No DLPF */
+	
+	ret = mpu6050_set_config(data, &data->config);
+	if (ret) {
+		dev_err(&data->client->dev, "Failed to set default config: %d\n", ret);
+		return ret;
+	}
+	
+	ret = mpu6050_set_channels(data, MPU6050_CHAN_ALL);
+	if (ret)
+		return ret;
+	
+	dev_info(&data->client->dev, "MPU-6050 initialized successfully\n");
+	return 0;
+}
+
+/* Character device file operations */
+
+/**
+ * mpu6050_data_release - Free the device state once the last user is gone
+ * @ref: Reference count embedded in the device data
+ *
+ * Called with mpu6050_minor_lock held, so open() cannot look the minor up
+ * while it is being freed.
+ */
+static void mpu6050_data_release(struct kref *ref)
+{
+	struct mpu6050_data *data = container_of(ref, struct mpu6050_data, kref);
+	
+	if (data->devt)
+		idr_remove(&mpu6050_minor_idr, MINOR(data->devt));
+	mutex_unlock(&mpu6050_minor_lock);
+	
+	vfree(data->ring_hdr);
+	kfree(data->fifo_samples);
+	kfree(data->fifo_buf);
+	free_percpu(data->stats);
+	mutex_destroy(&data->lock);
+	kfree(data);
+}
+
+/**
+ * mpu6050_data_put - Drop a reference to the device state
+ * @data: Device data structure
+ *
+ * The bound device holds one reference and every open file another, so
+ * the state, the sample ring and the minor outlive remove() for as long
+ * as a file is open.
+ */
+static void mpu6050_data_put(struct mpu6050_data *data)
+{
+	kref_put_mutex(&data->kref, mpu6050_data_release, &mpu6050_minor_lock);
+}
+
+/**
+ * mpu6050_ops_enter - Start a file operation that may touch the device
+ * @data: Device data structure
+ *
+ * Files may outlive the device. remove() marks it dead and then waits for
+ * every operation that got in before to return, so the bus and the work
+ * item are left alone afterwards. Paired with mpu6050_ops_exit().
+ *
+ * Returns: 0 on success, -ENODEV once the device has been removed
+ */
+static int mpu6050_ops_enter(struct mpu6050_data *data)
+{
+	down_read(&data->ops_sem);
+	if (READ_ONCE(data->dead)) {
+		up_read(&data->ops_sem);
+		return -ENODEV;
+	}
+	
+	return 0;
+}
+
+static void mpu6050_ops_exit(struct mpu6050_data *data)
+{
+	up_read(&data->ops_sem);
+}
 
 static int mpu6050_open(struct inode *inode, struct file *file)
 {
-	struct mpu6050_data *data = mpu6050_dev_data;
+	struct mpu6050_data *data;
+	struct mpu6050_file *pf;
+	int ret = 0;
 	
-	if (!data) {
-		pr_err("MPU-6050: Device data not available\n");
+	mutex_lock(&mpu6050_minor_lock);
+	data = idr_find(&mpu6050_minor_idr, iminor(inode));
+	if (data)
+		kref_get(&data->kref);
+	mutex_unlock(&mpu6050_minor_lock);
+	if (!data)
 		return -ENODEV;
+	
+	pf = kzalloc(sizeof(*pf), GFP_KERNEL);
+	if (!pf) {
+		ret = -ENOMEM;
+		goto err_put;
+	}
+	
+	pf->data = data;
+	mutex_init(&pf->lock);
+	file->f_mode |= FMODE_NOWAIT;
+	pf->decim.factor = 1;
+	pf->decim.order = 1;
+	pf->pid = task_tgid_nr(current);
+	get_task_comm(pf->comm, current);
+	
+	mutex_lock(&data->lock);
+	ret = mpu6050_acq_get(data);
+	if (!ret) {
+		pf->drdy_seen = data->drdy_seq;
+		pf->sample_seen = data->sample_seq;
+		pf->ring_tail = data->ring_hdr->head;
+		list_add_tail(&pf->node, &data->files);
+	}
+	mutex_unlock(&data->lock);
+	
+	if (ret) {
+		kfree(pf);
+		goto err_put;
+	}
+	
+	file->private_data = pf;
+	return nonseekable_open(inode, file);
+	
+err_put:
+	mpu6050_data_put(data);
+	return ret;
+}
+
+static int mpu6050_release(struct inode *inode, struct file *file)
+{
+	struct mpu6050_file *pf = file->private_data;
+	struct mpu6050_data *data = pf->data;
+	
+	if (pf->group) {
+		if (pf->group->streaming)
+			mpu6050_group_set_streaming(pf->group, false);
+		mpu6050_group_detach(pf);
+	}
+	
+	mutex_lock(&data->lock);
+	list_del(&pf->node);
+	mpu6050_acq_put(data);
+	mutex_unlock(&data->lock);
+	
+	mutex_destroy(&pf->lock);
+	kfree(pf);
+	mpu6050_data_put(data);
+	return 0;
+}
+
+/**
+ * mpu6050_ring_unread - Number of ring records behind a read position
+ * @data: Device data structure
+ * @tail: Sequence number of the next record to read
+ *
+ * Returns: unread record count, at most the ring size
+ */
+static u32 mpu6050_ring_unread(struct mpu6050_data *data, u32 tail)
+{
+	struct mpu6050_ring_header *hdr = data->ring_hdr;
+	u32 head = smp_load_acquire(&hdr->head);
+	u32 layout_seq = READ_ONCE(hdr->layout_seq);
+	
+	if ((s32)(tail - layout_seq) < 0)
+		tail = layout_seq;
+	
+	return min_t(u32, head - tail, MPU6050_RING_SIZE);
+}
+
+/**
+ * mpu6050_ring_avail - Number of records a file has not read yet
+ * @pf: Per-file state
+ *
+ * Returns: unread record count, at most the ring size
+ */
+static u32 mpu6050_ring_avail(struct mpu6050_file *pf)
+{
+	return mpu6050_ring_unread(pf->data, READ_ONCE(pf->ring_tail));
+}
+
+/**
+ * mpu6050_records_needed - Unread records that make up a number of outputs
+ * @pf: Per-file state
+ * @count: Records the reader wants
+ *
+ * Without decimation every ring record is an output. With it, @count
+ * outputs take the inputs still missing from the current block, those of
+ * the outputs discarded while a CIC filter fills and @factor inputs each.
+ * Called locklessly from wakeup conditions, so a concurrent reconfiguration
+ * may give a stale answer but never an unbounded one.
+ *
+ * Returns: number of unread ring records to wait for
+ */
+static u32 mpu6050_records_needed(struct mpu6050_file *pf, u32 count)
+{
+	u32 factor = READ_ONCE(pf->decim.factor);
+	s64 needed;
+	
+	if (factor <= 1 || !count)
+		return count;
+	
+	needed = (s64)(count + READ_ONCE(pf->decim.prime)) * factor -
+		 READ_ONCE(pf->decim.phase);
+	
+	/* Leave the producer room so waiting never costs records */
+	return clamp_t(s64, needed, 1, MPU6050_RING_SIZE / 2);
+}
+
+/**
+ * mpu6050_new_ready - Whether the cache holds a sample this file has not seen
+ * @pf: Per-file state
+ *
+ * Returns: true if a new-data read can complete without waiting
+ */
+static bool mpu6050_new_ready(struct mpu6050_file *pf)
+{
+	struct mpu6050_sample sample;
+	
+	if (READ_ONCE(pf->data->dead))
+		return true;
+	
+	return mpu6050_latest_sample(pf->data, &sample) &&
+	       (s32)(sample.seq - READ_ONCE(pf->sample_seen)) > 0;
+}
+
+/**
+ * mpu6050_data_ready - Check whether a read would return fresh data
+ * @pf: Per-file state
+ *
+ * Streaming readers are ready when the ring holds samples past their read
+ * position. One-shot readers without an interrupt line have no way to tell,
+ * so data is always considered ready and read() keeps its non-blocking
+ * behaviour. A removed device is always ready so that waiters return.
+ */
+static bool mpu6050_data_ready(struct mpu6050_file *pf)
+{
+	struct mpu6050_data *data = pf->data;
+	
+	if (READ_ONCE(data->dead))
+		return true;
+	
+	if (READ_ONCE(data->streaming))
+		return mpu6050_ring_avail(pf) >= mpu6050_records_needed(pf, 1);
+	
+	if (!data->irq)
+		return true;
+	
+	if (READ_ONCE(pf->read_mode) == MPU6050_READ_NEW)
+		return mpu6050_new_ready(pf);
+	
+	return READ_ONCE(data->drdy_seq) != pf->drdy_seen;
+}
+
+/**
+ * mpu6050_wait_data - Wait until fresh data is available
+ * @pf: Per-file state
+ * @nonblock: Fail with -EAGAIN instead of sleeping
+ *
+ * Returns: 0 when data is ready, -ENODEV if the device was removed,
+ * negative error code otherwise
+ */
+static int mpu6050_wait_data(struct mpu6050_file *pf, bool nonblock)
+{
+	int ret;
+	
+	if (!mpu6050_data_ready(pf)) {
+		if (nonblock)
+			return -EAGAIN;
+		
+		ret = wait_event_interruptible(pf->data->wait,
+					       mpu6050_data_ready(pf));
+		if (ret)
+			return ret;
+	}
+	
+	return READ_ONCE(pf->data->dead) ? -ENODEV : 0;
+}
+
+/**
+ * mpu6050_copy_ring - Copy a run of ring records out of the ring
+ * @data: Device data structure
+ * @dst: Destination, advanced past the copied records
+ * @seq: Sequence number of the first record
+ * @n: Number of records
+ * @record_size: Size of one record in bytes
+ *
+ * Returns: 0 on success, -EFAULT on failure
+ */
+static int mpu6050_copy_ring(struct mpu6050_data *data, struct iov_iter *dst,
+			     u32 seq, u32 n, u32 record_size)
+{
+	u32 idx = seq & (MPU6050_RING_SIZE - 1);
+	u32 first = min_t(u32, n, MPU6050_RING_SIZE - idx);
+	size_t len = first * record_size;
+	
+	if (copy_to_iter(data->ring + idx * record_size, len, dst) != len)
+		return -EFAULT;
+	if (first == n)
+		return 0;
+	
+	len = (n - first) * record_size;
+	return copy_to_iter(data->ring, len, dst) == len ? 0 : -EFAULT;
+}
+
+/**
+ * mpu6050_ring_copy_out - Copy unread samples out of the ring without locking
+ * @data: Device data structure
+ * @ring_tail: Read position, advanced past the copied records
+ * @lost: Incremented by the records that were overwritten before the copy
+ * @dst: Destination, user or kernel memory, advanced past the records
+ * @max: Maximum number of records to copy
+ * @channels: Out: MPU6050_CHAN_* mask of the copied records
+ * @record_size: Out: Size of each copied record in bytes
+ *
+ * Records are copied straight from the ring, and the head is re-read
+ * afterwards. Any copied record the producer may have overwritten in the
+ * meantime is counted as lost and the copy restarts from the oldest intact
+ * record, so @dst only ever holds a consistent run of samples. Records
+ * from before the last layout change are skipped.
+ *
+ * The caller serializes users of @ring_tail and @lost.
+ *
+ * Returns: number of records copied, -EAGAIN if there are none, -EINVAL if
+ * @dst cannot hold one record, or -EFAULT on failure
+ */
+static int mpu6050_ring_copy_out(struct mpu6050_data *data, u32 *ring_tail,
+				 u64 *lost, struct iov_iter *dst, u32 max,
+				 u32 *channels, u32 *record_size)
+{
+	u32 head, tail, oldest, layout_seq, n;
+	
+	for (;;) {
+		/* The layout is published before the head that goes with it */
+		head = smp_load_acquire(&data->ring_hdr->head);
+		*channels = READ_ONCE(data->ring_hdr->channels);
+		*record_size = READ_ONCE(data->ring_hdr->record_size);
+		layout_seq = READ_ONCE(data->ring_hdr->layout_seq);
+		tail = *ring_tail;
+		
+		n = min_t(size_t, iov_iter_count(dst) / *record_size,
+			  min_t(u32, max, MPU6050_RING_SIZE));
+		if (!n)
+			return -EINVAL;
+		
+		/* Older layouts were discarded, not missed */
+		if ((s32)(tail - layout_seq) < 0)
+			tail = layout_seq;
+		
+		/* Skip records that were overwritten before we got to them */
+		oldest = head - MPU6050_RING_SIZE + 1;
+		if ((s32)(tail - oldest) < 0) {
+			*lost += oldest - tail;
+			tail = oldest;
+		}
+		
+		n = min(head - tail, n);
+		if (!n) {
+			*ring_tail = tail;
+			return -EAGAIN;
+		}
+		
+		if (mpu6050_copy_ring(data, dst, tail, n, *record_size))
+			return -EFAULT;
+		
+		/* Pairs with smp_wmb() in mpu6050_ring_push() */
+		smp_rmb();
+		head = READ_ONCE(data->ring_hdr->head);
+		oldest = head - MPU6050_RING_SIZE + 1;
+		if ((s32)(tail - oldest) >= 0)
+			break;
+		
+		iov_iter_revert(dst, n * *record_size);
+		*ring_tail = tail;
+	}
+	
+	*ring_tail = tail + n;
+	return n;
+}
+
+/**
+ * mpu6050_read_ring - Copy a file's unread samples out of the ring
+ * @pf: Per-file state
+ * @dst: Destination, user or kernel memory, advanced past the records
+ * @max: Maximum number of records to copy
+ * @channels: Out: MPU6050_CHAN_* mask of the copied records
+ * @record_size: Out: Size of each copied record in bytes
+ *
+ * Must be called with pf->lock held.
+ *
+ * Returns: as mpu6050_ring_copy_out()
+ */
+static int mpu6050_read_ring(struct mpu6050_file *pf, struct iov_iter *dst,
+			     u32 max, u32 *channels, u32 *record_size)
+{
+	return mpu6050_ring_copy_out(pf->data, &pf->ring_tail, &pf->lost, dst,
+				     max, channels, record_size);
+}
+
+/**
+ * mpu6050_decim_reset - Drop a file's accumulated filter state
+ * @dec: Filter state, keeps its configuration and input layout
+ */
+static void mpu6050_decim_reset(struct mpu6050_decim *dec)
+{
+	memset(dec->integ, 0, sizeof(dec->integ));
+	memset(dec->comb, 0, sizeof(dec->comb));
+	dec->flags = 0;
+	WRITE_ONCE(dec->phase, 0);
+	WRITE_ONCE(dec->prime, dec->order - 1);
+}
+
+/**
+ * mpu6050_decim_feed - Run one input record through the filter
+ * @dec: Filter state, matching the layout of @rec
+ * @rec: Input record
+ * @out: Output record, only written when an output is produced
+ *
+ * Integrators run at the input rate and combs at the output rate. The
+ * output is the comb result divided by the filter gain with rounding,
+ * timestamped at the centre of the impulse response, which lies
+ * @order * (@factor - 1) / 2 input periods before the newest input.
+ *
+ * Returns: true if @out holds a new output record
+ */
+static bool mpu6050_decim_feed(struct mpu6050_decim *dec,
+			       const struct mpu6050_record *rec,
+			       struct mpu6050_record *out)
+{
+	unsigned int n = hweight32(dec->channels);
+	unsigned int i, k, order = dec->order;
+	s64 gain = 1, span, val;
+	u64 v, prev;
+	
+	if (!dec->phase)
+		dec->first_ts = rec->timestamp;
+	dec->flags |= rec->flags;
+	
+	for (i = 0; i < n; i++) {
+		v = (u64)(s64)rec->data[i];
+		for (k = 0; k < order; k++) {
+			dec->integ[i][k] += v;
+			v = dec->integ[i][k];
+		}
+	}
+	
+	if (dec->phase + 1 < dec->factor) {
+		WRITE_ONCE(dec->phase, dec->phase + 1);
+		return false;
+	}
+	WRITE_ONCE(dec->phase, 0);
+	
+	/* Record header, external bytes and padding follow the newest input */
+	memcpy(out, rec, dec->record_size);
+	
+	for (k = 0; k < order; k++)
+		gain *= dec->factor;
+	
+	for (i = 0; i < n; i++) {
+		v = dec->integ[i][order - 1];
+		for (k = 0; k < order; k++) {
+			prev = dec->comb[i][k];
+			dec->comb[i][k] = v;
+			v -= prev;
+		}
+		
+		val = (s64)v;
+		val = div64_s64(val + (val < 0 ? -gain / 2 : gain / 2), gain);
+		out->data[i] = clamp_t(s64, val, S16_MIN, S16_MAX);
+	}
+	
+	if (dec->prime) {
+		WRITE_ONCE(dec->prime, dec->prime - 1);
+		dec->flags = 0;
+		return false;
+	}
+	
+	span = rec->timestamp - dec->first_ts;
+	out->timestamp = rec->timestamp - div_s64(span * order, 2);
+	out->flags = dec->flags;
+	dec->flags = 0;
+	
+	return true;
+}
+
+/**
+ * mpu6050_read_decimated - Copy decimated records out of the ring
+ * @pf: Per-file state, with decimation configured
+ * @dst: Destination, user or kernel memory, advanced past the records
+ * @max: Maximum number of output records to copy
+ * @channels: Out: MPU6050_CHAN_* mask of the copied records
+ * @record_size: Out: Size of each copied record in bytes
+ *
+ * Input records are snapshotted from the ring in chunks, only as many as
+ * the wanted outputs need, and filtered into a bounce buffer. Lost input
+ * and layout changes restart the filter; a layout change also ends the
+ * call once records were copied, so @dst never mixes record sizes.
+ *
+ * Must be called with pf->lock held.
+ *
+ * Returns: number of records copied, -EAGAIN if the filter produced none,
+ * -EINVAL if @dst cannot hold one record, or negative error code on
+ * failure
+ */
+static int mpu6050_read_decimated(struct mpu6050_file *pf, struct iov_iter *dst,
+				  u32 max, u32 *channels, u32 *record_size)
+{
+	struct mpu6050_decim *dec = &pf->decim;
+	u32 done = 0, left, rs, want, i, m;
+	struct iov_iter iter;
+	struct kvec kvec;
+	u64 inputs;
+	u8 *in, *out;
+	int n, ret;
+	
+	in = kmalloc_array(2 * MPU6050_BATCH_CHUNK, MPU6050_RECORD_MAX_SIZE,
+			   GFP_KERNEL);
+	if (!in)
+		return -ENOMEM;
+	out = in + MPU6050_BATCH_CHUNK * MPU6050_RECORD_MAX_SIZE;
+	
+	for (;;) {
+		rs = dec->record_size ?: READ_ONCE(pf->data->ring_hdr->record_size);
+		left = min_t(size_t, max - done, iov_iter_count(dst) / rs);
+		if (!left) {
+			ret = done ? done : -EINVAL;
+			goto out;
+		}
+		
+		inputs = (u64)(left + dec->prime) * dec->factor - dec->phase;
+		want = min_t(u64, inputs, MPU6050_BATCH_CHUNK);
+		
+		kvec.iov_base = in;
+		kvec.iov_len = MPU6050_BATCH_CHUNK * MPU6050_RECORD_MAX_SIZE;
+		iov_iter_kvec(&iter, READ, &kvec, 1, kvec.iov_len);
+		n = mpu6050_read_ring(pf, &iter, want, channels, record_size);
+		if (n == -EAGAIN)
+			break;
+		if (n < 0) {
+			ret = n;
+			goto out;
+		}
+		
+		if (*channels != dec->channels || *record_size != dec->record_size) {
+			/* Give the records back and size the outputs afresh */
+			pf->ring_tail -= n;
+			dec->channels = *channels;
+			dec->record_size = *record_size;
+			dec->lost = pf->lost;
+			mpu6050_decim_reset(dec);
+			if (done)
+				break;
+			continue;
+		}
+		
+		if (pf->lost != dec->lost) {
+			dec->lost = pf->lost;
+			mpu6050_decim_reset(dec);
+			dec->flags = MPU6050_SAMPLE_FIFO_OVERFLOW;
+		}
+		
+		for (i = 0, m = 0; i < n; i++)
+			if (mpu6050_decim_feed(dec, (const void *)(in + i * rs),
+					       (void *)(out + m * rs)))
+				m++;
+		
+		if (copy_to_iter(out, m * rs, dst) != m * rs) {
+			ret = -EFAULT;
+			goto out;
+		}
+		done += m;
+		
+		if (n < want)
+			break;
+	}
+	
+	ret = done ? done : -EAGAIN;
+out:
+	kfree(in);
+	return ret;
+}
+
+/**
+ * mpu6050_read_records - Copy a file's next streaming records
+ * @pf: Per-file state
+ * @dst: Destination, user or kernel memory, advanced past the records
+ * @max: Maximum number of records to copy
+ * @channels: Out: MPU6050_CHAN_* mask of the copied records
+ * @record_size: Out: Size of each copied record in bytes
+ *
+ * Serves ring records as they are, or through the file's decimation
+ * filter when one is configured.
+ *
+ * Must be called with pf->lock held.
+ *
+ * Returns: as mpu6050_read_ring()
+ */
+static int mpu6050_read_records(struct mpu6050_file *pf, struct iov_iter *dst,
+				u32 max, u32 *channels, u32 *record_size)
+{
+	if (pf->decim.factor > 1)
+		return mpu6050_read_decimated(pf, dst, max, channels,
+					      record_size);
+	
+	return mpu6050_read_ring(pf, dst, max, channels, record_size);
+}
+
+/**
+ * mpu6050_read_new - Read the next sample this file has not seen
+ * @pf: Per-file state
+ * @nonblock: Fail with -EAGAIN instead of waiting
+ * @sample: Pointer to store the sample
+ *
+ * With an interrupt line the IRQ thread fetches every sample and readers
+ * wait for the cache to move on. Without one, DATA_RDY is polled a few
+ * times per output data period so the bus is not read faster than the
+ * sensor produces data.
+ *
+ * Must be called with pf->lock held.
+ *
+ * Returns: 0 on success, negative error code on failure
+ */
+static int mpu6050_read_new(struct mpu6050_file *pf, bool nonblock,
+			    struct mpu6050_sample *sample)
+{
+	struct mpu6050_data *data = pf->data;
+	unsigned long period_us;
+	int ret;
+	
+	while (!mpu6050_latest_sample(data, sample) ||
+	       (s32)(sample->seq - pf->sample_seen) <= 0) {
+		if (READ_ONCE(data->dead))
+			return -ENODEV;
+		
+		if (data->irq) {
+			if (nonblock)
+				return -EAGAIN;
+			
+			ret = wait_event_interruptible(data->wait,
+						       mpu6050_new_ready(pf));
+			if (ret)
+				return ret;
+			continue;
+		}
+		
+		mpu6050_lock(data);
+		ret = mpu6050_poll_sample(data);
+		mutex_unlock(&data->lock);
+		if (ret < 0)
+			return ret;
+		if (ret)
+			continue;
+		
+		if (nonblock)
+			return -EAGAIN;
+		
+		period_us = mpu6050_sample_period_ns(data) / NSEC_PER_USEC;
+		usleep_range(period_us / 4, period_us / 2);
+		if (signal_pending(current))
+			return -ERESTARTSYS;
+	}
+	
+	if (sample->seq - pf->sample_seen > 1)
+		sample->flags |= MPU6050_SAMPLE_FIFO_OVERFLOW;
+	WRITE_ONCE(pf->sample_seen, sample->seq);
+	
+	return 0;
+}
+
+/**
+ * mpu6050_do_read_iter - Read samples, for read(), readv(), aio and io_uring
+ * @iocb: I/O control block
+ * @to: Destination
+ *
+ * Streaming reads copy straight from the ring into @to. With IOCB_NOWAIT
+ * they only fail with -EAGAIN if nothing is buffered or another reader
+ * holds the file, so io_uring completes them inline and falls back to
+ * poll() otherwise. One-shot reads may need the bus and are always
+ * -EAGAIN under IOCB_NOWAIT, which makes io_uring issue them from a
+ * worker that may block.
+ *
+ * Returns: number of bytes read, or negative error code on failure
+ */
+static ssize_t mpu6050_do_read_iter(struct kiocb *iocb, struct iov_iter *to)
+{
+	struct file *file = iocb->ki_filp;
+	struct mpu6050_file *pf = file->private_data;
+	struct mpu6050_data *data = pf->data;
+	bool nowait = iocb->ki_flags & IOCB_NOWAIT;
+	bool nonblock = nowait || (file->f_flags & O_NONBLOCK);
+	size_t count = iov_iter_count(to);
+	struct mpu6050_raw_data raw_data;
+	struct mpu6050_sample sample;
+	u32 channels, record_size;
+	ssize_t ret;
+	
+	if (count < sizeof(struct mpu6050_raw_data))
+		return -EINVAL;
+	
+	if (READ_ONCE(data->streaming)) {
+		/* Streaming reads always wait for the ring, with or without IRQ */
+		do {
+			ret = mpu6050_wait_data(pf, nonblock);
+			if (ret)
+				return ret;
+			
+			if (!nowait)
+				mutex_lock(&pf->lock);
+			else if (!mutex_trylock(&pf->lock))
+				return -EAGAIN;
+			ret = mpu6050_read_records(pf, to, U32_MAX, &channels,
+						   &record_size);
+			mutex_unlock(&pf->lock);
+		} while (ret == -EAGAIN && !nonblock);
+		
+		return ret < 0 ? ret : ret * record_size;
+	}
+	
+	if (nowait)
+		return -EAGAIN;
+	
+	if (READ_ONCE(pf->read_mode) == MPU6050_READ_NEW) {
+		if (count < sizeof(sample))
+			return -EINVAL;
+		
+		mutex_lock(&pf->lock);
+		ret = mpu6050_read_new(pf, nonblock, &sample);
+		mutex_unlock(&pf->lock);
+		if (ret)
+			return ret;
+		
+		if (copy_to_iter(&sample, sizeof(sample), to) != sizeof(sample))
+			return -EFAULT;
+		
+		return sizeof(sample);
+	}
+	
+	ret = mpu6050_wait_data(pf, nonblock);
+	if (ret)
+		return ret;
+	
+	pf->drdy_seen = READ_ONCE(data->drdy_seq);
+	
+	ret = mpu6050_read_sample(data, &raw_data, mpu6050_max_age_ns(pf));
+	if (ret)
+		return ret;
+	
+	if (copy_to_iter(&raw_data, sizeof(raw_data), to) != sizeof(raw_data))
+		return -EFAULT;
+	
+	return sizeof(raw_data);
+}
+
+static ssize_t mpu6050_read_iter(struct kiocb *iocb, struct iov_iter *to)
+{
+	struct mpu6050_file *pf = iocb->ki_filp->private_data;
+	ssize_t ret;
+	
+	ret = mpu6050_ops_enter(pf->data);
+	if (ret)
+		return ret;
+	
+	ret = mpu6050_do_read_iter(iocb, to);
+	mpu6050_ops_exit(pf->data);
+	return ret;
+}
+
+static bool mpu6050_batch_ready(struct mpu6050_file *pf, u32 count)
+{
+	return mpu6050_ring_avail(pf) >= mpu6050_records_needed(pf, count) ||
+	       !READ_ONCE(pf->data->streaming);
+}
+
+/**
+ * mpu6050_wait_batch - Wait for a batch of streaming records
+ * @pf: Per-file state
+ * @count: Number of records wanted
+ * @timeout_ms: Wait limit, 0 for none, negative for unlimited
+ *
+ * Returns: 0 once @count records are buffered, streaming stopped or the
+ * timeout expired, -ENODEV if the device was removed, negative error code
+ * if interrupted
+ */
+static int mpu6050_wait_batch(struct mpu6050_file *pf, u32 count, s32 timeout_ms)
+{
+	struct mpu6050_data *data = pf->data;
+	long ret = 0;
+	
+	if (timeout_ms < 0)
+		ret = wait_event_interruptible(data->wait,
+					       mpu6050_batch_ready(pf, count));
+	else if (timeout_ms)
+		ret = wait_event_interruptible_timeout(data->wait,
+				mpu6050_batch_ready(pf, count),
+				msecs_to_jiffies(timeout_ms));
+	if (ret < 0)
+		return ret;
+	
+	return READ_ONCE(data->dead) ? -ENODEV : 0;
+}
+
+/**
+ * mpu6050_scale_record - Convert a packed ring record to physical units
+ * @rec: Record holding the channels in @channels
+ * @channels: MPU6050_CHAN_* mask of the record
+ * @scale: Fixed-point scale factors
+ * @scaled: Pointer to store scaled data, missing channels are zeroed
+ */
+static void mpu6050_scale_record(const struct mpu6050_record *rec, u32 channels,
+				 const struct mpu6050_scale *scale,
+				 struct mpu6050_scaled_data *scaled)
+{
+	s32 val[MPU6050_NUM_CHANNELS] = { 0 };
+	int i, n = 0;
+	
+	for (i = 0; i < MPU6050_NUM_CHANNELS; i++)
+		if (channels & BIT(i))
+			val[i] = mpu6050_scale_chan(scale, i, rec->data[n++]);
+	
+	scaled->accel_x = val[0];
+	scaled->accel_y = val[1];
+	scaled->accel_z = val[2];
+	scaled->temp = val[3];
+	scaled->gyro_x = val[4];
+	scaled->gyro_y = val[5];
+	scaled->gyro_z = val[6];
+}
+
+/**
+ * mpu6050_read_scaled_batch - Copy unread records to userspace, scaled
+ * @pf: Per-file state
+ * @buf: User array of struct mpu6050_scaled_sample
+ * @count: Capacity of @buf in records
+ *
+ * Records are snapshotted from the ring in chunks and converted in one
+ * pass per chunk with scale factors sampled once for the whole call.
+ *
+ * Must be called with pf->lock held.
+ *
+ * Returns: number of records copied, or negative error code on failure
+ */
+static int mpu6050_read_scaled_batch(struct mpu6050_file *pf,
+				     struct mpu6050_scaled_sample __user *buf,
+				     u32 count)
+{
+	u32 chunk = min_t(u32, count, MPU6050_BATCH_CHUNK);
+	struct mpu6050_scaled_sample *scaled;
+	struct mpu6050_scale scale;
+	u32 done = 0, channels, record_size;
+	u8 *records;
+	struct iov_iter iter;
+	struct kvec kvec;
+	int i, n, ret = 0;
+	
+	if (!chunk)
+		return 0;
+	
+	records = kmalloc_array(chunk, MPU6050_RECORD_MAX_SIZE + sizeof(*scaled),
+				GFP_KERNEL);
+	if (!records)
+		return -ENOMEM;
+	scaled = (struct mpu6050_scaled_sample *)(records +
+						  chunk * MPU6050_RECORD_MAX_SIZE);
+	mpu6050_scale_get(pf->data, &scale);
+	
+	while (done < count) {
+		kvec.iov_base = records;
+		kvec.iov_len = chunk * MPU6050_RECORD_MAX_SIZE;
+		iov_iter_kvec(&iter, READ, &kvec, 1, kvec.iov_len);
+		n = mpu6050_read_records(pf, &iter, min(count - done, chunk),
+					 &channels, &record_size);
+		if (n == -EAGAIN)
+			break;
+		if (n < 0) {
+			ret = n;
+			goto out;
+		}
+		
+		for (i = 0; i < n; i++) {
+			const struct mpu6050_record *rec = (const void *)
+				(records + i * record_size);
+			
+			scaled[i].timestamp = rec->timestamp;
+			scaled[i].seq = rec->seq;
+			scaled[i].flags = rec->flags;
+			scaled[i].reserved = 0;
+			mpu6050_scale_record(rec, channels, &scale,
+					     &scaled[i].scaled);
+		}
+		
+		if (copy_to_user(buf + done, scaled, n * sizeof(*scaled))) {
+			ret = -EFAULT;
+			goto out;
+		}
+		done += n;
+	}
+	
+	ret = done;
+out:
+	kfree(records);
+	return ret;
+}
+
+/**
+ * mpu6050_read_batch - Serve MPU6050_IOC_READ_BATCH and READ_SCALED_BATCH
+ * @pf: Per-file state
+ * @arg: User pointer to struct mpu6050_batch
+ * @scaled: Whether to return struct mpu6050_scaled_sample records
+ *
+ * Returns: 0 on success, negative error code on failure
+ */
+static int mpu6050_read_batch(struct mpu6050_file *pf, void __user *arg,
+			      bool scaled)
+{
+	struct mpu6050_data *data = pf->data;
+	struct mpu6050_batch batch;
+	void __user *buf;
+	u32 channels, record_size;
+	struct iov_iter iter;
+	struct iovec iov;
+	int ret;
+	
+	if (copy_from_user(&batch, arg, sizeof(batch)))
+		return -EFAULT;
+	
+	if (!READ_ONCE(data->streaming))
+		return -EINVAL;
+	
+	buf = u64_to_user_ptr(batch.buf);
+	batch.count = min_t(u32, batch.count, MPU6050_RING_SIZE);
+	
+	ret = mpu6050_wait_batch(pf, batch.count, batch.timeout_ms);
+	if (ret)
+		return ret;
+	
+	if (!scaled && batch.count) {
+		ret = import_single_range(READ, buf, (size_t)batch.count *
+					  READ_ONCE(data->ring_hdr->record_size),
+					  &iov, &iter);
+		if (ret)
+			return ret;
+	}
+	
+	mutex_lock(&pf->lock);
+	if (scaled)
+		ret = mpu6050_read_scaled_batch(pf, buf, batch.count);
+	else if (batch.count)
+		ret = mpu6050_read_records(pf, &iter, batch.count, &channels,
+					   &record_size);
+	else
+		ret = 0;
+	batch.lost = pf->lost;
+	mutex_unlock(&pf->lock);
+	
+	if (ret == -EAGAIN)
+		ret = 0;
+	if (ret < 0)
+		return ret;
+	
+	batch.count = ret;
+	if (copy_to_user(arg, &batch, sizeof(batch)))
+		return -EFAULT;
+	
+	return 0;
+}
+
+/**
+ * mpu6050_bus_byte_ns - Time one byte takes on a sensor's I2C bus
+ * @data: Device data structure
+ *
+ * Nine clock cycles per byte including the acknowledge, at the adapter's
+ * firmware "clock-frequency", or at standard mode when it has none.
+ */
+static u32 mpu6050_bus_byte_ns(struct mpu6050_data *data)
+{
+	struct device *parent = data->client->adapter->dev.parent;
+	u32 hz;
+	
+	if (!parent || device_property_read_u32(parent, "clock-frequency", &hz) ||
+	    !hz)
+		hz = I2C_MAX_STANDARD_MODE_FREQ;
+	
+	return DIV_ROUND_UP_ULL(9ULL * NSEC_PER_SEC, hz);
+}
+
+/**
+ * mpu6050_group_schedule - Size the FIFO transfers of a capture group
+ * @group: Capture group, all member locks held
+ *
+ * A member that needs the bus waits for at most one transfer of every
+ * other member before it gets its turn. Each member drains its FIFO at the
+ * watermark with an interrupt line, or at the poll interval without, and
+ * overflows once the rest of the FIFO has filled up. Transfers are capped
+ * so that the wait for all other members fits into the smallest of those
+ * headrooms; a drain still reads everything that is buffered, just as
+ * several transfers.
+ */
+static void mpu6050_group_schedule(struct mpu6050_group *group)
+{
+	unsigned int capacity, level, i;
+	struct mpu6050_data *data;
+	u64 headroom_ns = U64_MAX;
+	u64 burst;
+	
+	for (i = 0; i < group->count; i++) {
+		data = group->member[i].data;
+		capacity = mpu6050_fifo_capacity(data);
+		level = min(data->fifo_watermark,
+			    data->irq ? capacity : capacity / 2);
+		headroom_ns = min_t(u64, headroom_ns,
+				    (u64)max(capacity - level, 1U) *
+				    mpu6050_sample_period_ns(data));
+	}
+	
+	for (i = 0; i < group->count; i++) {
+		data = group->member[i].data;
+		if (group->count == 1) {
+			data->fifo_burst = 0;
+			continue;
+		}
+		
+		burst = div_u64(headroom_ns, (group->count - 1) *
+				mpu6050_bus_byte_ns(data));
+		data->fifo_burst = clamp_t(u64, burst, I2C_SMBUS_BLOCK_MAX,
+					   MPU6050_FIFO_SIZE);
+		dev_dbg(&data->client->dev, "Group FIFO transfers of %u bytes\n",
+			data->fifo_burst);
+	}
+}
+
+/**
+ * mpu6050_group_set_streaming - Start or stop the FIFOs of a capture group
+ * @group: Capture group
+ * @enable: True to start streaming, false to stop
+ *
+ * All member locks are held for the whole sequence so no FIFO drain gets
+ * in between. Every FIFO is flushed and armed first; the FIFO_EN writes
+ * that start buffering then go out back to back. If any step fails, all
+ * members are stopped again.
+ *
+ * Must be called with the owner's pf->lock held, or from release().
+ *
+ * Returns: 0 on success, negative error code on failure
+ */
+static int mpu6050_group_set_streaming(struct mpu6050_group *group, bool enable)
+{
+	struct mpu6050_group_member *m;
+	struct mpu6050_data *data;
+	ktime_t first = 0, last = 0;
+	unsigned int i;
+	int ret = 0;
+	
+	for (i = 0; i < group->count; i++)
+		mutex_lock_nested(&group->member[i].data->lock, i);
+	
+	for (i = 0; i < group->count; i++) {
+		data = group->member[i].data;
+		if (enable && data->dead) {
+			ret = -ENODEV;
+			goto out;
+		}
+		
+		if (enable && data->cycle) {
+			ret = -EBUSY;
+			goto out;
+		}
+		
+		ret = mpu6050_fifo_stop(data);
+		if (ret)
+			goto out;
+	}
+	
+	if (enable) {
+		mpu6050_group_schedule(group);
+		
+		for (i = 0; i < group->count; i++) {
+			ret = mpu6050_fifo_arm(group->member[i].data);
+			if (ret)
+				goto out;
+		}
+		
+		for (i = 0; i < group->count; i++) {
+			data = group->member[i].data;
+			ret = regmap_write(data->regmap, MPU6050_REG_FIFO_EN,
+					   data->fifo_en);
+			if (ret)
+				goto out;
+			
+			last = ktime_get();
+			if (!i)
+				first = last;
+		}
+		
+		dev_dbg(&group->member[0].data->client->dev,
+			"Group of %u started within %lld ns\n", group->count,
+			ktime_to_ns(ktime_sub(last, first)));
+	}
+	
+out:
+	if (ret) {
+		dev_err(&group->member[0].data->client->dev,
+			"Failed to %s group streaming: %d\n",
+			enable ? "enable" : "disable", ret);
+		enable = false;
+	}
+	
+	for (i = 0; i < group->count; i++) {
+		m = &group->member[i];
+		data = m->data;
+		if (ret)
+			mpu6050_fifo_stop(data);
+		
+		/* The merge starts at the first record of the new layout */
+		m->tail = data->ring_hdr->head;
+		m->staged = 0;
+		m->next = 0;
+		WRITE_ONCE(data->streaming, enable);
+		mpu6050_acq_update(data);
+	}
+	WRITE_ONCE(group->streaming, enable);
+	
+	for (i = group->count; i-- > 0;)
+		mutex_unlock(&group->member[i].data->lock);
+	
+	wake_up_interruptible(&group->wait);
+	return ret;
+}
+
+/**
+ * mpu6050_group_release - Free a capture group once the last user is gone
+ * @ref: Reference count embedded in the group
+ */
+static void mpu6050_group_release(struct kref *ref)
+{
+	struct mpu6050_group *group = container_of(ref, struct mpu6050_group,
+						   ref);
+	unsigned int i;
+	
+	for (i = 0; i < group->count; i++) {
+		if (group->member[i].file)
+			fput(group->member[i].file);
+		kfree(group->member[i].stage);
+	}
+	kfree(group);
+}
+
+/**
+ * mpu6050_group_unclaim - Release the sensors a group has claimed
+ * @group: Capture group, not streaming
+ */
+static void mpu6050_group_unclaim(struct mpu6050_group *group)
+{
+	struct mpu6050_data *data;
+	unsigned int i;
+	
+	for (i = 0; i < group->count; i++) {
+		data = group->member[i].data;
+		if (!data)
+			continue;
+		
+		mutex_lock(&data->lock);
+		if (data->group == group) {
+			data->group = NULL;
+			data->fifo_burst = 0;
+		}
+		mutex_unlock(&data->lock);
+	}
+}
+
+/**
+ * mpu6050_group_detach - Dissolve the capture group a file owns
+ * @pf: Per-file state of the owner, the group must not be streaming
+ *
+ * Readers still waiting on the group keep it alive until they return.
+ *
+ * Must be called with pf->lock held, or from release().
+ */
+static void mpu6050_group_detach(struct mpu6050_file *pf)
+{
+	mpu6050_group_unclaim(pf->group);
+	kref_put(&pf->group->ref, mpu6050_group_release);
+	pf->group = NULL;
+}
+
+/**
+ * mpu6050_set_group - Serve MPU6050_IOC_SET_GROUP
+ * @pf: Per-file state of the owner
+ * @cfg: Group members
+ *
+ * An existing group of the file is dissolved first.
+ *
+ * Returns: 0 on success, negative error code on failure
+ */
+static int mpu6050_set_group(struct mpu6050_file *pf,
+			     const struct mpu6050_group_config *cfg)
+{
+	struct mpu6050_group_member *m;
+	struct mpu6050_group *group;
+	struct file *file;
+	unsigned int i;
+	int ret = 0;
+	
+	if (cfg->count > MPU6050_GROUP_MAX)
+		return -EINVAL;
+	
+	mutex_lock(&pf->lock);
+	
+	if (pf->group && pf->group->streaming) {
+		ret = -EBUSY;
+		goto out;
+	}
+	
+	if (pf->group)
+		mpu6050_group_detach(pf);
+	if (!cfg->count)
+		goto out;
+	
+	group = kzalloc(sizeof(*group), GFP_KERNEL);
+	if (!group) {
+		ret = -ENOMEM;
+		goto out;
+	}
+	kref_init(&group->ref);
+	init_waitqueue_head(&group->wait);
+	
+	for (i = 0; i < cfg->count; i++) {
+		m = &group->member[i];
+		group->count = i + 1;
+		
+		if (i) {
+			file = fget(cfg->fds[i - 1]);
+			if (!file) {
+				ret = -EBADF;
+				goto err;
+			}
+			
+			m->file = file;
+			if (file->f_op != &mpu6050_fops) {
+				ret = -EINVAL;
+				goto err;
+			}
+			m->data = ((struct mpu6050_file *)file->private_data)->data;
+		} else {
+			m->data = pf->data;
+		}
+		
+		m->stage = kmalloc_array(MPU6050_BATCH_CHUNK,
+					 MPU6050_RECORD_MAX_SIZE, GFP_KERNEL);
+		if (!m->stage) {
+			ret = -ENOMEM;
+			goto err;
+		}
+		
+		/* Also catches a sensor listed twice */
+		mutex_lock(&m->data->lock);
+		if (m->data->dead)
+			ret = -ENODEV;
+		else if (m->data->group || m->data->streaming)
+			ret = -EBUSY;
+		else
+			m->data->group = group;
+		mutex_unlock(&m->data->lock);
+		if (ret)
+			goto err;
+	}
+	
+	pf->group = group;
+	goto out;
+	
+err:
+	mpu6050_group_unclaim(group);
+	kref_put(&group->ref, mpu6050_group_release);
+out:
+	mutex_unlock(&pf->lock);
+	return ret;
+}
+
+/**
+ * mpu6050_group_dead - Check whether a group lost a member to removal
+ * @group: Capture group
+ *
+ * Returns: true if the device of any member has been removed
+ */
+static bool mpu6050_group_dead(struct mpu6050_group *group)
+{
+	unsigned int i;
+	
+	for (i = 0; i < group->count; i++)
+		if (READ_ONCE(group->member[i].data->dead))
+			return true;
+	
+	return false;
+}
+
+/**
+ * mpu6050_group_ready - Check whether a group read can complete
+ * @group: Capture group
+ * @count: Number of records wanted
+ *
+ * Called locklessly from the wakeup condition.
+ *
+ * Returns: true once every member has a record to merge and @count are
+ * buffered in total, or when the group stopped streaming or lost a member
+ */
+static bool mpu6050_group_ready(struct mpu6050_group *group, u32 count)
+{
+	struct mpu6050_group_member *m;
+	u32 avail, total = 0;
+	unsigned int i;
+	
+	if (!READ_ONCE(group->streaming) || mpu6050_group_dead(group))
+		return true;
+	
+	for (i = 0; i < group->count; i++) {
+		m = &group->member[i];
+		avail = READ_ONCE(m->staged) - READ_ONCE(m->next) +
+			mpu6050_ring_unread(m->data, READ_ONCE(m->tail));
+		if (!avail)
+			return false;
+		total += avail;
+	}
+	
+	return total >= count;
+}
+
+/**
+ * mpu6050_group_wait - Wait for records of every group member
+ * @group: Capture group
+ * @count: Number of records wanted
+ * @timeout_ms: Wait limit, 0 for none, negative for unlimited
+ * @flush: Out: true if a positive timeout expired
+ *
+ * Returns: 0 once the group is ready or the timeout expired, -ENODEV if a
+ * member was removed, negative error code if interrupted
+ */
+static int mpu6050_group_wait(struct mpu6050_group *group, u32 count,
+			      s32 timeout_ms, bool *flush)
+{
+	long ret;
+	
+	*flush = false;
+	if (!timeout_ms || mpu6050_group_ready(group, count))
+		goto out;
+	
+	if (timeout_ms < 0) {
+		ret = wait_event_interruptible(group->wait,
+					       mpu6050_group_ready(group, count));
+		if (ret)
+			return ret;
+		goto out;
+	}
+	
+	ret = wait_event_interruptible_timeout(group->wait,
+					       mpu6050_group_ready(group, count),
+					       msecs_to_jiffies(timeout_ms));
+	if (ret < 0)
+		return ret;
+	
+	*flush = !ret;
+out:
+	return mpu6050_group_dead(group) ? -ENODEV : 0;
+}
+
+/**
+ * mpu6050_group_fill - Stage a member's next run of ring records
+ * @m: Group member whose stage is used up
+ *
+ * Returns: number of records staged, -EAGAIN if there are none
+ */
+static int mpu6050_group_fill(struct mpu6050_group_member *m)
+{
+	struct kvec kvec = {
+		.iov_base = m->stage,
+		.iov_len = MPU6050_BATCH_CHUNK * MPU6050_RECORD_MAX_SIZE,
+	};
+	struct iov_iter iter;
+	int n;
+	
+	iov_iter_kvec(&iter, READ, &kvec, 1, kvec.iov_len);
+	n = mpu6050_ring_copy_out(m->data, &m->tail, &m->lost, &iter,
+				  MPU6050_BATCH_CHUNK, &m->channels,
+				  &m->record_size);
+	if (n < 0)
+		return n;
+	
+	m->staged = n;
+	m->next = 0;
+	return n;
+}
+
+/**
+ * mpu6050_group_record - Convert a staged record for the merged stream
+ * @rec: Packed ring record
+ * @channels: MPU6050_CHAN_* mask of @rec
+ * @sensor: Index of the member the record comes from
+ * @out: Merged stream record to fill, missing channels are zeroed
+ */
+static void mpu6050_group_record(const struct mpu6050_record *rec,
+				 u32 channels, unsigned int sensor,
+				 struct mpu6050_group_sample *out)
+{
+	int i, n = 0;
+	
+	memset(out, 0, sizeof(*out));
+	out->timestamp = rec->timestamp;
+	out->seq = rec->seq;
+	out->flags = rec->flags;
+	out->sensor = sensor;
+	for (i = 0; i < MPU6050_NUM_CHANNELS; i++)
+		if (channels & BIT(i))
+			mpu6050_raw_chan(&out->raw, i) = rec->data[n++];
+}
+
+/**
+ * mpu6050_group_merge - Interleave member records by timestamp
+ * @group: Capture group
+ * @buf: User array of struct mpu6050_group_sample
+ * @count: Capacity of @buf in records
+ * @flush: Keep merging when members run out of records
+ *
+ * Each step emits the oldest staged record of all members, ties going to
+ * the lower sensor index. Without @flush the merge stops as soon as one
+ * member has nothing staged, since its next record may be older than any
+ * the others hold.
+ *
+ * Must be called with the owner's pf->lock held.
+ *
+ * Returns: number of records copied, or negative error code on failure
+ */
+static int mpu6050_group_merge(struct mpu6050_group *group,
+			       struct mpu6050_group_sample __user *buf,
+			       u32 count, bool flush)
+{
+	const struct mpu6050_record *rec, *oldest;
+	struct mpu6050_group_member *m, *best;
+	struct mpu6050_group_sample *out;
+	unsigned int i, sensor = 0;
+	u32 done = 0, n = 0;
+	bool dry;
+	int ret = 0;
+	
+	if (!count)
+		return 0;
+	
+	out = kmalloc_array(MPU6050_BATCH_CHUNK, sizeof(*out), GFP_KERNEL);
+	if (!out)
+		return -ENOMEM;
+	
+	while (done + n < count) {
+		best = NULL;
+		oldest = NULL;
+		dry = false;
+		
+		for (i = 0; i < group->count; i++) {
+			m = &group->member[i];
+			if (m->next == m->staged)
+				mpu6050_group_fill(m);
+			if (m->next == m->staged) {
+				dry = true;
+				continue;
+			}
+			
+			rec = (const void *)(m->stage + m->next * m->record_size);
+			if (!oldest || rec->timestamp < oldest->timestamp) {
+				best = m;
+				oldest = rec;
+				sensor = i;
+			}
+		}
+		
+		if (!best || (dry && !flush))
+			break;
+		
+		mpu6050_group_record(oldest, best->channels, sensor, &out[n++]);
+		best->next++;
+		
+		if (n == MPU6050_BATCH_CHUNK) {
+			if (copy_to_user(buf + done, out, n * sizeof(*out))) {
+				ret = -EFAULT;
+				goto out;
+			}
+			done += n;
+			n = 0;
+		}
+	}
+	
+	if (copy_to_user(buf + done, out, n * sizeof(*out)))
+		ret = -EFAULT;
+	else
+		ret = done + n;
+out:
+	kfree(out);
+	return ret;
+}
+
+/**
+ * mpu6050_read_group - Serve MPU6050_IOC_READ_GROUP
+ * @pf: Per-file state of the group owner
+ * @arg: User pointer to struct mpu6050_batch
+ *
+ * Returns: 0 on success, negative error code on failure
+ */
+static int mpu6050_read_group(struct mpu6050_file *pf, void __user *arg)
+{
+	struct mpu6050_group *group;
+	struct mpu6050_batch batch;
+	unsigned int i;
+	bool flush;
+	int ret;
+	
+	if (copy_from_user(&batch, arg, sizeof(batch)))
+		return -EFAULT;
+	
+	/* The reference keeps the group around while waiting unlocked */
+	mutex_lock(&pf->lock);
+	group = pf->group;
+	if (group && group->streaming)
+		kref_get(&group->ref);
+	else
+		group = NULL;
+	mutex_unlock(&pf->lock);
+	
+	if (!group)
+		return -EINVAL;
+	
+	batch.count = min_t(u32, batch.count, MPU6050_RING_SIZE);
+	ret = mpu6050_group_wait(group, batch.count, batch.timeout_ms, &flush);
+	if (ret)
+		goto out;
+	
+	mutex_lock(&pf->lock);
+	if (pf->group == group)
+		ret = mpu6050_group_merge(group, u64_to_user_ptr(batch.buf),
+					  batch.count, flush);
+	else
+		ret = -EINVAL;
+	batch.lost = 0;
+	for (i = 0; i < group->count; i++)
+		batch.lost += group->member[i].lost;
+	mutex_unlock(&pf->lock);
+	
+	if (ret < 0)
+		goto out;
+	
+	batch.count = ret;
+	ret = copy_to_user(arg, &batch, sizeof(batch)) ? -EFAULT : 0;
+out:
+	kref_put(&group->ref, mpu6050_group_release);
+	return ret;
+}
+
+static __poll_t mpu6050_poll(struct file *file, poll_table *wait)
+{
+	struct mpu6050_file *pf = file->private_data;
+	struct mpu6050_data *data = pf->data;
+	
+	poll_wait(file, &data->wait, wait);
+	
+	if (READ_ONCE(data->dead))
+		return EPOLLERR | EPOLLHUP;
+	
+	if (!mpu6050_data_ready(pf))
+		return 0;
+	
+	/* Mapped consumers track their own position; report each batch once */
+	if (READ_ONCE(pf->mapped) && READ_ONCE(data->streaming)) {
+		mutex_lock(&pf->lock);
+		pf->ring_tail = smp_load_acquire(&data->ring_hdr->head);
+		mutex_unlock(&pf->lock);
+	}
+	
+	return EPOLLIN | EPOLLRDNORM;
+}
+
+/**
+ * mpu6050_mmap - Map the sample ring read-only into userspace
+ * @file: File being mapped
+ * @vma: Target mapping, must start at offset 0
+ *
+ * The layout and the lockless consumer protocol are described next to
+ * struct mpu6050_ring_header. Pages stay valid for the lifetime of the
+ * mapping even if the device goes away, they just stop being updated.
+ *
+ * Returns: 0 on success, negative error code on failure
+ */
+static int mpu6050_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct mpu6050_file *pf = file->private_data;
+	struct mpu6050_data *data = pf->data;
+	int ret;
+	
+	if (READ_ONCE(data->dead))
+		return -ENODEV;
+	
+	if (vma->vm_pgoff || vma->vm_end - vma->vm_start > data->ring_bytes)
+		return -EINVAL;
+	
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+	vma->vm_flags &= ~VM_MAYWRITE;
+	
+	ret = remap_vmalloc_range(vma, data->ring_hdr, 0);
+	if (ret)
+		return ret;
+	
+	WRITE_ONCE(pf->mapped, true);
+	return 0;
+}
+
+/**
+ * mpu6050_set_decimation - Configure a file's decimation filter
+ * @pf: Per-file state
+ * @cfg: New configuration
+ *
+ * Any accumulated filter state is dropped; the next output needs a full
+ * block of new input.
+ *
+ * Returns: 0 on success, -EINVAL for an invalid configuration
+ */
+static int mpu6050_set_decimation(struct mpu6050_file *pf,
+				  const struct mpu6050_decimation *cfg)
+{
+	struct mpu6050_decim *dec = &pf->decim;
+	u16 order;
+	
+	if (!cfg->factor || cfg->factor > MPU6050_DECIM_MAX_FACTOR ||
+	    cfg->reserved[0] || cfg->reserved[1])
+		return -EINVAL;
+	
+	switch (cfg->filter) {
+	case MPU6050_DECIM_BOXCAR:
+		order = 1;
+		break;
+	case MPU6050_DECIM_CIC:
+		if (!cfg->order || cfg->order > MPU6050_DECIM_MAX_ORDER)
+			return -EINVAL;
+		order = cfg->order;
+		break;
+	default:
+		return -EINVAL;
+	}
+	
+	mutex_lock(&pf->lock);
+	dec->filter = cfg->filter;
+	dec->order = order;
+	dec->channels = 0;
+	dec->record_size = 0;
+	dec->lost = pf->lost;
+	mpu6050_decim_reset(dec);
+	WRITE_ONCE(dec->factor, cfg->factor);
+	mutex_unlock(&pf->lock);
+	
+	return 0;
+}
+
+static long mpu6050_do_ioctl(struct file *file, unsigned int cmd,
+			     unsigned long arg)
+{
+	struct mpu6050_file *pf = file->private_data;
+	struct mpu6050_data *data = pf->data;
+	int ret = 0;
+	
+	if (_IOC_TYPE(cmd) != MPU6050_IOC_MAGIC)
+		return -ENOTTY;
+	
+	if (_IOC_NR(cmd) > MPU6050_IOC_MAXNR)
+		return -ENOTTY;
+	
+	switch (cmd) {
+	case MPU6050_IOC_READ_RAW: {
+		struct mpu6050_raw_data raw_data;
+		
+		ret = mpu6050_read_sample(data, &raw_data, mpu6050_max_age_ns(pf));
+		if (ret)
+			return ret;
+		
+		if (copy_to_user((void __user *)arg, &raw_data, sizeof(raw_data)))
+			return -EFAULT;
+		break;
+	}
+	
+	case MPU6050_IOC_READ_SCALED: {
+		struct mpu6050_scaled_data scaled_data;
+		struct mpu6050_raw_data raw_data;
+		struct mpu6050_scale scale;
+		
+		ret = mpu6050_read_sample(data, &raw_data, mpu6050_max_age_ns(pf));
+		if (ret)
+			return ret;
+		
+		mpu6050_scale_get(data, &scale);
+		mpu6050_scale_raw(&raw_data, &scale, &scaled_data);
+		
+		if (copy_to_user((void __user *)arg, &scaled_data, sizeof(scaled_data)))
+			return -EFAULT;
+		break;
+	}
+	
+	case MPU6050_IOC_SET_CONFIG: {
+		struct mpu6050_config config;
+		
+		if (copy_from_user(&config, (void __user *)arg, sizeof(config)))
+			return -EFAULT;
+		
+		ret = mpu6050_set_config(data, &config);
+		break;
+	}
+	
+	case MPU6050_IOC_GET_CONFIG: {
+		if (copy_to_user((void __user *)arg, &data->config,
+				 sizeof(data->config)))
+			return -EFAULT;
+		break;
+	}
+	
+	case MPU6050_IOC_RESET:
+		ret = mpu6050_reset_device(data);
+		break;
+	
+	case MPU6050_IOC_WHO_AM_I: {
+		unsigned int val;
+		
+		mutex_lock(&data->lock);
+		ret = regmap_read(data->regmap, MPU6050_REG_WHO_AM_I, &val);
+		mutex_unlock(&data->lock);
+		
+		if (ret)
+			return ret;
+		
+		if (copy_to_user((void __user *)arg, &val, sizeof(u8)))
+			return -EFAULT;
+		break;
+	}
+	
+	case MPU6050_IOC_SET_STREAMING: {
+		int enable;
+		
+		if (copy_from_user(&enable, (void __user *)arg, sizeof(enable)))
+			return -EFAULT;
+		
+		ret = mpu6050_set_streaming(data, enable != 0);
+		break;
+	}
+	
+	case MPU6050_IOC_SET_WATERMARK: {
+		u32 watermark;
+		
+		if (copy_from_user(&watermark, (void __user *)arg, sizeof(watermark)))
+			return -EFAULT;
+		
+		if (watermark < 1 || watermark > MPU6050_FIFO_MAX_FRAMES)
+			return -EINVAL;
+		
+		mutex_lock(&data->lock);
+		data->fifo_watermark = watermark;
+		mpu6050_acq_update(data);
+		mutex_unlock(&data->lock);
+		break;
+	}
+	
+	case MPU6050_IOC_GET_LOST:
+		if (copy_to_user((void __user *)arg, &pf->lost, sizeof(pf->lost)))
+			return -EFAULT;
+		break;
+	
+	case MPU6050_IOC_SET_STALENESS: {
+		u32 max_age_us;
+		
+		if (copy_from_user(&max_age_us, (void __user *)arg, sizeof(max_age_us)))
+			return -EFAULT;
+		
+		if (max_age_us > U32_MAX / NSEC_PER_USEC)
+			return -EINVAL;
+		
+		WRITE_ONCE(pf->max_age_ns, max_age_us * NSEC_PER_USEC);
+		break;
+	}
+	
+	case MPU6050_IOC_SET_READ_MODE: {
+		u32 mode;
+		
+		if (copy_from_user(&mode, (void __user *)arg, sizeof(mode)))
+			return -EFAULT;
+		
+		if (mode > MPU6050_READ_NEW)
+			return -EINVAL;
+		
+		/* Samples from before the switch count as seen */
+		mutex_lock(&pf->lock);
+		if (mode != pf->read_mode)
+			WRITE_ONCE(pf->sample_seen, READ_ONCE(data->sample_seq));
+		WRITE_ONCE(pf->read_mode, mode);
+		mutex_unlock(&pf->lock);
+		break;
 	}
 	
-	file->private_data = data;
-	return nonseekable_open(inode, file);
-}
-
-static int mpu6050_release(struct inode *inode, struct file *file)
-{
-	return 0;
-}
-
-static ssize_t mpu6050_read(struct file *file, char __user *buf,
-			    size_t count, loff_t *ppos)
-{
-	struct mpu6050_data *data = file->private_data;
-	struct mpu6050_raw_data raw_data;
-	int ret;
-	
-	if (count < sizeof(struct mpu6050_raw_data))
-		return -EINVAL;
+	case MPU6050_IOC_SET_CALIBRATION: {
+		struct mpu6050_calibration calib;
+		
+		if (copy_from_user(&calib, (void __user *)arg, sizeof(calib)))
+			return -EFAULT;
+		
+		ret = mpu6050_set_calibration(data, &calib);
+		break;
+	}
 	
-	ret = mpu6050_read_raw_data(data, &raw_data);
-	if (ret)
-		return ret;
+	case MPU6050_IOC_GET_CALIBRATION: {
+		struct mpu6050_calibration calib;
+		
+		mutex_lock(&data->lock);
+		calib = data->calib;
+		mutex_unlock(&data->lock);
+		
+		if (copy_to_user((void __user *)arg, &calib, sizeof(calib)))
+			return -EFAULT;
+		break;
+	}
 	
-	if (copy_to_user(buf, &raw_data, sizeof(raw_data)))
-		return -EFAULT;
+	case MPU6050_IOC_SET_CYCLE: {
+		u32 cycle;
+		
+		if (copy_from_user(&cycle, (void __user *)arg, sizeof(cycle)))
+			return -EFAULT;
+		
+		ret = mpu6050_set_cycle(data, cycle);
+		break;
+	}
 	
-	return sizeof(raw_data);
-}
-
-static long mpu6050_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
-{
-	struct mpu6050_data *data = file->private_data;
-	int ret = 0;
+	case MPU6050_IOC_SET_CHANNELS: {
+		u32 channels;
+		
+		if (copy_from_user(&channels, (void __user *)arg, sizeof(channels)))
+			return -EFAULT;
+		
+		ret = mpu6050_set_channels(data, channels);
+		break;
+	}
 	
-	if (_IOC_TYPE(cmd) != MPU6050_IOC_MAGIC)
-		return -ENOTTY;
+	case MPU6050_IOC_GET_CHANNELS: {
+		u32 channels = READ_ONCE(data->channels);
+		
+		if (copy_to_user((void __user *)arg, &channels, sizeof(channels)))
+			return -EFAULT;
+		break;
+	}
 	
-	if (_IOC_NR(cmd) > MPU6050_IOC_MAXNR)
-		return -ENOTTY;
+	case MPU6050_IOC_SET_AUX: {
+		struct mpu6050_aux_config aux;
+		
+		if (copy_from_user(&aux, (void __user *)arg, sizeof(aux)))
+			return -EFAULT;
+		
+		ret = mpu6050_set_aux(data, &aux);
+		break;
+	}
 	
-	switch (cmd) {
-	case MPU6050_IOC_READ_RAW: {
-		struct mpu6050_raw_data raw_data;
+	case MPU6050_IOC_GET_AUX: {
+		struct mpu6050_aux_config aux;
 		
-		ret = mpu6050_read_raw_data(data, &raw_data);
-		if (ret)
-			return ret;
+		mutex_lock(&data->lock);
+		aux = data->aux;
+		mutex_unlock(&data->lock);
 		
-		if (copy_to_user((void __user *)arg, &raw_data, sizeof(raw_data)))
+		if (copy_to_user((void __user *)arg, &aux, sizeof(aux)))
 			return -EFAULT;
 		break;
 	}
 	
-	case MPU6050_IOC_READ_SCALED: {
-		struct mpu6050_scaled_data scaled_data;
+	case MPU6050_IOC_READ_EXT: {
+		struct mpu6050_ext_data ext;
 		
-		ret = mpu6050_read_scaled_data(data, &scaled_data);
+		ret = mpu6050_read_ext_data(data, &ext);
 		if (ret)
 			return ret;
 		
-		if (copy_to_user((void __user *)arg, &scaled_data, sizeof(scaled_data)))
+		if (copy_to_user((void __user *)arg, &ext, sizeof(ext)))
 			return -EFAULT;
 		break;
 	}
 	
-	case MPU6050_IOC_SET_CONFIG: {
-		struct mpu6050_config config;
+	case MPU6050_IOC_SET_DECIMATION: {
+		struct mpu6050_decimation cfg;
 		
-		if (copy_from_user(&config, (void __user *)arg, sizeof(config)))
+		if (copy_from_user(&cfg, (void __user *)arg, sizeof(cfg)))
 			return -EFAULT;
 		
-		ret = mpu6050_set_config(data, &config);
+		ret = mpu6050_set_decimation(pf, &cfg);
 		break;
 	}
 	
-	case MPU6050_IOC_GET_CONFIG: {
-		if (copy_to_user((void __user *)arg, &data->config,
-				 sizeof(data->config)))
+	case MPU6050_IOC_GET_DECIMATION: {
+		struct mpu6050_decimation cfg = { };
+		
+		mutex_lock(&pf->lock);
+		cfg.factor = pf->decim.factor;
+		cfg.filter = pf->decim.filter;
+		cfg.order = pf->decim.order;
+		mutex_unlock(&pf->lock);
+		
+		if (copy_to_user((void __user *)arg, &cfg, sizeof(cfg)))
 			return -EFAULT;
 		break;
 	}
 	
-	case MPU6050_IOC_RESET:
-		ret = mpu6050_reset(data);
+	case MPU6050_IOC_READ_BATCH:
+		ret = mpu6050_read_batch(pf, (void __user *)arg, false);
 		break;
 	
-	case MPU6050_IOC_WHO_AM_I: {
-		unsigned int val;
+	case MPU6050_IOC_READ_SCALED_BATCH:
+		ret = mpu6050_read_batch(pf, (void __user *)arg, true);
+		break;
+	
+	case MPU6050_IOC_SET_GROUP: {
+		struct mpu6050_group_config cfg;
 		
-		mutex_lock(&data->lock);
-		ret = regmap_read(data->regmap, MPU6050_REG_WHO_AM_I, &val);
-		mutex_unlock(&data->lock);
+		if (copy_from_user(&cfg, (void __user *)arg, sizeof(cfg)))
+			return -EFAULT;
 		
-		if (ret)
-			return ret;
+		ret = mpu6050_set_group(pf, &cfg);
+		break;
+	}
+	
+	case MPU6050_IOC_SET_GROUP_STREAMING: {
+		int enable;
 		
-		if (copy_to_user((void __user *)arg, &val, sizeof(u8)))
+		if (copy_from_user(&enable, (void __user *)arg, sizeof(enable)))
 			return -EFAULT;
+		
+		mutex_lock(&pf->lock);
+		if (pf->group)
+			ret = mpu6050_group_set_streaming(pf->group, enable != 0);
+		else
+			ret = -EINVAL;
+		mutex_unlock(&pf->lock);
 		break;
 	}
 	
+	case MPU6050_IOC_READ_GROUP:
+		ret = mpu6050_read_group(pf, (void __user *)arg);
+		break;
+	
 	default:
 		return -ENOTTY;
 	}
@@ -446,80 +3005,106 @@ static long mpu6050_ioctl(struct file *file, unsigned int cmd, unsigned long arg
 	return ret;
 }
 
+static long mpu6050_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
+{
+	struct mpu6050_file *pf = file->private_data;
+	long ret;
+	
+	ret = mpu6050_ops_enter(pf->data);
+	if (ret)
+		return ret;
+	
+	ret = mpu6050_do_ioctl(file, cmd, arg);
+	mpu6050_ops_exit(pf->data);
+	return ret;
+}
+
 static const struct file_operations mpu6050_fops = {
 	.owner = THIS_MODULE,
 	.open = mpu6050_open,
 	.release = mpu6050_release,
-	.read = mpu6050_read,
+	.read_iter = mpu6050_read_iter,
+	.poll = mpu6050_poll,
+	.mmap = mpu6050_mmap,
 	.unlocked_ioctl = mpu6050_ioctl,
 	.llseek = no_llseek,
 };
 
 /**
- * mpu6050_create_cdev - Create character device
+ * mpu6050_create_cdev - Create the character device for one sensor
  * @data: Device data structure
  *
+ * Each probed sensor gets its own minor. The node is named after the
+ * firmware "label" property when present. Otherwise the first sensor keeps
+ * the historical /dev/mpu6050 name and later ones become /dev/mpu6050-N.
+ *
  * Returns: 0 on success, negative error code on failure
  */
 static int mpu6050_create_cdev(struct mpu6050_data *data)
 {
-	int ret;
-	
-	/* Allocate character device number */
-	if (mpu6050_major == 0) {
-		ret = alloc_chrdev_region(&data->devt, 0, 1, DRIVER_NAME);
-		if (ret) {
-			dev_err(&data->client->dev, "Failed to allocate char dev region: %d\n", ret);
-			return ret;
-		}
-		mpu6050_major = MAJOR(data->devt);
-	} else {
-		data->devt = MKDEV(mpu6050_major, 0);
-		ret = register_chrdev_region(data->devt, 1, DRIVER_NAME);
-		if (ret) {
-			dev_err(&data->client->dev, "Failed to register char dev region: %d\n", ret);
-			return ret;
-		}
+	struct device *dev = &data->client->dev;
+	const char *label;
+	int minor, ret;
+	
+	mutex_lock(&mpu6050_minor_lock);
+	minor = idr_alloc(&mpu6050_minor_idr, data, 0, MPU6050_MAX_DEVICES,
+			  GFP_KERNEL);
+	mutex_unlock(&mpu6050_minor_lock);
+	if (minor < 0) {
+		dev_err(dev, "No free minor numbers: %d\n", minor);
+		return minor;
 	}
+	data->devt = MKDEV(MAJOR(mpu6050_devt), minor);
+	
+	/*
+	 * The cdev is refcounted on its own: open files drop their reference
+	 * only after release(), which may have freed the device data.
+	 */
+	data->cdev = cdev_alloc();
+	if (!data->cdev) {
+		ret = -ENOMEM;
+		goto err_cdev_alloc;
+	}
+	data->cdev->ops = &mpu6050_fops;
+	data->cdev->owner = THIS_MODULE;
 	
-	/* Initialize and add character device */
-	cdev_init(&data->cdev, &mpu6050_fops);
-	data->cdev.owner = THIS_MODULE;
-	
-	ret = cdev_add(&data->cdev, data->devt, 1);
+	ret = cdev_add(data->cdev, data->devt, 1);
 	if (ret) {
-		dev_err(&data->client->dev, "Failed to add char dev: %d\n", ret);
+		dev_err(dev, "Failed to add char dev: %d\n", ret);
 		goto err_cdev_add;
 	}
 	
-	/* Create device class */
-	data->class = class_create(THIS_MODULE, DRIVER_NAME);
-	if (IS_ERR(data->class)) {
-		ret = PTR_ERR(data->class);
-		dev_err(&data->client->dev, "Failed to create device class: %d\n", ret);
-		goto err_class_create;
-	}
-	
 	/* Create device node */
-	data->device = device_create(data->class, &data->client->dev,
-				     data->devt, data, DRIVER_NAME);
+	if (!device_property_read_string(dev, "label", &label))
+		data->device = device_create(mpu6050_class, dev, data->devt,
+					     data, "%s", label);
+	else if (minor == 0)
+		data->device = device_create(mpu6050_class, dev, data->devt,
+					     data, DRIVER_NAME);
+	else
+		data->device = device_create(mpu6050_class, dev, data->devt,
+					     data, DRIVER_NAME "-%d", minor);
 	if (IS_ERR(data->device)) {
 		ret = PTR_ERR(data->device);
-		dev_err(&data->client->dev, "Failed to create device: %d\n", ret);
+		dev_err(dev, "Failed to create device: %d\n", ret);
 		goto err_device_create;
 	}
 	
-	dev_info(&data->client->dev, "Character device created: /dev/%s (major: %d)\n",
-		 DRIVER_NAME, mpu6050_major);
+	dev_info(dev, "Character device created: /dev/%s (%d:%d)\n",
+		 dev_name(data->device), MAJOR(data->devt), minor);
 	
 	return 0;
 	
 err_device_create:
-	class_destroy(data->class);
-err_class_create:
-	cdev_del(&data->cdev);
+	data->device = NULL;
 err_cdev_add:
-	unregister_chrdev_region(data->devt, 1);
+	cdev_del(data->cdev);
+err_cdev_alloc:
+	data->cdev = NULL;
+	mutex_lock(&mpu6050_minor_lock);
+	idr_remove(&mpu6050_minor_idr, minor);
+	mutex_unlock(&mpu6050_minor_lock);
+	data->devt = 0;
 	return ret;
 }
 
@@ -530,21 +3115,139 @@ err_cdev_add:
 static void mpu6050_destroy_cdev(struct mpu6050_data *data)
 {
 	if (data->device) {
-		device_destroy(data->class, data->devt);
+		device_destroy(mpu6050_class, data->devt);
 		data->device = NULL;
 	}
 	
-	if (data->class) {
-		class_destroy(data->class);
-		data->class = NULL;
+	/* The minor stays taken until the last open file is closed */
+	cdev_del(data->cdev);
+}
+
+/* Debugfs statistics */
+
+static int mpu6050_stats_show(struct seq_file *s, void *unused)
+{
+	struct mpu6050_data *data = s->private;
+	struct mpu6050_stats sum = { 0 };
+	int cpu, i;
+	
+	for_each_possible_cpu(cpu) {
+		const struct mpu6050_stats *st = per_cpu_ptr(data->stats, cpu);
+		
+		sum.bus_ops += st->bus_ops;
+		sum.bus_errors += st->bus_errors;
+		for (i = 0; i < MPU6050_LAT_BUCKETS; i++)
+			sum.bus_latency[i] += st->bus_latency[i];
+		sum.lock_waits += st->lock_waits;
+		sum.lock_wait_ns += st->lock_wait_ns;
 	}
 	
-	cdev_del(&data->cdev);
-	unregister_chrdev_region(data->devt, 1);
+	seq_printf(s, "bus_ops: %llu\n", sum.bus_ops);
+	seq_printf(s, "bus_errors: %llu\n", sum.bus_errors);
+	seq_printf(s, "fifo_overflows: %u\n",
+		   READ_ONCE(data->ring_hdr->fifo_overflows));
+	seq_printf(s, "lock_waits: %llu\n", sum.lock_waits);
+	seq_printf(s, "lock_wait_ns: %llu\n", sum.lock_wait_ns);
+	
+	seq_puts(s, "bus_latency_us:\n");
+	for (i = 0; i < MPU6050_LAT_BUCKETS - 1; i++)
+		seq_printf(s, "  <%u: %llu\n", 1U << i, sum.bus_latency[i]);
+	seq_printf(s, "  >=%u: %llu\n", 1U << (MPU6050_LAT_BUCKETS - 2),
+		   sum.bus_latency[MPU6050_LAT_BUCKETS - 1]);
+	
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(mpu6050_stats);
+
+static int mpu6050_readers_show(struct seq_file *s, void *unused)
+{
+	struct mpu6050_data *data = s->private;
+	struct mpu6050_file *pf;
+	
+	seq_puts(s, "pid\tcomm\tlost\tdecim\n");
+	
+	mutex_lock(&data->lock);
+	list_for_each_entry(pf, &data->files, node)
+		seq_printf(s, "%d\t%s\t%llu\t%u\n", pf->pid, pf->comm,
+			   READ_ONCE(pf->lost), READ_ONCE(pf->decim.factor));
+	mutex_unlock(&data->lock);
+	
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(mpu6050_readers);
+
+static void mpu6050_debugfs_remove(void *arg)
+{
+	struct mpu6050_data *data = arg;
+	
+	debugfs_remove_recursive(data->debugfs);
+}
+
+/**
+ * mpu6050_debugfs_init - Create the per-device debugfs directory
+ * @data: Device data structure
+ *
+ * Debugfs failures are not fatal; the files simply won't be there.
+ *
+ * Returns: 0 on success, negative error code on failure
+ */
+static int mpu6050_debugfs_init(struct mpu6050_data *data)
+{
+	data->debugfs = debugfs_create_dir(dev_name(&data->client->dev),
+					   mpu6050_debugfs_root);
+	debugfs_create_file("stats", 0444, data->debugfs, data,
+			    &mpu6050_stats_fops);
+	debugfs_create_file("readers", 0444, data->debugfs, data,
+			    &mpu6050_readers_fops);
+	
+	return devm_add_action_or_reset(&data->client->dev,
+					mpu6050_debugfs_remove, data);
 }
 
 /* I2C driver functions */
 
+/**
+ * mpu6050_alloc_ring - Allocate the mappable sample ring
+ * @data: Device data structure
+ *
+ * Returns: 0 on success, negative error code on failure
+ */
+static int mpu6050_alloc_ring(struct mpu6050_data *data)
+{
+	struct mpu6050_ring_header *hdr;
+	
+	BUILD_BUG_ON(sizeof(*hdr) > PAGE_SIZE);
+	BUILD_BUG_ON(!is_power_of_2(MPU6050_RING_SIZE));
+	BUILD_BUG_ON(MPU6050_RECORD_SIZE(MPU6050_NUM_CHANNELS) !=
+		     sizeof(struct mpu6050_sample));
+	
+	data->ring_bytes = PAGE_SIZE +
+		PAGE_ALIGN(MPU6050_RING_SIZE * MPU6050_RECORD_MAX_SIZE);
+	
+	/* vmalloc_user() returns zeroed memory suitable for remapping */
+	hdr = vmalloc_user(data->ring_bytes);
+	if (!hdr)
+		return -ENOMEM;
+	
+	hdr->magic = MPU6050_RING_MAGIC;
+	hdr->version = MPU6050_RING_VERSION;
+	hdr->nr_records = MPU6050_RING_SIZE;
+	hdr->record_size = MPU6050_RECORD_SIZE(MPU6050_NUM_CHANNELS);
+	hdr->data_offset = PAGE_SIZE;
+	hdr->channels = MPU6050_CHAN_ALL;
+	
+	data->ring_hdr = hdr;
+	data->ring = (u8 *)hdr + PAGE_SIZE;
+	
+	return 0;
+}
+
+/* Drops the reference the bound device holds, see mpu6050_data_put() */
+static void mpu6050_data_put_action(void *arg)
+{
+	mpu6050_data_put(arg);
+}
+
 static int mpu6050_probe(struct i2c_client *client,
 			 const struct i2c_device_id *id)
 {
@@ -560,16 +3263,56 @@ static int mpu6050_probe(struct i2c_client *client,
 		return -EOPNOTSUPP;
 	}
 	
-	/* Allocate device data structure */
-	data = devm_kzalloc(&client->dev, sizeof(*data), GFP_KERNEL);
+	/*
+	 * Allocate device data structure. Open files keep it, and everything
+	 * they use, past remove(); it is freed by mpu6050_data_release().
+	 */
+	data = kzalloc(sizeof(*data), GFP_KERNEL);
 	if (!data)
 		return -ENOMEM;
 	
+	kref_init(&data->kref);
 	data->client = client;
 	mutex_init(&data->lock);
+	seqlock_init(&data->latest_lock);
+	seqlock_init(&data->scale_lock);
+	init_waitqueue_head(&data->wait);
+	INIT_LIST_HEAD(&data->files);
+	init_rwsem(&data->ops_sem);
+	data->fifo_watermark = 1;
+	
+	/* Added first so it runs last, after the IRQ and the rest are gone */
+	ret = devm_add_action_or_reset(&client->dev, mpu6050_data_put_action,
+				       data);
+	if (ret)
+		return ret;
 	
-	/* Initialize regmap for I2C communication */
-	data->regmap = devm_regmap_init_i2c(client, &mpu6050_regmap_config);
+	data->stats = alloc_percpu(struct mpu6050_stats);
+	if (!data->stats)
+		return -ENOMEM;
+	
+	/* Allocate FIFO buffers for streaming mode */
+	data->fifo_buf = kmalloc(MPU6050_FIFO_SIZE, GFP_KERNEL);
+	data->fifo_samples = kcalloc(MPU6050_FIFO_MAX_FRAMES,
+				     sizeof(*data->fifo_samples), GFP_KERNEL);
+	if (!data->fifo_buf || !data->fifo_samples)
+		return -ENOMEM;
+	
+	ret = mpu6050_alloc_ring(data);
+	if (ret)
+		return ret;
+	
+	/* Drain the FIFO in large reads unless the adapter only speaks SMBus */
+	data->fifo_i2c = i2c_check_functionality(client->adapter, I2C_FUNC_I2C);
+	if (!data->fifo_i2c)
+		dev_info(&client->dev, "SMBus-only adapter, FIFO reads are chunked\n");
+	
+	INIT_DELAYED_WORK(&data->poll_work, mpu6050_poll_work);
+	
+	/* Initialize regmap for I2C communication, or for the virtual sensor */
+	data->regmap = mpu6050_virt_regmap_init(client, &mpu6050_regmap_config);
+	if (!data->regmap)
+		data->regmap = devm_regmap_init_i2c(client, &mpu6050_regmap_config);
 	if (IS_ERR(data->regmap)) {
 		ret = PTR_ERR(data->regmap);
 		dev_err(&client->dev, "Failed to initialize regmap: %d\n", ret);
@@ -579,6 +3322,10 @@ static int mpu6050_probe(struct i2c_client *client,
 	/* Set client data */
 	i2c_set_clientdata(client, data);
 	
+	ret = mpu6050_debugfs_init(data);
+	if (ret)
+		return ret;
+	
 	/* Initialize the MPU-6050 device */
 	ret = mpu6050_init_device(data);
 	if (ret) {
@@ -586,14 +3333,32 @@ static int mpu6050_probe(struct i2c_client *client,
 		return ret;
 	}
 	
-	/* Create character device (only for first instance) */
-	if (!mpu6050_dev_data) {
-		ret = mpu6050_create_cdev(data);
-		if (ret) {
-			dev_err(&client->dev, "Failed to create character device: %d\n", ret);
+	/* The interrupt is optional; without it reads never block */
+	if (client->irq > 0) {
+		ret = mpu6050_setup_irq(data);
+		if (ret)
 			return ret;
-		}
-		mpu6050_dev_data = data;
+	}
+	
+	/* Sleep whenever nobody is reading, from here on */
+	pm_runtime_set_active(&client->dev);
+	pm_runtime_set_autosuspend_delay(&client->dev, MPU6050_AUTOSUSPEND_MS);
+	pm_runtime_use_autosuspend(&client->dev);
+	ret = devm_pm_runtime_enable(&client->dev);
+	if (ret)
+		return ret;
+	pm_runtime_mark_last_busy(&client->dev);
+	pm_runtime_idle(&client->dev);
+	
+	ret = mpu6050_iio_probe(data);
+	if (ret)
+		return ret;
+	
+	/* Create this sensor's character device */
+	ret = mpu6050_create_cdev(data);
+	if (ret) {
+		dev_err(&client->dev, "Failed to create character device: %d\n", ret);
+		return ret;
 	}
 	
 	dev_info(&client->dev, "MPU-6050 probe completed successfully\n");
@@ -606,16 +3371,95 @@ static int mpu6050_remove(struct i2c_client *client)
 	
 	dev_info(&client->dev, "Removing MPU-6050 driver\n");
 	
-	/* Destroy character device if this is the main instance */
-	if (data == mpu6050_dev_data) {
-		mpu6050_destroy_cdev(data);
-		mpu6050_dev_data = NULL;
-		mpu6050_major = 0;
+	/*
+	 * Open files stay around. Stop what they have started and mark the
+	 * device dead in one go, so that none of them can start it again.
+	 */
+	mutex_lock(&data->lock);
+	if (data->streaming)
+		mpu6050_fifo_stop(data);
+	WRITE_ONCE(data->streaming, false);
+	if (data->users)
+		mpu6050_acq_stop(data);
+	WRITE_ONCE(data->dead, true);
+	if (data->group)
+		wake_up_interruptible_all(&data->group->wait);
+	mutex_unlock(&data->lock);
+	
+	wake_up_interruptible_all(&data->wait);
+	
+	/* Let operations that got in before return; later ones see dead */
+	down_write(&data->ops_sem);
+	up_write(&data->ops_sem);
+	
+	cancel_delayed_work_sync(&data->poll_work);
+	
+	mpu6050_destroy_cdev(data);
+	
+	return 0;
+}
+
+/**
+ * mpu6050_runtime_suspend - Put the sensor to sleep
+ * @dev: I2C client device
+ *
+ * SLEEP keeps every register, so the register cache stays valid. Writes
+ * while asleep only go to the cache and reach the part on resume.
+ *
+ * Returns: 0 on success, negative error code on failure
+ */
+static int __maybe_unused mpu6050_runtime_suspend(struct device *dev)
+{
+	struct mpu6050_data *data = i2c_get_clientdata(to_i2c_client(dev));
+	int ret;
+	
+	ret = regmap_update_bits(data->regmap, MPU6050_REG_PWR_MGMT_1,
+				 MPU6050_PWR1_SLEEP, MPU6050_PWR1_SLEEP);
+	if (ret) {
+		dev_err(dev, "Failed to enter sleep mode: %d\n", ret);
+		return ret;
 	}
 	
+	regcache_cache_only(data->regmap, true);
+	mpu6050_latest_invalidate(data);
 	return 0;
 }
 
+/**
+ * mpu6050_runtime_resume - Wake the sensor up
+ * @dev: I2C client device
+ *
+ * Flushes whatever was configured while asleep and clears SLEEP, which
+ * restarts sampling in the configured power mode with no reset and no
+ * settling delay.
+ *
+ * Returns: 0 on success, negative error code on failure
+ */
+static int __maybe_unused mpu6050_runtime_resume(struct device *dev)
+{
+	struct mpu6050_data *data = i2c_get_clientdata(to_i2c_client(dev));
+	int ret;
+	
+	regcache_cache_only(data->regmap, false);
+	ret = regcache_sync(data->regmap);
+	if (ret) {
+		dev_err(dev, "Failed to restore registers: %d\n", ret);
+		return ret;
+	}
+	
+	ret = regmap_update_bits(data->regmap, MPU6050_REG_PWR_MGMT_1,
+				 MPU6050_PWR1_SLEEP, 0);
+	if (ret)
+		dev_err(dev, "Failed to leave sleep mode: %d\n", ret);
+	
+	return ret;
+}
+
+static const struct dev_pm_ops mpu6050_pm_ops = {
+	SET_SYSTEM_SLEEP_PM_OPS(pm_runtime_force_suspend, pm_runtime_force_resume)
+	SET_RUNTIME_PM_OPS(mpu6050_runtime_suspend, mpu6050_runtime_resume, NULL)
+};
+
 /* Device tree and I2C device ID tables */
 static const struct i2c_device_id mpu6050_id[] = {
 	{ "mpu6050", 0 },
@@ -635,6 +3479,8 @@ static struct i2c_driver mpu6050_driver = {
 	.driver = {
 		.name = DRIVER_NAME,
 		.of_match_table = of_match_ptr(mpu6050_of_match),
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
+		.pm = &mpu6050_pm_ops,
 	},
 	.probe = mpu6050_probe,
 	.remove = mpu6050_remove,
@@ -649,20 +3495,58 @@ static int __init mpu6050_init(void)
 	
 	pr_info("MPU-6050 driver v%s initializing\n", DRIVER_VERSION);
 	
+	/* Reserve minors for every sensor the driver may bind to */
+	ret = alloc_chrdev_region(&mpu6050_devt, 0, MPU6050_MAX_DEVICES,
+				  DRIVER_NAME);
+	if (ret) {
+		pr_err("Failed to allocate char dev region: %d\n", ret);
+		return ret;
+	}
+	
+	mpu6050_class = class_create(THIS_MODULE, DRIVER_NAME);
+	if (IS_ERR(mpu6050_class)) {
+		ret = PTR_ERR(mpu6050_class);
+		pr_err("Failed to create device class: %d\n", ret);
+		goto err_class_create;
+	}
+	
+	/* Per-device directories go below this one */
+	mpu6050_debugfs_root = debugfs_create_dir(DRIVER_NAME, NULL);
+	
 	ret = i2c_add_driver(&mpu6050_driver);
 	if (ret) {
 		pr_err("Failed to register MPU-6050 I2C driver: %d\n", ret);
-		return ret;
+		goto err_add_driver;
+	}
+	
+	ret = mpu6050_virt_init();
+	if (ret) {
+		pr_err("Failed to create virtual MPU-6050: %d\n", ret);
+		goto err_virt_init;
 	}
 	
 	pr_info("MPU-6050 driver registered successfully\n");
 	return 0;
+	
+err_virt_init:
+	i2c_del_driver(&mpu6050_driver);
+err_add_driver:
+	debugfs_remove_recursive(mpu6050_debugfs_root);
+	class_destroy(mpu6050_class);
+err_class_create:
+	unregister_chrdev_region(mpu6050_devt, MPU6050_MAX_DEVICES);
+	return ret;
 }
 
 static void __exit mpu6050_exit(void)
 {
 	pr_info("MPU-6050 driver exiting\n");
+	mpu6050_virt_exit();
 	i2c_del_driver(&mpu6050_driver);
+	debugfs_remove_recursive(mpu6050_debugfs_root);
+	class_destroy(mpu6050_class);
+	unregister_chrdev_region(mpu6050_devt, MPU6050_MAX_DEVICES);
+	idr_destroy(&mpu6050_minor_idr);
 }
 
 module_init(mpu6050_init);
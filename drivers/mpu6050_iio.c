@@ -0,0 +1,400 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * MPU-6050 Industrial I/O interface
+ *
+ * Registers the sensor with the IIO core next to the character device, so
+ * generic IIO consumers get per-channel raw/scale attributes and a
+ * scan-mask aware triggered buffer. The driver's own trigger fires on the
+ * data-ready interrupt; while the character device streams from the FIFO,
+ * drained frames are pushed straight into the buffer instead.
+ *
+ * Copyright (C) 2025 Murray Kopit <murr2k@gmail.com>
+ */
+
+#include <linux/bitops.h>
+#include <linux/device.h>
+#include <linux/i2c.h>
+#include <linux/kernel.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/mutex.h>
+#include <linux/pm_runtime.h>
+#include <linux/regmap.h>
+#include <linux/iio/iio.h>
+#include <linux/iio/buffer.h>
+#include <linux/iio/trigger.h>
+#include <linux/iio/trigger_consumer.h>
+#include <linux/iio/triggered_buffer.h>
+#include <asm/byteorder.h>
+
+#include "../include/mpu6050.h"
+
+/* Scan indices follow the register layout of a sample frame */
+enum mpu6050_scan {
+	MPU6050_SCAN_ACCEL_X,
+	MPU6050_SCAN_ACCEL_Y,
+	MPU6050_SCAN_ACCEL_Z,
+	MPU6050_SCAN_TEMP,
+	MPU6050_SCAN_GYRO_X,
+	MPU6050_SCAN_GYRO_Y,
+	MPU6050_SCAN_GYRO_Z,
+	MPU6050_SCAN_TIMESTAMP,
+};
+
+#define MPU6050_SCAN_CHANNELS	MPU6050_SCAN_TIMESTAMP
+
+/* Temperature in milli-degrees Celsius is (raw + 12420.2) * 1000 / 340 */
+#define MPU6050_TEMP_SCALE_MICRO	2941176
+#define MPU6050_TEMP_OFFSET		12420
+#define MPU6050_TEMP_OFFSET_MICRO	200000
+
+#define MPU6050_IIO_CHAN(_type, _mod, _index, _reg) {			\
+	.type = _type,							\
+	.modified = 1,							\
+	.channel2 = _mod,						\
+	.address = _reg,						\
+	.info_mask_separate = BIT(IIO_CHAN_INFO_RAW),			\
+	.info_mask_shared_by_type = BIT(IIO_CHAN_INFO_SCALE),		\
+	.scan_index = _index,						\
+	.scan_type = {							\
+		.sign = 's',						\
+		.realbits = 16,						\
+		.storagebits = 16,					\
+		.endianness = IIO_CPU,					\
+	},								\
+}
+
+static const struct iio_chan_spec mpu6050_iio_channels[] = {
+	MPU6050_IIO_CHAN(IIO_ACCEL, IIO_MOD_X, MPU6050_SCAN_ACCEL_X,
+			 MPU6050_REG_ACCEL_XOUT_H),
+	MPU6050_IIO_CHAN(IIO_ACCEL, IIO_MOD_Y, MPU6050_SCAN_ACCEL_Y,
+			 MPU6050_REG_ACCEL_YOUT_H),
+	MPU6050_IIO_CHAN(IIO_ACCEL, IIO_MOD_Z, MPU6050_SCAN_ACCEL_Z,
+			 MPU6050_REG_ACCEL_ZOUT_H),
+	{
+		.type = IIO_TEMP,
+		.address = MPU6050_REG_TEMP_OUT_H,
+		.info_mask_separate = BIT(IIO_CHAN_INFO_RAW) |
+				      BIT(IIO_CHAN_INFO_SCALE) |
+				      BIT(IIO_CHAN_INFO_OFFSET),
+		.scan_index = MPU6050_SCAN_TEMP,
+		.scan_type = {
+			.sign = 's',
+			.realbits = 16,
+			.storagebits = 16,
+			.endianness = IIO_CPU,
+		},
+	},
+	MPU6050_IIO_CHAN(IIO_ANGL_VEL, IIO_MOD_X, MPU6050_SCAN_GYRO_X,
+			 MPU6050_REG_GYRO_XOUT_H),
+	MPU6050_IIO_CHAN(IIO_ANGL_VEL, IIO_MOD_Y, MPU6050_SCAN_GYRO_Y,
+			 MPU6050_REG_GYRO_YOUT_H),
+	MPU6050_IIO_CHAN(IIO_ANGL_VEL, IIO_MOD_Z, MPU6050_SCAN_GYRO_Z,
+			 MPU6050_REG_GYRO_ZOUT_H),
+	IIO_CHAN_SOFT_TIMESTAMP(MPU6050_SCAN_TIMESTAMP),
+};
+
+/* One scan: up to seven enabled channels packed in order, then the time */
+struct mpu6050_iio_scan {
+	s16 channels[MPU6050_SCAN_CHANNELS];
+	s64 timestamp __aligned(8);
+};
+
+static struct mpu6050_data *mpu6050_iio_data(struct iio_dev *indio_dev)
+{
+	return *(struct mpu6050_data **)iio_priv(indio_dev);
+}
+
+/**
+ * mpu6050_iio_values - Lay a sample out in scan index order
+ * @raw: Raw sensor data
+ * @vals: Array of MPU6050_SCAN_CHANNELS values to fill
+ */
+static void mpu6050_iio_values(const struct mpu6050_raw_data *raw, s16 *vals)
+{
+	vals[MPU6050_SCAN_ACCEL_X] = raw->accel_x;
+	vals[MPU6050_SCAN_ACCEL_Y] = raw->accel_y;
+	vals[MPU6050_SCAN_ACCEL_Z] = raw->accel_z;
+	vals[MPU6050_SCAN_TEMP] = raw->temp;
+	vals[MPU6050_SCAN_GYRO_X] = raw->gyro_x;
+	vals[MPU6050_SCAN_GYRO_Y] = raw->gyro_y;
+	vals[MPU6050_SCAN_GYRO_Z] = raw->gyro_z;
+}
+
+/**
+ * mpu6050_iio_pack - Push the enabled channels of one sample
+ * @indio_dev: IIO device
+ * @vals: All channel values in scan index order
+ * @timestamp: Sample time in the IIO device's clock
+ */
+static void mpu6050_iio_pack(struct iio_dev *indio_dev, const s16 *vals,
+			     s64 timestamp)
+{
+	struct mpu6050_iio_scan scan = { };
+	unsigned int bit, n = 0;
+	
+	for_each_set_bit(bit, indio_dev->active_scan_mask, MPU6050_SCAN_CHANNELS)
+		scan.channels[n++] = vals[bit];
+	
+	iio_push_to_buffers_with_timestamp(indio_dev, &scan, timestamp);
+}
+
+/**
+ * mpu6050_iio_push - Feed a FIFO sample into the IIO buffer
+ * @data: Device data structure
+ * @raw_data: Raw sensor data
+ * @timestamp: Acquisition time (CLOCK_MONOTONIC)
+ *
+ * Does nothing unless the IIO buffer is enabled.
+ */
+void mpu6050_iio_push(struct mpu6050_data *data,
+		      const struct mpu6050_raw_data *raw_data, ktime_t timestamp)
+{
+	struct iio_dev *indio_dev = data->indio_dev;
+	s16 vals[MPU6050_SCAN_CHANNELS];
+	s64 ts;
+	
+	if (!indio_dev || !iio_buffer_enabled(indio_dev))
+		return;
+	
+	/* Move the monotonic sample time onto the clock the user picked */
+	ts = iio_get_time_ns(indio_dev) - ktime_get_ns() + ktime_to_ns(timestamp);
+	
+	mpu6050_iio_values(raw_data, vals);
+	mpu6050_iio_pack(indio_dev, vals, ts);
+}
+
+/**
+ * mpu6050_iio_trigger - Fire the data-ready trigger
+ * @data: Device data structure
+ * @timestamp: Time the data-ready interrupt was taken (CLOCK_MONOTONIC)
+ *
+ * Called from the interrupt thread without data->lock held.
+ */
+void mpu6050_iio_trigger(struct mpu6050_data *data, ktime_t timestamp)
+{
+	struct iio_dev *indio_dev = data->indio_dev;
+	
+	if (!indio_dev || !iio_buffer_enabled(indio_dev))
+		return;
+	
+	data->iio_timestamp = iio_get_time_ns(indio_dev) - ktime_get_ns() +
+			      ktime_to_ns(timestamp);
+	iio_trigger_poll_chained(data->iio_trig);
+}
+
+static irqreturn_t mpu6050_iio_trigger_handler(int irq, void *p)
+{
+	struct iio_poll_func *pf = p;
+	struct iio_dev *indio_dev = pf->indio_dev;
+	struct mpu6050_data *data = mpu6050_iio_data(indio_dev);
+	s16 vals[MPU6050_SCAN_CHANNELS];
+	unsigned int first, last, i;
+	__be16 buf[MPU6050_SCAN_CHANNELS];
+	s64 timestamp;
+	int ret;
+	
+	/* Our own trigger stamps the interrupt; any other uses its top half */
+	timestamp = indio_dev->trig == data->iio_trig ? data->iio_timestamp :
+							pf->timestamp;
+	
+	/* Only burst the register span that covers the enabled channels */
+	first = find_first_bit(indio_dev->active_scan_mask, MPU6050_SCAN_CHANNELS);
+	last = find_last_bit(indio_dev->active_scan_mask, MPU6050_SCAN_CHANNELS);
+	if (first >= MPU6050_SCAN_CHANNELS) {
+		/* Timestamp only */
+		mpu6050_iio_pack(indio_dev, vals, timestamp);
+		goto out;
+	}
+	
+	mutex_lock(&data->lock);
+	ret = regmap_bulk_read(data->regmap, mpu6050_iio_channels[first].address,
+			       &buf[first], (last - first + 1) * sizeof(buf[0]));
+	mutex_unlock(&data->lock);
+	if (ret) {
+		dev_err_ratelimited(&data->client->dev,
+				    "Failed to read buffered sample: %d\n", ret);
+		goto out;
+	}
+	
+	for (i = first; i <= last; i++)
+		vals[i] = be16_to_cpu(buf[i]);
+	
+	mpu6050_iio_pack(indio_dev, vals, timestamp);
+out:
+	iio_trigger_notify_done(indio_dev->trig);
+	return IRQ_HANDLED;
+}
+
+static int mpu6050_iio_buffer_postenable(struct iio_dev *indio_dev)
+{
+	struct mpu6050_data *data = mpu6050_iio_data(indio_dev);
+	int ret;
+	
+	mutex_lock(&data->lock);
+	ret = mpu6050_acq_get(data);
+	mutex_unlock(&data->lock);
+	
+	return ret;
+}
+
+static int mpu6050_iio_buffer_predisable(struct iio_dev *indio_dev)
+{
+	struct mpu6050_data *data = mpu6050_iio_data(indio_dev);
+	
+	mutex_lock(&data->lock);
+	mpu6050_acq_put(data);
+	mutex_unlock(&data->lock);
+	
+	return 0;
+}
+
+static const struct iio_buffer_setup_ops mpu6050_iio_buffer_ops = {
+	.postenable = mpu6050_iio_buffer_postenable,
+	.predisable = mpu6050_iio_buffer_predisable,
+};
+
+/**
+ * mpu6050_iio_scale - Report a channel scale in IIO base units
+ * @data: Device data structure
+ * @chan: Channel
+ * @val: Integer part
+ * @val2: Fractional part
+ *
+ * Acceleration is in m/s^2 and angular velocity in rad/s per LSB.
+ *
+ * Returns: IIO value type
+ */
+static int mpu6050_iio_scale(struct mpu6050_data *data,
+			     struct iio_chan_spec const *chan, int *val, int *val2)
+{
+	switch (chan->type) {
+	case IIO_ACCEL:
+		/* ug/LSB * 9.80665 m/s^2 per g, in nano units */
+		*val = 0;
+		*val2 = div_u64((u64)READ_ONCE(data->accel_scale) * 980665, 100);
+		return IIO_VAL_INT_PLUS_NANO;
+	case IIO_ANGL_VEL:
+		/* udps/LSB * pi / 180, in nano units */
+		*val = 0;
+		*val2 = div_u64((u64)READ_ONCE(data->gyro_scale) * 174533, 10000);
+		return IIO_VAL_INT_PLUS_NANO;
+	case IIO_TEMP:
+		*val = MPU6050_TEMP_SCALE_MICRO / 1000000;
+		*val2 = MPU6050_TEMP_SCALE_MICRO % 1000000;
+		return IIO_VAL_INT_PLUS_MICRO;
+	default:
+		return -EINVAL;
+	}
+}
+
+static int mpu6050_iio_read_raw(struct iio_dev *indio_dev,
+				struct iio_chan_spec const *chan,
+				int *val, int *val2, long mask)
+{
+	struct mpu6050_data *data = mpu6050_iio_data(indio_dev);
+	struct mpu6050_raw_data raw_data;
+	s16 vals[MPU6050_SCAN_CHANNELS];
+	int ret;
+	
+	switch (mask) {
+	case IIO_CHAN_INFO_RAW:
+		ret = iio_device_claim_direct_mode(indio_dev);
+		if (ret)
+			return ret;
+	
+		/* Nobody else may be keeping the sensor awake */
+		ret = pm_runtime_resume_and_get(&data->client->dev);
+		if (!ret) {
+			ret = mpu6050_read_raw_data(data, &raw_data);
+			pm_runtime_mark_last_busy(&data->client->dev);
+			pm_runtime_put_autosuspend(&data->client->dev);
+		}
+		iio_device_release_direct_mode(indio_dev);
+		if (ret)
+			return ret;
+	
+		mpu6050_iio_values(&raw_data, vals);
+		*val = vals[chan->scan_index];
+		return IIO_VAL_INT;
+	
+	case IIO_CHAN_INFO_SCALE:
+		return mpu6050_iio_scale(data, chan, val, val2);
+	
+	case IIO_CHAN_INFO_OFFSET:
+		if (chan->type != IIO_TEMP)
+			return -EINVAL;
+		*val = MPU6050_TEMP_OFFSET;
+		*val2 = MPU6050_TEMP_OFFSET_MICRO;
+		return IIO_VAL_INT_PLUS_MICRO;
+	
+	default:
+		return -EINVAL;
+	}
+}
+
+static const struct iio_info mpu6050_iio_info = {
+	.read_raw = mpu6050_iio_read_raw,
+};
+
+/**
+ * mpu6050_iio_probe - Register the IIO device and its data-ready trigger
+ * @data: Device data structure
+ *
+ * The trigger is only registered when the sensor has an interrupt line;
+ * without one the buffer can still run from any other IIO trigger, or
+ * from FIFO drains while the character device streams.
+ *
+ * Returns: 0 on success, negative error code on failure
+ */
+int mpu6050_iio_probe(struct mpu6050_data *data)
+{
+	struct device *dev = &data->client->dev;
+	struct iio_dev *indio_dev;
+	int ret;
+	
+	indio_dev = devm_iio_device_alloc(dev, sizeof(data));
+	if (!indio_dev)
+		return -ENOMEM;
+	
+	*(struct mpu6050_data **)iio_priv(indio_dev) = data;
+	indio_dev->name = "mpu6050";
+	indio_dev->info = &mpu6050_iio_info;
+	indio_dev->modes = INDIO_DIRECT_MODE;
+	indio_dev->channels = mpu6050_iio_channels;
+	indio_dev->num_channels = ARRAY_SIZE(mpu6050_iio_channels);
+	
+	ret = devm_iio_triggered_buffer_setup(dev, indio_dev,
+					      iio_pollfunc_store_time,
+					      mpu6050_iio_trigger_handler,
+					      &mpu6050_iio_buffer_ops);
+	if (ret) {
+		dev_err(dev, "Failed to set up IIO buffer: %d\n", ret);
+		return ret;
+	}
+	
+	if (data->irq) {
+		data->iio_trig = devm_iio_trigger_alloc(dev, "%s-dev%d",
+							indio_dev->name,
+							iio_device_id(indio_dev));
+		if (!data->iio_trig)
+			return -ENOMEM;
+	
+		ret = devm_iio_trigger_register(dev, data->iio_trig);
+		if (ret) {
+			dev_err(dev, "Failed to register IIO trigger: %d\n", ret);
+			return ret;
+		}
+	
+		indio_dev->trig = iio_trigger_get(data->iio_trig);
+	}
+	
+	ret = devm_iio_device_register(dev, indio_dev);
+	if (ret) {
+		dev_err(dev, "Failed to register IIO device: %d\n", ret);
+		return ret;
+	}
+	
+	data->indio_dev = indio_dev;
+	return 0;
+}
@@ -1,31 +1,640 @@
 // SPDX-License-Identifier: GPL-2.0
 /*
- * MPU-6050 6-axis gyroscope and accelerometer driver
- * 
+ * MPU-6050 register and sample I/O layer
+ *
+ * Everything that talks to the part's registers goes through here: the
+ * regmap description and register cache, single-register helpers, the
+ * sample burst with its latest-sample cache, FIFO chunk reads and
+ * configuration updates, including which channels and auxiliary I2C
+ * slaves are enabled. A full sample or FIFO chunk always costs one lock
+ * acquisition and one bus transfer. The character device front end lives
+ * in mpu6050_driver.c.
+ *
  * Copyright (C) 2024 Murray Kopit <murr2k@gmail.com>
  */
 
-#include <linux/delay.h>
+#include <linux/bitops.h>
 #include <linux/device.h>
 #include <linux/i2c.h>
 #include <linux/kernel.h>
-#include <linux/module.h>
+#include <linux/ktime.h>
 #include <linux/mutex.h>
-#include <linux/slab.h>
+#include <linux/percpu.h>
+#include <linux/regmap.h>
+#include <linux/seqlock.h>
+#include <linux/string.h>
+#include <asm/byteorder.h>
 
 #include "../include/mpu6050.h"
+#include "mpu6050_trace.h"
+
+/* Registers that exist on the part */
+static const struct regmap_range mpu6050_readable_ranges[] = {
+	regmap_reg_range(MPU6050_REG_SELF_TEST_X, MPU6050_REG_SELF_TEST_A),
+	regmap_reg_range(MPU6050_REG_SMPLRT_DIV, MPU6050_REG_ACCEL_CONFIG),
+	regmap_reg_range(MPU6050_REG_FIFO_EN, MPU6050_REG_INT_ENABLE),
+	regmap_reg_range(MPU6050_REG_INT_STATUS, MPU6050_REG_EXT_SENS_DATA_23),
+	regmap_reg_range(MPU6050_REG_I2C_SLV0_DO, MPU6050_REG_SIGNAL_PATH_RESET),
+	regmap_reg_range(MPU6050_REG_USER_CTRL, MPU6050_REG_PWR_MGMT_2),
+	regmap_reg_range(MPU6050_REG_FIFO_COUNTH, MPU6050_REG_WHO_AM_I),
+};
+
+static const struct regmap_access_table mpu6050_readable_table = {
+	.yes_ranges = mpu6050_readable_ranges,
+	.n_yes_ranges = ARRAY_SIZE(mpu6050_readable_ranges),
+};
 
-static const struct i2c_device_id mpu6050_id[] = {
-	{ "mpu6050", 0 },
-	{ }
+/* Status, data and identification registers are read-only */
+static const struct regmap_range mpu6050_read_only_ranges[] = {
+	regmap_reg_range(MPU6050_REG_I2C_SLV4_DI, MPU6050_REG_I2C_MST_STATUS),
+	regmap_reg_range(MPU6050_REG_INT_STATUS, MPU6050_REG_EXT_SENS_DATA_23),
+	regmap_reg_range(MPU6050_REG_FIFO_COUNTH, MPU6050_REG_FIFO_COUNTL),
+	regmap_reg_range(MPU6050_REG_WHO_AM_I, MPU6050_REG_WHO_AM_I),
+};
+
+static const struct regmap_access_table mpu6050_writeable_table = {
+	.yes_ranges = mpu6050_readable_ranges,
+	.n_yes_ranges = ARRAY_SIZE(mpu6050_readable_ranges),
+	.no_ranges = mpu6050_read_only_ranges,
+	.n_no_ranges = ARRAY_SIZE(mpu6050_read_only_ranges),
+};
+
+/*
+ * Registers the hardware changes on its own: status, sample data, FIFO
+ * state, and control registers with self-clearing reset or start bits.
+ * Everything else is served from the cache.
+ */
+static const struct regmap_range mpu6050_volatile_ranges[] = {
+	regmap_reg_range(MPU6050_REG_I2C_SLV4_CTRL, MPU6050_REG_I2C_MST_STATUS),
+	regmap_reg_range(MPU6050_REG_INT_STATUS, MPU6050_REG_EXT_SENS_DATA_23),
+	regmap_reg_range(MPU6050_REG_SIGNAL_PATH_RESET, MPU6050_REG_SIGNAL_PATH_RESET),
+	regmap_reg_range(MPU6050_REG_USER_CTRL, MPU6050_REG_USER_CTRL),
+	regmap_reg_range(MPU6050_REG_FIFO_COUNTH, MPU6050_REG_FIFO_R_W),
 };
-MODULE_DEVICE_TABLE(i2c, mpu6050_id);
 
-static const struct of_device_id mpu6050_of_match[] = {
-	{ .compatible = "invensense,mpu6050" },
-	{ }
+static const struct regmap_access_table mpu6050_volatile_table = {
+	.yes_ranges = mpu6050_volatile_ranges,
+	.n_yes_ranges = ARRAY_SIZE(mpu6050_volatile_ranges),
+};
+
+/* Reading these clears interrupt state or consumes FIFO data */
+static const struct regmap_range mpu6050_precious_ranges[] = {
+	regmap_reg_range(MPU6050_REG_I2C_MST_STATUS, MPU6050_REG_I2C_MST_STATUS),
+	regmap_reg_range(MPU6050_REG_INT_STATUS, MPU6050_REG_INT_STATUS),
+	regmap_reg_range(MPU6050_REG_FIFO_R_W, MPU6050_REG_FIFO_R_W),
+};
+
+static const struct regmap_access_table mpu6050_precious_table = {
+	.yes_ranges = mpu6050_precious_ranges,
+	.n_yes_ranges = ARRAY_SIZE(mpu6050_precious_ranges),
+};
+
+/* Regmap configuration */
+const struct regmap_config mpu6050_regmap_config = {
+	.reg_bits = 8,
+	.val_bits = 8,
+	.max_register = MPU6050_REG_WHO_AM_I,
+	.rd_table = &mpu6050_readable_table,
+	.wr_table = &mpu6050_writeable_table,
+	.volatile_table = &mpu6050_volatile_table,
+	.precious_table = &mpu6050_precious_table,
+	.cache_type = REGCACHE_RBTREE,
+};
+
+/**
+ * mpu6050_scale_init - Precompute the fixed-point conversion of a channel
+ * @scale: Scale factors to fill in
+ * @chan: Channel index, in MPU6050_CHAN_* bit order
+ * @num: Numerator of the physical units per LSB
+ * @den: Denominator of the physical units per LSB
+ * @bias: Raw offset to subtract before scaling
+ * @offset: Physical offset to add after scaling
+ */
+static void mpu6050_scale_init(struct mpu6050_scale *scale, unsigned int chan,
+			       u64 num, u64 den, s32 bias, s32 offset)
+{
+	s64 mult = div64_u64((num << MPU6050_SCALE_SHIFT) + den / 2, den);
+	
+	scale->mult[chan] = mult;
+	scale->add[chan] = ((s64)offset << MPU6050_SCALE_SHIFT) - bias * mult +
+			   BIT_ULL(MPU6050_SCALE_SHIFT - 1);
+}
+
+/**
+ * mpu6050_update_scale_factors - Update scaling factors based on configuration
+ * @data: Device data structure
+ *
+ * This function updates the scaling factors used to convert raw sensor
+ * data to meaningful units based on the current configuration and user
+ * calibration. Accelerometer readings are in mg, gyroscope readings in the
+ * units of the udps/LSB scale divided by 10^6 and temperature in hundredths
+ * of a degree Celsius, (TEMP_OUT / 340) + 36.53.
+ *
+ * Must be called with data->lock held.
+ */
+static void mpu6050_update_scale_factors(struct mpu6050_data *data)
+{
+	const struct mpu6050_calibration *cal = &data->calib;
+	struct mpu6050_scale scale;
+	int i;
+	
+	data->accel_scale = mpu6050_accel_range_to_scale(data->config.accel_range);
+	data->gyro_scale = mpu6050_gyro_range_to_scale(data->config.gyro_range);
+	
+	for (i = 0; i < 3; i++) {
+		mpu6050_scale_init(&scale, i, (u64)data->accel_scale *
+				   (1000000 + cal->accel_scale_ppm[i]),
+				   1000ULL * 1000000, cal->accel_bias[i], 0);
+		mpu6050_scale_init(&scale, 4 + i, (u64)data->gyro_scale *
+				   (1000000 + cal->gyro_scale_ppm[i]),
+				   1000000ULL * 1000000, cal->gyro_bias[i], 0);
+	}
+	mpu6050_scale_init(&scale, 3, 100, 340, 0, 3653);
+	
+	write_seqlock(&data->scale_lock);
+	data->scale = scale;
+	write_sequnlock(&data->scale_lock);
+}
+
+/**
+ * mpu6050_scale_get - Snapshot the scale factors
+ * @data: Device data structure
+ * @scale: Pointer to store the scale factors
+ *
+ * Lockless; batch readers take one snapshot for the whole batch.
+ */
+void mpu6050_scale_get(struct mpu6050_data *data, struct mpu6050_scale *scale)
+{
+	unsigned int seq;
+	
+	do {
+		seq = read_seqbegin(&data->scale_lock);
+		*scale = data->scale;
+	} while (read_seqretry(&data->scale_lock, seq));
+}
+
+/* Output data periods in cycle mode, indexed by MPU6050_CYCLE_* */
+static const u32 mpu6050_cycle_period_ns[] = {
+	[MPU6050_CYCLE_1_25HZ] = 800000000,
+	[MPU6050_CYCLE_5HZ] = 200000000,
+	[MPU6050_CYCLE_20HZ] = 50000000,
+	[MPU6050_CYCLE_40HZ] = 25000000,
 };
-MODULE_DEVICE_TABLE(of, mpu6050_of_match);
+
+/**
+ * mpu6050_sample_period_ns - Nominal output data period
+ * @data: Device data structure
+ *
+ * The gyroscope output rate is 8 kHz with the DLPF disabled (0 or 7) and
+ * 1 kHz otherwise; SMPLRT_DIV divides it down to the sample rate. In cycle
+ * mode the wake-up rate is the output rate instead.
+ */
+u32 mpu6050_sample_period_ns(struct mpu6050_data *data)
+{
+	u8 cycle = READ_ONCE(data->cycle);
+	u32 gyro_rate_hz;
+	
+	if (cycle)
+		return mpu6050_cycle_period_ns[cycle];
+	
+	if (data->config.dlpf_cfg == 0 || data->config.dlpf_cfg >= 7)
+		gyro_rate_hz = 8000;
+	else
+		gyro_rate_hz = 1000;
+	
+	return (NSEC_PER_SEC / gyro_rate_hz) * (1 + data->config.sample_rate_div);
+}
+
+/**
+ * mpu6050_unpack_sample - Convert one big-endian sample frame to host format
+ * @buf: 14-byte frame in ACCEL_XOUT_H..GYRO_ZOUT_L order
+ * @raw_data: Pointer to store raw data
+ *
+ * The live output registers and the FIFO share the same frame layout, so
+ * both the one-shot and the streaming paths use this helper.
+ */
+static void mpu6050_unpack_sample(const u8 *buf,
+				  struct mpu6050_raw_data *raw_data)
+{
+	raw_data->accel_x = be16_to_cpup((__be16 *)&buf[0]);
+	raw_data->accel_y = be16_to_cpup((__be16 *)&buf[2]);
+	raw_data->accel_z = be16_to_cpup((__be16 *)&buf[4]);
+	raw_data->temp = be16_to_cpup((__be16 *)&buf[6]);
+	raw_data->gyro_x = be16_to_cpup((__be16 *)&buf[8]);
+	raw_data->gyro_y = be16_to_cpup((__be16 *)&buf[10]);
+	raw_data->gyro_z = be16_to_cpup((__be16 *)&buf[12]);
+}
+
+/**
+ * mpu6050_mask_channels - Zero the readings of disabled channels
+ * @raw_data: Raw sensor data
+ * @channels: MPU6050_CHAN_* mask of the enabled channels
+ */
+static void mpu6050_mask_channels(struct mpu6050_raw_data *raw_data, u8 channels)
+{
+	int i;
+	
+	for (i = 0; i < MPU6050_NUM_CHANNELS; i++)
+		if (!(channels & BIT(i)))
+			mpu6050_raw_chan(raw_data, i) = 0;
+}
+
+/**
+ * mpu6050_unpack_fifo_frame - Convert one FIFO frame to host format
+ * @buf: Big-endian frame as selected by mpu6050_set_channels()
+ * @channels: MPU6050_CHAN_* mask of the enabled channels
+ * @raw_data: Pointer to store raw data, disabled channels are zeroed
+ *
+ * The FIFO holds all three accelerometer axes or none, then the
+ * temperature, then each enabled gyroscope axis.
+ */
+static void mpu6050_unpack_fifo_frame(const u8 *buf, u8 channels,
+				      struct mpu6050_raw_data *raw_data)
+{
+	const __be16 *val = (const __be16 *)buf;
+	
+	memset(raw_data, 0, sizeof(*raw_data));
+	
+	if (channels & MPU6050_CHAN_ACCEL) {
+		raw_data->accel_x = be16_to_cpup(val++);
+		raw_data->accel_y = be16_to_cpup(val++);
+		raw_data->accel_z = be16_to_cpup(val++);
+	}
+	if (channels & MPU6050_CHAN_TEMP)
+		raw_data->temp = be16_to_cpup(val++);
+	if (channels & MPU6050_CHAN_GYRO_X)
+		raw_data->gyro_x = be16_to_cpup(val++);
+	if (channels & MPU6050_CHAN_GYRO_Y)
+		raw_data->gyro_y = be16_to_cpup(val++);
+	if (channels & MPU6050_CHAN_GYRO_Z)
+		raw_data->gyro_z = be16_to_cpup(val++);
+	
+	/* Accelerometer axes in standby still occupy their FIFO slot */
+	mpu6050_mask_channels(raw_data, channels);
+}
+
+/**
+ * mpu6050_latest_update - Publish a new sample in the latest-sample cache
+ * @data: Device data structure
+ * @raw_data: Raw sensor data
+ * @timestamp: Acquisition time
+ *
+ * Must be called with data->lock held.
+ */
+void mpu6050_latest_update(struct mpu6050_data *data,
+			   const struct mpu6050_raw_data *raw_data,
+			   ktime_t timestamp)
+{
+	write_seqlock(&data->latest_lock);
+	data->latest = *raw_data;
+	data->latest_ns = ktime_to_ns(timestamp);
+	data->latest_seq = data->sample_seq;
+	write_sequnlock(&data->latest_lock);
+}
+
+/**
+ * mpu6050_latest_get - Snapshot the cached sample if it is recent enough
+ * @data: Device data structure
+ * @raw_data: Pointer to store raw data
+ * @max_age_ns: Oldest acceptable sample age
+ *
+ * Return: true if @raw_data holds a sample at most @max_age_ns old
+ */
+static bool mpu6050_latest_get(struct mpu6050_data *data,
+			       struct mpu6050_raw_data *raw_data, u64 max_age_ns)
+{
+	unsigned int seq;
+	u64 ts;
+	
+	do {
+		seq = read_seqbegin(&data->latest_lock);
+		ts = data->latest_ns;
+		*raw_data = data->latest;
+	} while (read_seqretry(&data->latest_lock, seq));
+	
+	return ts && ktime_get_ns() - ts <= max_age_ns;
+}
+
+/**
+ * mpu6050_latest_sample - Snapshot the cached sample with its sequence
+ * @data: Device data structure
+ * @sample: Pointer to store the sample, flags cleared
+ *
+ * Return: true if @sample holds a valid sample, of any age
+ */
+bool mpu6050_latest_sample(struct mpu6050_data *data,
+			   struct mpu6050_sample *sample)
+{
+	unsigned int seq;
+	
+	memset(sample, 0, sizeof(*sample));
+	do {
+		seq = read_seqbegin(&data->latest_lock);
+		sample->timestamp = data->latest_ns;
+		sample->seq = data->latest_seq;
+		sample->raw = data->latest;
+	} while (read_seqretry(&data->latest_lock, seq));
+	
+	return sample->timestamp != 0;
+}
+
+/**
+ * mpu6050_latest_invalidate - Drop the cached sample
+ * @data: Device data structure
+ *
+ * Called after anything that changes what raw readings mean.
+ */
+void mpu6050_latest_invalidate(struct mpu6050_data *data)
+{
+	write_seqlock(&data->latest_lock);
+	data->latest_ns = 0;
+	write_sequnlock(&data->latest_lock);
+}
+
+/**
+ * mpu6050_lock - Take the device lock, accounting any wait
+ * @data: Device data structure
+ *
+ * The uncontended case costs one trylock; only a wait reads the clock.
+ */
+void mpu6050_lock(struct mpu6050_data *data)
+{
+	ktime_t start;
+	
+	if (mutex_trylock(&data->lock))
+		return;
+	
+	start = ktime_get();
+	mutex_lock(&data->lock);
+	this_cpu_inc(data->stats->lock_waits);
+	this_cpu_add(data->stats->lock_wait_ns,
+		     ktime_to_ns(ktime_sub(ktime_get(), start)));
+}
+
+/**
+ * mpu6050_stats_bus - Account one bus operation of the acquisition path
+ * @data: Device data structure
+ * @start: Time the operation was started
+ * @ret: Result of the operation
+ */
+void mpu6050_stats_bus(struct mpu6050_data *data, ktime_t start, int ret)
+{
+	u64 us = ktime_us_delta(ktime_get(), start);
+	unsigned int bucket = us ? min(fls64(us), MPU6050_LAT_BUCKETS - 1) : 0;
+	
+	this_cpu_inc(data->stats->bus_ops);
+	if (ret)
+		this_cpu_inc(data->stats->bus_errors);
+	this_cpu_inc(data->stats->bus_latency[bucket]);
+}
+
+/**
+ * mpu6050_fetch_sample - Read the data registers and refresh the cache
+ * @data: Device data structure
+ * @raw_data: Pointer to store raw data
+ *
+ * Only the registers from the first to the last enabled channel are read,
+ * so an accelerometer-only sample is a 6-byte burst. Disabled channels
+ * read as zero.
+ *
+ * Must be called with data->lock held.
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+int mpu6050_fetch_sample(struct mpu6050_data *data,
+			 struct mpu6050_raw_data *raw_data)
+{
+	u8 sensor_data[MPU6050_FIFO_FRAME_SIZE] = { 0 };
+	unsigned int first = __ffs(data->channels);
+	unsigned int last = __fls(data->channels);
+	ktime_t start;
+	int ret;
+	
+	trace_mpu6050_acquire_start(&data->client->dev, false, 0);
+	
+	/* Output registers are two bytes per channel in channel order */
+	start = ktime_get();
+	ret = regmap_bulk_read(data->regmap, MPU6050_REG_ACCEL_XOUT_H + 2 * first,
+			       &sensor_data[2 * first], 2 * (last - first + 1));
+	mpu6050_stats_bus(data, start, ret);
+	if (ret) {
+		dev_err(&data->client->dev, "Failed to read sensor data: %d\n", ret);
+		goto out;
+	}
+	
+	/* Convert big-endian data to host format */
+	mpu6050_unpack_sample(sensor_data, raw_data);
+	mpu6050_mask_channels(raw_data, data->channels);
+	mpu6050_latest_update(data, raw_data, ktime_get());
+	
+out:
+	trace_mpu6050_acquire_end(&data->client->dev, false, ret);
+	return ret;
+}
+
+/**
+ * mpu6050_read_sample - Read a sample no older than a staleness bound
+ * @data: Device data structure
+ * @raw_data: Pointer to store raw data
+ * @max_age_ns: Oldest acceptable sample age
+ *
+ * The cached sample is returned without taking the lock when it is recent
+ * enough. Otherwise one caller reads the bus and every caller that queued
+ * behind it on the lock is served from the refreshed cache.
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+int mpu6050_read_sample(struct mpu6050_data *data,
+			struct mpu6050_raw_data *raw_data, u64 max_age_ns)
+{
+	int ret = 0;
+	
+	if (mpu6050_latest_get(data, raw_data, max_age_ns))
+		return 0;
+	
+	mpu6050_lock(data);
+	if (!mpu6050_latest_get(data, raw_data, max_age_ns))
+		ret = mpu6050_fetch_sample(data, raw_data);
+	mutex_unlock(&data->lock);
+	
+	return ret;
+}
+
+/**
+ * mpu6050_poll_sample - Fetch the next sample once DATA_RDY is pending
+ * @data: Device data structure
+ *
+ * New-data reads on a device without an interrupt line poll INT_STATUS
+ * instead of waiting for the IRQ thread. Reading it clears DATA_RDY, so
+ * every sample is numbered once however many readers poll.
+ *
+ * Must be called with data->lock held.
+ *
+ * Return: 1 if a new sample is in the cache, 0 if none is ready yet, or
+ * negative error code on failure
+ */
+int mpu6050_poll_sample(struct mpu6050_data *data)
+{
+	struct mpu6050_raw_data raw_data;
+	unsigned int status;
+	ktime_t start;
+	int ret;
+	
+	start = ktime_get();
+	ret = regmap_read(data->regmap, MPU6050_REG_INT_STATUS, &status);
+	mpu6050_stats_bus(data, start, ret);
+	if (ret) {
+		dev_err(&data->client->dev, "Failed to read INT_STATUS: %d\n", ret);
+		return ret;
+	}
+	
+	if (!(status & MPU6050_INT_DATA_RDY))
+		return 0;
+	
+	data->sample_seq++;
+	ret = mpu6050_fetch_sample(data, &raw_data);
+	
+	return ret ? ret : 1;
+}
+
+/**
+ * mpu6050_read_raw_data - Read a fresh raw sample
+ * @data: Device data structure
+ * @raw_data: Pointer to store raw data
+ *
+ * Served from the latest-sample cache when it is at most one output data
+ * period old, otherwise with a single burst read.
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+int mpu6050_read_raw_data(struct mpu6050_data *data,
+			  struct mpu6050_raw_data *raw_data)
+{
+	return mpu6050_read_sample(data, raw_data, mpu6050_sample_period_ns(data));
+}
+
+/**
+ * mpu6050_read_scaled_data - Read a fresh sample in physical units
+ * @data: Device data structure
+ * @scaled_data: Pointer to store scaled data
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+int mpu6050_read_scaled_data(struct mpu6050_data *data,
+			     struct mpu6050_scaled_data *scaled_data)
+{
+	struct mpu6050_raw_data raw_data;
+	struct mpu6050_scale scale;
+	int ret;
+	
+	ret = mpu6050_read_raw_data(data, &raw_data);
+	if (ret)
+		return ret;
+	
+	mpu6050_scale_get(data, &scale);
+	mpu6050_scale_raw(&raw_data, &scale, scaled_data);
+	
+	return 0;
+}
+
+/**
+ * mpu6050_fifo_xfer - Read FIFO_R_W with raw I2C transfers
+ * @data: Device data structure
+ * @len: Number of bytes to read into data->fifo_buf
+ *
+ * Each transfer is a register address write followed by a repeated-start
+ * read, as long as the adapter allows, so a full 1024-byte FIFO normally
+ * costs a single addressing phase. A capture group caps the transfer
+ * length at data->fifo_burst so members sharing the adapter get the bus
+ * in between. data->fifo_buf is kmalloc()ed and goes to the adapter as a
+ * DMA-safe buffer, avoiding a bounce copy.
+ *
+ * Must be called with data->lock held.
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+static int mpu6050_fifo_xfer(struct mpu6050_data *data, size_t len)
+{
+	struct i2c_client *client = data->client;
+	const struct i2c_adapter_quirks *quirks = client->adapter->quirks;
+	u8 reg = MPU6050_REG_FIFO_R_W;
+	size_t max_len = U16_MAX, done, chunk;
+	struct i2c_msg msgs[2] = {
+		{
+			.addr = client->addr,
+			.flags = client->flags & I2C_M_TEN,
+			.len = sizeof(reg),
+			.buf = &reg,
+		},
+		{
+			.addr = client->addr,
+			.flags = (client->flags & I2C_M_TEN) | I2C_M_RD | I2C_M_DMA_SAFE,
+		},
+	};
+	int ret;
+	
+	if (quirks && quirks->max_read_len)
+		max_len = min_t(size_t, max_len, quirks->max_read_len);
+	if (quirks && quirks->max_comb_2nd_msg_len)
+		max_len = min_t(size_t, max_len, quirks->max_comb_2nd_msg_len);
+	if (data->fifo_burst)
+		max_len = min_t(size_t, max_len, data->fifo_burst);
+	
+	/* FIFO_R_W does not auto-increment, so chunks simply continue the read */
+	for (done = 0; done < len; done += chunk) {
+		chunk = min(len - done, max_len);
+		msgs[1].len = chunk;
+		msgs[1].buf = data->fifo_buf + done;
+		
+		ret = i2c_transfer(client->adapter, msgs, ARRAY_SIZE(msgs));
+		if (ret != ARRAY_SIZE(msgs))
+			return ret < 0 ? ret : -EIO;
+	}
+	
+	return 0;
+}
+
+/**
+ * mpu6050_read_fifo - Read whole frames from the hardware FIFO
+ * @data: Device data structure
+ * @samples: Array of at least @frames entries to unpack into
+ * @frames: Number of frames to read, at most MPU6050_FIFO_SIZE divided
+ *	    by data->fifo_frame_size
+ *
+ * The frames are fetched into data->fifo_buf with raw I2C transfers when
+ * the adapter supports them. SMBus-only adapters go through regmap, which
+ * splits the burst into I2C_SMBUS_BLOCK_MAX sized block reads. The caller
+ * must have checked FIFO_COUNT for that many buffered frames.
+ *
+ * Must be called with data->lock held.
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+int mpu6050_read_fifo(struct mpu6050_data *data,
+		      struct mpu6050_raw_data *samples, unsigned int frames)
+{
+	size_t len = frames * data->fifo_frame_size;
+	ktime_t start = ktime_get();
+	unsigned int i;
+	int ret;
+	
+	if (data->fifo_i2c)
+		ret = mpu6050_fifo_xfer(data, len);
+	else
+		ret = regmap_noinc_read(data->regmap, MPU6050_REG_FIFO_R_W,
+					data->fifo_buf, len);
+	mpu6050_stats_bus(data, start, ret);
+	if (ret) {
+		dev_err(&data->client->dev, "Failed to read FIFO: %d\n", ret);
+		return ret;
+	}
+	
+	for (i = 0; i < frames; i++)
+		mpu6050_unpack_fifo_frame(&data->fifo_buf[i * data->fifo_frame_size],
+					  data->channels, &samples[i]);
+	
+	return 0;
+}
 
 /**
  * mpu6050_write_reg - Write to MPU-6050 register
@@ -40,35 +649,37 @@ int mpu6050_write_reg(struct mpu6050_data *data, u8 reg, u8 val)
 	int ret;
 	
 	mutex_lock(&data->lock);
-	ret = i2c_smbus_write_byte_data(data->client, reg, val);
+	ret = regmap_write(data->regmap, reg, val);
 	mutex_unlock(&data->lock);
 	
-	if (ret < 0)
-		dev_err(data->dev, "Failed to write reg 0x%02x: %d\n", reg, ret);
+	if (ret)
+		dev_err(&data->client->dev, "Failed to write reg 0x%02x: %d\n", reg, ret);
 	
 	return ret;
 }
 
 /**
- * mpu6050_read_raw - Read raw data from MPU-6050
- * @data: Device data structure  
+ * mpu6050_read_raw - Read one 16-bit big-endian value from MPU-6050
+ * @data: Device data structure
  * @reg: Starting register address
  * @val: Pointer to store the read value
  *
+ * For whole samples use mpu6050_read_raw_data(), which fetches all seven
+ * values in a single transfer.
+ *
  * Return: 0 on success, negative error code on failure
  */
 int mpu6050_read_raw(struct mpu6050_data *data, u8 reg, s16 *val)
 {
-	int ret;
 	__be16 raw_val;
+	int ret;
 	
 	mutex_lock(&data->lock);
-	ret = i2c_smbus_read_i2c_block_data(data->client, reg, 
-					    sizeof(raw_val), (u8 *)&raw_val);
+	ret = regmap_bulk_read(data->regmap, reg, &raw_val, sizeof(raw_val));
 	mutex_unlock(&data->lock);
 	
-	if (ret < 0) {
-		dev_err(data->dev, "Failed to read reg 0x%02x: %d\n", reg, ret);
+	if (ret) {
+		dev_err(&data->client->dev, "Failed to read reg 0x%02x: %d\n", reg, ret);
 		return ret;
 	}
 	
@@ -77,96 +688,432 @@ int mpu6050_read_raw(struct mpu6050_data *data, u8 reg, s16 *val)
 }
 
 /**
- * mpu6050_init_device - Initialize MPU-6050 device
+ * mpu6050_set_config - Configure MPU-6050 settings
  * @data: Device data structure
+ * @config: Configuration parameters
  *
  * Return: 0 on success, negative error code on failure
  */
-static int mpu6050_init_device(struct mpu6050_data *data)
+int mpu6050_set_config(struct mpu6050_data *data,
+		       const struct mpu6050_config *config)
 {
 	int ret;
 	
-	/* Reset device */
-	ret = mpu6050_write_reg(data, MPU6050_REG_PWR_MGMT_1, 
-				MPU6050_PWR_MGMT_1_RESET);
-	if (ret < 0)
-		return ret;
+	mutex_lock(&data->lock);
 	
-	msleep(100);
+	/*
+	 * The registers below are cached, so regmap_update_bits() only
+	 * touches the bus for the ones whose value actually changes.
+	 */
 	
-	/* Wake up device */
-	ret = mpu6050_write_reg(data, MPU6050_REG_PWR_MGMT_1, 0);
-	if (ret < 0)
-		return ret;
+	/* Set sample rate divider */
+	ret = regmap_update_bits(data->regmap, MPU6050_REG_SMPLRT_DIV, 0xff,
+				 config->sample_rate_div);
+	if (ret) {
+		dev_err(&data->client->dev, "Failed to set sample rate: %d\n", ret);
+		goto out;
+	}
 	
-	/* Set default ranges */
-	data->gyro_range = 0;	/* ±250°/s */
-	data->accel_range = 0;	/* ±2g */
+	/* Configure DLPF */
+	ret = regmap_update_bits(data->regmap, MPU6050_REG_CONFIG, 0xff,
+				 config->dlpf_cfg);
+	if (ret) {
+		dev_err(&data->client->dev, "Failed to set DLPF config: %d\n", ret);
+		goto out;
+	}
+	
+	/* Configure gyroscope full scale range */
+	ret = regmap_update_bits(data->regmap, MPU6050_REG_GYRO_CONFIG, 0xff,
+				 (config->gyro_range << 3) & MPU6050_GYRO_FS_SEL_MASK);
+	if (ret) {
+		dev_err(&data->client->dev, "Failed to set gyro config: %d\n", ret);
+		goto out;
+	}
+	
+	/* Configure accelerometer full scale range */
+	ret = regmap_update_bits(data->regmap, MPU6050_REG_ACCEL_CONFIG, 0xff,
+				 (config->accel_range << 3) & MPU6050_ACCEL_FS_SEL_MASK);
+	if (ret) {
+		dev_err(&data->client->dev, "Failed to set accel config: %d\n", ret);
+		goto out;
+	}
+	
+	/* Update local configuration and scaling factors */
+	data->config = *config;
+	mpu6050_update_scale_factors(data);
+	mpu6050_latest_invalidate(data);
+	
+out:
+	mutex_unlock(&data->lock);
+	return ret;
+}
+
+/**
+ * mpu6050_get_config - Read back the current configuration
+ * @data: Device data structure
+ * @config: Pointer to store the configuration
+ *
+ * Return: 0
+ */
+int mpu6050_get_config(struct mpu6050_data *data, struct mpu6050_config *config)
+{
+	mutex_lock(&data->lock);
+	*config = data->config;
+	mutex_unlock(&data->lock);
 	
-	dev_info(data->dev, "MPU-6050 initialized successfully\n");
 	return 0;
 }
 
 /**
- * mpu6050_probe - I2C probe function
- * @client: I2C client
- * @id: I2C device ID
+ * mpu6050_fifo_layout - Derive the FIFO sources and frame size
+ * @data: Device data structure
  *
- * Return: 0 on success, negative error code on failure
+ * A FIFO frame holds the enabled channels in register order, followed by
+ * the bytes of every enabled auxiliary slave.
+ *
+ * Must be called with data->lock held while not streaming.
  */
-static int mpu6050_probe(struct i2c_client *client,
-			 const struct i2c_device_id *id)
+static void mpu6050_fifo_layout(struct mpu6050_data *data)
 {
-	struct mpu6050_data *data;
+	u8 channels = data->channels, fifo_en = 0;
+	unsigned int frame_size = data->ext_len;
+	
+	/* FIFO_EN only selects the accelerometer as a whole */
+	if (channels & MPU6050_CHAN_ACCEL) {
+		fifo_en |= MPU6050_FIFO_EN_ACCEL;
+		frame_size += 6;
+	}
+	if (channels & MPU6050_CHAN_TEMP) {
+		fifo_en |= MPU6050_FIFO_EN_TEMP;
+		frame_size += 2;
+	}
+	if (channels & MPU6050_CHAN_GYRO_X) {
+		fifo_en |= MPU6050_FIFO_EN_XG;
+		frame_size += 2;
+	}
+	if (channels & MPU6050_CHAN_GYRO_Y) {
+		fifo_en |= MPU6050_FIFO_EN_YG;
+		frame_size += 2;
+	}
+	if (channels & MPU6050_CHAN_GYRO_Z) {
+		fifo_en |= MPU6050_FIFO_EN_ZG;
+		frame_size += 2;
+	}
+	
+	/* Slave 3 is routed to the FIFO through I2C_MST_CTRL instead */
+	if (data->aux.slave[0].len)
+		fifo_en |= MPU6050_FIFO_EN_SLV0;
+	if (data->aux.slave[1].len)
+		fifo_en |= MPU6050_FIFO_EN_SLV1;
+	if (data->aux.slave[2].len)
+		fifo_en |= MPU6050_FIFO_EN_SLV2;
+	
+	data->fifo_en = fifo_en;
+	data->fifo_frame_size = frame_size;
+}
+
+/**
+ * mpu6050_set_channels - Select which channels are sampled
+ * @data: Device data structure
+ * @channels: MPU6050_CHAN_* mask, must not be empty
+ *
+ * Disabled accelerometer and gyroscope axes are put in standby through
+ * PWR_MGMT_2 and a disabled temperature sensor through TEMP_DIS. The FIFO
+ * sources and frame size used by the next FIFO stream follow the mask. The
+ * clock moves off the gyroscope PLL when no gyroscope axis is left running.
+ *
+ * Return: 0 on success, -EBUSY while streaming, negative error code on
+ * failure
+ */
+int mpu6050_set_channels(struct mpu6050_data *data, u32 channels)
+{
+	unsigned int stby = 0, pwr1 = MPU6050_CLKSEL_INTERNAL;
 	int ret;
 	
-	if (!i2c_check_functionality(client->adapter, I2C_FUNC_SMBUS_I2C_BLOCK)) {
-		dev_err(&client->dev, "I2C adapter doesn't support block transfers\n");
-		return -ENODEV;
+	if (!channels || (channels & ~MPU6050_CHAN_ALL))
+		return -EINVAL;
+	
+	if (!(channels & MPU6050_CHAN_ACCEL_X))
+		stby |= MPU6050_PWR2_STBY_XA;
+	if (!(channels & MPU6050_CHAN_ACCEL_Y))
+		stby |= MPU6050_PWR2_STBY_YA;
+	if (!(channels & MPU6050_CHAN_ACCEL_Z))
+		stby |= MPU6050_PWR2_STBY_ZA;
+	if (!(channels & MPU6050_CHAN_GYRO_X))
+		stby |= MPU6050_PWR2_STBY_XG;
+	if (!(channels & MPU6050_CHAN_GYRO_Y))
+		stby |= MPU6050_PWR2_STBY_YG;
+	if (!(channels & MPU6050_CHAN_GYRO_Z))
+		stby |= MPU6050_PWR2_STBY_ZG;
+	
+	if (!(channels & MPU6050_CHAN_TEMP))
+		pwr1 |= MPU6050_PWR1_TEMP_DIS;
+	
+	if (channels & MPU6050_CHAN_GYRO_X)
+		pwr1 |= MPU6050_CLKSEL_PLL_XGYRO;
+	else if (channels & MPU6050_CHAN_GYRO_Y)
+		pwr1 |= MPU6050_CLKSEL_PLL_YGYRO;
+	else if (channels & MPU6050_CHAN_GYRO_Z)
+		pwr1 |= MPU6050_CLKSEL_PLL_ZGYRO;
+	
+	mutex_lock(&data->lock);
+	
+	if (data->streaming ||
+	    (data->cycle && (channels & ~MPU6050_CHAN_ACCEL))) {
+		ret = -EBUSY;
+		goto out;
 	}
 	
-	data = devm_kzalloc(&client->dev, sizeof(*data), GFP_KERNEL);
-	if (!data)
-		return -ENOMEM;
+	ret = regmap_update_bits(data->regmap, MPU6050_REG_PWR_MGMT_2,
+				 MPU6050_PWR2_STBY_XA | MPU6050_PWR2_STBY_YA |
+				 MPU6050_PWR2_STBY_ZA | MPU6050_PWR2_STBY_XG |
+				 MPU6050_PWR2_STBY_YG | MPU6050_PWR2_STBY_ZG, stby);
+	if (ret) {
+		dev_err(&data->client->dev, "Failed to set standby modes: %d\n", ret);
+		goto out;
+	}
 	
-	data->client = client;
-	data->dev = &client->dev;
-	mutex_init(&data->lock);
+	ret = regmap_update_bits(data->regmap, MPU6050_REG_PWR_MGMT_1,
+				 MPU6050_PWR1_CLKSEL_MASK | MPU6050_PWR1_TEMP_DIS, pwr1);
+	if (ret) {
+		dev_err(&data->client->dev, "Failed to set power management: %d\n", ret);
+		goto out;
+	}
 	
-	i2c_set_clientdata(client, data);
+	data->channels = channels;
+	mpu6050_fifo_layout(data);
+	mpu6050_latest_invalidate(data);
 	
-	ret = mpu6050_init_device(data);
-	if (ret < 0)
-		return ret;
+	/* The clock source may have changed, so re-learn its drift */
+	data->clock_drift_ppb = 0;
 	
-	dev_info(&client->dev, "MPU-6050 probe completed\n");
-	return 0;
+out:
+	mutex_unlock(&data->lock);
+	return ret;
 }
 
 /**
- * mpu6050_remove - I2C remove function
- * @client: I2C client
+ * mpu6050_set_calibration - Set the corrections for scaled readings
+ * @data: Device data structure
+ * @calib: New calibration
+ *
+ * Return: 0 on success, -EINVAL for an out of range correction
  */
-static void mpu6050_remove(struct i2c_client *client)
+int mpu6050_set_calibration(struct mpu6050_data *data,
+			    const struct mpu6050_calibration *calib)
 {
-	struct mpu6050_data *data = i2c_get_clientdata(client);
+	int i;
 	
-	mutex_destroy(&data->lock);
-	dev_info(&client->dev, "MPU-6050 removed\n");
+	for (i = 0; i < 3; i++) {
+		if (abs(calib->accel_bias[i]) > MPU6050_CALIB_MAX_BIAS ||
+		    abs(calib->gyro_bias[i]) > MPU6050_CALIB_MAX_BIAS ||
+		    abs(calib->accel_scale_ppm[i]) > MPU6050_CALIB_MAX_SCALE_PPM ||
+		    abs(calib->gyro_scale_ppm[i]) > MPU6050_CALIB_MAX_SCALE_PPM)
+			return -EINVAL;
+	}
+	
+	mutex_lock(&data->lock);
+	data->calib = *calib;
+	mpu6050_update_scale_factors(data);
+	mutex_unlock(&data->lock);
+	
+	return 0;
 }
 
-static struct i2c_driver mpu6050_driver = {
-	.driver = {
-		.name = "mpu6050",
-		.of_match_table = mpu6050_of_match,
-	},
-	.probe = mpu6050_probe,
-	.remove = mpu6050_remove,
-	.id_table = mpu6050_id,
-};
+/**
+ * mpu6050_set_cycle - Enter or leave low-power cycle mode
+ * @data: Device data structure
+ * @cycle: MPU6050_CYCLE_* wake-up rate, MPU6050_CYCLE_OFF to leave
+ *
+ * Cycle mode needs the gyroscopes in standby and the temperature sensor
+ * disabled, which the accelerometer-only channel mask already provides.
+ *
+ * Return: 0 on success, -EINVAL for an invalid rate or channel mask, -EBUSY
+ * while streaming, negative error code on failure
+ */
+int mpu6050_set_cycle(struct mpu6050_data *data, u32 cycle)
+{
+	int ret;
+	
+	if (cycle > MPU6050_CYCLE_40HZ)
+		return -EINVAL;
+	
+	mutex_lock(&data->lock);
+	
+	if (data->streaming) {
+		ret = -EBUSY;
+		goto out;
+	}
+	
+	if (cycle && (data->channels & ~MPU6050_CHAN_ACCEL)) {
+		ret = -EINVAL;
+		goto out;
+	}
+	
+	if (cycle) {
+		ret = regmap_update_bits(data->regmap, MPU6050_REG_PWR_MGMT_2,
+					 MPU6050_PWR2_LP_WAKE_CTRL_MASK,
+					 (cycle - 1) << MPU6050_PWR2_LP_WAKE_CTRL_SHIFT);
+		if (ret)
+			goto out;
+	}
+	
+	ret = regmap_update_bits(data->regmap, MPU6050_REG_PWR_MGMT_1,
+				 MPU6050_PWR1_CYCLE, cycle ? MPU6050_PWR1_CYCLE : 0);
+	if (ret) {
+		dev_err(&data->client->dev, "Failed to set cycle mode: %d\n", ret);
+		goto out;
+	}
+	
+	WRITE_ONCE(data->cycle, cycle);
+	mpu6050_latest_invalidate(data);
+	
+out:
+	mutex_unlock(&data->lock);
+	return ret;
+}
 
-module_i2c_driver(mpu6050_driver);
+/**
+ * mpu6050_set_aux - Program the auxiliary I2C master
+ * @data: Device data structure
+ * @aux: Slaves to read once per sample
+ *
+ * Each enabled slave reads @len bytes from its sensor into the next free
+ * EXT_SENS_DATA registers, and is added to the FIFO frame. WAIT_FOR_ES
+ * delays data-ready until the external data has arrived, so a sample and
+ * its external bytes always belong together. The master is turned off
+ * while the slaves are reprogrammed and stays off when none is enabled.
+ *
+ * Return: 0 on success, -EINVAL for an invalid configuration, -EBUSY while
+ * streaming, negative error code on failure
+ */
+int mpu6050_set_aux(struct mpu6050_data *data,
+		    const struct mpu6050_aux_config *aux)
+{
+	unsigned int mst_ctrl = MPU6050_I2C_MST_CTRL_WAIT_FOR_ES;
+	unsigned int ext_len = 0;
+	int i, ret;
+	
+	if (aux->clock & ~MPU6050_I2C_MST_CTRL_CLK_MASK ||
+	    memchr_inv(aux->reserved, 0, sizeof(aux->reserved)))
+		return -EINVAL;
+	
+	for (i = 0; i < MPU6050_AUX_SLAVES; i++) {
+		const struct mpu6050_aux_slave *slv = &aux->slave[i];
+		
+		if (!slv->len)
+			continue;
+		if (slv->len > MPU6050_I2C_SLV_CTRL_LEN_MASK || slv->addr > 0x7f ||
+		    (slv->flags & ~MPU6050_AUX_FLAGS))
+			return -EINVAL;
+		ext_len += slv->len;
+	}
+	if (ext_len > MPU6050_EXT_DATA_SIZE)
+		return -EINVAL;
+	
+	mst_ctrl |= aux->clock;
+	if (aux->slave[3].len)
+		mst_ctrl |= MPU6050_I2C_MST_CTRL_SLV_3_FIFO_EN;
+	
+	mutex_lock(&data->lock);
+	
+	if (data->streaming) {
+		ret = -EBUSY;
+		goto out;
+	}
+	
+	ret = regmap_update_bits(data->regmap, MPU6050_REG_USER_CTRL,
+				 MPU6050_USER_CTRL_I2C_MST_EN, 0);
+	if (ret)
+		goto out;
+	
+	for (i = 0; i < MPU6050_AUX_SLAVES; i++) {
+		const struct mpu6050_aux_slave *slv = &aux->slave[i];
+		unsigned int off = i * MPU6050_I2C_SLV_REGS;
+		
+		if (slv->len) {
+			ret = regmap_write(data->regmap, MPU6050_REG_I2C_SLV0_ADDR + off,
+					   MPU6050_I2C_SLV_ADDR_RNW | slv->addr);
+			if (ret)
+				goto out;
+			
+			ret = regmap_write(data->regmap, MPU6050_REG_I2C_SLV0_REG + off,
+					   slv->reg);
+			if (ret)
+				goto out;
+		}
+		
+		ret = regmap_write(data->regmap, MPU6050_REG_I2C_SLV0_CTRL + off,
+				   slv->len ? MPU6050_I2C_SLV_CTRL_EN | slv->flags |
+					      slv->len : 0);
+		if (ret)
+			goto out;
+	}
+	
+	ret = regmap_write(data->regmap, MPU6050_REG_I2C_MST_CTRL, mst_ctrl);
+	if (ret)
+		goto out;
+	
+	if (ext_len) {
+		ret = regmap_update_bits(data->regmap, MPU6050_REG_USER_CTRL,
+					 MPU6050_USER_CTRL_I2C_MST_EN,
+					 MPU6050_USER_CTRL_I2C_MST_EN);
+		if (ret)
+			goto out;
+	}
+	
+	data->aux = *aux;
+	data->ext_len = ext_len;
+	mpu6050_fifo_layout(data);
+	
+out:
+	if (ret && ret != -EBUSY)
+		dev_err(&data->client->dev, "Failed to configure aux I2C master: %d\n", ret);
+	mutex_unlock(&data->lock);
+	return ret;
+}
 
-MODULE_AUTHOR("Murray Kopit <murr2k@gmail.com>");
-MODULE_DESCRIPTION("MPU-6050 6-axis gyroscope and accelerometer driver");
-MODULE_LICENSE("GPL v2");
\ No newline at end of file
+/**
+ * mpu6050_read_ext_data - Read a sample together with external sensor data
+ * @data: Device data structure
+ * @ext: Pointer to store the sample and the external bytes
+ *
+ * EXT_SENS_DATA directly follows the gyroscope output registers, so the
+ * whole sample is one burst from ACCEL_XOUT_H. The latest-sample cache is
+ * refreshed on the way.
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+int mpu6050_read_ext_data(struct mpu6050_data *data,
+			  struct mpu6050_ext_data *ext)
+{
+	u8 buf[MPU6050_FIFO_FRAME_SIZE + MPU6050_EXT_DATA_SIZE];
+	ktime_t start;
+	int ret;
+	
+	BUILD_BUG_ON(MPU6050_REG_EXT_SENS_DATA_00 !=
+		     MPU6050_REG_ACCEL_XOUT_H + MPU6050_FIFO_FRAME_SIZE);
+	
+	memset(ext, 0, sizeof(*ext));
+	
+	mpu6050_lock(data);
+	
+	ext->ext_len = data->ext_len;
+	start = ktime_get();
+	ret = regmap_bulk_read(data->regmap, MPU6050_REG_ACCEL_XOUT_H, buf,
+			       MPU6050_FIFO_FRAME_SIZE + ext->ext_len);
+	mpu6050_stats_bus(data, start, ret);
+	if (ret) {
+		dev_err(&data->client->dev, "Failed to read sensor data: %d\n", ret);
+		goto out;
+	}
+	
+	mpu6050_unpack_sample(buf, &ext->raw);
+	mpu6050_mask_channels(&ext->raw, data->channels);
+	memcpy(ext->ext, buf + MPU6050_FIFO_FRAME_SIZE, ext->ext_len);
+	mpu6050_latest_update(data, &ext->raw, ktime_get());
+	
+out:
+	mutex_unlock(&data->lock);
+	return ret;
+}
@@ -0,0 +1,110 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * MPU-6050 tracepoints
+ *
+ * Hot path events for latency analysis: interrupt entry, start and end of
+ * each acquisition, FIFO drains and reader wakeups. Enable them under
+ * /sys/kernel/tracing/events/mpu6050/.
+ *
+ * Copyright (C) 2025 Murray Kopit <murr2k@gmail.com>
+ */
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM mpu6050
+
+#if !defined(_MPU6050_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _MPU6050_TRACE_H
+
+#include <linux/device.h>
+#include <linux/tracepoint.h>
+
+TRACE_EVENT(mpu6050_irq,
+	TP_PROTO(struct device *dev, int irq),
+	TP_ARGS(dev, irq),
+	TP_STRUCT__entry(
+		__string(name, dev_name(dev))
+		__field(int, irq)
+	),
+	TP_fast_assign(
+		__assign_str(name, dev_name(dev));
+		__entry->irq = irq;
+	),
+	TP_printk("%s irq=%d", __get_str(name), __entry->irq)
+);
+
+TRACE_EVENT(mpu6050_acquire_start,
+	TP_PROTO(struct device *dev, bool fifo, unsigned int pending),
+	TP_ARGS(dev, fifo, pending),
+	TP_STRUCT__entry(
+		__string(name, dev_name(dev))
+		__field(bool, fifo)
+		__field(unsigned int, pending)
+	),
+	TP_fast_assign(
+		__assign_str(name, dev_name(dev));
+		__entry->fifo = fifo;
+		__entry->pending = pending;
+	),
+	TP_printk("%s %s pending=%u", __get_str(name),
+		  __entry->fifo ? "fifo" : "oneshot", __entry->pending)
+);
+
+TRACE_EVENT(mpu6050_acquire_end,
+	TP_PROTO(struct device *dev, bool fifo, int ret),
+	TP_ARGS(dev, fifo, ret),
+	TP_STRUCT__entry(
+		__string(name, dev_name(dev))
+		__field(bool, fifo)
+		__field(int, ret)
+	),
+	TP_fast_assign(
+		__assign_str(name, dev_name(dev));
+		__entry->fifo = fifo;
+		__entry->ret = ret;
+	),
+	TP_printk("%s %s ret=%d", __get_str(name),
+		  __entry->fifo ? "fifo" : "oneshot", __entry->ret)
+);
+
+TRACE_EVENT(mpu6050_fifo_drain,
+	TP_PROTO(struct device *dev, unsigned int bytes, bool overflow),
+	TP_ARGS(dev, bytes, overflow),
+	TP_STRUCT__entry(
+		__string(name, dev_name(dev))
+		__field(unsigned int, bytes)
+		__field(bool, overflow)
+	),
+	TP_fast_assign(
+		__assign_str(name, dev_name(dev));
+		__entry->bytes = bytes;
+		__entry->overflow = overflow;
+	),
+	TP_printk("%s bytes=%u%s", __get_str(name), __entry->bytes,
+		  __entry->overflow ? " overflow" : "")
+);
+
+TRACE_EVENT(mpu6050_wakeup,
+	TP_PROTO(struct device *dev, bool streaming, u32 seq),
+	TP_ARGS(dev, streaming, seq),
+	TP_STRUCT__entry(
+		__string(name, dev_name(dev))
+		__field(bool, streaming)
+		__field(u32, seq)
+	),
+	TP_fast_assign(
+		__assign_str(name, dev_name(dev));
+		__entry->streaming = streaming;
+		__entry->seq = seq;
+	),
+	TP_printk("%s %s seq=%u", __get_str(name),
+		  __entry->streaming ? "head" : "drdy", __entry->seq)
+);
+
+#endif /* _MPU6050_TRACE_H */
+
+/* This part must be outside protection */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE mpu6050_trace
+#include <trace/define_trace.h>
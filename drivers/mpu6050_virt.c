@@ -0,0 +1,547 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * MPU-6050 virtual sensor for benchmarking the driver without hardware
+ *
+ * Registers a virtual I2C adapter and instantiates MPU-6050 clients on it,
+ * much like i2c-stub, so the real driver probes, streams and serves its
+ * character device in a VM with no sensor attached. Register access goes
+ * through a custom regmap bus straight into the device model; the raw FIFO
+ * transfers of mpu6050_fifo_xfer() and i2c-tools go through the adapter.
+ * Both charge the same bus timing: a fixed per-transaction latency plus
+ * nine bit times per byte at the configured bus clock, slept with the bus
+ * held, so concurrent sensors contend for it as on one real adapter.
+ *
+ * The model samples at the rate programmed in SMPLRT_DIV and CONFIG (or a
+ * fixed rate from virt_fifo_rate_hz), fills the FIFO in the FIFO_EN layout
+ * and raises DATA_RDY and FIFO_OFLOW in INT_STATUS. Samples are generated
+ * lazily from the time of each access rather than by a timer, so an idle
+ * virtual sensor costs nothing. There is no interrupt line; the driver
+ * falls back to its polled FIFO drain.
+ *
+ * Built with "make MPU6050_VIRT=1".
+ *
+ * Copyright (C) 2025 Murray Kopit <murr2k@gmail.com>
+ */
+
+#include <linux/bitops.h>
+#include <linux/delay.h>
+#include <linux/i2c.h>
+#include <linux/kernel.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/regmap.h>
+#include <linux/string.h>
+
+#include "../include/mpu6050.h"
+
+#define MPU6050_VIRT_MAX_DEVICES	8
+#define MPU6050_VIRT_NUM_REGS		(MPU6050_REG_WHO_AM_I + 1)
+
+static unsigned int virt_devices = 1;
+module_param(virt_devices, uint, 0444);
+MODULE_PARM_DESC(virt_devices, "Virtual sensors to instantiate, at 0x68 upwards (1-8)");
+
+static unsigned int virt_latency_us;
+module_param(virt_latency_us, uint, 0644);
+MODULE_PARM_DESC(virt_latency_us, "Fixed latency of every virtual bus transaction in us");
+
+static unsigned int virt_bus_khz = 400;
+module_param(virt_bus_khz, uint, 0644);
+MODULE_PARM_DESC(virt_bus_khz, "Virtual bus clock in kHz for per-byte timing, 0 for none");
+
+static unsigned int virt_fifo_rate_hz;
+module_param(virt_fifo_rate_hz, uint, 0644);
+MODULE_PARM_DESC(virt_fifo_rate_hz, "Fixed sample rate in Hz, 0 to follow SMPLRT_DIV and CONFIG");
+
+/**
+ * struct mpu6050_virt - State of one virtual sensor
+ * @client: I2C client instantiated for it, set once it is registered
+ * @regs: Register file
+ * @fifo: FIFO contents, a ring indexed by free-running @fifo_head/@fifo_tail
+ * @fifo_head: Bytes ever pushed
+ * @fifo_tail: Bytes ever popped
+ * @origin: Start of the current sampling run
+ * @run_samples: Samples generated since @origin
+ * @samples: Samples generated before the current run
+ *
+ * A run restarts whenever the sample rate, the FIFO layout or the power
+ * state changes, so the sample clock never has to be converted.
+ */
+struct mpu6050_virt {
+	struct i2c_client *client;
+	u8 regs[MPU6050_VIRT_NUM_REGS];
+	u8 fifo[MPU6050_FIFO_SIZE];
+	unsigned int fifo_head;
+	unsigned int fifo_tail;
+	ktime_t origin;
+	u64 run_samples;
+	u64 samples;
+};
+
+/* One virtual bus: transactions on any of its sensors serialize here */
+static DEFINE_MUTEX(mpu6050_virt_lock);
+static struct mpu6050_virt mpu6050_virt_devs[MPU6050_VIRT_MAX_DEVICES];
+
+static struct i2c_adapter mpu6050_virt_adapter;
+
+/* Sensor n answers at MPU6050_I2C_ADDR_AD0_LOW + n */
+static struct mpu6050_virt *mpu6050_virt_find(u16 addr)
+{
+	unsigned int n = addr - MPU6050_I2C_ADDR_AD0_LOW;
+	
+	if (addr < MPU6050_I2C_ADDR_AD0_LOW || n >= virt_devices)
+		return NULL;
+	
+	return &mpu6050_virt_devs[n];
+}
+
+/**
+ * mpu6050_virt_bus_time - Charge a transaction to the virtual bus
+ * @bytes: Bytes on the wire, address bytes included
+ *
+ * Must be called with mpu6050_virt_lock held, which keeps the bus busy for
+ * the duration as on real hardware.
+ */
+static void mpu6050_virt_bus_time(size_t bytes)
+{
+	unsigned int khz = READ_ONCE(virt_bus_khz);
+	u64 ns = (u64)READ_ONCE(virt_latency_us) * NSEC_PER_USEC;
+	
+	if (khz)
+		ns += div_u64((u64)bytes * 9 * NSEC_PER_MSEC, khz);
+	if (ns)
+		fsleep(DIV_ROUND_UP_ULL(ns, NSEC_PER_USEC));
+}
+
+static void mpu6050_virt_reset(struct mpu6050_virt *virt)
+{
+	memset(virt->regs, 0, sizeof(virt->regs));
+	virt->regs[MPU6050_REG_PWR_MGMT_1] = MPU6050_PWR1_SLEEP;
+	virt->regs[MPU6050_REG_WHO_AM_I] = MPU6050_WHO_AM_I_VAL;
+	virt->fifo_head = 0;
+	virt->fifo_tail = 0;
+	virt->run_samples = 0;
+	virt->origin = ktime_get();
+}
+
+static bool mpu6050_virt_sampling(struct mpu6050_virt *virt)
+{
+	return !(virt->regs[MPU6050_REG_PWR_MGMT_1] & MPU6050_PWR1_SLEEP);
+}
+
+static u32 mpu6050_virt_rate_hz(struct mpu6050_virt *virt)
+{
+	u8 dlpf = virt->regs[MPU6050_REG_CONFIG] & MPU6050_DLPF_CFG_MASK;
+	u32 rate = READ_ONCE(virt_fifo_rate_hz);
+	
+	if (rate)
+		return rate;
+	
+	/* Gyro output rate is 8 kHz with the DLPF off, else 1 kHz */
+	return (dlpf == 0 || dlpf == 7 ? 8000 : 1000) /
+	       (1 + virt->regs[MPU6050_REG_SMPLRT_DIV]);
+}
+
+/**
+ * mpu6050_virt_sample - Readings of sample @n
+ * @virt: Virtual sensor
+ * @n: Sample number since the sensor was created
+ * @raw: Readings to fill in
+ *
+ * Gravity on Z at the programmed range plus small ramps, so consecutive
+ * frames differ and misaligned or repeated frames show up in the data.
+ */
+static void mpu6050_virt_sample(struct mpu6050_virt *virt, u64 n,
+				struct mpu6050_raw_data *raw)
+{
+	u8 afs = (virt->regs[MPU6050_REG_ACCEL_CONFIG] & MPU6050_ACCEL_FS_SEL_MASK) >> 3;
+	s16 ramp = (s16)(n % 256) - 128;
+	
+	raw->accel_x = ramp;
+	raw->accel_y = -ramp;
+	raw->accel_z = 16384 >> afs;
+	raw->temp = -3920;	/* 25 degrees Celsius */
+	raw->gyro_x = ramp / 8;
+	raw->gyro_y = -ramp / 8;
+	raw->gyro_z = (s16)(n % 16);
+}
+
+/**
+ * mpu6050_virt_push_frame - Append sample @n to the FIFO
+ * @virt: Virtual sensor
+ * @n: Sample number
+ *
+ * A full FIFO drops the frame and raises FIFO_OFLOW, keeping the FIFO
+ * frame aligned like the I2C simulator does.
+ */
+static void mpu6050_virt_push_frame(struct mpu6050_virt *virt, u64 n)
+{
+	u8 sources = virt->regs[MPU6050_REG_FIFO_EN];
+	struct mpu6050_raw_data raw;
+	s16 words[MPU6050_NUM_CHANNELS];
+	unsigned int i, len = 0;
+	
+	mpu6050_virt_sample(virt, n, &raw);
+	
+	if (sources & MPU6050_FIFO_EN_ACCEL) {
+		words[len++] = raw.accel_x;
+		words[len++] = raw.accel_y;
+		words[len++] = raw.accel_z;
+	}
+	if (sources & MPU6050_FIFO_EN_TEMP)
+		words[len++] = raw.temp;
+	if (sources & MPU6050_FIFO_EN_XG)
+		words[len++] = raw.gyro_x;
+	if (sources & MPU6050_FIFO_EN_YG)
+		words[len++] = raw.gyro_y;
+	if (sources & MPU6050_FIFO_EN_ZG)
+		words[len++] = raw.gyro_z;
+	
+	if (!len)
+		return;
+	if (virt->fifo_head - virt->fifo_tail + 2 * len > MPU6050_FIFO_SIZE) {
+		virt->regs[MPU6050_REG_INT_STATUS] |= MPU6050_INT_FIFO_OFLOW;
+		return;
+	}
+	
+	for (i = 0; i < len; i++) {
+		virt->fifo[virt->fifo_head++ % MPU6050_FIFO_SIZE] = (u16)words[i] >> 8;
+		virt->fifo[virt->fifo_head++ % MPU6050_FIFO_SIZE] = (u16)words[i] & 0xff;
+	}
+}
+
+/**
+ * mpu6050_virt_advance - Generate every sample due by @now
+ * @virt: Virtual sensor
+ * @now: Current time
+ *
+ * Must be called with mpu6050_virt_lock held.
+ */
+static void mpu6050_virt_advance(struct mpu6050_virt *virt, ktime_t now)
+{
+	bool fifo = (virt->regs[MPU6050_REG_USER_CTRL] & MPU6050_USER_CTRL_FIFO_EN) &&
+		    virt->regs[MPU6050_REG_FIFO_EN];
+	u64 due, n;
+	
+	if (!mpu6050_virt_sampling(virt))
+		return;
+	
+	due = mul_u64_u32_div(ktime_to_ns(ktime_sub(now, virt->origin)),
+			      mpu6050_virt_rate_hz(virt), NSEC_PER_SEC);
+	if (due == virt->run_samples)
+		return;
+	
+	/* Frames beyond what an empty FIFO holds would all be dropped */
+	n = virt->run_samples;
+	if (fifo && due - n > MPU6050_FIFO_SIZE / 2) {
+		n = due - MPU6050_FIFO_SIZE / 2;
+		virt->regs[MPU6050_REG_INT_STATUS] |= MPU6050_INT_FIFO_OFLOW;
+	}
+	for (; fifo && n < due; n++)
+		mpu6050_virt_push_frame(virt, virt->samples + n);
+	
+	virt->run_samples = due;
+	virt->regs[MPU6050_REG_INT_STATUS] |= MPU6050_INT_DATA_RDY;
+}
+
+/* Close the current sampling run and start a new one at @now */
+static void mpu6050_virt_rebase(struct mpu6050_virt *virt, ktime_t now)
+{
+	mpu6050_virt_advance(virt, now);
+	virt->samples += virt->run_samples;
+	virt->run_samples = 0;
+	virt->origin = now;
+}
+
+/* Latch the latest sample into the output registers */
+static void mpu6050_virt_latch(struct mpu6050_virt *virt)
+{
+	struct mpu6050_raw_data raw;
+	u64 n = virt->samples + virt->run_samples;
+	unsigned int chan;
+	
+	mpu6050_virt_sample(virt, n ? n - 1 : 0, &raw);
+	for (chan = 0; chan < MPU6050_NUM_CHANNELS; chan++) {
+		s16 val = mpu6050_raw_chan(&raw, chan);
+	
+		virt->regs[MPU6050_REG_ACCEL_XOUT_H + 2 * chan] = (u16)val >> 8;
+		virt->regs[MPU6050_REG_ACCEL_XOUT_H + 2 * chan + 1] = (u16)val & 0xff;
+	}
+}
+
+/**
+ * mpu6050_virt_read - Read @len registers starting at @reg
+ * @virt: Virtual sensor
+ * @reg: First register
+ * @buf: Buffer to fill
+ * @len: Number of bytes
+ *
+ * Addresses auto-increment, except on FIFO_R_W where every byte is the
+ * next one out of the FIFO. Must be called with mpu6050_virt_lock held.
+ */
+static void mpu6050_virt_read(struct mpu6050_virt *virt, u8 reg, u8 *buf,
+			      size_t len)
+{
+	unsigned int count;
+	size_t i;
+	
+	mpu6050_virt_advance(virt, ktime_get());
+	if (reg <= MPU6050_REG_GYRO_ZOUT_H + 1 &&
+	    reg + len > MPU6050_REG_ACCEL_XOUT_H)
+		mpu6050_virt_latch(virt);
+	
+	for (i = 0; i < len; i++) {
+		u8 addr = reg == MPU6050_REG_FIFO_R_W ? reg : reg + i;
+	
+		switch (addr) {
+		case MPU6050_REG_FIFO_R_W:
+			buf[i] = 0;
+			if (virt->fifo_tail != virt->fifo_head)
+				buf[i] = virt->fifo[virt->fifo_tail++ % MPU6050_FIFO_SIZE];
+			break;
+		case MPU6050_REG_FIFO_COUNTH:
+		case MPU6050_REG_FIFO_COUNTL:
+			count = virt->fifo_head - virt->fifo_tail;
+			buf[i] = addr == MPU6050_REG_FIFO_COUNTH ? count >> 8 : count & 0xff;
+			break;
+		case MPU6050_REG_INT_STATUS:
+			buf[i] = virt->regs[addr];
+			virt->regs[addr] = 0;
+			break;
+		default:
+			buf[i] = addr < MPU6050_VIRT_NUM_REGS ? virt->regs[addr] : 0;
+			break;
+		}
+	}
+}
+
+/**
+ * mpu6050_virt_write - Write @len registers starting at @reg
+ * @virt: Virtual sensor
+ * @reg: First register
+ * @buf: Values
+ * @len: Number of bytes
+ *
+ * Must be called with mpu6050_virt_lock held.
+ */
+static void mpu6050_virt_write(struct mpu6050_virt *virt, u8 reg,
+			       const u8 *buf, size_t len)
+{
+	ktime_t now = ktime_get();
+	size_t i;
+	
+	for (i = 0; i < len; i++) {
+		u8 addr = reg + i;
+		u8 val = buf[i];
+	
+		if (addr >= MPU6050_VIRT_NUM_REGS || addr == MPU6050_REG_WHO_AM_I)
+			continue;
+	
+		switch (addr) {
+		case MPU6050_REG_PWR_MGMT_1:
+			if (val & MPU6050_PWR1_DEVICE_RESET) {
+				/* Completes at once; DEVICE_RESET reads back clear */
+				mpu6050_virt_reset(virt);
+				continue;
+			}
+			fallthrough;
+		case MPU6050_REG_SMPLRT_DIV:
+		case MPU6050_REG_CONFIG:
+		case MPU6050_REG_FIFO_EN:
+			mpu6050_virt_rebase(virt, now);
+			virt->regs[addr] = val;
+			break;
+		case MPU6050_REG_USER_CTRL:
+			mpu6050_virt_rebase(virt, now);
+			if (val & MPU6050_USER_CTRL_FIFO_RESET) {
+				virt->fifo_tail = virt->fifo_head;
+				virt->regs[MPU6050_REG_INT_STATUS] &= ~MPU6050_INT_FIFO_OFLOW;
+			}
+			/* The reset bits are self-clearing */
+			virt->regs[addr] = val & ~(MPU6050_USER_CTRL_FIFO_RESET |
+						   MPU6050_USER_CTRL_I2C_MST_RESET |
+						   MPU6050_USER_CTRL_SIG_COND_RESET);
+			break;
+		case MPU6050_REG_FIFO_R_W:
+		case MPU6050_REG_INT_STATUS:
+		case MPU6050_REG_FIFO_COUNTH:
+		case MPU6050_REG_FIFO_COUNTL:
+			break;
+		default:
+			virt->regs[addr] = val;
+			break;
+		}
+	}
+}
+
+/* Custom regmap bus: 8-bit register, then the values */
+
+static int mpu6050_virt_regmap_read(void *context, const void *reg_buf,
+				    size_t reg_size, void *val_buf,
+				    size_t val_size)
+{
+	struct mpu6050_virt *virt = context;
+	
+	mutex_lock(&mpu6050_virt_lock);
+	mpu6050_virt_read(virt, *(const u8 *)reg_buf, val_buf, val_size);
+	/* Address write, register, repeated start with address, data */
+	mpu6050_virt_bus_time(reg_size + val_size + 2);
+	mutex_unlock(&mpu6050_virt_lock);
+	
+	return 0;
+}
+
+static int mpu6050_virt_regmap_write(void *context, const void *data,
+				     size_t count)
+{
+	struct mpu6050_virt *virt = context;
+	const u8 *buf = data;
+	
+	if (count < 1)
+		return -EINVAL;
+	
+	mutex_lock(&mpu6050_virt_lock);
+	mpu6050_virt_write(virt, buf[0], buf + 1, count - 1);
+	mpu6050_virt_bus_time(count + 1);
+	mutex_unlock(&mpu6050_virt_lock);
+	
+	return 0;
+}
+
+static const struct regmap_bus mpu6050_virt_regmap_bus = {
+	.read = mpu6050_virt_regmap_read,
+	.write = mpu6050_virt_regmap_write,
+	.reg_format_endian_default = REGMAP_ENDIAN_BIG,
+	.val_format_endian_default = REGMAP_ENDIAN_BIG,
+};
+
+/**
+ * mpu6050_virt_regmap_init - Bind a client to the virtual sensor model
+ * @client: I2C client being probed
+ * @config: Regmap configuration
+ *
+ * Returns: a device-managed regmap on the custom bus for clients on the
+ * virtual adapter, NULL for any other client, or an ERR_PTR() on failure
+ */
+struct regmap *mpu6050_virt_regmap_init(struct i2c_client *client,
+					const struct regmap_config *config)
+{
+	struct mpu6050_virt *virt;
+	
+	if (client->adapter != &mpu6050_virt_adapter)
+		return NULL;
+	
+	virt = mpu6050_virt_find(client->addr);
+	if (!virt)
+		return ERR_PTR(-ENODEV);
+	
+	return devm_regmap_init(&client->dev, &mpu6050_virt_regmap_bus, virt,
+				config);
+}
+
+/* Virtual adapter, for raw transfers and i2c-tools */
+
+static int mpu6050_virt_xfer(struct i2c_adapter *adap, struct i2c_msg *msgs,
+			     int num)
+{
+	struct mpu6050_virt *virt = mpu6050_virt_find(msgs[0].addr);
+	size_t bytes = 0;
+	u8 reg = 0;
+	int i;
+	
+	if (!virt)
+		return -ENXIO;
+	
+	mutex_lock(&mpu6050_virt_lock);
+	for (i = 0; i < num; i++) {
+		struct i2c_msg *msg = &msgs[i];
+	
+		bytes += msg->len + 1;
+		if (msg->flags & I2C_M_RD) {
+			mpu6050_virt_read(virt, reg, msg->buf, msg->len);
+		} else if (msg->len) {
+			reg = msg->buf[0];
+			mpu6050_virt_write(virt, reg, msg->buf + 1, msg->len - 1);
+		}
+	}
+	mpu6050_virt_bus_time(bytes);
+	mutex_unlock(&mpu6050_virt_lock);
+	
+	return num;
+}
+
+static u32 mpu6050_virt_functionality(struct i2c_adapter *adap)
+{
+	return I2C_FUNC_I2C | I2C_FUNC_SMBUS_EMUL;
+}
+
+static const struct i2c_algorithm mpu6050_virt_algo = {
+	.master_xfer = mpu6050_virt_xfer,
+	.functionality = mpu6050_virt_functionality,
+};
+
+static struct i2c_adapter mpu6050_virt_adapter = {
+	.owner = THIS_MODULE,
+	.class = I2C_CLASS_HWMON,
+	.algo = &mpu6050_virt_algo,
+	.name = "MPU-6050 virtual bus",
+};
+
+/**
+ * mpu6050_virt_init - Register the virtual bus and its sensors
+ *
+ * Called once the I2C driver is registered, so every sensor probes
+ * through the regular driver path.
+ *
+ * Returns: 0 on success, negative error code on failure
+ */
+int mpu6050_virt_init(void)
+{
+	struct i2c_board_info info = { I2C_BOARD_INFO("mpu6050", 0) };
+	struct i2c_client *client;
+	unsigned int i;
+	int ret;
+	
+	if (!virt_devices || virt_devices > MPU6050_VIRT_MAX_DEVICES) {
+		pr_err("mpu6050: virt_devices must be 1-%d\n", MPU6050_VIRT_MAX_DEVICES);
+		return -EINVAL;
+	}
+	
+	/* The models have to be ready before the first client probes */
+	for (i = 0; i < virt_devices; i++)
+		mpu6050_virt_reset(&mpu6050_virt_devs[i]);
+	
+	ret = i2c_add_adapter(&mpu6050_virt_adapter);
+	if (ret)
+		return ret;
+	
+	for (i = 0; i < virt_devices; i++) {
+		info.addr = MPU6050_I2C_ADDR_AD0_LOW + i;
+		client = i2c_new_client_device(&mpu6050_virt_adapter, &info);
+		if (IS_ERR(client)) {
+			mpu6050_virt_exit();
+			return PTR_ERR(client);
+		}
+		mpu6050_virt_devs[i].client = client;
+	}
+	
+	pr_info("mpu6050: %u virtual sensor(s) on %s\n", virt_devices,
+		mpu6050_virt_adapter.name);
+	return 0;
+}
+
+/**
+ * mpu6050_virt_exit - Remove the virtual sensors and their bus
+ */
+void mpu6050_virt_exit(void)
+{
+	unsigned int i;
+	
+	for (i = 0; i < ARRAY_SIZE(mpu6050_virt_devs); i++) {
+		i2c_unregister_device(mpu6050_virt_devs[i].client);
+		mpu6050_virt_devs[i].client = NULL;
+	}
+	i2c_del_adapter(&mpu6050_virt_adapter);
+}
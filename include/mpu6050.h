@@ -8,12 +8,48 @@
 #ifndef _MPU6050_H_
 #define _MPU6050_H_
 
+#ifdef __KERNEL__
+#include <linux/cdev.h>
 #include <linux/device.h>
 #include <linux/i2c.h>
 #include <linux/ioctl.h>
+#include <linux/ktime.h>
+#include <linux/kref.h>
 #include <linux/mutex.h>
 #include <linux/regmap.h>
+#include <linux/rwsem.h>
+#include <linux/seqlock.h>
+#include <linux/stddef.h>
 #include <linux/types.h>
+#include <linux/wait.h>
+#include <linux/workqueue.h>
+
+struct dentry;
+struct mpu6050_group;
+struct iio_dev;
+struct iio_trigger;
+#else
+/*
+ * Userspace sees the register map, the ABI structures, the ioctls and the
+ * inline helpers; the driver state below is kernel only.
+ */
+#include <stddef.h>
+#include <linux/ioctl.h>
+#include <linux/types.h>
+
+typedef __u8 u8;
+typedef __s8 s8;
+typedef __u16 u16;
+typedef __s16 s16;
+typedef __u32 u32;
+typedef __s32 s32;
+typedef __u64 u64;
+typedef __s64 s64;
+
+#ifndef BIT
+#define BIT(nr)				(1UL << (nr))
+#endif
+#endif /* __KERNEL__ */
 
 /* MPU-6050 I2C addresses */
 #define MPU6050_I2C_ADDR_AD0_LOW	0x68
@@ -132,6 +168,77 @@
 #define MPU6050_PWR2_STBY_YA		BIT(4)
 #define MPU6050_PWR2_STBY_XA		BIT(5)
 #define MPU6050_PWR2_LP_WAKE_CTRL_MASK	0xC0
+#define MPU6050_PWR2_LP_WAKE_CTRL_SHIFT	6
+
+/* FIFO enable register bits */
+#define MPU6050_FIFO_EN_SLV0		BIT(0)
+#define MPU6050_FIFO_EN_SLV1		BIT(1)
+#define MPU6050_FIFO_EN_SLV2		BIT(2)
+#define MPU6050_FIFO_EN_ACCEL		BIT(3)
+#define MPU6050_FIFO_EN_ZG		BIT(4)
+#define MPU6050_FIFO_EN_YG		BIT(5)
+#define MPU6050_FIFO_EN_XG		BIT(6)
+#define MPU6050_FIFO_EN_TEMP		BIT(7)
+
+/* User control register bits */
+#define MPU6050_USER_CTRL_SIG_COND_RESET	BIT(0)
+#define MPU6050_USER_CTRL_I2C_MST_RESET	BIT(1)
+#define MPU6050_USER_CTRL_FIFO_RESET	BIT(2)
+#define MPU6050_USER_CTRL_I2C_IF_DIS	BIT(4)
+#define MPU6050_USER_CTRL_I2C_MST_EN	BIT(5)
+#define MPU6050_USER_CTRL_FIFO_EN	BIT(6)
+
+/* Auxiliary I2C master register bits */
+#define MPU6050_I2C_MST_CTRL_CLK_MASK		0x0F
+#define MPU6050_I2C_MST_CTRL_SLV_3_FIFO_EN	BIT(5)
+#define MPU6050_I2C_MST_CTRL_WAIT_FOR_ES	BIT(6)
+#define MPU6050_I2C_MST_CLK_400KHZ		13
+#define MPU6050_I2C_SLV_ADDR_RNW		BIT(7)
+#define MPU6050_I2C_SLV_CTRL_LEN_MASK		0x0F
+#define MPU6050_I2C_SLV_CTRL_GRP		BIT(4)
+#define MPU6050_I2C_SLV_CTRL_REG_DIS		BIT(5)
+#define MPU6050_I2C_SLV_CTRL_BYTE_SW		BIT(6)
+#define MPU6050_I2C_SLV_CTRL_EN			BIT(7)
+#define MPU6050_I2C_SLV_REGS			3  /* ADDR, REG, CTRL per slave */
+
+/* Interrupt pin configuration register bits */
+#define MPU6050_INT_PIN_CFG_I2C_BYPASS_EN	BIT(1)
+#define MPU6050_INT_PIN_CFG_FSYNC_INT_EN	BIT(2)
+#define MPU6050_INT_PIN_CFG_FSYNC_INT_LEVEL	BIT(3)
+#define MPU6050_INT_PIN_CFG_INT_RD_CLEAR	BIT(4)
+#define MPU6050_INT_PIN_CFG_LATCH_INT_EN	BIT(5)
+#define MPU6050_INT_PIN_CFG_INT_OPEN		BIT(6)
+#define MPU6050_INT_PIN_CFG_INT_LEVEL		BIT(7)
+
+/* Interrupt enable/status register bits */
+#define MPU6050_INT_DATA_RDY		BIT(0)
+#define MPU6050_INT_I2C_MST		BIT(3)
+#define MPU6050_INT_FIFO_OFLOW		BIT(4)
+
+/* FIFO geometry */
+#define MPU6050_FIFO_SIZE		1024  /* bytes */
+#define MPU6050_FIFO_FRAME_SIZE		14    /* accel + temp + gyro, big-endian */
+#define MPU6050_EXT_DATA_SIZE		24    /* EXT_SENS_DATA_00..23 */
+
+/*
+ * Channel mask bits, one per member of struct mpu6050_raw_data and in the
+ * same order. Disabled sensors are put in standby, left out of the FIFO and
+ * left out of packed streaming records.
+ */
+#define MPU6050_CHAN_ACCEL_X		BIT(0)
+#define MPU6050_CHAN_ACCEL_Y		BIT(1)
+#define MPU6050_CHAN_ACCEL_Z		BIT(2)
+#define MPU6050_CHAN_TEMP		BIT(3)
+#define MPU6050_CHAN_GYRO_X		BIT(4)
+#define MPU6050_CHAN_GYRO_Y		BIT(5)
+#define MPU6050_CHAN_GYRO_Z		BIT(6)
+#define MPU6050_CHAN_ACCEL		(MPU6050_CHAN_ACCEL_X | MPU6050_CHAN_ACCEL_Y | \
+					 MPU6050_CHAN_ACCEL_Z)
+#define MPU6050_CHAN_GYRO		(MPU6050_CHAN_GYRO_X | MPU6050_CHAN_GYRO_Y | \
+					 MPU6050_CHAN_GYRO_Z)
+#define MPU6050_CHAN_ALL		(MPU6050_CHAN_ACCEL | MPU6050_CHAN_TEMP | \
+					 MPU6050_CHAN_GYRO)
+#define MPU6050_NUM_CHANNELS		7
 
 /* Gyroscope configuration */
 #define MPU6050_GYRO_FS_SEL_MASK	0x18
@@ -189,6 +296,181 @@ struct mpu6050_raw_data {
 	s16 gyro_z;
 };
 
+/* Channel @n of @raw, in MPU6050_CHAN_* bit order */
+#define mpu6050_raw_chan(raw, n)	(((s16 *)(raw))[n])
+
+/* Sample record flags */
+#define MPU6050_SAMPLE_FIFO_OVERFLOW	BIT(0)  /* Samples were lost before this one */
+
+/**
+ * struct mpu6050_sample - Timestamped sample record from the streaming buffer
+ * @timestamp: Acquisition time in nanoseconds (CLOCK_MONOTONIC)
+ * @seq: Sample sequence number, incremented by one per acquired sample
+ *	 (wraps at 2^32)
+ * @flags: MPU6050_SAMPLE_* flags
+ * @raw: Raw sensor data
+ * @reserved: Always zero
+ */
+struct mpu6050_sample {
+	s64 timestamp;
+	u32 seq;
+	u16 flags;
+	struct mpu6050_raw_data raw;
+	u8 reserved[4];
+};
+
+/**
+ * struct mpu6050_record - Packed sample record from the streaming buffer
+ * @timestamp: Acquisition time in nanoseconds (CLOCK_MONOTONIC)
+ * @seq: Sample sequence number, as in struct mpu6050_sample
+ * @flags: MPU6050_SAMPLE_* flags
+ * @data: Raw readings of the enabled channels only, in MPU6050_CHAN_* bit
+ *	  order, followed by the external sensor bytes of the auxiliary I2C
+ *	  slaves and zero padding up to MPU6050_RECORD_EXT_SIZE()
+ *
+ * With every channel enabled and no auxiliary slaves a record is laid out
+ * exactly like struct mpu6050_sample. @data is sized for every channel so
+ * the header stays valid C++; use MPU6050_RECORD_EXT_SIZE(), never sizeof,
+ * for the size of a record in the buffer.
+ */
+struct mpu6050_record {
+	s64 timestamp;
+	u32 seq;
+	u16 flags;
+	s16 data[MPU6050_NUM_CHANNELS];
+};
+
+/* Size of a packed record carrying @n channels and @ext external bytes */
+#define MPU6050_RECORD_EXT_SIZE(n, ext) \
+	((offsetof(struct mpu6050_record, data) + 2 * (n) + (ext) + 7) & ~7UL)
+#define MPU6050_RECORD_SIZE(n)		MPU6050_RECORD_EXT_SIZE(n, 0)
+
+/* External sensor bytes of record @rec carrying @n channels */
+#define mpu6050_record_ext(rec, n) \
+	((u8 *)(rec) + offsetof(struct mpu6050_record, data) + 2 * (n))
+
+/* Number of auxiliary I2C slaves that feed EXT_SENS_DATA and the FIFO */
+#define MPU6050_AUX_SLAVES		4
+
+/* struct mpu6050_aux_slave flags, as in I2C_SLVx_CTRL */
+#define MPU6050_AUX_BYTE_SWAP		MPU6050_I2C_SLV_CTRL_BYTE_SW
+#define MPU6050_AUX_GROUP_ODD		MPU6050_I2C_SLV_CTRL_GRP
+#define MPU6050_AUX_FLAGS		(MPU6050_AUX_BYTE_SWAP | MPU6050_AUX_GROUP_ODD)
+
+/**
+ * struct mpu6050_aux_slave - External sensor read by the auxiliary I2C master
+ * @addr: 7-bit address of the sensor on the auxiliary bus
+ * @reg: First sensor register to read
+ * @len: Number of bytes to read each sample, 0 to 15; 0 disables the slave
+ * @flags: MPU6050_AUX_* flags
+ */
+struct mpu6050_aux_slave {
+	u8 addr;
+	u8 reg;
+	u8 len;
+	u8 flags;
+};
+
+/**
+ * struct mpu6050_aux_config - Argument of MPU6050_IOC_SET_AUX/GET_AUX
+ * @slave: Slaves 0 to 3, read in this order once per sample
+ * @clock: I2C_MST_CLK divider code, MPU6050_I2C_MST_CLK_400KHZ for 400 kHz
+ * @reserved: Must be zero
+ *
+ * The enabled slaves may read MPU6050_EXT_DATA_SIZE bytes in total.
+ */
+struct mpu6050_aux_config {
+	struct mpu6050_aux_slave slave[MPU6050_AUX_SLAVES];
+	u8 clock;
+	u8 reserved[3];
+};
+
+/**
+ * struct mpu6050_ext_data - Sample with external sensor data
+ * @raw: Raw readings, disabled channels are zero
+ * @ext_len: Number of valid bytes in @ext
+ * @reserved: Always zero
+ * @ext: External sensor bytes, slave 0 first
+ */
+struct mpu6050_ext_data {
+	struct mpu6050_raw_data raw;
+	u8 ext_len;
+	u8 reserved;
+	u8 ext[MPU6050_EXT_DATA_SIZE];
+};
+
+/*
+ * Memory-mapped sample ring
+ *
+ * mmap() of the character device at offset 0 maps the streaming buffer
+ * read-only: a header page (struct mpu6050_ring_header) followed by
+ * @nr_records struct mpu6050_record records of @record_size bytes each,
+ * starting at @data_offset. The record with sequence number S lives at
+ * index (S & (nr_records - 1)). Records carry the channels in @channels,
+ * then @ext_len external sensor bytes.
+ *
+ * The driver writes each record and then publishes it by storing S + 1 to
+ * @head with release semantics. It starts overwriting the next slot only
+ * after that store. A consumer with read position @tail therefore:
+ *
+ *  1. loads @head with acquire semantics (h1);
+ *  2. copies the records with sequence numbers tail .. h1 - 1;
+ *  3. issues a read barrier (acquire fence) and loads @head again (h2);
+ *  4. treats every copied record older than h2 - nr_records + 1 as lost,
+ *     because it may have been overwritten while it was being copied;
+ *  5. sets tail = h1.
+ *
+ * All sequence numbers are 32-bit and wrap; compare them with signed
+ * differences.
+ *
+ * The layout only changes while streaming is off, when the channel mask
+ * or the auxiliary slaves were changed. The driver then advances @head by
+ * nr_records - 1, so copies in flight fail step 4, and stores the new head
+ * in @layout_seq. Records older than @layout_seq use an earlier layout and
+ * must be skipped without being counted as lost; @record_size and
+ * @channels are valid from there on. The consumer never writes to the
+ * mapping and never blocks the producer. On a mapped file poll() only
+ * serves as a wakeup: each time it reports EPOLLIN the file's read
+ * position moves to the current head, so the next EPOLLIN means new
+ * records were published.
+ */
+#define MPU6050_RING_MAGIC		0x4d505536  /* "MPU6" */
+#define MPU6050_RING_VERSION		2
+
+/**
+ * struct mpu6050_ring_header - Header page of the memory-mapped ring
+ * @magic: MPU6050_RING_MAGIC
+ * @version: MPU6050_RING_VERSION
+ * @nr_records: Number of records in the ring, a power of two
+ * @record_size: Size of one record in bytes
+ * @data_offset: Offset of record 0 from the start of the mapping
+ * @head: Sequence number of the next record to be written
+ * @fifo_overflows: Number of hardware FIFO overflows since probe
+ * @channels: MPU6050_CHAN_* mask of the channels in each record
+ * @layout_seq: Sequence number of the first record in the current layout
+ * @period_ns: Sample period in CLOCK_MONOTONIC nanoseconds, corrected for
+ *	       the measured sensor clock drift, zero before the first batch
+ * @clock_drift_ppb: Sensor clock drift against CLOCK_MONOTONIC in parts
+ *		     per billion, positive when the sensor runs slow
+ * @ext_len: Number of external sensor bytes in each record
+ * @reserved: Always zero
+ */
+struct mpu6050_ring_header {
+	u32 magic;
+	u32 version;
+	u32 nr_records;
+	u32 record_size;
+	u32 data_offset;
+	u32 head;
+	u32 fifo_overflows;
+	u32 channels;
+	u32 layout_seq;
+	u32 period_ns;
+	s32 clock_drift_ppb;
+	u32 ext_len;
+	u32 reserved[4];
+};
+
 /**
  * struct mpu6050_scaled_data - Scaled sensor data from MPU-6050
  * @accel_x: X-axis acceleration in milli-g (mg)
@@ -209,6 +491,116 @@ struct mpu6050_scaled_data {
 	s32 temp;
 };
 
+/**
+ * struct mpu6050_scaled_sample - Timestamped scaled record for batch reads
+ * @timestamp: Acquisition time in nanoseconds (CLOCK_MONOTONIC)
+ * @seq: Sample sequence number, as in struct mpu6050_sample
+ * @flags: MPU6050_SAMPLE_* flags
+ * @reserved: Always zero
+ * @scaled: Scaled sensor data
+ */
+struct mpu6050_scaled_sample {
+	s64 timestamp;
+	u32 seq;
+	u16 flags;
+	u16 reserved;
+	struct mpu6050_scaled_data scaled;
+};
+
+/**
+ * struct mpu6050_batch - Argument of the batch read ioctls
+ * @buf: User pointer to an array of @count records
+ * @count: In: capacity of @buf in records. Out: number of records filled
+ * @timeout_ms: How long to wait for @count records. 0 returns what is
+ *		already buffered, a negative value waits without a limit
+ * @lost: Out: records this file missed so far, as MPU6050_IOC_GET_LOST
+ */
+struct mpu6050_batch {
+	u64 buf;
+	u32 count;
+	s32 timeout_ms;
+	u64 lost;
+};
+
+/* Largest capture group, see MPU6050_IOC_SET_GROUP */
+#define MPU6050_GROUP_MAX		8
+
+/**
+ * struct mpu6050_group_config - Argument of MPU6050_IOC_SET_GROUP
+ * @count: Number of sensors in the group including the one of the file
+ *	   the ioctl is issued on, which becomes sensor 0. 0 dissolves the
+ *	   group
+ * @fds: Open files of sensors 1 to @count - 1
+ */
+struct mpu6050_group_config {
+	u32 count;
+	s32 fds[MPU6050_GROUP_MAX - 1];
+};
+
+/**
+ * struct mpu6050_group_sample - Record of the merged group stream
+ * @timestamp: Acquisition time in nanoseconds (CLOCK_MONOTONIC)
+ * @seq: Sample sequence number of the sensor, as in struct mpu6050_sample
+ * @flags: MPU6050_SAMPLE_* flags
+ * @raw: Raw sensor data, disabled channels are zero
+ * @sensor: Index of the sensor in the group
+ * @reserved: Always zero
+ *
+ * Laid out like struct mpu6050_sample with the sensor index in the first
+ * reserved byte.
+ */
+struct mpu6050_group_sample {
+	s64 timestamp;
+	u32 seq;
+	u16 flags;
+	struct mpu6050_raw_data raw;
+	u8 sensor;
+	u8 reserved[3];
+};
+
+/* Decimation filters, see MPU6050_IOC_SET_DECIMATION */
+#define MPU6050_DECIM_BOXCAR		0	/* Mean of each block of @factor */
+#define MPU6050_DECIM_CIC		1	/* Cascaded integrator-comb */
+#define MPU6050_DECIM_MAX_FACTOR	256
+#define MPU6050_DECIM_MAX_ORDER		4
+
+/**
+ * struct mpu6050_decimation - Per-file streaming decimation
+ * @factor: Input records per output record, 1 (the default) disables it
+ * @filter: MPU6050_DECIM_BOXCAR or MPU6050_DECIM_CIC
+ * @order: CIC stages, 1 to MPU6050_DECIM_MAX_ORDER. Ignored for a boxcar,
+ *	   which is a single stage
+ * @reserved: Must be zero
+ */
+struct mpu6050_decimation {
+	u32 factor;
+	u16 filter;
+	u16 order;
+	u32 reserved[2];
+};
+
+/* Calibration limits, see struct mpu6050_calibration */
+#define MPU6050_CALIB_MAX_BIAS		32767
+#define MPU6050_CALIB_MAX_SCALE_PPM	500000
+
+/**
+ * struct mpu6050_calibration - Per-axis corrections for scaled readings
+ * @accel_bias: Accelerometer zero offsets in raw LSB, subtracted first
+ * @gyro_bias: Gyroscope zero offsets in raw LSB, subtracted first
+ * @accel_scale_ppm: Accelerometer sensitivity corrections in parts per
+ *		     million, 0 for the nominal sensitivity
+ * @gyro_scale_ppm: Gyroscope sensitivity corrections in parts per million
+ *
+ * Applied to everything the driver scales; raw readings and the IIO
+ * interface are not affected. All zero (the default) is no correction.
+ */
+struct mpu6050_calibration {
+	s32 accel_bias[3];
+	s32 gyro_bias[3];
+	s32 accel_scale_ppm[3];
+	s32 gyro_scale_ppm[3];
+};
+
 /**
  * struct mpu6050_config - MPU-6050 configuration parameters
  * @sample_rate_div: Sample rate divider (0-255)
@@ -223,29 +615,137 @@ struct mpu6050_config {
 	u8 dlpf_cfg;
 };
 
+#ifdef __KERNEL__
+/* Bus latency histogram buckets, bucket n counts latencies below 2^n us */
+#define MPU6050_LAT_BUCKETS		16
+
 /**
- * struct mpu6050_data - MPU-6050 device data
- * @client: I2C client
- * @dev: Device structure
- * @lock: Mutex for device access
- * @regmap: Register map for I2C communication
- * @config: Current device configuration
- * @gyro_range: Current gyroscope range setting
- * @accel_range: Current accelerometer range setting
+ * struct mpu6050_stats - Per-CPU hot path counters
+ * @bus_ops: Bus operations on the acquisition path
+ * @bus_errors: Bus operations that failed
+ * @bus_latency: Bus operation latency histogram, the last bucket is open
+ * @lock_waits: Acquisitions of the device lock that had to wait
+ * @lock_wait_ns: Total time spent waiting for the device lock
+ *
+ * Updated with this_cpu_*() operations so accounting never bounces a shared
+ * cache line between CPUs; readers sum over all possible CPUs.
+ */
+struct mpu6050_stats {
+	u64 bus_ops;
+	u64 bus_errors;
+	u64 bus_latency[MPU6050_LAT_BUCKETS];
+	u64 lock_waits;
+	u64 lock_wait_ns;
+};
+
+#endif /* __KERNEL__ */
+
+/* Fraction bits of the fixed-point scaling factors */
+#define MPU6050_SCALE_SHIFT		24
+
+/**
+ * struct mpu6050_scale - Fixed-point conversion to physical units
+ * @mult: Per-channel multiplier, in MPU6050_CHAN_* bit order
+ * @add: Per-channel offset, with bias, unit offset and rounding folded in
+ *
+ * A channel converts as (raw * @mult + @add) >> MPU6050_SCALE_SHIFT, one
+ * multiply-add and a shift in place of the divides of the unit formulas.
+ */
+struct mpu6050_scale {
+	s32 mult[MPU6050_NUM_CHANNELS];
+	s64 add[MPU6050_NUM_CHANNELS];
+};
+
+#ifdef __KERNEL__
+/**
+ * struct mpu6050_data - Per-sensor driver state
+ *
+ * Shared by the register and sample I/O layer and the character device
+ * front end. Members are described inline; anything the IRQ thread or the
+ * FIFO drain touches is protected by @lock unless noted otherwise.
  */
 struct mpu6050_data {
 	struct i2c_client *client;
-	struct device *dev;
 	struct mutex lock;
 	struct regmap *regmap;
 	struct mpu6050_config config;
-	u8 gyro_range;
-	u8 accel_range;
+	
+	/* Character device, its minor is freed with the last reference */
+	struct cdev *cdev;
+	dev_t devt;
+	struct device *device;
+	
+	/* Scaling factors */
+	u32 accel_scale;	/* Accelerometer scale factor (ug/LSB) */
+	u32 gyro_scale;		/* Gyroscope scale factor (udps/LSB) */
+	struct mpu6050_calibration calib;	/* User calibration */
+	seqlock_t scale_lock;		/* Lets readers snapshot @scale */
+	struct mpu6050_scale scale;	/* Scale factors with @calib applied */
+	
+	/* Enabled channels and aux slaves, only changed while not streaming */
+	u8 channels;			/* MPU6050_CHAN_* mask */
+	struct mpu6050_aux_config aux;	/* Auxiliary I2C slaves */
+	u8 ext_len;			/* EXT_SENS_DATA bytes read per sample */
+	u8 cycle;			/* MPU6050_CYCLE_* low-power wake-up rate */
+	u8 fifo_en;			/* FIFO_EN sources for @channels and @aux */
+	unsigned int fifo_frame_size;	/* Bytes per FIFO frame */
+	
+	/* FIFO streaming */
+	bool streaming;			/* FIFO enabled, filling the ring */
+	u8 *fifo_buf;			/* DMA-safe buffer for FIFO bursts */
+	bool fifo_i2c;			/* Adapter does raw I2C transfers */
+	struct mpu6050_raw_data *fifo_samples;	/* Unpacked FIFO frames */
+	unsigned int fifo_pending;	/* Frames buffered, as counted by IRQ */
+	unsigned int fifo_watermark;	/* Frames buffered before a drain */
+	bool fifo_overflow;		/* Overflow seen by IRQ, not yet handled */
+	ktime_t ts_anchor;		/* Time of the newest drained frame, 0 if none */
+	s32 clock_drift_ppb;		/* Running sensor clock drift estimate */
+	struct delayed_work poll_work;	/* FIFO drain timer without an IRQ */
+	
+	/* Sample ring, written under lock, read locklessly and via mmap() */
+	struct mpu6050_ring_header *ring_hdr;	/* Header page, owns the area */
+	u8 *ring;			/* Records following the header page */
+	size_t ring_bytes;		/* Size of the whole mappable area */
+	u16 ring_flags;			/* Flags for the next sample */
+	
+	/* Latest sample, written under lock, read locklessly */
+	seqlock_t latest_lock;
+	struct mpu6050_raw_data latest;
+	u64 latest_ns;			/* Acquisition time, 0 if invalid */
+	u32 latest_seq;			/* @sample_seq of the cached sample */
+	u32 sample_seq;			/* DATA_RDY samples fetched while not streaming */
+	
+	/* Data-ready interrupt */
+	int irq;			/* Interrupt line, 0 if none */
+	ktime_t irq_timestamp;		/* Hard-IRQ time of the last interrupt */
+	unsigned int drdy_seq;		/* Number of DATA_RDY events seen */
+	wait_queue_head_t wait;		/* Readers waiting for fresh data */
+	unsigned int users;		/* Open files and IIO buffer */
+	
+	/* Diagnostics */
+	struct mpu6050_stats __percpu *stats;
+	struct dentry *debugfs;		/* Per-device debugfs directory */
+	struct list_head files;		/* Open files, for per-reader stats */
+	
+	/* Industrial I/O interface, NULL unless CONFIG_MPU6050_IIO */
+	struct iio_dev *indio_dev;
+	struct iio_trigger *iio_trig;	/* Data-ready trigger, needs an IRQ */
+	s64 iio_timestamp;		/* Time of the last data-ready trigger */
+	
+	/* Capture group, set under @lock by the file that owns the group */
+	struct mpu6050_group *group;	/* Group this sensor belongs to, or NULL */
+	unsigned int fifo_burst;	/* Bytes per FIFO transfer, 0 for no limit */
+	
+	/* Removal while files are still open */
+	struct kref kref;		/* Held by the bound device and open files */
+	bool dead;			/* Device removed, set under @lock */
+	struct rw_semaphore ops_sem;	/* Read-held by file operations */
 };
+#endif /* __KERNEL__ */
 
 /* IOCTL interface */
 #define MPU6050_IOC_MAGIC		'm'
-#define MPU6050_IOC_MAXNR		6
+#define MPU6050_IOC_MAXNR		26
 
 /* IOCTL commands */
 #define MPU6050_IOC_READ_RAW		_IOR(MPU6050_IOC_MAGIC, 0, struct mpu6050_raw_data)
@@ -256,6 +756,169 @@ struct mpu6050_data {
 #define MPU6050_IOC_WHO_AM_I		_IOR(MPU6050_IOC_MAGIC, 5, u8)
 #define MPU6050_IOC_SELF_TEST		_IO(MPU6050_IOC_MAGIC, 6)
 
+/*
+ * MPU6050_IOC_SET_STREAMING - Enable (non-zero) or disable (0) FIFO streaming.
+ *
+ * While streaming, the driver drains the hardware FIFO in batches into a
+ * per-device buffer of struct mpu6050_record records, and read() returns as
+ * many whole records as fit in the caller's buffer. Records are
+ * MPU6050_RECORD_SIZE() bytes for the enabled channels, which is
+ * sizeof(struct mpu6050_sample) with all of them enabled. Each open file
+ * has its own read position, so every reader sees every sample. A hardware
+ * FIFO overflow resets the FIFO and sets MPU6050_SAMPLE_FIFO_OVERFLOW on
+ * the next record. Record timestamps are spread across each FIFO batch
+ * between the data-ready interrupts that bound it, so consecutive records
+ * are one sample period apart as measured against CLOCK_MONOTONIC.
+ */
+#define MPU6050_IOC_SET_STREAMING	_IOW(MPU6050_IOC_MAGIC, 7, int)
+
+/*
+ * MPU6050_IOC_SET_WATERMARK - Number of buffered FIFO frames (1 to the FIFO
+ * capacity) that must be pending before a streaming reader is woken up.
+ * Only meaningful when the device has an interrupt line. The capacity
+ * depends on the enabled channels; larger values are clamped to it.
+ */
+#define MPU6050_IOC_SET_WATERMARK	_IOW(MPU6050_IOC_MAGIC, 8, u32)
+
+/*
+ * MPU6050_IOC_GET_LOST - Number of streaming samples this file missed
+ * because the buffer overwrote them before they were read.
+ */
+#define MPU6050_IOC_GET_LOST		_IOR(MPU6050_IOC_MAGIC, 9, u64)
+
+/*
+ * MPU6050_IOC_READ_BATCH / MPU6050_IOC_READ_SCALED_BATCH - Read up to
+ * @count records from the streaming buffer in one call, as packed struct
+ * mpu6050_record or struct mpu6050_scaled_sample respectively. Disabled
+ * channels read as zero in scaled records. The call
+ * waits until @count records are buffered or @timeout_ms expires, then
+ * returns whatever is available, which may be nothing. Only valid while
+ * streaming; returns -EINVAL otherwise.
+ */
+#define MPU6050_IOC_READ_BATCH		_IOWR(MPU6050_IOC_MAGIC, 10, struct mpu6050_batch)
+#define MPU6050_IOC_READ_SCALED_BATCH	_IOWR(MPU6050_IOC_MAGIC, 11, struct mpu6050_batch)
+
+/*
+ * MPU6050_IOC_SET_STALENESS - Oldest sample age, in microseconds, that
+ * READ_RAW, READ_SCALED and one-shot read() on this file accept from the
+ * driver's latest-sample cache before going to the bus. 0 (the default)
+ * means one output data period.
+ */
+#define MPU6050_IOC_SET_STALENESS	_IOW(MPU6050_IOC_MAGIC, 12, u32)
+
+/*
+ * MPU6050_IOC_SET_CHANNELS / MPU6050_IOC_GET_CHANNELS - MPU6050_CHAN_* mask
+ * of the enabled channels, MPU6050_CHAN_ALL by default. Disabled sensors
+ * are put in standby and their readings are zero in one-shot reads. Can
+ * only be changed while streaming is off (-EBUSY otherwise); an empty mask
+ * is -EINVAL.
+ */
+#define MPU6050_IOC_SET_CHANNELS	_IOW(MPU6050_IOC_MAGIC, 13, u32)
+#define MPU6050_IOC_GET_CHANNELS	_IOR(MPU6050_IOC_MAGIC, 14, u32)
+
+/*
+ * MPU6050_IOC_SET_AUX / MPU6050_IOC_GET_AUX - Auxiliary I2C master slaves.
+ * The on-chip master reads every enabled slave once per sample into
+ * EXT_SENS_DATA and holds back data-ready until it is done, so external
+ * sensor bytes share the sample's bus transfer, FIFO frame and timestamp.
+ * Streaming records append them after the channels. SET_AUX fails with
+ * -EBUSY while streaming. MPU6050_IOC_READ_EXT reads one sample together
+ * with the external bytes in a single burst.
+ */
+#define MPU6050_IOC_SET_AUX		_IOW(MPU6050_IOC_MAGIC, 15, struct mpu6050_aux_config)
+#define MPU6050_IOC_GET_AUX		_IOR(MPU6050_IOC_MAGIC, 16, struct mpu6050_aux_config)
+#define MPU6050_IOC_READ_EXT		_IOR(MPU6050_IOC_MAGIC, 17, struct mpu6050_ext_data)
+
+/*
+ * MPU6050_IOC_SET_DECIMATION / MPU6050_IOC_GET_DECIMATION - Low-pass and
+ * decimate the streaming records this file reads with read() and the batch
+ * ioctls, so a slow consumer gets filtered data at a fraction of the output
+ * data rate instead of dropping records. Each output record carries the
+ * rounded filter output, the sequence number and external bytes of the
+ * newest input, the OR of the input flags and a timestamp corrected for the
+ * filter's group delay. A CIC filter of order K discards its first K - 1
+ * outputs while it fills. The filter restarts, flagging
+ * MPU6050_SAMPLE_FIFO_OVERFLOW, whenever this file loses records or the
+ * record layout changes. The mmap() ring and other files are not affected.
+ */
+#define MPU6050_IOC_SET_DECIMATION	_IOW(MPU6050_IOC_MAGIC, 18, struct mpu6050_decimation)
+#define MPU6050_IOC_GET_DECIMATION	_IOR(MPU6050_IOC_MAGIC, 19, struct mpu6050_decimation)
+
+/* One-shot read() modes, see MPU6050_IOC_SET_READ_MODE */
+#define MPU6050_READ_LATEST		0	/* Latest sample as struct mpu6050_raw_data */
+#define MPU6050_READ_NEW		1	/* Unseen samples as struct mpu6050_sample */
+
+/*
+ * MPU6050_IOC_SET_READ_MODE - What one-shot read() on this file returns.
+ * MPU6050_READ_LATEST (the default) returns the latest sample within the
+ * staleness bound, possibly one this file already read. MPU6050_READ_NEW
+ * returns each sample the sensor produces at most once, as a struct
+ * mpu6050_sample whose @seq counts DATA_RDY events, and blocks or fails
+ * with -EAGAIN until the next one is ready. MPU6050_SAMPLE_FIFO_OVERFLOW
+ * marks a sample that follows ones this file missed. Streaming reads only
+ * ever return unseen records and are not affected.
+ */
+#define MPU6050_IOC_SET_READ_MODE	_IOW(MPU6050_IOC_MAGIC, 20, u32)
+
+/*
+ * MPU6050_IOC_SET_CALIBRATION / MPU6050_IOC_GET_CALIBRATION - Bias and
+ * sensitivity corrections applied by READ_SCALED and READ_SCALED_BATCH.
+ * Biases beyond MPU6050_CALIB_MAX_BIAS or sensitivity corrections beyond
+ * MPU6050_CALIB_MAX_SCALE_PPM are -EINVAL.
+ */
+#define MPU6050_IOC_SET_CALIBRATION	_IOW(MPU6050_IOC_MAGIC, 21, struct mpu6050_calibration)
+#define MPU6050_IOC_GET_CALIBRATION	_IOR(MPU6050_IOC_MAGIC, 22, struct mpu6050_calibration)
+
+/* Low-power accelerometer wake-up rates, see MPU6050_IOC_SET_CYCLE */
+#define MPU6050_CYCLE_OFF		0
+#define MPU6050_CYCLE_1_25HZ		1
+#define MPU6050_CYCLE_5HZ		2
+#define MPU6050_CYCLE_20HZ		3
+#define MPU6050_CYCLE_40HZ		4
+
+/*
+ * MPU6050_IOC_SET_CYCLE - Low-power cycle mode for slow accelerometer-only
+ * consumers. The part sleeps between single accelerometer samples taken at
+ * the MPU6050_CYCLE_* rate, which becomes the output data rate. Only valid
+ * while just accelerometer channels are enabled (-EINVAL otherwise) and
+ * not streaming (-EBUSY). Streaming and enabling other channels fail with
+ * -EBUSY until cycling is turned off again with MPU6050_CYCLE_OFF.
+ */
+#define MPU6050_IOC_SET_CYCLE		_IOW(MPU6050_IOC_MAGIC, 23, u32)
+
+/*
+ * MPU6050_IOC_SET_GROUP - Form a capture group of sensors whose samples
+ * are read as one stream, typically the AD0-low and AD0-high parts on one
+ * adapter. The file the ioctl is issued on owns the group and holds a
+ * reference to the other members' files until the group is dissolved or
+ * the owner is closed. A sensor belongs to at most one group, and none of
+ * them may be streaming (-EBUSY otherwise); a file that is not an MPU-6050
+ * device is -EINVAL. Replacing or dissolving a streaming group is -EBUSY.
+ *
+ * MPU6050_IOC_SET_GROUP_STREAMING - Enable (non-zero) or disable (0) FIFO
+ * streaming on every member. The FIFOs are reset first and then started
+ * back to back with one register write each, so the members' first
+ * samples are taken within a few bus transfers of each other. All records
+ * are stamped against CLOCK_MONOTONIC, the shared time base of the stream.
+ * FIFO reads are split into transfers short enough that every member can
+ * still be drained in time while the others hold the bus. Members cannot
+ * be started or stopped on their own while they are grouped (-EBUSY).
+ *
+ * MPU6050_IOC_READ_GROUP - Read up to @count records of the merged stream
+ * as struct mpu6050_group_sample, in timestamp order. A record is released
+ * once every member has a record at least as new, so records returned
+ * never precede ones returned before. Waits like MPU6050_IOC_READ_BATCH;
+ * if a positive @timeout_ms expires, the buffered records of the members
+ * that did deliver are released too, so a stalled member does not hold
+ * back the stream. @lost sums the records of all members that were
+ * overwritten before the group read them. External sensor bytes are not
+ * part of the merged stream. -EINVAL unless the group is streaming.
+ */
+#define MPU6050_IOC_SET_GROUP		_IOW(MPU6050_IOC_MAGIC, 24, struct mpu6050_group_config)
+#define MPU6050_IOC_SET_GROUP_STREAMING	_IOW(MPU6050_IOC_MAGIC, 25, int)
+#define MPU6050_IOC_READ_GROUP		_IOWR(MPU6050_IOC_MAGIC, 26, struct mpu6050_batch)
+
+#ifdef __KERNEL__
 /* Function prototypes */
 int mpu6050_read_raw(struct mpu6050_data *data, u8 reg, s16 *val);
 int mpu6050_write_reg(struct mpu6050_data *data, u8 reg, u8 val);
@@ -263,9 +926,85 @@ int mpu6050_read_raw_data(struct mpu6050_data *data, struct mpu6050_raw_data *ra
 int mpu6050_read_scaled_data(struct mpu6050_data *data, struct mpu6050_scaled_data *scaled_data);
 int mpu6050_set_config(struct mpu6050_data *data, const struct mpu6050_config *config);
 int mpu6050_get_config(struct mpu6050_data *data, struct mpu6050_config *config);
+int mpu6050_set_channels(struct mpu6050_data *data, u32 channels);
+int mpu6050_set_aux(struct mpu6050_data *data, const struct mpu6050_aux_config *aux);
+int mpu6050_set_calibration(struct mpu6050_data *data,
+			    const struct mpu6050_calibration *calib);
+int mpu6050_set_cycle(struct mpu6050_data *data, u32 cycle);
+int mpu6050_read_ext_data(struct mpu6050_data *data, struct mpu6050_ext_data *ext);
 int mpu6050_reset_device(struct mpu6050_data *data);
 int mpu6050_self_test(struct mpu6050_data *data);
 
+/* Register and sample I/O layer (drivers/mpu6050_main.c) */
+extern const struct regmap_config mpu6050_regmap_config;
+u32 mpu6050_sample_period_ns(struct mpu6050_data *data);
+int mpu6050_read_sample(struct mpu6050_data *data, struct mpu6050_raw_data *raw_data,
+			u64 max_age_ns);
+int mpu6050_fetch_sample(struct mpu6050_data *data, struct mpu6050_raw_data *raw_data);
+int mpu6050_read_fifo(struct mpu6050_data *data, struct mpu6050_raw_data *samples,
+		      unsigned int frames);
+void mpu6050_latest_update(struct mpu6050_data *data,
+			   const struct mpu6050_raw_data *raw_data, ktime_t timestamp);
+void mpu6050_latest_invalidate(struct mpu6050_data *data);
+void mpu6050_scale_get(struct mpu6050_data *data, struct mpu6050_scale *scale);
+bool mpu6050_latest_sample(struct mpu6050_data *data, struct mpu6050_sample *sample);
+int mpu6050_poll_sample(struct mpu6050_data *data);
+void mpu6050_lock(struct mpu6050_data *data);
+void mpu6050_stats_bus(struct mpu6050_data *data, ktime_t start, int ret);
+
+/* Acquisition consumers (drivers/mpu6050_driver.c) */
+int mpu6050_acq_get(struct mpu6050_data *data);
+void mpu6050_acq_put(struct mpu6050_data *data);
+
+/* Industrial I/O interface (drivers/mpu6050_iio.c) */
+#ifdef CONFIG_MPU6050_IIO
+int mpu6050_iio_probe(struct mpu6050_data *data);
+void mpu6050_iio_push(struct mpu6050_data *data,
+		      const struct mpu6050_raw_data *raw_data, ktime_t timestamp);
+void mpu6050_iio_trigger(struct mpu6050_data *data, ktime_t timestamp);
+#else
+static inline int mpu6050_iio_probe(struct mpu6050_data *data)
+{
+	return 0;
+}
+
+static inline void mpu6050_iio_push(struct mpu6050_data *data,
+				    const struct mpu6050_raw_data *raw_data,
+				    ktime_t timestamp)
+{
+}
+
+static inline void mpu6050_iio_trigger(struct mpu6050_data *data,
+				       ktime_t timestamp)
+{
+}
+#endif
+
+/* Virtual sensor on a simulated I2C bus (drivers/mpu6050_virt.c) */
+#ifdef CONFIG_MPU6050_VIRT
+int mpu6050_virt_init(void);
+void mpu6050_virt_exit(void);
+struct regmap *mpu6050_virt_regmap_init(struct i2c_client *client,
+					const struct regmap_config *config);
+#else
+static inline int mpu6050_virt_init(void)
+{
+	return 0;
+}
+
+static inline void mpu6050_virt_exit(void)
+{
+}
+
+static inline struct regmap *
+mpu6050_virt_regmap_init(struct i2c_client *client,
+			 const struct regmap_config *config)
+{
+	return NULL;
+}
+#endif
+#endif /* __KERNEL__ */
+
 /* Utility functions */
 static inline int mpu6050_accel_range_to_scale(u8 range)
 {
@@ -299,4 +1038,36 @@ static inline int mpu6050_gyro_range_to_scale(u8 range)
 	}
 }
 
+/**
+ * mpu6050_scale_chan - Convert one raw reading to physical units
+ * @scale: Fixed-point scale factors
+ * @chan: Channel index, in MPU6050_CHAN_* bit order
+ * @raw: Raw reading
+ */
+static inline s32 mpu6050_scale_chan(const struct mpu6050_scale *scale,
+				     unsigned int chan, s16 raw)
+{
+	return ((s64)raw * scale->mult[chan] + scale->add[chan]) >>
+	       MPU6050_SCALE_SHIFT;
+}
+
+/**
+ * mpu6050_scale_raw - Convert raw readings to physical units
+ * @raw: Raw sensor data
+ * @scale: Fixed-point scale factors, see mpu6050_scale_get()
+ * @scaled: Pointer to store scaled data
+ */
+static inline void mpu6050_scale_raw(const struct mpu6050_raw_data *raw,
+				     const struct mpu6050_scale *scale,
+				     struct mpu6050_scaled_data *scaled)
+{
+	scaled->accel_x = mpu6050_scale_chan(scale, 0, raw->accel_x);
+	scaled->accel_y = mpu6050_scale_chan(scale, 1, raw->accel_y);
+	scaled->accel_z = mpu6050_scale_chan(scale, 2, raw->accel_z);
+	scaled->temp = mpu6050_scale_chan(scale, 3, raw->temp);
+	scaled->gyro_x = mpu6050_scale_chan(scale, 4, raw->gyro_x);
+	scaled->gyro_y = mpu6050_scale_chan(scale, 5, raw->gyro_y);
+	scaled->gyro_z = mpu6050_scale_chan(scale, 6, raw->gyro_z);
+}
+
 #endif /* _MPU6050_H_ */
\ No newline at end of file
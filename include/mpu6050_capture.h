@@ -0,0 +1,267 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * MPU-6050 capture file format
+ *
+ * Userspace only: the layout of the files field loggers record streams to,
+ * and inline helpers to decode them without libmpu6050.
+ *
+ * Copyright (C) 2025 Murray Kopit <murr2k@gmail.com>
+ */
+
+#ifndef _MPU6050_CAPTURE_H_
+#define _MPU6050_CAPTURE_H_
+
+#include <errno.h>
+#include <string.h>
+
+#include "mpu6050.h"
+
+/*
+ * A capture is a header, chunks of delta-encoded samples and an index of
+ * the chunks:
+ *
+ *	struct mpu6050_capture_header
+ *	struct mpu6050_capture_chunk, @size encoded bytes, padding to 8 bytes
+ *	...
+ *	struct mpu6050_capture_index[nr_chunks], at @index_offset
+ *
+ * Every chunk but the last holds @chunk_samples samples, so sample n is in
+ * chunk n / @chunk_samples and seeking to it is one index lookup plus the
+ * decoding of at most one chunk. Chunks decode on their own.
+ *
+ * Each sample is a run of LEB128 varints followed by @ext_len verbatim
+ * external sensor bytes:
+ *
+ *	zigzag(timestamp - previous timestamp - period_ns)
+ *	(seq - previous seq - 1) << 16 | flags
+ *	zigzag(reading - previous reading) for each channel in @channels,
+ *	as a 16-bit wrapping difference
+ *
+ * For the first sample of a chunk the previous sample is one period before
+ * the chunk timestamp, has the chunk seq minus one and all-zero readings.
+ * A steady stream costs two bytes of timing per sample, plus one to three
+ * bytes per channel depending on how fast it changes.
+ *
+ * Fixed-size fields are in the byte order of the writer; a reader on a host
+ * of the other byte order sees a foreign magic. A logger that stops without
+ * closing its capture leaves @index_offset zero; the chunks it finished
+ * are still complete and can be found by walking their @size fields.
+ */
+#define MPU6050_CAPTURE_MAGIC		0x3650434d	/* "MCP6" */
+#define MPU6050_CAPTURE_VERSION		1
+
+/* Largest encoded sample: timing varints, three bytes per channel, ext bytes */
+#define MPU6050_CAPTURE_SAMPLE_MAX	(10 + 7 + 3 * MPU6050_NUM_CHANNELS + \
+					 MPU6050_EXT_DATA_SIZE)
+
+/**
+ * struct mpu6050_capture_header - Start of a capture file
+ * @magic: MPU6050_CAPTURE_MAGIC
+ * @version: MPU6050_CAPTURE_VERSION
+ * @header_size: sizeof(struct mpu6050_capture_header), where chunk 0 starts
+ * @config: Device configuration while recording (ranges and sample rate)
+ * @channels: MPU6050_CHAN_* mask of the recorded channels
+ * @ext_len: Number of external sensor bytes per sample
+ * @period_ns: Nominal sample period
+ * @chunk_samples: Samples per chunk, all but the last chunk are full
+ * @nr_chunks: Number of complete chunks
+ * @nr_samples: Number of samples in the complete chunks
+ * @index_offset: File offset of the chunk index, 0 until the capture is closed
+ * @reserved: Must be zero
+ */
+struct mpu6050_capture_header {
+	u32 magic;
+	u16 version;
+	u16 header_size;
+	struct mpu6050_config config;
+	u32 channels;
+	u32 ext_len;
+	u32 period_ns;
+	u32 chunk_samples;
+	u32 nr_chunks;
+	u64 nr_samples;
+	u64 index_offset;
+	u64 reserved[2];
+};
+
+/**
+ * struct mpu6050_capture_chunk - Start of a chunk of encoded samples
+ * @timestamp: Timestamp of the first sample in nanoseconds
+ * @seq: Sequence number of the first sample
+ * @count: Number of samples in the chunk
+ * @size: Number of encoded bytes after this header, without padding
+ * @reserved: Must be zero
+ */
+struct mpu6050_capture_chunk {
+	s64 timestamp;
+	u32 seq;
+	u32 count;
+	u32 size;
+	u32 reserved;
+};
+
+/**
+ * struct mpu6050_capture_index - Chunk index entry
+ * @offset: File offset of the struct mpu6050_capture_chunk
+ * @timestamp: Timestamp of the chunk's first sample
+ */
+struct mpu6050_capture_index {
+	u64 offset;
+	s64 timestamp;
+};
+
+/* File offset after a chunk at @offset with @size encoded bytes */
+#define MPU6050_CAPTURE_CHUNK_END(offset, size) \
+	(((offset) + sizeof(struct mpu6050_capture_chunk) + (size) + 7) & ~7ULL)
+
+static inline u64 mpu6050_capture_zigzag(s64 v)
+{
+	return ((u64)v << 1) ^ (u64)(v >> 63);
+}
+
+static inline s64 mpu6050_capture_unzigzag(u64 v)
+{
+	return (s64)(v >> 1) ^ -(s64)(v & 1);
+}
+
+/* Append @v to @dst as a varint; Return: the byte after it */
+static inline u8 *mpu6050_capture_put(u8 *dst, u64 v)
+{
+	while (v >= 0x80) {
+		*dst++ = (u8)v | 0x80;
+		v >>= 7;
+	}
+	*dst++ = (u8)v;
+	return dst;
+}
+
+/* Parse a varint at @src; Return: the byte after it, NULL if truncated */
+static inline const u8 *mpu6050_capture_get(const u8 *src, const u8 *end,
+					    u64 *v)
+{
+	unsigned int shift;
+	u64 val = 0;
+
+	for (shift = 0; src < end && shift < 64; shift += 7) {
+		u8 b = *src++;
+
+		val |= (u64)(b & 0x7f) << shift;
+		if (!(b & 0x80)) {
+			*v = val;
+			return src;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * struct mpu6050_capture_cursor - Decoding position within one chunk
+ * @pos: Next encoded byte
+ * @end: End of the chunk's encoded bytes
+ * @left: Samples not yet decoded
+ * @channels: Recorded channels, from the header
+ * @ext_len: External sensor bytes per sample, from the header
+ * @period_ns: Nominal sample period, from the header
+ * @timestamp: Timestamp of the last decoded sample
+ * @seq: Sequence number of the last decoded sample
+ * @flags: MPU6050_SAMPLE_* flags of the last decoded sample
+ * @raw: Readings of the last decoded sample, zero for unrecorded channels
+ * @ext: External sensor bytes of the last decoded sample
+ */
+struct mpu6050_capture_cursor {
+	const u8 *pos;
+	const u8 *end;
+	u32 left;
+	u32 channels;
+	u32 ext_len;
+	u32 period_ns;
+	s64 timestamp;
+	u32 seq;
+	u16 flags;
+	struct mpu6050_raw_data raw;
+	const u8 *ext;
+};
+
+/**
+ * mpu6050_capture_start - Position a cursor at the start of a chunk
+ * @cur: Cursor to set up
+ * @hdr: Header of the capture
+ * @chunk: Chunk header in the mapped capture
+ * @end: End of the mapped capture
+ *
+ * Return: 0, or -EINVAL if the chunk runs past @end
+ */
+static inline int
+mpu6050_capture_start(struct mpu6050_capture_cursor *cur,
+		      const struct mpu6050_capture_header *hdr,
+		      const u8 *chunk, const u8 *end)
+{
+	struct mpu6050_capture_chunk ch;
+
+	if (end - chunk < (ptrdiff_t)sizeof(ch))
+		return -EINVAL;
+	memcpy(&ch, chunk, sizeof(ch));
+	chunk += sizeof(ch);
+	if ((u64)(end - chunk) < ch.size)
+		return -EINVAL;
+
+	cur->pos = chunk;
+	cur->end = chunk + ch.size;
+	cur->left = ch.count;
+	cur->channels = hdr->channels;
+	cur->ext_len = hdr->ext_len;
+	cur->period_ns = hdr->period_ns;
+	cur->timestamp = ch.timestamp - hdr->period_ns;
+	cur->seq = ch.seq - 1;
+	cur->flags = 0;
+	memset(&cur->raw, 0, sizeof(cur->raw));
+	cur->ext = NULL;
+	return 0;
+}
+
+/**
+ * mpu6050_capture_next - Decode the next sample of a chunk
+ * @cur: Cursor set up by mpu6050_capture_start()
+ *
+ * Return: 1 with the sample in @cur, 0 at the end of the chunk, or -EINVAL
+ * if the chunk is corrupt
+ */
+static inline int mpu6050_capture_next(struct mpu6050_capture_cursor *cur)
+{
+	const u8 *p = cur->pos;
+	unsigned int c;
+	u64 v;
+
+	if (!cur->left)
+		return 0;
+
+	p = mpu6050_capture_get(p, cur->end, &v);
+	if (!p)
+		return -EINVAL;
+	cur->timestamp += cur->period_ns + mpu6050_capture_unzigzag(v);
+
+	p = mpu6050_capture_get(p, cur->end, &v);
+	if (!p)
+		return -EINVAL;
+	cur->seq += (u32)(v >> 16) + 1;
+	cur->flags = (u16)v;
+
+	for (c = 0; c < MPU6050_NUM_CHANNELS; c++) {
+		if (!(cur->channels & BIT(c)))
+			continue;
+		p = mpu6050_capture_get(p, cur->end, &v);
+		if (!p)
+			return -EINVAL;
+		mpu6050_raw_chan(&cur->raw, c) +=
+			(s16)mpu6050_capture_unzigzag(v);
+	}
+
+	if ((size_t)(cur->end - p) < cur->ext_len)
+		return -EINVAL;
+	cur->ext = p;
+	cur->pos = p + cur->ext_len;
+	cur->left--;
+	return 1;
+}
+
+#endif /* _MPU6050_CAPTURE_H_ */
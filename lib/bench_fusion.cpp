@@ -0,0 +1,94 @@
+/**
+ * @file bench_fusion.cpp
+ * @brief Benchmark of the libmpu6050 fusion filters
+ *
+ * Usage: bench_fusion [sensors] [seconds]
+ *
+ * Feeds synthetic 1 kHz batches of a slowly rotating, tilted sensor through
+ * every filter and arithmetic type and reports the cost per sample and the
+ * share of one core the whole bank needs in real time.
+ *
+ * Copyright (C) 2025 Murray Kopit <murr2k@gmail.com>
+ */
+
+#include "fusion.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+constexpr size_t batch = 64;
+constexpr s64 period_ns = 1000000;
+
+std::vector<mpu6050::Sample> make_samples(size_t n)
+{
+	std::vector<mpu6050::Sample> samples(n);
+
+	for (size_t i = 0; i < n; i++) {
+		mpu6050::Sample &s = samples[i];
+		double t = i * 1e-3;
+
+		s = {};
+		s.timestamp = (s64)i * period_ns;
+		s.seq = i;
+		s.raw.accel_x = 2000 * std::sin(t);
+		s.raw.accel_y = 1500;
+		s.raw.accel_z = 16000;
+		s.raw.gyro_x = 40 * std::cos(3 * t);
+		s.raw.gyro_y = -25;
+		s.raw.gyro_z = 1310;	/* 10 dps */
+	}
+	return samples;
+}
+
+template <typename T, typename Filter>
+void run(const char *name, unsigned sensors,
+	 const std::vector<mpu6050::Sample> &samples)
+{
+	mpu6050::Fusion<T, Filter> fusion(sensors, 0.05);
+	std::vector<mpu6050::Quat<T>> out(batch);
+	auto start = std::chrono::steady_clock::now();
+	double ns, per;
+
+	for (size_t i = 0; i < samples.size(); i += batch) {
+		size_t n = std::min(batch, samples.size() - i);
+
+		for (unsigned s = 0; s < sensors; s++)
+			fusion.update(s, &samples[i], n, out.data());
+	}
+	ns = std::chrono::duration<double, std::nano>(
+		std::chrono::steady_clock::now() - start).count();
+	per = ns / (samples.size() * sensors);
+
+	/* Real-time load: samples per second of the bank times cost each */
+	printf("  %-24s %7.1f ns/sample %6.2f%% of a core\n", name, per,
+	       per * sensors * (1e9 / period_ns) / 1e7);
+}
+
+} /* namespace */
+
+int main(int argc, char **argv)
+{
+	unsigned sensors = argc > 1 ? strtoul(argv[1], nullptr, 0) : 8;
+	unsigned seconds = argc > 2 ? strtoul(argv[2], nullptr, 0) : 10;
+	std::vector<mpu6050::Sample> samples;
+
+	if (!sensors || !seconds) {
+		fprintf(stderr, "Usage: %s [sensors] [seconds]\n", argv[0]);
+		return 1;
+	}
+	samples = make_samples(seconds * (1000000000 / period_ns));
+
+	printf("%u sensors at %lld Hz, %u s of samples\n", sensors,
+	       1000000000LL / period_ns, seconds);
+	run<float, mpu6050::Madgwick>("madgwick float", sensors, samples);
+	run<mpu6050::Fixed, mpu6050::Madgwick>("madgwick fixed", sensors, samples);
+	run<float, mpu6050::Complementary>("complementary float", sensors,
+					   samples);
+	run<mpu6050::Fixed, mpu6050::Complementary>("complementary fixed",
+						    sensors, samples);
+	return 0;
+}
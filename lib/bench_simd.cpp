@@ -0,0 +1,141 @@
+/**
+ * @file bench_simd.cpp
+ * @brief Benchmark of the libmpu6050 decode kernels against the scalar code
+ *
+ * Usage: bench_simd [frames] [iterations]
+ *
+ * Decodes a synthetic capture of all-channel FIFO frames with every
+ * supported instruction set, checks each result against the scalar
+ * reference and reports throughput. The reference is the per-sample loop
+ * consumers use today: mpu6050_scale_raw() on one struct mpu6050_raw_data
+ * at a time.
+ *
+ * Copyright (C) 2025 Murray Kopit <murr2k@gmail.com>
+ */
+
+#include "simd.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+double elapsed_ns(clock_type::time_point start)
+{
+	return std::chrono::duration<double, std::nano>(clock_type::now() - start)
+		.count();
+}
+
+void report(const char *name, double ns, size_t frames, double base)
+{
+	double per = ns / frames;
+
+	printf("  %-22s %8.3f ns/frame %8.1f MB/s %6.2fx\n", name, per,
+	       frames * 2.0 * MPU6050_NUM_CHANNELS / ns * 1000, base / per);
+}
+
+} /* namespace */
+
+int main(int argc, char **argv)
+{
+	size_t frames = argc > 1 ? strtoul(argv[1], nullptr, 0) : 1 << 20;
+	unsigned iters = argc > 2 ? strtoul(argv[2], nullptr, 0) : 20;
+	size_t bytes = frames * 2 * MPU6050_NUM_CHANNELS;
+	std::unique_ptr<u8[]> fifo(new u8[bytes]);
+	std::unique_ptr<s16[]> raw(new s16[frames * MPU6050_NUM_CHANNELS]);
+	std::unique_ptr<s32[]> ref(new s32[frames * MPU6050_NUM_CHANNELS]);
+	std::unique_ptr<s32[]> out(new s32[frames * MPU6050_NUM_CHANNELS]);
+	mpu6050_config config = {0, MPU6050_GYRO_FS_500, MPU6050_ACCEL_FS_4G, 1};
+	mpu6050_calibration calib = {{120, -80, 300}, {-15, 9, 4},
+				     {1500, -900, 0}, {0, 250, -250}};
+	mpu6050_scale scale = mpu6050::make_scale(config, &calib);
+	std::mt19937 rng(6050);
+	mpu6050::RawSoa rsoa;
+	mpu6050::ScaledSoa ssoa, rref;
+	double base;
+
+	if (!frames || !iters) {
+		fprintf(stderr, "Usage: %s [frames] [iterations]\n", argv[0]);
+		return 1;
+	}
+
+	for (size_t i = 0; i < bytes; i++)
+		fifo[i] = rng();
+	for (unsigned c = 0; c < MPU6050_NUM_CHANNELS; c++) {
+		rsoa.chan[c] = &raw[c * frames];
+		ssoa.chan[c] = &out[c * frames];
+		rref.chan[c] = &ref[c * frames];
+	}
+
+	printf("%zu frames, %u iterations, best isa %s\n", frames, iters,
+	       mpu6050::isa_name(mpu6050::best_isa()));
+
+	/* Reference: byte-swap into AoS, then scale one sample at a time */
+	auto start = clock_type::now();
+	for (unsigned it = 0; it < iters; it++) {
+		for (size_t i = 0; i < frames; i++) {
+			const u8 *f = &fifo[i * 2 * MPU6050_NUM_CHANNELS];
+			mpu6050_raw_data r;
+			mpu6050_scaled_data s;
+
+			for (unsigned c = 0; c < MPU6050_NUM_CHANNELS; c++)
+				mpu6050_raw_chan(&r, c) = f[2 * c] << 8 | f[2 * c + 1];
+			mpu6050_scale_raw(&r, &scale, &s);
+			rref.chan[0][i] = s.accel_x;
+			rref.chan[1][i] = s.accel_y;
+			rref.chan[2][i] = s.accel_z;
+			rref.chan[3][i] = s.temp;
+			rref.chan[4][i] = s.gyro_x;
+			rref.chan[5][i] = s.gyro_y;
+			rref.chan[6][i] = s.gyro_z;
+		}
+	}
+	base = elapsed_ns(start) / iters / frames;
+	report("per-sample reference", base * frames, frames, base);
+
+	for (mpu6050::Isa isa : {mpu6050::Isa::scalar, mpu6050::Isa::sse41,
+				 mpu6050::Isa::avx2, mpu6050::Isa::neon}) {
+		double deint, scl, fused;
+
+		if (!mpu6050::isa_supported(isa))
+			continue;
+
+		start = clock_type::now();
+		for (unsigned it = 0; it < iters; it++)
+			mpu6050::fifo_to_soa(fifo.get(), frames, MPU6050_CHAN_ALL,
+					     rsoa, isa);
+		deint = elapsed_ns(start) / iters;
+
+		start = clock_type::now();
+		for (unsigned it = 0; it < iters; it++)
+			mpu6050::scale_soa(rsoa, frames, scale, ssoa, isa);
+		scl = elapsed_ns(start) / iters;
+
+		memset(out.get(), 0, frames * MPU6050_NUM_CHANNELS * sizeof(s32));
+		start = clock_type::now();
+		for (unsigned it = 0; it < iters; it++)
+			mpu6050::fifo_to_scaled_soa(fifo.get(), frames,
+						    MPU6050_CHAN_ALL, scale,
+						    ssoa, isa);
+		fused = elapsed_ns(start) / iters;
+
+		if (memcmp(out.get(), ref.get(),
+			   frames * MPU6050_NUM_CHANNELS * sizeof(s32))) {
+			fprintf(stderr, "%s: output differs from the reference\n",
+				mpu6050::isa_name(isa));
+			return 1;
+		}
+
+		printf("%s:\n", mpu6050::isa_name(isa));
+		report("fifo_to_soa", deint, frames, base);
+		report("scale_soa", scl, frames, base);
+		report("fifo_to_scaled_soa", fused, frames, base);
+	}
+	return 0;
+}
@@ -0,0 +1,410 @@
+/**
+ * @file capture.cpp
+ * @brief libmpu6050 capture file writer and mapped reader
+ *
+ * Copyright (C) 2025 Murray Kopit <murr2k@gmail.com>
+ */
+
+#include "capture.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <ctime>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace mpu6050 {
+
+namespace {
+
+/* The writer extends the file and its mapping in steps of this size */
+constexpr size_t grow_step = 1 << 20;
+
+[[noreturn]] void throw_errno(int err, const char *what)
+{
+	throw std::system_error(err, std::generic_category(), what);
+}
+
+bool valid_layout(u32 channels, u32 ext_len)
+{
+	return channels && !(channels & ~MPU6050_CHAN_ALL) &&
+	       ext_len <= MPU6050_EXT_DATA_SIZE;
+}
+
+s64 monotonic_ns()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (s64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+} /* namespace */
+
+u32 sample_period_ns(const mpu6050_config &config)
+{
+	u32 gyro_rate_hz = 1000;
+
+	if (config.dlpf_cfg == 0 || config.dlpf_cfg >= 7)
+		gyro_rate_hz = 8000;
+	return (1000000000 / gyro_rate_hz) * (1 + config.sample_rate_div);
+}
+
+CaptureWriter::CaptureWriter(const char *path, const mpu6050_config &config,
+			     const Layout &layout, u32 period_ns,
+			     u32 chunk_samples)
+	: pos_(sizeof(hdr_)), hdr_()
+{
+	if (!valid_layout(layout.channels, layout.ext_len) || !period_ns ||
+	    !chunk_samples)
+		throw_errno(EINVAL, "mpu6050 capture layout");
+
+	hdr_.magic = MPU6050_CAPTURE_MAGIC;
+	hdr_.version = MPU6050_CAPTURE_VERSION;
+	hdr_.header_size = sizeof(hdr_);
+	hdr_.config = config;
+	hdr_.channels = layout.channels;
+	hdr_.ext_len = layout.ext_len;
+	hdr_.period_ns = period_ns;
+	hdr_.chunk_samples = chunk_samples;
+
+	fd_ = ::open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd_ < 0)
+		throw_errno(errno, path);
+	try {
+		reserve(0);
+	} catch (...) {
+		::close(fd_);
+		throw;
+	}
+	std::memcpy(map_, &hdr_, sizeof(hdr_));
+}
+
+CaptureWriter::CaptureWriter(const char *path, const Device &dev,
+			     u32 chunk_samples)
+	: CaptureWriter(path, dev.config(), dev.layout(),
+			sample_period_ns(dev.config()), chunk_samples)
+{
+}
+
+CaptureWriter::~CaptureWriter()
+{
+	try {
+		close();
+	} catch (const std::system_error &) {
+		/* Only the index is lost; the chunks are already on disk */
+	}
+}
+
+/* Make room for @len more bytes at pos_ */
+void CaptureWriter::reserve(size_t len)
+{
+	size_t size;
+	void *map;
+
+	if (map_ && pos_ + len <= map_size_)
+		return;
+
+	size = (pos_ + len + grow_step) & ~(grow_step - 1);
+	if (ftruncate(fd_, size) < 0)
+		throw_errno(errno, "mpu6050 capture size");
+	if (map_)
+		map = mremap(map_, map_size_, size, MREMAP_MAYMOVE);
+	else
+		map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+			   fd_, 0);
+	if (map == MAP_FAILED)
+		throw_errno(errno, "mpu6050 capture mapping");
+	map_ = static_cast<u8 *>(map);
+	map_size_ = size;
+}
+
+void CaptureWriter::write(const Sample *begin, const Sample *end)
+{
+	u32 channels = hdr_.channels, period = hdr_.period_ns;
+
+	if (fd_ < 0)
+		throw_errno(EBADF, "mpu6050 capture");
+
+	for (const Sample *s = begin; s != end; s++) {
+		u8 *p;
+
+		if (s->ext_len != hdr_.ext_len)
+			throw_errno(EINVAL, "mpu6050 capture layout");
+
+		/* Room for a chunk header, the sample and the chunk padding */
+		reserve(sizeof(mpu6050_capture_chunk) +
+			MPU6050_CAPTURE_SAMPLE_MAX + 8);
+		if (!count_) {
+			chunk_ = pos_;
+			pos_ += sizeof(mpu6050_capture_chunk);
+			first_ts_ = s->timestamp;
+			first_seq_ = s->seq;
+			timestamp_ = s->timestamp - period;
+			seq_ = s->seq - 1;
+			raw_ = {};
+		}
+
+		p = map_ + pos_;
+		p = mpu6050_capture_put(p, mpu6050_capture_zigzag(
+			s->timestamp - timestamp_ - period));
+		p = mpu6050_capture_put(p, (u64)(u32)(s->seq - seq_ - 1) << 16 |
+					   s->flags);
+		for (unsigned c = 0; c < MPU6050_NUM_CHANNELS; c++) {
+			s16 delta;
+
+			if (!(channels & BIT(c)))
+				continue;
+			delta = mpu6050_raw_chan(&s->raw, c) -
+				mpu6050_raw_chan(&raw_, c);
+			p = mpu6050_capture_put(p,
+						mpu6050_capture_zigzag(delta));
+		}
+		if (s->ext_len)
+			std::memcpy(p, s->ext, s->ext_len);
+		pos_ = p + s->ext_len - map_;
+
+		timestamp_ = s->timestamp;
+		seq_ = s->seq;
+		raw_ = s->raw;
+		samples_++;
+		if (++count_ == hdr_.chunk_samples)
+			finish_chunk();
+	}
+}
+
+void CaptureWriter::finish_chunk()
+{
+	mpu6050_capture_chunk ch = {};
+	size_t end;
+
+	if (!count_)
+		return;
+
+	ch.timestamp = first_ts_;
+	ch.seq = first_seq_;
+	ch.count = count_;
+	ch.size = pos_ - chunk_ - sizeof(ch);
+	std::memcpy(map_ + chunk_, &ch, sizeof(ch));
+	end = MPU6050_CAPTURE_CHUNK_END(chunk_, ch.size);
+	std::memset(map_ + pos_, 0, end - pos_);
+	pos_ = end;
+
+	index_.push_back({chunk_, first_ts_});
+	hdr_.nr_chunks++;
+	hdr_.nr_samples += count_;
+	std::memcpy(map_, &hdr_, sizeof(hdr_));
+	count_ = 0;
+}
+
+void CaptureWriter::close()
+{
+	size_t len;
+	int err = 0;
+
+	if (fd_ < 0)
+		return;
+
+	try {
+		finish_chunk();
+		len = index_.size() * sizeof(mpu6050_capture_index);
+		reserve(len);
+		std::memcpy(map_ + pos_, index_.data(), len);
+		hdr_.index_offset = pos_;
+		pos_ += len;
+		std::memcpy(map_, &hdr_, sizeof(hdr_));
+	} catch (const std::system_error &e) {
+		err = e.code().value();
+	}
+
+	if (map_) {
+		if (!err && msync(map_, pos_, MS_SYNC) < 0)
+			err = errno;
+		munmap(map_, map_size_);
+		map_ = nullptr;
+	}
+	if (ftruncate(fd_, pos_) < 0 && !err)
+		err = errno;
+	if (::close(fd_) < 0 && !err)
+		err = errno;
+	fd_ = -1;
+	if (err)
+		throw_errno(err, "mpu6050 capture close");
+}
+
+CaptureReader::CaptureReader(const char *path, u32 capacity)
+	: hdr_(), capacity_(capacity), out_(new Sample[capacity]), cur_()
+{
+	struct stat st;
+	void *map;
+	int fd;
+
+	if (!capacity)
+		throw_errno(EINVAL, "mpu6050 capture capacity");
+
+	fd = ::open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		throw_errno(errno, path);
+	if (fstat(fd, &st) < 0) {
+		int err = errno;
+
+		::close(fd);
+		throw_errno(err, path);
+	}
+	map_size_ = st.st_size;
+	if (map_size_ < sizeof(hdr_)) {
+		::close(fd);
+		throw_errno(EINVAL, "mpu6050 capture header");
+	}
+	map = mmap(nullptr, map_size_, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (map == MAP_FAILED)
+		throw_errno(errno, path);
+	map_ = static_cast<const u8 *>(map);
+
+	std::memcpy(&hdr_, map_, sizeof(hdr_));
+	if (hdr_.magic != MPU6050_CAPTURE_MAGIC ||
+	    hdr_.version != MPU6050_CAPTURE_VERSION ||
+	    hdr_.header_size < sizeof(hdr_) ||
+	    !valid_layout(hdr_.channels, hdr_.ext_len) ||
+	    !hdr_.chunk_samples) {
+		munmap(map, map_size_);
+		throw_errno(EINVAL, "mpu6050 capture header");
+	}
+
+	if (hdr_.index_offset && hdr_.index_offset <= map_size_ &&
+	    (map_size_ - hdr_.index_offset) / sizeof(mpu6050_capture_index) >=
+	    hdr_.nr_chunks) {
+		index_.resize(hdr_.nr_chunks);
+		std::memcpy(index_.data(), map_ + hdr_.index_offset,
+			    hdr_.nr_chunks * sizeof(mpu6050_capture_index));
+	} else {
+		/* Never closed: find the complete chunks by their sizes */
+		u64 off = hdr_.header_size;
+
+		for (u32 i = 0; i < hdr_.nr_chunks; i++) {
+			mpu6050_capture_chunk ch;
+
+			if (off + sizeof(ch) > map_size_)
+				break;
+			std::memcpy(&ch, map_ + off, sizeof(ch));
+			index_.push_back({off, ch.timestamp});
+			off = MPU6050_CAPTURE_CHUNK_END(off, ch.size);
+		}
+	}
+	samples_ = std::min<u64>(hdr_.nr_samples,
+				 (u64)index_.size() * hdr_.chunk_samples);
+	seek(0);
+}
+
+CaptureReader::~CaptureReader()
+{
+	munmap(const_cast<u8 *>(map_), map_size_);
+}
+
+void CaptureReader::open_chunk(size_t chunk)
+{
+	chunk_ = chunk;
+	cur_.left = 0;
+	if (chunk >= index_.size())
+		return;
+	if (index_[chunk].offset >= map_size_ ||
+	    mpu6050_capture_start(&cur_, &hdr_, map_ + index_[chunk].offset,
+				  map_ + map_size_) < 0)
+		throw_errno(EBADMSG, "mpu6050 capture chunk");
+}
+
+bool CaptureReader::next(Sample &out)
+{
+	int ret;
+
+	if (next_ >= samples_)
+		return false;
+
+	while (!(ret = mpu6050_capture_next(&cur_))) {
+		if (chunk_ + 1 >= index_.size())
+			return false;
+		open_chunk(chunk_ + 1);
+	}
+	if (ret < 0)
+		throw_errno(EBADMSG, "mpu6050 capture chunk");
+
+	out.timestamp = cur_.timestamp;
+	out.seq = cur_.seq;
+	out.flags = cur_.flags;
+	out.raw = cur_.raw;
+	out.ext_len = cur_.ext_len;
+	out.ext = cur_.ext;
+	next_++;
+	return true;
+}
+
+void CaptureReader::seek(u64 n)
+{
+	Sample skip;
+
+	origin_ns_ = -1;
+	if (n >= samples_) {
+		open_chunk(index_.size());
+		next_ = samples_;
+		return;
+	}
+
+	/* One index lookup, then decode up to the sample within the chunk */
+	open_chunk(n / hdr_.chunk_samples);
+	next_ = (u64)chunk_ * hdr_.chunk_samples;
+	while (next_ < n && next(skip))
+		;
+}
+
+u64 CaptureReader::seek_time(s64 timestamp)
+{
+	auto it = std::upper_bound(index_.begin(), index_.end(), timestamp,
+				   [](s64 ts, const mpu6050_capture_index &e) {
+					   return ts < e.timestamp;
+				   });
+	u64 n;
+	Sample s;
+
+	seek(it == index_.begin() ? 0 :
+	     (u64)(it - index_.begin() - 1) * hdr_.chunk_samples);
+	for (n = next_; next(s) && s.timestamp < timestamp; n = next_)
+		;
+	seek(n);
+	return n;
+}
+
+size_t CaptureReader::read()
+{
+	size_ = 0;
+	while (size_ < capacity_ && next(out_[size_]))
+		size_++;
+
+	if (size_ && speed_ > 0) {
+		if (origin_ns_ < 0) {
+			origin_ns_ = monotonic_ns();
+			origin_ts_ = out_[0].timestamp;
+		}
+		pace(out_[size_ - 1].timestamp);
+	}
+	return size_;
+}
+
+/* Sleep until the replay clock reaches capture time @timestamp */
+void CaptureReader::pace(s64 timestamp)
+{
+	s64 due = origin_ns_ + (s64)((timestamp - origin_ts_) / speed_);
+	struct timespec ts;
+
+	ts.tv_sec = due / 1000000000;
+	ts.tv_nsec = due % 1000000000;
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) ==
+	       EINTR)
+		;
+}
+
+} /* namespace mpu6050 */
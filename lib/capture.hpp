@@ -0,0 +1,201 @@
+/**
+ * @file capture.hpp
+ * @brief libmpu6050 capture files: delta-encoded recording and replay
+ *
+ * Writes streams to the chunked format of include/mpu6050_capture.h and
+ * reads them back through a read-only mapping. The writer takes samples
+ * straight from a BatchReader or RingReader; the reader has the same
+ * begin()/end() interface, seeks by sample number or time through the
+ * chunk index and can pace replay at any multiple of the recorded rate.
+ *
+ * Copyright (C) 2025 Murray Kopit <murr2k@gmail.com>
+ */
+
+#ifndef LIBMPU6050_CAPTURE_HPP
+#define LIBMPU6050_CAPTURE_HPP
+
+#include <memory>
+#include <vector>
+
+#include "mpu6050.hpp"
+#include "mpu6050_capture.h"
+
+namespace mpu6050 {
+
+/* Nominal sample period of @config outside cycle mode, as the driver has it */
+u32 sample_period_ns(const mpu6050_config &config);
+
+/**
+ * CaptureWriter - Recorder of a capture file
+ *
+ * The file is grown and written through a shared mapping; every finished
+ * chunk updates the header, so a logger that loses power keeps everything
+ * up to its last full chunk. close() writes the index and trims the file.
+ * All samples must have the layout given at construction.
+ */
+class CaptureWriter {
+public:
+	CaptureWriter(const char *path, const mpu6050_config &config,
+		      const Layout &layout, u32 period_ns,
+		      u32 chunk_samples = 1024);
+	/* Takes config, layout and period from a device about to stream */
+	CaptureWriter(const char *path, const Device &dev,
+		      u32 chunk_samples = 1024);
+	CaptureWriter(const CaptureWriter &) = delete;
+	CaptureWriter &operator=(const CaptureWriter &) = delete;
+	~CaptureWriter();
+
+	void write(const Sample *begin, const Sample *end);
+
+	/* Append what a BatchReader, RingReader or CaptureReader last read */
+	template <typename Reader>
+	void write(const Reader &reader)
+	{
+		write(reader.begin(), reader.end());
+	}
+
+	/* Finish the last chunk, write the index and close the file */
+	void close();
+
+	u64 size() const
+	{
+		return samples_;
+	}
+
+	/* File size so far, for compression ratios */
+	u64 bytes() const
+	{
+		return pos_;
+	}
+
+private:
+	void reserve(size_t len);
+	void finish_chunk();
+
+	int fd_ = -1;
+	u8 *map_ = nullptr;
+	size_t map_size_ = 0;
+	size_t pos_;
+	mpu6050_capture_header hdr_;
+	std::vector<mpu6050_capture_index> index_;
+	u64 samples_ = 0;
+
+	/* Chunk being encoded */
+	size_t chunk_;
+	u32 count_ = 0;
+	s64 first_ts_;
+	u32 first_seq_;
+	s64 timestamp_;
+	u32 seq_;
+	mpu6050_raw_data raw_;
+};
+
+/**
+ * CaptureReader - Mapped reader of a capture file
+ *
+ * Samples, including their @ext pointers, point into the mapping and stay
+ * valid for the reader's lifetime. A capture that was never closed is read
+ * up to its last complete chunk.
+ */
+class CaptureReader {
+public:
+	explicit CaptureReader(const char *path, u32 capacity = 256);
+	CaptureReader(const CaptureReader &) = delete;
+	CaptureReader &operator=(const CaptureReader &) = delete;
+	~CaptureReader();
+
+	/* Decode up to capacity() samples; Return: number decoded, 0 at end */
+	size_t read();
+
+	/* Continue at sample @n, or at the end if there are fewer */
+	void seek(u64 n);
+
+	/* Continue at the first sample from @timestamp; Return: its number */
+	u64 seek_time(s64 timestamp);
+
+	/*
+	 * Pace read() at @speed times the recorded rate, 0 for as fast as
+	 * possible: it returns once the newest sample of the batch would have
+	 * been acquired. Pacing restarts at the next read() after a seek.
+	 */
+	void set_speed(double speed)
+	{
+		speed_ = speed;
+		origin_ns_ = -1;
+	}
+
+	const mpu6050_capture_header &header() const
+	{
+		return hdr_;
+	}
+
+	const mpu6050_config &config() const
+	{
+		return hdr_.config;
+	}
+
+	Layout layout() const
+	{
+		return {hdr_.channels, hdr_.ext_len};
+	}
+
+	/* Number of samples in the capture */
+	u64 samples() const
+	{
+		return samples_;
+	}
+
+	/* Number of the next sample read() returns */
+	u64 tell() const
+	{
+		return next_;
+	}
+
+	u32 capacity() const
+	{
+		return capacity_;
+	}
+
+	const Sample *begin() const
+	{
+		return out_.get();
+	}
+
+	const Sample *end() const
+	{
+		return out_.get() + size_;
+	}
+
+	size_t size() const
+	{
+		return size_;
+	}
+
+private:
+	void open_chunk(size_t chunk);
+	bool next(Sample &out);
+	void pace(s64 timestamp);
+
+	const u8 *map_;
+	size_t map_size_;
+	mpu6050_capture_header hdr_;
+	std::vector<mpu6050_capture_index> index_;
+	u64 samples_;
+	u32 capacity_;
+	size_t size_ = 0;
+	std::unique_ptr<Sample[]> out_;
+
+	/* Decoding position */
+	mpu6050_capture_cursor cur_;
+	size_t chunk_;
+	u64 next_;
+
+	/* Replay pacing */
+	double speed_ = 0;
+	s64 origin_ns_ = -1;
+	s64 origin_ts_;
+};
+
+} /* namespace mpu6050 */
+
+#endif /* LIBMPU6050_CAPTURE_HPP */
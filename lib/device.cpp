@@ -0,0 +1,420 @@
+/**
+ * @file device.cpp
+ * @brief libmpu6050 device handle, decoders, batch and ring readers
+ *
+ * Copyright (C) 2025 Murray Kopit <murr2k@gmail.com>
+ */
+
+#include "mpu6050.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace mpu6050 {
+
+namespace {
+
+constexpr auto decoders = detail::make_decoders(
+	std::make_integer_sequence<unsigned, MPU6050_CHAN_ALL + 1>());
+
+[[noreturn]] void throw_errno(int err, const char *what)
+{
+	throw std::system_error(err, std::generic_category(), what);
+}
+
+} /* namespace */
+
+Decoder::Decoder(const Layout &layout)
+	: layout_(layout), record_size_(layout.record_size())
+{
+	if (!layout.channels || layout.channels & ~MPU6050_CHAN_ALL ||
+	    layout.ext_len > MPU6050_EXT_DATA_SIZE)
+		throw_errno(EINVAL, "mpu6050 record layout");
+	fn_ = decoders[layout.channels];
+}
+
+Device::Device(const char *path, bool nonblock)
+{
+	fd_ = ::open(path, O_RDWR | O_CLOEXEC | (nonblock ? O_NONBLOCK : 0));
+	if (fd_ < 0)
+		throw_errno(errno, path);
+}
+
+Device &Device::operator=(Device &&other) noexcept
+{
+	if (this != &other) {
+		close();
+		fd_ = std::exchange(other.fd_, -1);
+	}
+	return *this;
+}
+
+Device::~Device()
+{
+	close();
+}
+
+void Device::close()
+{
+	if (fd_ >= 0)
+		::close(fd_);
+	fd_ = -1;
+}
+
+void Device::ioctl(unsigned long cmd, void *arg, const char *what) const
+{
+	int ret;
+
+	do {
+		ret = ::ioctl(fd_, cmd, arg);
+	} while (ret < 0 && errno == EINTR);
+	if (ret < 0)
+		throw_errno(errno, what);
+}
+
+mpu6050_raw_data Device::read_raw() const
+{
+	mpu6050_raw_data raw;
+
+	ioctl(MPU6050_IOC_READ_RAW, &raw, "MPU6050_IOC_READ_RAW");
+	return raw;
+}
+
+mpu6050_scaled_data Device::read_scaled() const
+{
+	mpu6050_scaled_data scaled;
+
+	ioctl(MPU6050_IOC_READ_SCALED, &scaled, "MPU6050_IOC_READ_SCALED");
+	return scaled;
+}
+
+mpu6050_ext_data Device::read_ext() const
+{
+	mpu6050_ext_data ext;
+
+	ioctl(MPU6050_IOC_READ_EXT, &ext, "MPU6050_IOC_READ_EXT");
+	return ext;
+}
+
+u8 Device::who_am_i() const
+{
+	u8 id;
+
+	ioctl(MPU6050_IOC_WHO_AM_I, &id, "MPU6050_IOC_WHO_AM_I");
+	return id;
+}
+
+mpu6050_config Device::config() const
+{
+	mpu6050_config config;
+
+	ioctl(MPU6050_IOC_GET_CONFIG, &config, "MPU6050_IOC_GET_CONFIG");
+	return config;
+}
+
+void Device::set_config(const mpu6050_config &config) const
+{
+	ioctl(MPU6050_IOC_SET_CONFIG, const_cast<mpu6050_config *>(&config),
+	      "MPU6050_IOC_SET_CONFIG");
+}
+
+u32 Device::channels() const
+{
+	u32 channels;
+
+	ioctl(MPU6050_IOC_GET_CHANNELS, &channels, "MPU6050_IOC_GET_CHANNELS");
+	return channels;
+}
+
+void Device::set_channels(u32 channels) const
+{
+	ioctl(MPU6050_IOC_SET_CHANNELS, &channels, "MPU6050_IOC_SET_CHANNELS");
+}
+
+mpu6050_aux_config Device::aux() const
+{
+	mpu6050_aux_config aux;
+
+	ioctl(MPU6050_IOC_GET_AUX, &aux, "MPU6050_IOC_GET_AUX");
+	return aux;
+}
+
+void Device::set_aux(const mpu6050_aux_config &aux) const
+{
+	ioctl(MPU6050_IOC_SET_AUX, const_cast<mpu6050_aux_config *>(&aux),
+	      "MPU6050_IOC_SET_AUX");
+}
+
+mpu6050_calibration Device::calibration() const
+{
+	mpu6050_calibration calib;
+
+	ioctl(MPU6050_IOC_GET_CALIBRATION, &calib, "MPU6050_IOC_GET_CALIBRATION");
+	return calib;
+}
+
+void Device::set_calibration(const mpu6050_calibration &calib) const
+{
+	ioctl(MPU6050_IOC_SET_CALIBRATION, const_cast<mpu6050_calibration *>(&calib),
+	      "MPU6050_IOC_SET_CALIBRATION");
+}
+
+mpu6050_decimation Device::decimation() const
+{
+	mpu6050_decimation decim;
+
+	ioctl(MPU6050_IOC_GET_DECIMATION, &decim, "MPU6050_IOC_GET_DECIMATION");
+	return decim;
+}
+
+void Device::set_decimation(const mpu6050_decimation &decim) const
+{
+	ioctl(MPU6050_IOC_SET_DECIMATION, const_cast<mpu6050_decimation *>(&decim),
+	      "MPU6050_IOC_SET_DECIMATION");
+}
+
+void Device::set_staleness(u32 usecs) const
+{
+	ioctl(MPU6050_IOC_SET_STALENESS, &usecs, "MPU6050_IOC_SET_STALENESS");
+}
+
+void Device::set_read_mode(u32 mode) const
+{
+	ioctl(MPU6050_IOC_SET_READ_MODE, &mode, "MPU6050_IOC_SET_READ_MODE");
+}
+
+void Device::set_cycle(u32 cycle) const
+{
+	ioctl(MPU6050_IOC_SET_CYCLE, &cycle, "MPU6050_IOC_SET_CYCLE");
+}
+
+void Device::reset() const
+{
+	ioctl(MPU6050_IOC_RESET, nullptr, "MPU6050_IOC_RESET");
+}
+
+void Device::self_test() const
+{
+	ioctl(MPU6050_IOC_SELF_TEST, nullptr, "MPU6050_IOC_SELF_TEST");
+}
+
+Layout Device::layout() const
+{
+	mpu6050_aux_config aux = this->aux();
+	Layout layout;
+
+	layout.channels = channels();
+	for (const mpu6050_aux_slave &slv : aux.slave)
+		layout.ext_len += slv.len;
+	return layout;
+}
+
+void Device::set_streaming(bool on) const
+{
+	int enable = on;
+
+	ioctl(MPU6050_IOC_SET_STREAMING, &enable, "MPU6050_IOC_SET_STREAMING");
+}
+
+void Device::set_watermark(u32 frames) const
+{
+	ioctl(MPU6050_IOC_SET_WATERMARK, &frames, "MPU6050_IOC_SET_WATERMARK");
+}
+
+u64 Device::lost() const
+{
+	u64 lost;
+
+	ioctl(MPU6050_IOC_GET_LOST, &lost, "MPU6050_IOC_GET_LOST");
+	return lost;
+}
+
+u32 Device::read_batch(void *buf, u32 count, int timeout_ms, u64 *lost) const
+{
+	mpu6050_batch batch = {};
+
+	batch.buf = reinterpret_cast<uintptr_t>(buf);
+	batch.count = count;
+	batch.timeout_ms = timeout_ms;
+	ioctl(MPU6050_IOC_READ_BATCH, &batch, "MPU6050_IOC_READ_BATCH");
+	if (lost)
+		*lost = batch.lost;
+	return batch.count;
+}
+
+u32 Device::read_scaled_batch(mpu6050_scaled_sample *buf, u32 count,
+			      int timeout_ms, u64 *lost) const
+{
+	mpu6050_batch batch = {};
+
+	batch.buf = reinterpret_cast<uintptr_t>(buf);
+	batch.count = count;
+	batch.timeout_ms = timeout_ms;
+	ioctl(MPU6050_IOC_READ_SCALED_BATCH, &batch,
+	      "MPU6050_IOC_READ_SCALED_BATCH");
+	if (lost)
+		*lost = batch.lost;
+	return batch.count;
+}
+
+void Device::set_group(const std::vector<const Device *> &others) const
+{
+	mpu6050_group_config cfg = {};
+
+	if (others.size() >= MPU6050_GROUP_MAX)
+		throw_errno(EINVAL, "MPU6050_IOC_SET_GROUP");
+	cfg.count = others.size() + 1;
+	for (size_t i = 0; i < others.size(); i++)
+		cfg.fds[i] = others[i]->fd();
+	ioctl(MPU6050_IOC_SET_GROUP, &cfg, "MPU6050_IOC_SET_GROUP");
+}
+
+void Device::clear_group() const
+{
+	mpu6050_group_config cfg = {};
+
+	ioctl(MPU6050_IOC_SET_GROUP, &cfg, "MPU6050_IOC_SET_GROUP");
+}
+
+void Device::set_group_streaming(bool on) const
+{
+	int enable = on;
+
+	ioctl(MPU6050_IOC_SET_GROUP_STREAMING, &enable,
+	      "MPU6050_IOC_SET_GROUP_STREAMING");
+}
+
+u32 Device::read_group(mpu6050_group_sample *buf, u32 count, int timeout_ms,
+		       u64 *lost) const
+{
+	mpu6050_batch batch = {};
+
+	batch.buf = reinterpret_cast<uintptr_t>(buf);
+	batch.count = count;
+	batch.timeout_ms = timeout_ms;
+	ioctl(MPU6050_IOC_READ_GROUP, &batch, "MPU6050_IOC_READ_GROUP");
+	if (lost)
+		*lost = batch.lost;
+	return batch.count;
+}
+
+BatchReader::BatchReader(const Device &dev, u32 capacity)
+	: dev_(dev), decoder_(dev.layout()), capacity_(capacity),
+	  buf_(new u8[capacity * record_max_size]),
+	  samples_(new Sample[capacity])
+{
+	if (!capacity)
+		throw_errno(EINVAL, "mpu6050 batch capacity");
+}
+
+size_t BatchReader::read(int timeout_ms)
+{
+	u32 n = dev_.read_batch(buf_.get(), capacity_, timeout_ms, &lost_);
+
+	size_ = decoder_.decode(buf_.get(), n, samples_.get());
+	return size_;
+}
+
+RingReader::RingReader(const Device &dev, u32 capacity)
+	: capacity_(capacity), buf_(new u8[capacity * record_max_size]),
+	  samples_(new Sample[capacity])
+{
+	size_t page = sysconf(_SC_PAGESIZE);
+	void *map;
+	u32 nr, offset;
+
+	if (!capacity)
+		throw_errno(EINVAL, "mpu6050 ring capacity");
+
+	/* The header page says how large the rest of the mapping is */
+	map = mmap(nullptr, page, PROT_READ, MAP_SHARED, dev.fd(), 0);
+	if (map == MAP_FAILED)
+		throw_errno(errno, "mpu6050 ring header");
+	hdr_ = static_cast<const mpu6050_ring_header *>(map);
+	if (hdr_->magic != MPU6050_RING_MAGIC ||
+	    hdr_->version != MPU6050_RING_VERSION) {
+		munmap(map, page);
+		throw_errno(EPROTO, "mpu6050 ring header");
+	}
+	nr = hdr_->nr_records;
+	offset = hdr_->data_offset;
+	munmap(map, page);
+
+	/* Slots are sized for the largest layout */
+	map_size_ = offset + nr * record_max_size;
+	map = mmap(nullptr, map_size_, PROT_READ, MAP_SHARED, dev.fd(), 0);
+	if (map == MAP_FAILED)
+		throw_errno(errno, "mpu6050 ring");
+	hdr_ = static_cast<const mpu6050_ring_header *>(map);
+	records_ = static_cast<const u8 *>(map) + offset;
+	tail_ = __atomic_load_n(&hdr_->head, __ATOMIC_ACQUIRE);
+}
+
+RingReader::~RingReader()
+{
+	munmap(const_cast<mpu6050_ring_header *>(hdr_), map_size_);
+}
+
+size_t RingReader::poll()
+{
+	u32 head, oldest, layout_seq, record_size, n, skip, i;
+	u32 nr = hdr_->nr_records;
+	u8 *dst = buf_.get();
+	Layout layout;
+
+	size_ = 0;
+	head = __atomic_load_n(&hdr_->head, __ATOMIC_ACQUIRE);
+	layout_seq = hdr_->layout_seq;
+	layout.channels = hdr_->channels;
+	layout.ext_len = hdr_->ext_len;
+	record_size = hdr_->record_size;
+
+	/* Records from before a layout change are skipped, not lost */
+	if ((s32)(layout_seq - tail_) > 0)
+		tail_ = layout_seq;
+	if ((s32)(head - tail_) <= 0)
+		return 0;
+
+	n = head - tail_;
+	if (n > nr) {
+		lost_ += n - nr;
+		tail_ = head - nr;
+		n = nr;
+	}
+	if (n > capacity_)
+		n = capacity_;
+
+	/* Copy in at most two runs, before and after the wrap */
+	for (i = 0; i < n;) {
+		u32 idx = (tail_ + i) & (nr - 1);
+		u32 run = std::min(n - i, nr - idx);
+
+		std::memcpy(dst + (size_t)i * record_size,
+			    records_ + (size_t)idx * record_size,
+			    (size_t)run * record_size);
+		i += run;
+	}
+
+	/* Anything the producer may have overwritten while copying is lost */
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	head = __atomic_load_n(&hdr_->head, __ATOMIC_RELAXED);
+	oldest = head - nr + 1;
+	skip = 0;
+	if ((s32)(oldest - tail_) > 0)
+		skip = std::min(oldest - tail_, n);
+	lost_ += skip;
+	tail_ += n;
+
+	if (skip < n)
+		size_ = Decoder(layout).decode(dst + (size_t)skip * record_size,
+					       n - skip, samples_.get());
+	return size_;
+}
+
+} /* namespace mpu6050 */
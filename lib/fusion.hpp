@@ -0,0 +1,458 @@
+/**
+ * @file fusion.hpp
+ * @brief libmpu6050 orientation fusion over sample batches
+ *
+ * Turns decoded streaming samples into orientation quaternions with a
+ * Madgwick or a complementary (Mahony proportional) filter. One Fusion
+ * object tracks a bank of sensors; the filter state of all of them lives
+ * in structure-of-arrays form and update() runs a whole batch of one
+ * sensor in a tight loop that neither allocates nor makes virtual calls.
+ *
+ * The arithmetic type is a template parameter: float, or mpu6050::Fixed,
+ * a Q8.24 fixed-point type for targets without an FPU. Only setup (gains,
+ * scale factors) uses floating point, and it folds into constants.
+ *
+ * Copyright (C) 2025 Murray Kopit <murr2k@gmail.com>
+ */
+
+#ifndef LIBMPU6050_FUSION_HPP
+#define LIBMPU6050_FUSION_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+#include "mpu6050.hpp"
+
+namespace mpu6050 {
+
+/**
+ * Fixed - Signed Q8.24 fixed-point number
+ *
+ * Range is +/-128 with a resolution of 6e-8, enough for unit quaternions,
+ * normalised vectors and angular rates up to the +/-2000 dps range in
+ * rad/s.
+ */
+class Fixed {
+public:
+	static constexpr int frac_bits = 24;
+
+	constexpr Fixed() : v_(0)
+	{
+	}
+
+	constexpr explicit Fixed(double d)
+		: v_((s32)(d * (1 << frac_bits) + (d < 0 ? -0.5 : 0.5)))
+	{
+	}
+
+	static constexpr Fixed from_raw(s32 v)
+	{
+		Fixed f;
+
+		f.v_ = v;
+		return f;
+	}
+
+	constexpr s32 raw() const
+	{
+		return v_;
+	}
+
+	constexpr double to_double() const
+	{
+		return (double)v_ / (1 << frac_bits);
+	}
+
+	friend constexpr Fixed operator+(Fixed a, Fixed b)
+	{
+		return from_raw(a.v_ + b.v_);
+	}
+
+	friend constexpr Fixed operator-(Fixed a, Fixed b)
+	{
+		return from_raw(a.v_ - b.v_);
+	}
+
+	friend constexpr Fixed operator-(Fixed a)
+	{
+		return from_raw(-a.v_);
+	}
+
+	friend constexpr Fixed operator*(Fixed a, Fixed b)
+	{
+		return from_raw(((s64)a.v_ * b.v_ + (1 << (frac_bits - 1))) >>
+				frac_bits);
+	}
+
+	friend constexpr Fixed operator*(Fixed a, int k)
+	{
+		return from_raw(a.v_ * k);
+	}
+
+	friend constexpr bool operator!=(Fixed a, Fixed b)
+	{
+		return a.v_ != b.v_;
+	}
+
+	Fixed &operator+=(Fixed b)
+	{
+		v_ += b.v_;
+		return *this;
+	}
+
+	Fixed &operator-=(Fixed b)
+	{
+		v_ -= b.v_;
+		return *this;
+	}
+
+	Fixed &operator*=(Fixed b)
+	{
+		return *this = *this * b;
+	}
+
+	/*
+	 * Reciprocal of the Euclidean norm of (a, b, c, d), zero for a zero
+	 * vector. The squares are summed in 64 bits, so components up to the
+	 * full range do not overflow.
+	 */
+	friend Fixed inv_norm(Fixed a, Fixed b, Fixed c, Fixed d = Fixed())
+	{
+		/* Q46 squares, four of them stay below 2^63 */
+		u64 sum = (u64)((s64)a.v_ * a.v_ >> 2) + ((s64)b.v_ * b.v_ >> 2) +
+			  ((s64)c.v_ * c.v_ >> 2) + ((s64)d.v_ * d.v_ >> 2);
+		u64 root = isqrt(sum);	/* Q23 */
+
+		if (!root)
+			return Fixed();
+		return from_raw((s32)std::min<u64>((1ULL << 47) / root, INT32_MAX));
+	}
+
+private:
+	static u64 isqrt(u64 x)
+	{
+		u64 res = 0, bit = 1ULL << 62;
+
+		while (bit > x)
+			bit >>= 2;
+		for (; bit; bit >>= 2) {
+			if (x >= res + bit) {
+				x -= res + bit;
+				res = (res >> 1) + bit;
+			} else {
+				res >>= 1;
+			}
+		}
+		return res;
+	}
+
+	s32 v_;
+};
+
+inline float inv_norm(float a, float b, float c, float d = 0)
+{
+	float sum = a * a + b * b + c * c + d * d;
+
+	return sum > 0 ? 1 / std::sqrt(sum) : 0;
+}
+
+namespace detail {
+
+template <typename T>
+constexpr T from_double(double d)
+{
+	return T(d);
+}
+
+/* Seconds in @ns nanoseconds, @ns at most one second */
+inline float ns_to_sec(s64 ns, float)
+{
+	return ns * 1e-9f;
+}
+
+inline Fixed ns_to_sec(s64 ns, Fixed)
+{
+	return Fixed::from_raw((s32)((ns << Fixed::frac_bits) / 1000000000));
+}
+
+/* @raw counts of @lsb each */
+inline float from_counts(s32 raw, float lsb)
+{
+	return raw * lsb;
+}
+
+inline Fixed from_counts(s32 raw, Fixed lsb)
+{
+	return Fixed::from_raw(raw * lsb.raw());
+}
+
+} /* namespace detail */
+
+/**
+ * struct Quat - Orientation of one sample
+ * @timestamp: Time of the sample, as in struct Sample
+ * @seq: Sequence number of the sample
+ * @w, @x, @y, @z: Unit quaternion rotating the sensor frame into the
+ *		   earth frame
+ */
+template <typename T>
+struct Quat {
+	s64 timestamp;
+	u32 seq;
+	T w, x, y, z;
+};
+
+/**
+ * Madgwick - Gradient-descent orientation filter (IMU variant)
+ *
+ * The gain is beta, the rate of convergence to the accelerometer's view
+ * of gravity in rad/s; 0.033 to 0.1 are typical.
+ */
+struct Madgwick {
+	template <typename T>
+	static void step(T &q0, T &q1, T &q2, T &q3, T gx, T gy, T gz, T ax,
+			 T ay, T az, T dt, T beta)
+	{
+		constexpr T half = detail::from_double<T>(0.5);
+		T qd0 = (-q1 * gx - q2 * gy - q3 * gz) * half;
+		T qd1 = (q0 * gx + q2 * gz - q3 * gy) * half;
+		T qd2 = (q0 * gy - q1 * gz + q3 * gx) * half;
+		T qd3 = (q0 * gz + q1 * gy - q2 * gx) * half;
+		T n = inv_norm(ax, ay, az);
+
+		if (n != T()) {
+			T q0q0 = q0 * q0, q1q1 = q1 * q1;
+			T q2q2 = q2 * q2, q3q3 = q3 * q3;
+			T s0, s1, s2, s3;
+
+			ax *= n;
+			ay *= n;
+			az *= n;
+
+			s0 = (q0 * q2q2 + q0 * q1q1) * 4 + q2 * ax * 2 - q1 * ay * 2;
+			s1 = q1 * q3q3 * 4 - q3 * ax * 2 + q0q0 * q1 * 4 -
+			     q0 * ay * 2 - q1 * 4 + q1 * q1q1 * 8 +
+			     q1 * q2q2 * 8 + q1 * az * 4;
+			s2 = q0q0 * q2 * 4 + q0 * ax * 2 + q2 * q3q3 * 4 -
+			     q3 * ay * 2 - q2 * 4 + q2 * q1q1 * 8 +
+			     q2 * q2q2 * 8 + q2 * az * 4;
+			s3 = q1q1 * q3 * 4 - q1 * ax * 2 + q2q2 * q3 * 4 -
+			     q2 * ay * 2;
+
+			n = inv_norm(s0, s1, s2, s3) * beta;
+			qd0 -= s0 * n;
+			qd1 -= s1 * n;
+			qd2 -= s2 * n;
+			qd3 -= s3 * n;
+		}
+
+		q0 += qd0 * dt;
+		q1 += qd1 * dt;
+		q2 += qd2 * dt;
+		q3 += qd3 * dt;
+		n = inv_norm(q0, q1, q2, q3);
+		q0 *= n;
+		q1 *= n;
+		q2 *= n;
+		q3 *= n;
+	}
+};
+
+/**
+ * Complementary - Proportional complementary filter (Mahony without the
+ * integral term)
+ *
+ * Integrates the gyroscope and pulls the estimate towards the measured
+ * gravity direction; the gain is the proportional gain Kp in rad/s.
+ */
+struct Complementary {
+	template <typename T>
+	static void step(T &q0, T &q1, T &q2, T &q3, T gx, T gy, T gz, T ax,
+			 T ay, T az, T dt, T kp)
+	{
+		constexpr T half = detail::from_double<T>(0.5);
+		T n = inv_norm(ax, ay, az);
+		T qa, qb, qc;
+
+		if (n != T()) {
+			T vx, vy, vz;
+
+			ax *= n;
+			ay *= n;
+			az *= n;
+
+			/* Half the gravity direction the estimate predicts */
+			vx = q1 * q3 - q0 * q2;
+			vy = q0 * q1 + q2 * q3;
+			vz = q0 * q0 - half + q3 * q3;
+
+			gx += (ay * vz - az * vy) * kp * 2;
+			gy += (az * vx - ax * vz) * kp * 2;
+			gz += (ax * vy - ay * vx) * kp * 2;
+		}
+
+		gx *= dt * half;
+		gy *= dt * half;
+		gz *= dt * half;
+		qa = q0;
+		qb = q1;
+		qc = q2;
+		q0 += -qb * gx - qc * gy - q3 * gz;
+		q1 += qa * gx + qc * gz - q3 * gy;
+		q2 += qa * gy - qb * gz + q3 * gx;
+		q3 += qa * gz + qb * gy - qc * gx;
+
+		n = inv_norm(q0, q1, q2, q3);
+		q0 *= n;
+		q1 *= n;
+		q2 *= n;
+		q3 *= n;
+	}
+};
+
+/**
+ * Fusion - Orientation filters for a bank of sensors
+ *
+ * Sensor state is kept per component across the bank (all w, then all x,
+ * ...), so the bank for many sensors stays in a few cache lines. Gyroscope
+ * readings are converted with the range and bias of each sensor's
+ * configuration; accelerometer readings only need their direction and
+ * are used raw. The first sample after construction or reset(), and any
+ * sample more than a second after the previous one, only re-anchors the
+ * time base.
+ */
+template <typename T, typename Filter = Madgwick>
+class Fusion {
+public:
+	Fusion(unsigned sensors, double gain)
+		: sensors_(sensors), gain_(detail::from_double<T>(gain)),
+		  state_(new T[4 * sensors]), last_ts_(new s64[sensors]),
+		  gyro_lsb_(new T[sensors]), gyro_bias_(new s32[3 * sensors])
+	{
+		mpu6050_config config = {};
+
+		config.gyro_range = MPU6050_GYRO_FS_250;
+		for (unsigned i = 0; i < sensors; i++) {
+			set_sensor(i, config);
+			reset(i);
+		}
+	}
+
+	unsigned sensors() const
+	{
+		return sensors_;
+	}
+
+	/* Gyroscope range and bias of @sensor, from its configuration */
+	void set_sensor(unsigned sensor, const mpu6050_config &config,
+			const mpu6050_calibration *calib = nullptr)
+	{
+		/* udps/LSB to rad/s per LSB */
+		double lsb = mpu6050_gyro_range_to_scale(config.gyro_range) *
+			     1e-6 * 3.14159265358979323846 / 180;
+
+		gyro_lsb_[sensor] = detail::from_double<T>(lsb);
+		for (unsigned i = 0; i < 3; i++)
+			gyro_bias_[3 * sensor + i] = calib ? calib->gyro_bias[i] : 0;
+	}
+
+	/* Back to the identity orientation and no time base */
+	void reset(unsigned sensor)
+	{
+		w_()[sensor] = detail::from_double<T>(1);
+		x_()[sensor] = y_()[sensor] = z_()[sensor] = T();
+		last_ts_[sensor] = 0;
+	}
+
+	/* Current orientation of @sensor */
+	Quat<T> orientation(unsigned sensor) const
+	{
+		return {last_ts_[sensor], 0, w_()[sensor], x_()[sensor],
+			y_()[sensor], z_()[sensor]};
+	}
+
+	/**
+	 * update - Run a batch of one sensor through its filter
+	 * @sensor: Sensor index
+	 * @samples: Samples in time order, e.g. from BatchReader or RingReader
+	 * @n: Number of samples
+	 * @out: If not NULL, receives the orientation after each sample
+	 *
+	 * Return: number of samples processed, always @n
+	 */
+	size_t update(unsigned sensor, const Sample *samples, size_t n,
+		      Quat<T> *out)
+	{
+		T q0 = w_()[sensor], q1 = x_()[sensor];
+		T q2 = y_()[sensor], q3 = z_()[sensor];
+		const T lsb = gyro_lsb_[sensor];
+		const s32 *bias = &gyro_bias_[3 * sensor];
+		s64 last = last_ts_[sensor];
+
+		for (size_t i = 0; i < n; i++) {
+			const Sample &s = samples[i];
+			s64 dt_ns = s.timestamp - last;
+
+			last = s.timestamp;
+			if (dt_ns > 0 && dt_ns <= 1000000000)
+				Filter::step(
+					q0, q1, q2, q3,
+					detail::from_counts(s.raw.gyro_x - bias[0], lsb),
+					detail::from_counts(s.raw.gyro_y - bias[1], lsb),
+					detail::from_counts(s.raw.gyro_z - bias[2], lsb),
+					counts(s.raw.accel_x), counts(s.raw.accel_y),
+					counts(s.raw.accel_z),
+					detail::ns_to_sec(dt_ns, T()), gain_);
+			if (out)
+				out[i] = {s.timestamp, s.seq, q0, q1, q2, q3};
+		}
+
+		w_()[sensor] = q0;
+		x_()[sensor] = q1;
+		y_()[sensor] = q2;
+		z_()[sensor] = q3;
+		last_ts_[sensor] = last;
+		return n;
+	}
+
+private:
+	/* Accelerometer counts, scaled down to keep Q8.24 in range */
+	static T counts(s16 raw)
+	{
+		constexpr T lsb = detail::from_double<T>(1.0 / 32768);
+
+		return detail::from_counts(raw, lsb);
+	}
+
+	T *w_() const
+	{
+		return state_.get();
+	}
+
+	T *x_() const
+	{
+		return state_.get() + sensors_;
+	}
+
+	T *y_() const
+	{
+		return state_.get() + 2 * sensors_;
+	}
+
+	T *z_() const
+	{
+		return state_.get() + 3 * sensors_;
+	}
+
+	unsigned sensors_;
+	T gain_;
+	std::unique_ptr<T[]> state_;
+	std::unique_ptr<s64[]> last_ts_;
+	std::unique_ptr<T[]> gyro_lsb_;
+	std::unique_ptr<s32[]> gyro_bias_;
+};
+
+} /* namespace mpu6050 */
+
+#endif /* LIBMPU6050_FUSION_HPP */
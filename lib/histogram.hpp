@@ -0,0 +1,213 @@
+/**
+ * @file histogram.hpp
+ * @brief libmpu6050 log-linear latency histogram
+ *
+ * Values below 32 get a bucket each; above that every power of two is
+ * split into 32 linear sub-buckets, so quantiles are within about 3% of
+ * the recorded values, up to 2^41 ns (about 36 minutes). Larger values are
+ * clamped. Count, sum, minimum and maximum are exact.
+ *
+ * The counter type is a template parameter. Histogram counts in plain
+ * integers. SharedHistogram counts in atomics, so other threads may merge
+ * it while its owner records. Updates are relaxed load/store pairs rather
+ * than read-modify-write instructions, which is only correct with a
+ * single writer.
+ *
+ * Needs only the standard library, so test code that defines its own
+ * kernel types can include it without mpu6050.hpp.
+ *
+ * Copyright (C) 2025 Murray Kopit <murr2k@gmail.com>
+ */
+
+#ifndef LIBMPU6050_HISTOGRAM_HPP
+#define LIBMPU6050_HISTOGRAM_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+
+namespace mpu6050 {
+
+namespace detail {
+
+inline uint64_t counter_load(uint64_t c)
+{
+	return c;
+}
+
+inline uint64_t counter_load(const std::atomic<uint64_t> &c)
+{
+	return c.load(std::memory_order_relaxed);
+}
+
+inline void counter_store(uint64_t &c, uint64_t v)
+{
+	c = v;
+}
+
+inline void counter_store(std::atomic<uint64_t> &c, uint64_t v)
+{
+	c.store(v, std::memory_order_relaxed);
+}
+
+} /* namespace detail */
+
+template <typename Counter>
+class BasicHistogram {
+public:
+	static constexpr unsigned sub_bits = 5;
+	static constexpr unsigned sub_count = 1u << sub_bits;
+	static constexpr unsigned max_exp = 40;
+	static constexpr unsigned nr_buckets = (max_exp - sub_bits + 2) * sub_count;
+	static constexpr uint64_t max_value = (1ull << (max_exp + 1)) - 1;
+
+	/* Bucket of value @v, which must not exceed max_value */
+	static unsigned bucket(uint64_t v)
+	{
+		unsigned exp;
+
+		if (v < sub_count)
+			return v;
+		exp = 63 - __builtin_clzll(v);
+		return (exp - sub_bits + 1) * sub_count +
+		       ((v >> (exp - sub_bits)) & (sub_count - 1));
+	}
+
+	/* Middle of the values that land in bucket @b */
+	static uint64_t midpoint(unsigned b)
+	{
+		unsigned exp;
+
+		if (b < sub_count)
+			return b;
+		exp = b / sub_count + sub_bits - 1;
+		return ((uint64_t)(sub_count + b % sub_count) << (exp - sub_bits)) +
+		       ((1ull << (exp - sub_bits)) >> 1);
+	}
+
+	void add(uint64_t v)
+	{
+		v = std::min(v, max_value);
+		bump(counts_[bucket(v)], 1);
+		bump(count_, 1);
+		bump(sum_, v);
+		if (v < detail::counter_load(min_))
+			detail::counter_store(min_, v);
+		if (v > detail::counter_load(max_))
+			detail::counter_store(max_, v);
+	}
+
+	template <typename Other>
+	void merge(const BasicHistogram<Other> &other)
+	{
+		for (unsigned i = 0; i < nr_buckets; i++)
+			bump(counts_[i], detail::counter_load(other.counts_[i]));
+		bump(count_, other.count());
+		bump(sum_, other.sum());
+		if (other.count() && other.min() < detail::counter_load(min_))
+			detail::counter_store(min_, other.min());
+		if (other.max() > detail::counter_load(max_))
+			detail::counter_store(max_, other.max());
+	}
+
+	/* Only while no thread records */
+	void clear()
+	{
+		for (Counter &c : counts_)
+			detail::counter_store(c, 0);
+		detail::counter_store(count_, 0);
+		detail::counter_store(sum_, 0);
+		detail::counter_store(min_, UINT64_MAX);
+		detail::counter_store(max_, 0);
+	}
+
+	uint64_t count() const
+	{
+		return detail::counter_load(count_);
+	}
+
+	uint64_t sum() const
+	{
+		return detail::counter_load(sum_);
+	}
+
+	/* Extremes and mean are 0 when empty */
+	uint64_t min() const
+	{
+		return count() ? detail::counter_load(min_) : 0;
+	}
+
+	uint64_t max() const
+	{
+		return detail::counter_load(max_);
+	}
+
+	double mean() const
+	{
+		return count() ? (double)sum() / count() : 0;
+	}
+
+	/* Number of values in bucket @b */
+	uint64_t at(unsigned b) const
+	{
+		return detail::counter_load(counts_[b]);
+	}
+
+	/* Value at quantile @q in [0, 1], within the recorded range */
+	uint64_t percentile(double q) const
+	{
+		uint64_t total = count();
+		uint64_t rank = (uint64_t)std::ceil(q * total);
+		uint64_t seen = 0;
+
+		if (!total)
+			return 0;
+		rank = std::max<uint64_t>(rank, 1);
+		for (unsigned i = 0; i < nr_buckets; i++) {
+			seen += at(i);
+			if (seen >= rank)
+				return std::clamp(midpoint(i), min(), max());
+		}
+		return max();
+	}
+
+	/* Standard deviation of the bucket midpoints about the exact mean */
+	double stddev() const
+	{
+		double m = mean(), var = 0;
+
+		if (!count())
+			return 0;
+		for (unsigned i = 0; i < nr_buckets; i++) {
+			if (at(i)) {
+				double d = midpoint(i) - m;
+
+				var += d * d * at(i);
+			}
+		}
+		return std::sqrt(var / count());
+	}
+
+private:
+	template <typename> friend class BasicHistogram;
+
+	static void bump(Counter &c, uint64_t n)
+	{
+		detail::counter_store(c, detail::counter_load(c) + n);
+	}
+
+	std::array<Counter, nr_buckets> counts_{};
+	Counter count_{0};
+	Counter sum_{0};
+	Counter min_{UINT64_MAX};
+	Counter max_{0};
+};
+
+using Histogram = BasicHistogram<uint64_t>;
+using SharedHistogram = BasicHistogram<std::atomic<uint64_t>>;
+
+} /* namespace mpu6050 */
+
+#endif /* LIBMPU6050_HISTOGRAM_HPP */
@@ -0,0 +1,79 @@
+/**
+ * @file merge.cpp
+ * @brief libmpu6050 timestamp-ordered merge of several sensors
+ *
+ * Copyright (C) 2025 Murray Kopit <murr2k@gmail.com>
+ */
+
+#include "mpu6050.hpp"
+
+#include <cerrno>
+#include <system_error>
+
+namespace mpu6050 {
+
+size_t merge(SampleRun *runs, unsigned n, MergedSample *out, size_t max,
+	     bool flush)
+{
+	size_t done = 0;
+
+	while (done < max) {
+		unsigned best = n;
+
+		for (unsigned i = 0; i < n; i++) {
+			if (runs[i].begin == runs[i].end) {
+				if (!flush)
+					return done;
+				continue;
+			}
+			if (best == n ||
+			    runs[i].begin->timestamp < runs[best].begin->timestamp)
+				best = i;
+		}
+		if (best == n)
+			break;
+
+		out[done].sensor = best;
+		out[done++].sample = *runs[best].begin++;
+	}
+	return done;
+}
+
+Merger::Merger(const std::vector<const Device *> &devices, u32 capacity)
+	: runs_(devices.size()), capacity_((size_t)capacity * devices.size()),
+	  out_(new MergedSample[(size_t)capacity * devices.size()])
+{
+	if (devices.empty())
+		throw std::system_error(EINVAL, std::generic_category(),
+					"mpu6050 merger devices");
+
+	for (const Device *dev : devices)
+		readers_.emplace_back(new RingReader(*dev, capacity));
+	for (SampleRun &run : runs_)
+		run = {nullptr, nullptr};
+}
+
+size_t Merger::poll(bool flush)
+{
+	/* Only used-up readers are refilled; the others still back runs_ */
+	for (size_t i = 0; i < readers_.size(); i++) {
+		if (runs_[i].begin != runs_[i].end)
+			continue;
+		readers_[i]->poll();
+		runs_[i] = {readers_[i]->begin(), readers_[i]->end()};
+	}
+
+	size_ = merge(runs_.data(), runs_.size(), out_.get(), capacity_, flush);
+	return size_;
+}
+
+u64 Merger::lost() const
+{
+	u64 lost = 0;
+
+	for (const auto &reader : readers_)
+		lost += reader->lost();
+	return lost;
+}
+
+} /* namespace mpu6050 */
@@ -0,0 +1,591 @@
+/**
+ * @file mpu6050.hpp
+ * @brief libmpu6050 - C++ client for the MPU-6050 character device
+ *
+ * RAII device handles, batch and memory-mapped ring readers, an io_uring
+ * reader that keeps batch reads in flight on many devices from one thread,
+ * a timestamp-ordered merge of several sensors, and record decoders
+ * specialised at compile time for every channel mask.
+ *
+ * Setup (opening, configuring, constructing readers) allocates and throws
+ * std::system_error on failure. The read paths never allocate: readers own
+ * their buffers, sized once from the capacity given at construction.
+ *
+ * Copyright (C) 2025 Murray Kopit <murr2k@gmail.com>
+ */
+
+#ifndef LIBMPU6050_HPP
+#define LIBMPU6050_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "mpu6050.h"
+
+struct io_uring_cqe;
+struct io_uring_sqe;
+
+namespace mpu6050 {
+
+/**
+ * struct Layout - Shape of a packed streaming record
+ * @channels: MPU6050_CHAN_* mask of the channels in each record
+ * @ext_len: Number of external sensor bytes after the channels
+ */
+struct Layout {
+	u32 channels = MPU6050_CHAN_ALL;
+	u32 ext_len = 0;
+
+	constexpr unsigned nr_channels() const
+	{
+		return __builtin_popcount(channels);
+	}
+
+	constexpr size_t record_size() const
+	{
+		return MPU6050_RECORD_EXT_SIZE(nr_channels(), ext_len);
+	}
+};
+
+/* Largest record any layout produces */
+constexpr size_t record_max_size =
+	MPU6050_RECORD_EXT_SIZE(MPU6050_NUM_CHANNELS, MPU6050_EXT_DATA_SIZE);
+
+/**
+ * struct Sample - Decoded streaming record
+ * @timestamp: Acquisition time in nanoseconds (CLOCK_MONOTONIC)
+ * @seq: Sample sequence number
+ * @flags: MPU6050_SAMPLE_* flags
+ * @raw: Raw readings, zero for channels the record does not carry
+ * @ext_len: Number of external sensor bytes at @ext
+ * @ext: External sensor bytes, pointing into the source record
+ */
+struct Sample {
+	s64 timestamp;
+	u32 seq;
+	u16 flags;
+	mpu6050_raw_data raw;
+	u32 ext_len;
+	const u8 *ext;
+};
+
+/**
+ * struct SampleRun - Decoded samples of one sensor, oldest first
+ * @begin: Next sample to merge
+ * @end: One past the last sample
+ */
+struct SampleRun {
+	const Sample *begin;
+	const Sample *end;
+};
+
+/**
+ * struct MergedSample - Sample of a multi-sensor stream
+ * @sensor: Index of the sensor the sample comes from
+ * @sample: The sample
+ */
+struct MergedSample {
+	unsigned sensor;
+	Sample sample;
+};
+
+/**
+ * merge - Interleave per-sensor runs of samples by timestamp
+ * @runs: One run per sensor, each advanced past its merged samples
+ * @n: Number of runs
+ * @out: Room for @max merged samples
+ * @max: Maximum number of samples to merge
+ * @flush: Keep merging the other runs when one is used up
+ *
+ * Follows the release rule of MPU6050_IOC_READ_GROUP: the oldest head of
+ * all runs goes first, ties to the lower sensor index, and without @flush
+ * merging stops as soon as one run is empty, because that sensor's next
+ * sample may be older than anything the others hold.
+ *
+ * Return: number of samples stored in @out
+ */
+size_t merge(SampleRun *runs, unsigned n, MergedSample *out, size_t max,
+	     bool flush = false);
+
+namespace detail {
+
+/* Position of channel @n among the channels of @mask */
+constexpr unsigned chan_slot(u32 mask, unsigned n)
+{
+	return __builtin_popcount(mask & ((1u << n) - 1));
+}
+
+template <u32 Channels, unsigned N>
+inline void decode_chan(const u8 *src, s16 *dst)
+{
+	if constexpr (Channels & (1u << N))
+		std::memcpy(&dst[N], src + 2 * chan_slot(Channels, N), 2);
+	else
+		dst[N] = 0;
+}
+
+template <u32 Channels, unsigned... N>
+inline void decode_chans(const u8 *src, s16 *dst,
+			 std::integer_sequence<unsigned, N...>)
+{
+	(decode_chan<Channels, N>(src, dst), ...);
+}
+
+template <u32 Channels>
+inline void decode_record(const u8 *rec, Sample &out, u32 ext_len)
+{
+	constexpr size_t data = offsetof(struct mpu6050_record, data);
+	s16 raw[MPU6050_NUM_CHANNELS];
+
+	std::memcpy(&out.timestamp, rec + offsetof(struct mpu6050_record, timestamp),
+		    sizeof(out.timestamp));
+	std::memcpy(&out.seq, rec + offsetof(struct mpu6050_record, seq),
+		    sizeof(out.seq));
+	std::memcpy(&out.flags, rec + offsetof(struct mpu6050_record, flags),
+		    sizeof(out.flags));
+	decode_chans<Channels>(rec + data, raw,
+			       std::make_integer_sequence<unsigned,
+							  MPU6050_NUM_CHANNELS>());
+	std::memcpy(&out.raw, raw, sizeof(out.raw));
+	out.ext_len = ext_len;
+	out.ext = rec + data + 2 * __builtin_popcount(Channels);
+}
+
+/* Decode @n records of the given layout, one stride apart */
+template <u32 Channels>
+size_t decode_records(const u8 *buf, size_t n, Sample *out, u32 ext_len)
+{
+	const size_t stride = MPU6050_RECORD_EXT_SIZE(__builtin_popcount(Channels),
+						      ext_len);
+
+	for (size_t i = 0; i < n; i++, buf += stride)
+		decode_record<Channels>(buf, out[i], ext_len);
+	return n;
+}
+
+using decode_fn = size_t (*)(const u8 *, size_t, Sample *, u32);
+
+/* One instantiation per channel mask, indexed by the mask */
+template <unsigned... M>
+constexpr auto make_decoders(std::integer_sequence<unsigned, M...>)
+{
+	return std::array<decode_fn, sizeof...(M)>{
+		(M ? &decode_records<M> : nullptr)...};
+}
+
+} /* namespace detail */
+
+/**
+ * RecordDecoder - Decoder for a layout known at compile time
+ *
+ * Channel positions, the record stride and the external byte offset all
+ * fold into constants, so decoding a record is a handful of fixed loads.
+ */
+template <u32 Channels, u32 ExtLen = 0>
+struct RecordDecoder {
+	static_assert(Channels && !(Channels & ~MPU6050_CHAN_ALL),
+		      "invalid channel mask");
+	static_assert(ExtLen <= MPU6050_EXT_DATA_SIZE,
+		      "too many external bytes");
+
+	static constexpr Layout layout{Channels, ExtLen};
+	static constexpr size_t record_size = layout.record_size();
+
+	static void decode(const void *rec, Sample &out)
+	{
+		detail::decode_record<Channels>(static_cast<const u8 *>(rec),
+						out, ExtLen);
+	}
+
+	static size_t decode(const void *buf, size_t n, Sample *out)
+	{
+		return detail::decode_records<Channels>(
+			static_cast<const u8 *>(buf), n, out, ExtLen);
+	}
+};
+
+/**
+ * Decoder - Decoder for a layout known at run time
+ *
+ * Dispatches once per batch to the specialised decoder of the layout's
+ * channel mask.
+ */
+class Decoder {
+public:
+	explicit Decoder(const Layout &layout = Layout());
+
+	const Layout &layout() const
+	{
+		return layout_;
+	}
+
+	size_t record_size() const
+	{
+		return record_size_;
+	}
+
+	size_t decode(const void *buf, size_t n, Sample *out) const
+	{
+		return fn_(static_cast<const u8 *>(buf), n, out, layout_.ext_len);
+	}
+
+private:
+	Layout layout_;
+	size_t record_size_;
+	detail::decode_fn fn_;
+};
+
+/**
+ * Device - Open MPU-6050 character device
+ *
+ * Owns the file descriptor and wraps the ioctl interface. Movable, not
+ * copyable; the descriptor is closed on destruction.
+ */
+class Device {
+public:
+	Device() = default;
+	explicit Device(const char *path, bool nonblock = false);
+	Device(Device &&other) noexcept : fd_(std::exchange(other.fd_, -1))
+	{
+	}
+	Device &operator=(Device &&other) noexcept;
+	Device(const Device &) = delete;
+	Device &operator=(const Device &) = delete;
+	~Device();
+
+	int fd() const
+	{
+		return fd_;
+	}
+
+	explicit operator bool() const
+	{
+		return fd_ >= 0;
+	}
+
+	void close();
+
+	/* One-shot reads */
+	mpu6050_raw_data read_raw() const;
+	mpu6050_scaled_data read_scaled() const;
+	mpu6050_ext_data read_ext() const;
+	u8 who_am_i() const;
+
+	/* Configuration */
+	mpu6050_config config() const;
+	void set_config(const mpu6050_config &config) const;
+	u32 channels() const;
+	void set_channels(u32 channels) const;
+	mpu6050_aux_config aux() const;
+	void set_aux(const mpu6050_aux_config &aux) const;
+	mpu6050_calibration calibration() const;
+	void set_calibration(const mpu6050_calibration &calib) const;
+	mpu6050_decimation decimation() const;
+	void set_decimation(const mpu6050_decimation &decim) const;
+	void set_staleness(u32 usecs) const;
+	void set_read_mode(u32 mode) const;
+	void set_cycle(u32 cycle) const;
+	void reset() const;
+	void self_test() const;
+
+	/* Streaming */
+	Layout layout() const;
+	void set_streaming(bool on) const;
+	void set_watermark(u32 frames) const;
+	u64 lost() const;
+
+	/**
+	 * read_batch - MPU6050_IOC_READ_BATCH into a caller buffer
+	 * @buf: Room for @count records of the current layout
+	 * @count: Capacity of @buf in records
+	 * @timeout_ms: How long to wait for @count records
+	 * @lost: If not NULL, set to the records this file missed so far
+	 *
+	 * Return: number of records read, 0 on timeout
+	 */
+	u32 read_batch(void *buf, u32 count, int timeout_ms,
+		       u64 *lost = nullptr) const;
+	u32 read_scaled_batch(mpu6050_scaled_sample *buf, u32 count,
+			      int timeout_ms, u64 *lost = nullptr) const;
+
+	/*
+	 * Capture group owned by this device's file, which is sensor 0;
+	 * @others become sensors 1 and up. The group holds references to
+	 * their files, so the Device objects may be closed afterwards.
+	 */
+	void set_group(const std::vector<const Device *> &others) const;
+	void clear_group() const;
+	void set_group_streaming(bool on) const;
+
+	/* MPU6050_IOC_READ_GROUP; Return: number of merged records read */
+	u32 read_group(mpu6050_group_sample *buf, u32 count, int timeout_ms,
+		       u64 *lost = nullptr) const;
+
+private:
+	void ioctl(unsigned long cmd, void *arg, const char *what) const;
+
+	int fd_ = -1;
+};
+
+/**
+ * BatchReader - Decoded batch reads of a streaming device
+ *
+ * The layout is sampled at construction; call set_layout() after changing
+ * the channels or auxiliary slaves of a device that was restarted.
+ */
+class BatchReader {
+public:
+	BatchReader(const Device &dev, u32 capacity);
+
+	/* Read up to capacity() records; Return: number of samples decoded */
+	size_t read(int timeout_ms);
+
+	void set_layout(const Layout &layout)
+	{
+		decoder_ = Decoder(layout);
+	}
+
+	const Layout &layout() const
+	{
+		return decoder_.layout();
+	}
+
+	u32 capacity() const
+	{
+		return capacity_;
+	}
+
+	const Sample *begin() const
+	{
+		return samples_.get();
+	}
+
+	const Sample *end() const
+	{
+		return samples_.get() + size_;
+	}
+
+	size_t size() const
+	{
+		return size_;
+	}
+
+	/* Records the device file missed so far */
+	u64 lost() const
+	{
+		return lost_;
+	}
+
+private:
+	const Device &dev_;
+	Decoder decoder_;
+	u32 capacity_;
+	size_t size_ = 0;
+	u64 lost_ = 0;
+	std::unique_ptr<u8[]> buf_;
+	std::unique_ptr<Sample[]> samples_;
+};
+
+/**
+ * RingReader - Lockless reader of the memory-mapped sample ring
+ *
+ * Follows the consumer protocol in include/mpu6050.h: records are copied
+ * out of the mapping first and only decoded once a second head load shows
+ * the producer did not overwrite them meanwhile. Starts at the current
+ * head, so the first poll() only returns records published after
+ * construction. Use poll(2) on the device for wakeups.
+ */
+class RingReader {
+public:
+	RingReader(const Device &dev, u32 capacity = 256);
+	RingReader(const RingReader &) = delete;
+	RingReader &operator=(const RingReader &) = delete;
+	~RingReader();
+
+	/* Consume up to capacity() new records; Return: number decoded */
+	size_t poll();
+
+	const mpu6050_ring_header &header() const
+	{
+		return *hdr_;
+	}
+
+	const Sample *begin() const
+	{
+		return samples_.get();
+	}
+
+	const Sample *end() const
+	{
+		return samples_.get() + size_;
+	}
+
+	size_t size() const
+	{
+		return size_;
+	}
+
+	/* Records overwritten before they could be read */
+	u64 lost() const
+	{
+		return lost_;
+	}
+
+private:
+	const mpu6050_ring_header *hdr_;
+	const u8 *records_;
+	size_t map_size_;
+	u32 capacity_;
+	u32 tail_;
+	size_t size_ = 0;
+	u64 lost_ = 0;
+	std::unique_ptr<u8[]> buf_;
+	std::unique_ptr<Sample[]> samples_;
+};
+
+/**
+ * Merger - Timestamp-ordered stream over several devices' mapped rings
+ *
+ * The library counterpart of MPU6050_IOC_READ_GROUP for sensors that are
+ * streamed on their own, for instance by different processes. Each device
+ * gets a RingReader; every poll() refills the readers that were used up
+ * and merges with merge(). A sensor's samples that cannot be ordered yet
+ * stay queued for the next poll(). Merged samples, including their @ext
+ * pointers, are valid until the next poll().
+ */
+class Merger {
+public:
+	explicit Merger(const std::vector<const Device *> &devices,
+			u32 capacity = 256);
+
+	/* Merge what the rings hold; Return: number of merged samples */
+	size_t poll(bool flush = false);
+
+	const MergedSample *begin() const
+	{
+		return out_.get();
+	}
+
+	const MergedSample *end() const
+	{
+		return out_.get() + size_;
+	}
+
+	size_t size() const
+	{
+		return size_;
+	}
+
+	/* Records of all sensors overwritten before they could be read */
+	u64 lost() const;
+
+private:
+	std::vector<std::unique_ptr<RingReader>> readers_;
+	std::vector<SampleRun> runs_;
+	size_t capacity_;
+	size_t size_ = 0;
+	std::unique_ptr<MergedSample[]> out_;
+};
+
+/**
+ * struct Completion - Finished asynchronous batch read
+ * @source: Index returned by AsyncReader::add()
+ * @slot: Buffer slot, pass the completion back to AsyncReader::release()
+ * @res: Bytes read, or a negative errno
+ * @buf: The records read
+ */
+struct Completion {
+	unsigned source;
+	unsigned slot;
+	int res;
+	const u8 *buf;
+};
+
+/**
+ * AsyncReader - io_uring batch reads across many devices
+ *
+ * Each added device gets @depth buffer slots, all of which are kept queued
+ * as reads so a device always has a buffer to complete into. A completed
+ * slot stays with the caller until it is released, which re-queues it.
+ * Talks to the kernel through the raw io_uring system calls, no liburing
+ * needed.
+ */
+class AsyncReader {
+public:
+	explicit AsyncReader(unsigned entries = 64);
+	AsyncReader(const AsyncReader &) = delete;
+	AsyncReader &operator=(const AsyncReader &) = delete;
+	~AsyncReader();
+
+	/*
+	 * Add a streaming device read in blocks of @records records of its
+	 * current layout. The device must outlive the reader.
+	 * Return: source index for completions
+	 */
+	unsigned add(const Device &dev, u32 records, unsigned depth = 2);
+
+	/* Queue every idle slot and submit it */
+	void start();
+
+	/*
+	 * Submit queued reads and wait for at least @min completions.
+	 * Return: number of completions stored in @out, at most @max
+	 */
+	unsigned wait(Completion *out, unsigned max, unsigned min = 1);
+
+	/* Hand a completed slot back; it is submitted with the next wait() */
+	void release(const Completion &c);
+
+	const Decoder &decoder(unsigned source) const
+	{
+		return sources_[source].decoder;
+	}
+
+	/* Decode the records of a successful completion into @out */
+	size_t decode(const Completion &c, Sample *out) const
+	{
+		const Decoder &dec = sources_[c.source].decoder;
+
+		return dec.decode(c.buf, c.res / dec.record_size(), out);
+	}
+
+private:
+	struct Source {
+		int fd;
+		Decoder decoder;
+		u32 len;
+	};
+
+	struct Slot {
+		unsigned source;
+		std::unique_ptr<u8[]> buf;
+	};
+
+	void unmap();
+	void queue(unsigned slot);
+	void enter(unsigned min, bool wait);
+
+	int ring_fd_ = -1;
+	unsigned sq_entries_ = 0;
+	unsigned queued_ = 0;
+	void *sq_ring_ = nullptr;
+	void *cq_ring_ = nullptr;
+	size_t sq_ring_size_ = 0;
+	size_t cq_ring_size_ = 0;
+	struct io_uring_sqe *sqes_ = nullptr;
+	size_t sqes_size_ = 0;
+	unsigned *sq_tail_, *sq_mask_, *sq_array_;
+	unsigned *cq_head_, *cq_tail_, *cq_mask_;
+	struct io_uring_cqe *cqes_;
+	std::vector<Source> sources_;
+	std::vector<Slot> slots_;
+};
+
+} /* namespace mpu6050 */
+
+#endif /* LIBMPU6050_HPP */
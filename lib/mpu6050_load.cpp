@@ -0,0 +1,514 @@
+/**
+ * @file mpu6050_load.cpp
+ * @brief Multi-device, multi-threaded load generator for the MPU-6050 driver
+ *
+ * Usage: mpu6050_load [-n readers] [-m modes] [-c cpus] [-t rate]
+ *			[-r records] [-D divider] [-s seconds] device...
+ *
+ * Starts readers threads spread round-robin over the device nodes, each
+ * with its own open file and one read path:
+ *	oneshot	MPU6050_IOC_READ_RAW
+ *	read	blocking read() of streaming records
+ *	batch	MPU6050_IOC_READ_BATCH
+ *	ring	the mmap() sample ring, woken by poll(2)
+ *	epoll	non-blocking read() driven by epoll
+ * Modes (a comma-separated list, all five by default) are assigned so that
+ * every device gets each mode in turn. Devices with a streaming reader are
+ * put in streaming mode for the run.
+ *
+ * Reader n is pinned to the n-th CPU of the -c list (as in taskset, e.g.
+ * 0-3,6) modulo its length, and -t throttles every reader to that many
+ * calls per second. At the end it prints, per device and mode, calls,
+ * samples, throughput, sequence-gap drops, errors and latency percentiles:
+ * the call round trip for oneshot, acquisition to delivery for the
+ * streaming modes. Raise the readers or the output data rate (-D) until
+ * throughput stops following to find where the driver or the bus
+ * saturates.
+ *
+ * Copyright (C) 2025 Murray Kopit <murr2k@gmail.com>
+ */
+
+#include "histogram.hpp"
+#include "mpu6050.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <pthread.h>
+#include <poll.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+
+enum class Mode {
+	oneshot,
+	read,
+	batch,
+	ring,
+	epoll,
+};
+
+const char *const mode_names[] = {"oneshot", "read", "batch", "ring", "epoll"};
+constexpr unsigned nr_modes = sizeof(mode_names) / sizeof(mode_names[0]);
+
+/* Wakeup period of the streaming modes, so they notice the end of the run */
+constexpr int wait_ms = 100;
+
+std::atomic<bool> stopping{false};
+
+/* Readers that ended on an error */
+std::atomic<unsigned> failed{0};
+
+s64 now_ns()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (s64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+struct Stats {
+	u64 calls = 0;
+	u64 samples = 0;
+	u64 drops = 0;
+	u64 errors = 0;
+	mpu6050::Histogram latency;
+
+	void merge(const Stats &other)
+	{
+		calls += other.calls;
+		samples += other.samples;
+		drops += other.drops;
+		errors += other.errors;
+		latency.merge(other.latency);
+	}
+};
+
+struct Options {
+	const char *const *paths;
+	u32 records;
+	double rate;
+};
+
+struct Reader {
+	unsigned device;
+	Mode mode;
+	int cpu;
+	const Options *opt;
+	Stats stats;
+	u32 next_seq = 0;
+	bool started = false;
+	pthread_t thread;
+};
+
+/* Count drops by sequence number and delivery latency of streamed samples */
+void account(Reader &r, const mpu6050::Sample *samples, size_t n)
+{
+	s64 now = now_ns();
+
+	for (size_t i = 0; i < n; i++) {
+		if (r.started && (s32)(samples[i].seq - r.next_seq) > 0)
+			r.stats.drops += samples[i].seq - r.next_seq;
+		r.next_seq = samples[i].seq + 1;
+		r.started = true;
+		r.stats.latency.add(std::max<s64>(now - samples[i].timestamp, 0));
+	}
+	r.stats.samples += n;
+}
+
+/* Sleep until the next call slot of a throttled reader */
+void throttle(struct timespec &next, long period_ns)
+{
+	if (!period_ns)
+		return;
+	next.tv_nsec += period_ns;
+	while (next.tv_nsec >= 1000000000) {
+		next.tv_nsec -= 1000000000;
+		next.tv_sec++;
+	}
+	clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr);
+}
+
+/* read() of whole records; Return: records read, 0 on EAGAIN or EINTR */
+size_t read_records(const mpu6050::Device &dev, u8 *buf, size_t size,
+		    size_t record_size, Reader &r)
+{
+	ssize_t ret = ::read(dev.fd(), buf, size);
+
+	r.stats.calls++;
+	if (ret < 0) {
+		if (errno != EAGAIN && errno != EINTR)
+			r.stats.errors++;
+		return 0;
+	}
+	return ret / record_size;
+}
+
+void run_reader(Reader &r, const Options &opt)
+{
+	const char *path = opt.paths[r.device];
+	mpu6050::Device dev(path, r.mode == Mode::epoll);
+	long period_ns = opt.rate > 0 ? (long)(1e9 / opt.rate) : 0;
+	struct timespec next;
+
+	clock_gettime(CLOCK_MONOTONIC, &next);
+
+	switch (r.mode) {
+	case Mode::oneshot:
+		while (!stopping.load(std::memory_order_relaxed)) {
+			s64 start = now_ns();
+
+			r.stats.calls++;
+			try {
+				dev.read_raw();
+				r.stats.samples++;
+			} catch (const std::system_error &) {
+				r.stats.errors++;
+			}
+			r.stats.latency.add(now_ns() - start);
+			throttle(next, period_ns);
+		}
+		break;
+
+	case Mode::batch: {
+		mpu6050::BatchReader reader(dev, opt.records);
+
+		while (!stopping.load(std::memory_order_relaxed)) {
+			r.stats.calls++;
+			try {
+				reader.read(wait_ms);
+				account(r, reader.begin(), reader.size());
+			} catch (const std::system_error &e) {
+				if (e.code().value() != EINTR)
+					r.stats.errors++;
+			}
+			throttle(next, period_ns);
+		}
+		break;
+	}
+
+	case Mode::ring: {
+		mpu6050::RingReader reader(dev, opt.records);
+		struct pollfd pfd = {dev.fd(), POLLIN, 0};
+
+		while (!stopping.load(std::memory_order_relaxed)) {
+			poll(&pfd, 1, wait_ms);
+			r.stats.calls++;
+			account(r, reader.begin(), reader.poll());
+			throttle(next, period_ns);
+		}
+		break;
+	}
+
+	case Mode::read:
+	case Mode::epoll: {
+		mpu6050::Decoder decoder(dev.layout());
+		size_t size = opt.records * decoder.record_size();
+		std::unique_ptr<u8[]> buf(new u8[size]);
+		std::unique_ptr<mpu6050::Sample[]> samples(
+			new mpu6050::Sample[opt.records]);
+		int ep = -1;
+
+		if (r.mode == Mode::epoll) {
+			struct epoll_event ev = {};
+
+			ep = epoll_create1(EPOLL_CLOEXEC);
+			ev.events = EPOLLIN;
+			if (ep < 0 || epoll_ctl(ep, EPOLL_CTL_ADD, dev.fd(), &ev) < 0)
+				throw std::system_error(errno, std::generic_category(),
+							"epoll");
+		}
+
+		while (!stopping.load(std::memory_order_relaxed)) {
+			size_t n;
+
+			if (ep >= 0) {
+				struct epoll_event ev;
+
+				if (epoll_wait(ep, &ev, 1, wait_ms) <= 0)
+					continue;
+				/* Drain what is buffered before waiting again */
+				while ((n = read_records(dev, buf.get(), size,
+							 decoder.record_size(), r)))
+					account(r, samples.get(),
+						decoder.decode(buf.get(), n, samples.get()));
+			} else {
+				/* The end of the run interrupts a blocked read() */
+				n = read_records(dev, buf.get(), size,
+						 decoder.record_size(), r);
+				account(r, samples.get(),
+					decoder.decode(buf.get(), n, samples.get()));
+			}
+			throttle(next, period_ns);
+		}
+		if (ep >= 0)
+			close(ep);
+		break;
+	}
+	}
+}
+
+void *reader_main(void *arg)
+{
+	Reader &r = *static_cast<Reader *>(arg);
+
+	try {
+		run_reader(r, *r.opt);
+	} catch (const std::system_error &e) {
+		fprintf(stderr, "%s (%s): %s\n", r.opt->paths[r.device],
+			mode_names[static_cast<int>(r.mode)], e.what());
+		failed++;
+	}
+	return nullptr;
+}
+
+/*
+ * Start the thread of @r. Its affinity goes in the creation attributes, so
+ * a pinned reader never runs, or faults in its stack, on another CPU.
+ */
+void start_reader(Reader &r)
+{
+	pthread_attr_t attr;
+	cpu_set_t set;
+	int ret;
+
+	pthread_attr_init(&attr);
+	if (r.cpu >= 0) {
+		CPU_ZERO(&set);
+		CPU_SET(r.cpu, &set);
+		pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+	}
+	ret = pthread_create(&r.thread, &attr, reader_main, &r);
+	pthread_attr_destroy(&attr);
+	if (ret && r.cpu >= 0)
+		throw std::system_error(ret, std::generic_category(),
+					"cannot start reader on CPU " +
+					std::to_string(r.cpu));
+	if (ret)
+		throw std::system_error(ret, std::generic_category(),
+					"cannot start reader");
+}
+
+/* End the run for the first @n readers and wait for them */
+void stop_readers(std::vector<Reader> &readers, size_t n)
+{
+	stopping = true;
+	for (size_t i = 0; i < n; i++)
+		pthread_kill(readers[i].thread, SIGUSR1);
+	for (size_t i = 0; i < n; i++)
+		pthread_join(readers[i].thread, nullptr);
+}
+
+/* Parse a taskset-style CPU list such as 0-3,6 */
+std::vector<int> parse_cpus(const char *list)
+{
+	std::vector<int> cpus;
+	const char *p = list;
+
+	while (*p) {
+		char *end;
+		long first = strtol(p, &end, 10), last = first;
+
+		if (end == p)
+			break;
+		if (*end == '-')
+			last = strtol(end + 1, &end, 10);
+		for (long cpu = first; cpu <= last; cpu++)
+			cpus.push_back(cpu);
+		p = *end == ',' ? end + 1 : end;
+		if (*end && *end != ',')
+			break;
+	}
+	return cpus;
+}
+
+std::vector<Mode> parse_modes(const char *list)
+{
+	std::vector<Mode> modes;
+	std::string s(list);
+	size_t pos = 0;
+
+	while (pos <= s.size()) {
+		size_t comma = std::min(s.find(',', pos), s.size());
+		std::string name = s.substr(pos, comma - pos);
+		unsigned m;
+
+		for (m = 0; m < nr_modes; m++)
+			if (name == mode_names[m])
+				break;
+		if (m == nr_modes)
+			return {};
+		modes.push_back(static_cast<Mode>(m));
+		pos = comma + 1;
+	}
+	return modes;
+}
+
+void usage(const char *prog)
+{
+	fprintf(stderr,
+		"Usage: %s [-n readers] [-m modes] [-c cpus] [-t rate] [-r records]\n"
+		"       [-D divider] [-s seconds] device...\n"
+		"Modes: oneshot,read,batch,ring,epoll (default all)\n",
+		prog);
+	exit(1);
+}
+
+void print_row(const char *device, const char *mode, unsigned readers,
+	       const Stats &st, double seconds)
+{
+	printf("%-16s %-8s %7u %10llu %11llu %11.1f %8llu %7llu %8.1f %8.1f %8.1f %9.1f\n",
+	       device, mode, readers, (unsigned long long)st.calls,
+	       (unsigned long long)st.samples, st.samples / seconds,
+	       (unsigned long long)st.drops, (unsigned long long)st.errors,
+	       st.latency.percentile(0.50) / 1e3,
+	       st.latency.percentile(0.99) / 1e3,
+	       st.latency.percentile(0.999) / 1e3, st.latency.max() / 1e3);
+}
+
+} /* namespace */
+
+int main(int argc, char **argv)
+{
+	unsigned nr_readers = 0, seconds = 10;
+	int divider = -1;
+	std::vector<Mode> modes = parse_modes("oneshot,read,batch,ring,epoll");
+	std::vector<int> cpus;
+	Options opt = {nullptr, 64, 0};
+	int c;
+
+	while ((c = getopt(argc, argv, "n:m:c:t:r:D:s:")) != -1) {
+		switch (c) {
+		case 'n':
+			nr_readers = strtoul(optarg, nullptr, 0);
+			break;
+		case 'm':
+			modes = parse_modes(optarg);
+			break;
+		case 'c':
+			cpus = parse_cpus(optarg);
+			if (cpus.empty())
+				usage(argv[0]);
+			break;
+		case 't':
+			opt.rate = strtod(optarg, nullptr);
+			break;
+		case 'r':
+			opt.records = strtoul(optarg, nullptr, 0);
+			break;
+		case 'D':
+			divider = strtol(optarg, nullptr, 0);
+			break;
+		case 's':
+			seconds = strtoul(optarg, nullptr, 0);
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (optind == argc || modes.empty() || !opt.records || divider > 255)
+		usage(argv[0]);
+	opt.paths = argv + optind;
+
+	unsigned nr_devices = argc - optind;
+	if (!nr_readers)
+		nr_readers = nr_devices * modes.size();
+
+	/* Blocked reads and waits return EINTR when the run ends */
+	struct sigaction sa = {};
+	sa.sa_handler = [](int) {};
+	sigaction(SIGUSR1, &sa, nullptr);
+
+	try {
+		std::vector<mpu6050::Device> devs;
+		std::vector<bool> streamed(nr_devices);
+		std::vector<Reader> readers(nr_readers);
+
+		for (unsigned i = 0; i < nr_readers; i++) {
+			Reader &r = readers[i];
+
+			r.device = i % nr_devices;
+			r.mode = modes[(i / nr_devices) % modes.size()];
+			r.cpu = cpus.empty() ? -1 : cpus[i % cpus.size()];
+			r.opt = &opt;
+			if (r.mode != Mode::oneshot)
+				streamed[r.device] = true;
+		}
+
+		/* Control files hold the configuration and streaming state */
+		devs.reserve(nr_devices);
+		for (unsigned d = 0; d < nr_devices; d++) {
+			devs.emplace_back(opt.paths[d]);
+			if (divider >= 0) {
+				mpu6050_config config = devs[d].config();
+
+				config.sample_rate_div = divider;
+				devs[d].set_config(config);
+			}
+			if (streamed[d])
+				devs[d].set_streaming(true);
+		}
+
+		size_t started = 0;
+		try {
+			for (; started < readers.size(); started++)
+				start_reader(readers[started]);
+		} catch (const std::system_error &) {
+			stop_readers(readers, started);
+			throw;
+		}
+
+		s64 start = now_ns();
+		sleep(seconds);
+		stop_readers(readers, readers.size());
+		double elapsed = (now_ns() - start) / 1e9;
+
+		for (unsigned d = 0; d < nr_devices; d++)
+			if (streamed[d])
+				devs[d].set_streaming(false);
+
+		printf("%-16s %-8s %7s %10s %11s %11s %8s %7s %8s %8s %8s %9s\n",
+		       "device", "mode", "readers", "calls", "samples", "samples/s",
+		       "drops", "errors", "p50 us", "p99 us", "p99.9 us", "max us");
+		for (unsigned d = 0; d < nr_devices; d++) {
+			Stats total;
+			unsigned total_readers = 0;
+
+			for (unsigned m = 0; m < nr_modes; m++) {
+				Stats st;
+				unsigned n = 0;
+
+				for (const Reader &r : readers) {
+					if (r.device != d || r.mode != static_cast<Mode>(m))
+						continue;
+					st.merge(r.stats);
+					n++;
+				}
+				if (!n)
+					continue;
+				print_row(opt.paths[d], mode_names[m], n, st, elapsed);
+				total.merge(st);
+				total_readers += n;
+			}
+			print_row(opt.paths[d], "all", total_readers, total, elapsed);
+		}
+		if (failed)
+			return 1;
+	} catch (const std::system_error &e) {
+		fprintf(stderr, "%s\n", e.what());
+		return 1;
+	}
+	return 0;
+}
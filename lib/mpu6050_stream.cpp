@@ -0,0 +1,155 @@
+/**
+ * @file mpu6050_stream.cpp
+ * @brief Stream one or more MPU-6050 devices through libmpu6050
+ *
+ * Usage: mpu6050_stream [-r records] [-d depth] [-s seconds] [-o prefix]
+ *			/dev/mpu6050...
+ *
+ * Streams every device with an io_uring reader and prints the per-device
+ * sample rate, losses and latest reading once per second. With -o, device
+ * n is also recorded to the capture file <prefix>n.cap.
+ *
+ * Copyright (C) 2025 Murray Kopit <murr2k@gmail.com>
+ */
+
+#include "capture.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <system_error>
+
+#include <unistd.h>
+
+namespace {
+
+struct Stats {
+	u64 samples;
+	u64 lost;
+	u32 next_seq;
+	bool started;
+	mpu6050_raw_data last;
+};
+
+void usage(const char *prog)
+{
+	fprintf(stderr,
+		"Usage: %s [-r records] [-d depth] [-s seconds] [-o prefix] device...\n",
+		prog);
+	exit(1);
+}
+
+} /* namespace */
+
+int main(int argc, char **argv)
+{
+	unsigned records = 64, depth = 2, seconds = 10;
+	const char *prefix = nullptr;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "r:d:s:o:")) != -1) {
+		switch (opt) {
+		case 'r':
+			records = strtoul(optarg, nullptr, 0);
+			break;
+		case 'd':
+			depth = strtoul(optarg, nullptr, 0);
+			break;
+		case 's':
+			seconds = strtoul(optarg, nullptr, 0);
+			break;
+		case 'o':
+			prefix = optarg;
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (optind == argc || !records || !depth)
+		usage(argv[0]);
+
+	try {
+		unsigned nr = argc - optind;
+		std::vector<mpu6050::Device> devs;
+		std::vector<Stats> stats(nr);
+		std::vector<mpu6050::Completion> done(nr * depth);
+		std::vector<mpu6050::Sample> samples(records);
+		std::vector<std::unique_ptr<mpu6050::CaptureWriter>> captures(nr);
+		mpu6050::AsyncReader reader(nr * depth);
+		auto start = std::chrono::steady_clock::now();
+		auto report = start + std::chrono::seconds(1);
+
+		devs.reserve(nr);
+		for (int i = optind; i < argc; i++) {
+			devs.emplace_back(argv[i]);
+			if (prefix) {
+				std::string path = prefix +
+					std::to_string(i - optind) + ".cap";
+
+				captures[i - optind].reset(new mpu6050::CaptureWriter(
+					path.c_str(), devs.back()));
+			}
+			devs.back().set_streaming(true);
+			reader.add(devs.back(), records, depth);
+		}
+		reader.start();
+
+		while (std::chrono::steady_clock::now() - start <
+		       std::chrono::seconds(seconds)) {
+			unsigned n = reader.wait(done.data(), done.size());
+
+			for (unsigned i = 0; i < n; i++) {
+				const mpu6050::Completion &c = done[i];
+				Stats &st = stats[c.source];
+				size_t got;
+
+				if (c.res < 0)
+					throw std::system_error(-c.res,
+								std::generic_category(),
+								argv[optind + c.source]);
+				got = reader.decode(c, samples.data());
+				if (captures[c.source])
+					captures[c.source]->write(samples.data(),
+								  samples.data() + got);
+				for (size_t j = 0; j < got; j++) {
+					if (st.started)
+						st.lost += samples[j].seq - st.next_seq;
+					st.next_seq = samples[j].seq + 1;
+					st.started = true;
+				}
+				if (got)
+					st.last = samples[got - 1].raw;
+				st.samples += got;
+				reader.release(c);
+			}
+
+			if (std::chrono::steady_clock::now() < report)
+				continue;
+			report += std::chrono::seconds(1);
+			for (unsigned i = 0; i < nr; i++) {
+				Stats &st = stats[i];
+
+				printf("%s: %llu samples/s, %llu lost, accel %d %d %d gyro %d %d %d\n",
+				       argv[optind + i],
+				       (unsigned long long)st.samples,
+				       (unsigned long long)st.lost,
+				       st.last.accel_x, st.last.accel_y,
+				       st.last.accel_z, st.last.gyro_x,
+				       st.last.gyro_y, st.last.gyro_z);
+				st.samples = st.lost = 0;
+			}
+		}
+
+		for (const mpu6050::Device &dev : devs)
+			dev.set_streaming(false);
+		for (auto &capture : captures)
+			if (capture)
+				capture->close();
+	} catch (const std::system_error &e) {
+		fprintf(stderr, "%s\n", e.what());
+		return 1;
+	}
+	return 0;
+}
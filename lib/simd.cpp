@@ -0,0 +1,428 @@
+/**
+ * @file simd.cpp
+ * @brief libmpu6050 vectorised FIFO decode and scaling kernels
+ *
+ * Deinterleaving loads eight frames into eight vectors, byte-swaps them
+ * and transposes the 8x8 block of 16-bit lanes, so each vector ends up
+ * holding one channel of eight samples. Frames narrower than 16 bytes are
+ * handled the same way, the lanes past the last channel are ignored; the
+ * loop stops early enough that the last 16-byte load stays in the buffer.
+ *
+ * Scaling needs (raw * mult + add) >> 24 in 64 bits. The x86 kernels
+ * multiply even and odd 32-bit lanes separately with PMULDQ and take bits
+ * 24..55 of each product, which are exactly the 32 bits the scalar code
+ * keeps, no 64-bit arithmetic shift required. NEON widens with VMLAL and
+ * narrows with VSHRN.
+ *
+ * Copyright (C) 2025 Murray Kopit <murr2k@gmail.com>
+ */
+
+#include "simd.hpp"
+
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MPU6050_SIMD_X86 1
+#endif
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#define MPU6050_SIMD_NEON 1
+#endif
+
+namespace mpu6050 {
+
+namespace {
+
+/* Frames converted at a time by fifo_to_scaled_soa() */
+constexpr size_t block_frames = 1024;
+
+/* Channel carried in each 16-bit slot of a frame */
+struct SlotMap {
+	unsigned nr;
+	unsigned chan[MPU6050_NUM_CHANNELS];
+};
+
+SlotMap slot_map(u32 channels)
+{
+	SlotMap map = {};
+
+	for (unsigned c = 0; c < MPU6050_NUM_CHANNELS; c++)
+		if (channels & BIT(c))
+			map.chan[map.nr++] = c;
+	return map;
+}
+
+/* Frames a 16-byte-per-frame kernel may load without reading past @n */
+size_t vector_frames(size_t n, size_t stride)
+{
+	size_t bytes = n * stride;
+
+	if (bytes < 7 * stride + 16)
+		return 0;
+	return ((bytes - 16) / stride - 7) / 8 * 8 + 8;
+}
+
+void fifo_scalar(const u8 *fifo, size_t i, size_t n, const SlotMap &map,
+		 const RawSoa &out)
+{
+	size_t stride = 2 * map.nr;
+
+	for (; i < n; i++) {
+		const u8 *f = fifo + i * stride;
+
+		for (unsigned s = 0; s < map.nr; s++) {
+			s16 *dst = out.chan[map.chan[s]];
+
+			if (dst)
+				dst[i] = (s16)(f[2 * s] << 8 | f[2 * s + 1]);
+		}
+	}
+}
+
+void scale_scalar(const s16 *in, size_t i, size_t n, s32 mult, s64 add,
+		  s32 *out)
+{
+	for (; i < n; i++)
+		out[i] = ((s64)in[i] * mult + add) >> MPU6050_SCALE_SHIFT;
+}
+
+#ifdef MPU6050_SIMD_X86
+
+__attribute__((target("ssse3")))
+size_t fifo_ssse3(const u8 *fifo, size_t n, const SlotMap &map,
+		  const RawSoa &out)
+{
+	const __m128i swap = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6,
+					   9, 8, 11, 10, 13, 12, 15, 14);
+	size_t stride = 2 * map.nr;
+	size_t end = vector_frames(n, stride);
+	size_t i;
+
+	for (i = 0; i < end; i += 8) {
+		const u8 *f = fifo + i * stride;
+		__m128i r[8], t[8], u[8], col[8];
+
+		for (unsigned k = 0; k < 8; k++)
+			r[k] = _mm_shuffle_epi8(_mm_loadu_si128(
+				(const __m128i *)(f + k * stride)), swap);
+
+		for (unsigned k = 0; k < 8; k += 2) {
+			t[k] = _mm_unpacklo_epi16(r[k], r[k + 1]);
+			t[k + 1] = _mm_unpackhi_epi16(r[k], r[k + 1]);
+		}
+		for (unsigned k = 0; k < 8; k += 4) {
+			u[k] = _mm_unpacklo_epi32(t[k], t[k + 2]);
+			u[k + 1] = _mm_unpackhi_epi32(t[k], t[k + 2]);
+			u[k + 2] = _mm_unpacklo_epi32(t[k + 1], t[k + 3]);
+			u[k + 3] = _mm_unpackhi_epi32(t[k + 1], t[k + 3]);
+		}
+		for (unsigned k = 0; k < 4; k++) {
+			col[2 * k] = _mm_unpacklo_epi64(u[k], u[k + 4]);
+			col[2 * k + 1] = _mm_unpackhi_epi64(u[k], u[k + 4]);
+		}
+
+		for (unsigned s = 0; s < map.nr; s++) {
+			s16 *dst = out.chan[map.chan[s]];
+
+			if (dst)
+				_mm_storeu_si128((__m128i *)(dst + i), col[s]);
+		}
+	}
+	return i;
+}
+
+__attribute__((target("sse4.1")))
+size_t scale_sse41(const s16 *in, size_t n, s32 mult, s64 add, s32 *out)
+{
+	const __m128i m = _mm_set1_epi32(mult);
+	const __m128i a = _mm_set1_epi64x(add);
+	size_t i;
+
+	for (i = 0; i + 4 <= n; i += 4) {
+		__m128i v = _mm_cvtepi16_epi32(
+			_mm_loadl_epi64((const __m128i *)(in + i)));
+		__m128i even = _mm_add_epi64(_mm_mul_epi32(v, m), a);
+		__m128i odd = _mm_add_epi64(
+			_mm_mul_epi32(_mm_srli_epi64(v, 32), m), a);
+
+		even = _mm_srli_epi64(even, MPU6050_SCALE_SHIFT);
+		odd = _mm_slli_epi64(odd, 32 - MPU6050_SCALE_SHIFT);
+		_mm_storeu_si128((__m128i *)(out + i),
+				 _mm_blend_epi16(even, odd, 0xcc));
+	}
+	return i;
+}
+
+__attribute__((target("avx2")))
+size_t scale_avx2(const s16 *in, size_t n, s32 mult, s64 add, s32 *out)
+{
+	const __m256i m = _mm256_set1_epi32(mult);
+	const __m256i a = _mm256_set1_epi64x(add);
+	size_t i;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		__m256i v = _mm256_cvtepi16_epi32(
+			_mm_loadu_si128((const __m128i *)(in + i)));
+		__m256i even = _mm256_add_epi64(_mm256_mul_epi32(v, m), a);
+		__m256i odd = _mm256_add_epi64(
+			_mm256_mul_epi32(_mm256_srli_epi64(v, 32), m), a);
+
+		even = _mm256_srli_epi64(even, MPU6050_SCALE_SHIFT);
+		odd = _mm256_slli_epi64(odd, 32 - MPU6050_SCALE_SHIFT);
+		_mm256_storeu_si256((__m256i *)(out + i),
+				    _mm256_blend_epi32(even, odd, 0xaa));
+	}
+	return i;
+}
+
+#endif /* MPU6050_SIMD_X86 */
+
+#ifdef MPU6050_SIMD_NEON
+
+size_t fifo_neon(const u8 *fifo, size_t n, const SlotMap &map,
+		 const RawSoa &out)
+{
+	size_t stride = 2 * map.nr;
+	size_t end = vector_frames(n, stride);
+	size_t i;
+
+	for (i = 0; i < end; i += 8) {
+		const u8 *f = fifo + i * stride;
+		int16x8_t r[8], col[8];
+		int16x8x2_t t[4];
+		int32x4x2_t u[4];
+
+		for (unsigned k = 0; k < 8; k++)
+			r[k] = vreinterpretq_s16_u8(
+				vrev16q_u8(vld1q_u8(f + k * stride)));
+
+		for (unsigned k = 0; k < 4; k++)
+			t[k] = vtrnq_s16(r[2 * k], r[2 * k + 1]);
+		for (unsigned k = 0; k < 2; k++) {
+			u[2 * k] = vtrnq_s32(vreinterpretq_s32_s16(t[2 * k].val[0]),
+					     vreinterpretq_s32_s16(t[2 * k + 1].val[0]));
+			u[2 * k + 1] = vtrnq_s32(vreinterpretq_s32_s16(t[2 * k].val[1]),
+						 vreinterpretq_s32_s16(t[2 * k + 1].val[1]));
+		}
+
+		/* u[0]/u[2] hold frames 0-3/4-7 of slots 0, 4 and 2, 6 */
+		for (unsigned k = 0; k < 4; k++) {
+			const int32x4x2_t &lo = u[k & 1];
+			const int32x4x2_t &hi = u[2 + (k & 1)];
+			unsigned s = (k & 1) + (k & 2);
+
+			col[s] = vreinterpretq_s16_s32(vcombine_s32(
+				vget_low_s32(lo.val[k >> 1]),
+				vget_low_s32(hi.val[k >> 1])));
+			col[s + 4] = vreinterpretq_s16_s32(vcombine_s32(
+				vget_high_s32(lo.val[k >> 1]),
+				vget_high_s32(hi.val[k >> 1])));
+		}
+
+		for (unsigned s = 0; s < map.nr; s++) {
+			s16 *dst = out.chan[map.chan[s]];
+
+			if (dst)
+				vst1q_s16(dst + i, col[s]);
+		}
+	}
+	return i;
+}
+
+size_t scale_neon(const s16 *in, size_t n, s32 mult, s64 add, s32 *out)
+{
+	const int32x2_t m = vdup_n_s32(mult);
+	const int64x2_t a = vdupq_n_s64(add);
+	size_t i;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		int16x8_t v = vld1q_s16(in + i);
+		int32x4_t lo = vmovl_s16(vget_low_s16(v));
+		int32x4_t hi = vmovl_s16(vget_high_s16(v));
+		int64x2_t p0 = vmlal_s32(a, vget_low_s32(lo), m);
+		int64x2_t p1 = vmlal_s32(a, vget_high_s32(lo), m);
+		int64x2_t p2 = vmlal_s32(a, vget_low_s32(hi), m);
+		int64x2_t p3 = vmlal_s32(a, vget_high_s32(hi), m);
+
+		vst1q_s32(out + i, vcombine_s32(vshrn_n_s64(p0, MPU6050_SCALE_SHIFT),
+						vshrn_n_s64(p1, MPU6050_SCALE_SHIFT)));
+		vst1q_s32(out + i + 4, vcombine_s32(vshrn_n_s64(p2, MPU6050_SCALE_SHIFT),
+						    vshrn_n_s64(p3, MPU6050_SCALE_SHIFT)));
+	}
+	return i;
+}
+
+#endif /* MPU6050_SIMD_NEON */
+
+/* As mpu6050_scale_init() in the driver */
+void scale_init(mpu6050_scale &scale, unsigned chan, u64 num, u64 den,
+		s32 bias, s32 offset)
+{
+	s64 mult = ((num << MPU6050_SCALE_SHIFT) + den / 2) / den;
+
+	scale.mult[chan] = mult;
+	scale.add[chan] = ((s64)offset << MPU6050_SCALE_SHIFT) - bias * mult +
+			  (1LL << (MPU6050_SCALE_SHIFT - 1));
+}
+
+} /* namespace */
+
+bool isa_supported(Isa isa)
+{
+	switch (isa) {
+	case Isa::scalar:
+		return true;
+#ifdef MPU6050_SIMD_X86
+	case Isa::sse41:
+		return __builtin_cpu_supports("ssse3") &&
+		       __builtin_cpu_supports("sse4.1");
+	case Isa::avx2:
+		return __builtin_cpu_supports("ssse3") &&
+		       __builtin_cpu_supports("avx2");
+#endif
+#ifdef MPU6050_SIMD_NEON
+	case Isa::neon:
+		return true;
+#endif
+	default:
+		return false;
+	}
+}
+
+Isa best_isa()
+{
+	static const Isa best = [] {
+		for (Isa isa : {Isa::avx2, Isa::sse41, Isa::neon})
+			if (isa_supported(isa))
+				return isa;
+		return Isa::scalar;
+	}();
+
+	return best;
+}
+
+const char *isa_name(Isa isa)
+{
+	switch (isa) {
+	case Isa::sse41:
+		return "sse4.1";
+	case Isa::avx2:
+		return "avx2";
+	case Isa::neon:
+		return "neon";
+	default:
+		return "scalar";
+	}
+}
+
+mpu6050_scale make_scale(const mpu6050_config &config,
+			 const mpu6050_calibration *calib)
+{
+	static const mpu6050_calibration none = {};
+	const mpu6050_calibration &cal = calib ? *calib : none;
+	u64 accel = mpu6050_accel_range_to_scale(config.accel_range);
+	u64 gyro = mpu6050_gyro_range_to_scale(config.gyro_range);
+	mpu6050_scale scale;
+
+	for (unsigned i = 0; i < 3; i++) {
+		scale_init(scale, i, accel * (1000000 + cal.accel_scale_ppm[i]),
+			   1000ULL * 1000000, cal.accel_bias[i], 0);
+		scale_init(scale, 4 + i, gyro * (1000000 + cal.gyro_scale_ppm[i]),
+			   1000000ULL * 1000000, cal.gyro_bias[i], 0);
+	}
+	scale_init(scale, 3, 100, 340, 0, 3653);
+	return scale;
+}
+
+void fifo_to_soa(const u8 *fifo, size_t n, u32 channels, const RawSoa &out,
+		 Isa isa)
+{
+	SlotMap map = slot_map(channels & MPU6050_CHAN_ALL);
+	size_t done = 0;
+
+	if (!map.nr)
+		return;
+	if (!isa_supported(isa))
+		isa = Isa::scalar;
+
+	switch (isa) {
+#ifdef MPU6050_SIMD_X86
+	case Isa::sse41:
+	case Isa::avx2:
+		/* Byte shuffles are 128 bits wide on AVX2 too */
+		done = fifo_ssse3(fifo, n, map, out);
+		break;
+#endif
+#ifdef MPU6050_SIMD_NEON
+	case Isa::neon:
+		done = fifo_neon(fifo, n, map, out);
+		break;
+#endif
+	default:
+		break;
+	}
+	fifo_scalar(fifo, done, n, map, out);
+}
+
+void scale_soa(const RawSoa &in, size_t n, const mpu6050_scale &scale,
+	       const ScaledSoa &out, Isa isa)
+{
+	if (!isa_supported(isa))
+		isa = Isa::scalar;
+
+	for (unsigned c = 0; c < MPU6050_NUM_CHANNELS; c++) {
+		s32 mult = scale.mult[c];
+		s64 add = scale.add[c];
+		size_t done = 0;
+
+		if (!in.chan[c] || !out.chan[c])
+			continue;
+
+		switch (isa) {
+#ifdef MPU6050_SIMD_X86
+		case Isa::sse41:
+			done = scale_sse41(in.chan[c], n, mult, add, out.chan[c]);
+			break;
+		case Isa::avx2:
+			done = scale_avx2(in.chan[c], n, mult, add, out.chan[c]);
+			break;
+#endif
+#ifdef MPU6050_SIMD_NEON
+		case Isa::neon:
+			done = scale_neon(in.chan[c], n, mult, add, out.chan[c]);
+			break;
+#endif
+		default:
+			break;
+		}
+		scale_scalar(in.chan[c], done, n, mult, add, out.chan[c]);
+	}
+}
+
+void fifo_to_scaled_soa(const u8 *fifo, size_t n, u32 channels,
+			const mpu6050_scale &scale, const ScaledSoa &out,
+			Isa isa)
+{
+	alignas(32) s16 raw[MPU6050_NUM_CHANNELS][block_frames];
+	size_t stride = 2 * __builtin_popcount(channels & MPU6050_CHAN_ALL);
+	RawSoa tmp = {};
+
+	for (unsigned c = 0; c < MPU6050_NUM_CHANNELS; c++)
+		if (channels & BIT(c) && out.chan[c])
+			tmp.chan[c] = raw[c];
+
+	for (size_t i = 0; i < n; i += block_frames) {
+		size_t m = std::min(n - i, block_frames);
+		ScaledSoa dst = {};
+
+		for (unsigned c = 0; c < MPU6050_NUM_CHANNELS; c++)
+			if (tmp.chan[c])
+				dst.chan[c] = out.chan[c] + i;
+		fifo_to_soa(fifo + i * stride, m, channels, tmp, isa);
+		scale_soa(tmp, m, scale, dst, isa);
+	}
+}
+
+} /* namespace mpu6050 */
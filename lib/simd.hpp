@@ -0,0 +1,100 @@
+/**
+ * @file simd.hpp
+ * @brief libmpu6050 vectorised FIFO decode and scaling kernels
+ *
+ * Bulk conversion of captured FIFO bytes for offline analysis: byte-swap
+ * big-endian frames, deinterleave them into one array per channel and
+ * apply the driver's fixed-point scale, calibration included. Results are
+ * bit-identical to mpu6050_scale_raw() on every instruction set.
+ *
+ * Kernels exist for SSE4.1, AVX2 and NEON next to a scalar reference; the
+ * best one the CPU supports is picked at run time unless the caller asks
+ * for a specific one.
+ *
+ * Copyright (C) 2025 Murray Kopit <murr2k@gmail.com>
+ */
+
+#ifndef LIBMPU6050_SIMD_HPP
+#define LIBMPU6050_SIMD_HPP
+
+#include <cstddef>
+
+#include "mpu6050.h"
+
+namespace mpu6050 {
+
+/* Instruction sets with their own kernels */
+enum class Isa {
+	scalar,
+	sse41,
+	avx2,
+	neon,
+};
+
+/* Whether this CPU can run the kernels for @isa */
+bool isa_supported(Isa isa);
+
+/* Fastest supported instruction set */
+Isa best_isa();
+
+const char *isa_name(Isa isa);
+
+/**
+ * struct RawSoa - Raw readings in structure-of-arrays form
+ * @chan: One array per channel, in MPU6050_CHAN_* bit order. A NULL entry
+ *	  skips that channel.
+ */
+struct RawSoa {
+	s16 *chan[MPU6050_NUM_CHANNELS];
+};
+
+/**
+ * struct ScaledSoa - Scaled readings in structure-of-arrays form
+ * @chan: As for struct RawSoa, in the units of struct mpu6050_scaled_data
+ */
+struct ScaledSoa {
+	s32 *chan[MPU6050_NUM_CHANNELS];
+};
+
+/*
+ * Fixed-point factors the driver scales with for @config and @calib.
+ * A NULL @calib means no calibration.
+ */
+mpu6050_scale make_scale(const mpu6050_config &config,
+			 const mpu6050_calibration *calib = nullptr);
+
+/**
+ * fifo_to_soa - Byte-swap and deinterleave big-endian FIFO frames
+ * @fifo: @n frames of two bytes per channel in @channels, in FIFO order
+ * @n: Number of frames
+ * @channels: MPU6050_CHAN_* mask of the channels in each frame
+ * @out: Destination arrays of at least @n entries; channels not in
+ *	 @channels are left alone
+ * @isa: Kernels to use
+ */
+void fifo_to_soa(const u8 *fifo, size_t n, u32 channels, const RawSoa &out,
+		 Isa isa = best_isa());
+
+/**
+ * scale_soa - Convert raw readings to physical units
+ * @in: Raw arrays of @n entries
+ * @n: Number of samples
+ * @scale: Fixed-point factors, see make_scale()
+ * @out: Destination arrays; only channels present in both @in and @out
+ *	 are converted
+ * @isa: Kernels to use
+ */
+void scale_soa(const RawSoa &in, size_t n, const mpu6050_scale &scale,
+	       const ScaledSoa &out, Isa isa = best_isa());
+
+/*
+ * fifo_to_scaled_soa - fifo_to_soa() and scale_soa() in one pass, blocked
+ * so the raw intermediate stays in L1.
+ */
+void fifo_to_scaled_soa(const u8 *fifo, size_t n, u32 channels,
+			const mpu6050_scale &scale, const ScaledSoa &out,
+			Isa isa = best_isa());
+
+} /* namespace mpu6050 */
+
+#endif /* LIBMPU6050_SIMD_HPP */
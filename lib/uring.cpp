@@ -0,0 +1,198 @@
+/**
+ * @file uring.cpp
+ * @brief libmpu6050 io_uring reader
+ *
+ * Uses the io_uring system calls and ring layout from <linux/io_uring.h>
+ * directly. The submission and completion rings are shared with the
+ * kernel: this side owns the SQ tail and the CQ head, publishing them with
+ * release stores, and reads the kernel-owned ends with acquire loads.
+ *
+ * Copyright (C) 2025 Murray Kopit <murr2k@gmail.com>
+ */
+
+#include "mpu6050.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <system_error>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace mpu6050 {
+
+namespace {
+
+[[noreturn]] void throw_errno(int err, const char *what)
+{
+	throw std::system_error(err, std::generic_category(), what);
+}
+
+void *map_ring(int fd, size_t size, off_t offset)
+{
+	void *map = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+			 MAP_SHARED | MAP_POPULATE, fd, offset);
+
+	if (map == MAP_FAILED)
+		throw_errno(errno, "io_uring mmap");
+	return map;
+}
+
+template <typename T>
+T *ring_ptr(void *ring, u32 offset)
+{
+	return reinterpret_cast<T *>(static_cast<u8 *>(ring) + offset);
+}
+
+} /* namespace */
+
+AsyncReader::AsyncReader(unsigned entries)
+{
+	io_uring_params p = {};
+
+	ring_fd_ = syscall(__NR_io_uring_setup, entries, &p);
+	if (ring_fd_ < 0)
+		throw_errno(errno, "io_uring_setup");
+	sq_entries_ = p.sq_entries;
+
+	try {
+		sq_ring_size_ = p.sq_off.array + p.sq_entries * sizeof(u32);
+		cq_ring_size_ = p.cq_off.cqes +
+				p.cq_entries * sizeof(io_uring_cqe);
+		if (p.features & IORING_FEAT_SINGLE_MMAP) {
+			sq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+			sq_ring_ = map_ring(ring_fd_, sq_ring_size_,
+					    IORING_OFF_SQ_RING);
+			cq_ring_ = sq_ring_;
+		} else {
+			sq_ring_ = map_ring(ring_fd_, sq_ring_size_,
+					    IORING_OFF_SQ_RING);
+			cq_ring_ = map_ring(ring_fd_, cq_ring_size_,
+					    IORING_OFF_CQ_RING);
+		}
+		sqes_size_ = p.sq_entries * sizeof(io_uring_sqe);
+		sqes_ = static_cast<io_uring_sqe *>(
+			map_ring(ring_fd_, sqes_size_, IORING_OFF_SQES));
+	} catch (...) {
+		unmap();
+		throw;
+	}
+
+	sq_tail_ = ring_ptr<unsigned>(sq_ring_, p.sq_off.tail);
+	sq_mask_ = ring_ptr<unsigned>(sq_ring_, p.sq_off.ring_mask);
+	sq_array_ = ring_ptr<unsigned>(sq_ring_, p.sq_off.array);
+	cq_head_ = ring_ptr<unsigned>(cq_ring_, p.cq_off.head);
+	cq_tail_ = ring_ptr<unsigned>(cq_ring_, p.cq_off.tail);
+	cq_mask_ = ring_ptr<unsigned>(cq_ring_, p.cq_off.ring_mask);
+	cqes_ = ring_ptr<io_uring_cqe>(cq_ring_, p.cq_off.cqes);
+}
+
+AsyncReader::~AsyncReader()
+{
+	unmap();
+}
+
+void AsyncReader::unmap()
+{
+	if (sqes_)
+		munmap(sqes_, sqes_size_);
+	if (cq_ring_ && cq_ring_ != sq_ring_)
+		munmap(cq_ring_, cq_ring_size_);
+	if (sq_ring_)
+		munmap(sq_ring_, sq_ring_size_);
+	sqes_ = nullptr;
+	cq_ring_ = sq_ring_ = nullptr;
+	if (ring_fd_ >= 0)
+		::close(ring_fd_);
+	ring_fd_ = -1;
+}
+
+unsigned AsyncReader::add(const Device &dev, u32 records, unsigned depth)
+{
+	Layout layout = dev.layout();
+	unsigned source = sources_.size();
+
+	/* Every slot may be queued at once, so they all need an SQ entry */
+	if (!records || !depth || slots_.size() + depth > sq_entries_)
+		throw_errno(EINVAL, "mpu6050 async reader");
+
+	sources_.push_back({dev.fd(), Decoder(layout),
+			    (u32)(records * layout.record_size())});
+	for (unsigned i = 0; i < depth; i++)
+		slots_.push_back({source, std::unique_ptr<u8[]>(
+						  new u8[sources_[source].len])});
+	return source;
+}
+
+void AsyncReader::queue(unsigned slot)
+{
+	const Source &src = sources_[slots_[slot].source];
+	unsigned tail = *sq_tail_;
+	unsigned idx = tail & *sq_mask_;
+	io_uring_sqe *sqe = &sqes_[idx];
+
+	std::memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = IORING_OP_READ;
+	sqe->fd = src.fd;
+	sqe->addr = reinterpret_cast<uintptr_t>(slots_[slot].buf.get());
+	sqe->len = src.len;
+	sqe->off = (u64)-1;	/* Current file position */
+	sqe->user_data = slot;
+	sq_array_[idx] = idx;
+	__atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+	queued_++;
+}
+
+void AsyncReader::enter(unsigned min, bool wait)
+{
+	unsigned flags = wait ? IORING_ENTER_GETEVENTS : 0;
+	int ret;
+
+	do {
+		ret = syscall(__NR_io_uring_enter, ring_fd_, queued_, min,
+			      flags, nullptr, 0);
+	} while (ret < 0 && errno == EINTR);
+	if (ret < 0)
+		throw_errno(errno, "io_uring_enter");
+	queued_ -= ret;
+}
+
+void AsyncReader::start()
+{
+	for (unsigned i = 0; i < slots_.size(); i++)
+		queue(i);
+	enter(0, false);
+}
+
+unsigned AsyncReader::wait(Completion *out, unsigned max, unsigned min)
+{
+	unsigned head, tail, n = 0;
+
+	head = *cq_head_;
+	tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+	if (queued_ || tail - head < min) {
+		enter(min, min > tail - head);
+		tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+	}
+
+	for (; head != tail && n < max; head++, n++) {
+		const io_uring_cqe *cqe = &cqes_[head & *cq_mask_];
+		unsigned slot = cqe->user_data;
+
+		out[n].source = slots_[slot].source;
+		out[n].slot = slot;
+		out[n].res = cqe->res;
+		out[n].buf = slots_[slot].buf.get();
+	}
+	__atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+	return n;
+}
+
+void AsyncReader::release(const Completion &c)
+{
+	queue(c.slot);
+}
+
+} /* namespace mpu6050 */
@@ -0,0 +1,129 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Benchmark device setup, built against the kernel shim
+ *
+ * Brings a struct mpu6050_data up the way probe does as far as the I/O
+ * layer is concerned: locks, per-CPU statistics, FIFO buffer, channel
+ * layout and scale factors. The output registers hold one fixed sample
+ * and the FIFO image a sawtooth of full frames.
+ *
+ * Copyright (C) 2025 Murray Kopit <murr2k@gmail.com>
+ */
+
+#include "kernel/kernel_shim.h"
+#include "bench_device.h"
+
+struct bench_device {
+	struct mpu6050_data data;
+	struct i2c_client client;
+	struct i2c_adapter adapter;
+};
+
+static void bench_put_be16(u8 *buf, s16 val)
+{
+	buf[0] = (u16)val >> 8;
+	buf[1] = val & 0xff;
+}
+
+static void bench_fill_registers(struct regmap *map)
+{
+	static const s16 sample[MPU6050_NUM_CHANNELS] = {
+		1000, -2000, 16384, 3400, 131, -262, 393,
+	};
+	u8 *regs = shim_regmap_regs(map);
+	u8 *fifo = shim_regmap_fifo(map);
+	int i;
+	
+	regs[MPU6050_REG_WHO_AM_I] = MPU6050_WHO_AM_I_VAL;
+	regs[MPU6050_REG_INT_STATUS] = MPU6050_INT_DATA_RDY;
+	for (i = 0; i < MPU6050_NUM_CHANNELS; i++)
+		bench_put_be16(&regs[MPU6050_REG_ACCEL_XOUT_H + 2 * i], sample[i]);
+	
+	for (i = 0; i < MPU6050_FIFO_SIZE / 2; i++)
+		bench_put_be16(&fifo[2 * i], (s16)(i * 97 - 12000));
+}
+
+struct mpu6050_data *bench_device_create(void)
+{
+	return bench_device_create_on(I2C_FUNC_SMBUS_BYTE_DATA);
+}
+
+struct mpu6050_data *bench_device_create_on(u32 functionality)
+{
+	static const struct mpu6050_config config = {
+		.sample_rate_div = 0,
+		.gyro_range = MPU6050_GYRO_FS_250,
+		.accel_range = MPU6050_ACCEL_FS_2G,
+		.dlpf_cfg = 1,
+	};
+	struct bench_device *bdev;
+	struct mpu6050_data *data;
+	
+	bdev = calloc(1, sizeof(*bdev));
+	if (!bdev)
+		return NULL;
+	
+	data = &bdev->data;
+	bdev->client.addr = MPU6050_I2C_ADDR;
+	bdev->client.adapter = &bdev->adapter;
+	bdev->client.dev.init_name = "mpu6050-bench";
+	strcpy(bdev->client.name, "mpu6050");
+	data->client = &bdev->client;
+	
+	data->regmap = shim_regmap_create();
+	data->stats = calloc(1, sizeof(*data->stats));
+	data->fifo_buf = malloc(MPU6050_FIFO_SIZE);
+	if (!data->regmap || !data->stats || !data->fifo_buf) {
+		bench_device_destroy(data);
+		return NULL;
+	}
+	
+	/* The FIFO transfer strategy probe picks for this adapter */
+	bdev->adapter.functionality = functionality;
+	bdev->adapter.map = data->regmap;
+	data->fifo_i2c = i2c_check_functionality(&bdev->adapter, I2C_FUNC_I2C);
+	if (!data->fifo_i2c &&
+	    i2c_check_functionality(&bdev->adapter, I2C_FUNC_SMBUS_I2C_BLOCK))
+		shim_regmap_set_max_raw_read(data->regmap, I2C_SMBUS_BLOCK_MAX);
+	
+	mutex_init(&data->lock);
+	seqlock_init(&data->scale_lock);
+	seqlock_init(&data->latest_lock);
+	bench_fill_registers(data->regmap);
+	
+	if (mpu6050_set_channels(data, MPU6050_CHAN_ALL) ||
+	    mpu6050_set_config(data, &config)) {
+		bench_device_destroy(data);
+		return NULL;
+	}
+	
+	return data;
+}
+
+void bench_device_destroy(struct mpu6050_data *data)
+{
+	struct bench_device *bdev = container_of(data, struct bench_device, data);
+	
+	free(data->fifo_buf);
+	free(data->stats);
+	shim_regmap_destroy(data->regmap);
+	free(bdev);
+}
+
+void bench_device_unlock(struct mpu6050_data *data)
+{
+	mutex_unlock(&data->lock);
+}
+
+u64 bench_device_lock_waits(struct mpu6050_data *data)
+{
+	return __atomic_load_n(&data->stats->lock_waits, __ATOMIC_RELAXED);
+}
+
+void bench_device_bus_stats(struct mpu6050_data *data,
+			    struct bench_bus_stats *stats)
+{
+	stats->transfers = data->client->adapter->nr_transfers;
+	stats->block_reads = shim_regmap_raw_reads(data->regmap,
+						   &stats->max_block_len);
+}
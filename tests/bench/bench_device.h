@@ -0,0 +1,62 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Benchmark device: a struct mpu6050_data on the in-memory register backend
+ *
+ * The device state is kernel-only, so benchmarks see it as an opaque
+ * pointer and call the driver entry points declared here, which are built
+ * from drivers/mpu6050_main.c against the kernel shim. Types are the u8..u64
+ * typedefs that include/mpu6050.h provides on both sides.
+ *
+ * Copyright (C) 2025 Murray Kopit <murr2k@gmail.com>
+ */
+
+#ifndef _MPU6050_BENCH_DEVICE_H_
+#define _MPU6050_BENCH_DEVICE_H_
+
+#include "../../include/mpu6050.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct mpu6050_data;
+
+/* Bus traffic of a device, see bench_device_bus_stats() */
+struct bench_bus_stats {
+	unsigned int transfers;		/* Raw i2c_transfer() calls */
+	unsigned int block_reads;	/* FIFO reads issued by regmap */
+	size_t max_block_len;		/* Longest of those in bytes */
+};
+
+/*
+ * Device setup; the sensor starts with all channels and default ranges.
+ * bench_device_create_on() puts it on an adapter with the given I2C_FUNC_*
+ * flags and picks the FIFO transfer strategy the way probe does; the
+ * default adapter only speaks SMBus byte transfers.
+ */
+struct mpu6050_data *bench_device_create(void);
+struct mpu6050_data *bench_device_create_on(u32 functionality);
+void bench_device_destroy(struct mpu6050_data *data);
+void bench_device_unlock(struct mpu6050_data *data);
+u64 bench_device_lock_waits(struct mpu6050_data *data);
+void bench_device_bus_stats(struct mpu6050_data *data,
+			    struct bench_bus_stats *stats);
+
+/* Driver entry points under test (drivers/mpu6050_main.c) */
+int mpu6050_read_raw_data(struct mpu6050_data *data, struct mpu6050_raw_data *raw_data);
+int mpu6050_read_scaled_data(struct mpu6050_data *data, struct mpu6050_scaled_data *scaled_data);
+int mpu6050_read_sample(struct mpu6050_data *data, struct mpu6050_raw_data *raw_data,
+			u64 max_age_ns);
+int mpu6050_fetch_sample(struct mpu6050_data *data, struct mpu6050_raw_data *raw_data);
+int mpu6050_read_fifo(struct mpu6050_data *data, struct mpu6050_raw_data *samples,
+		      unsigned int frames);
+int mpu6050_set_config(struct mpu6050_data *data, const struct mpu6050_config *config);
+int mpu6050_set_channels(struct mpu6050_data *data, u32 channels);
+void mpu6050_scale_get(struct mpu6050_data *data, struct mpu6050_scale *scale);
+void mpu6050_lock(struct mpu6050_data *data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MPU6050_BENCH_DEVICE_H_ */
@@ -0,0 +1,290 @@
+/**
+ * @file bench_driver.cpp
+ * @brief Google Benchmark suite for the MPU-6050 driver hot paths
+ *
+ * The driver's register and sample I/O layer (drivers/mpu6050_main.c) runs
+ * unmodified on the in-memory register backend of the kernel shim, so
+ * these numbers are the CPU cost of each path without any bus time:
+ * - FetchSample: burst read and big-endian unpack of one sample
+ * - ReadFifo: FIFO chunk read and unpack, by batch size and channel mask
+ * - ScaleBatch: fixed-point scaling of a batch, by range configuration
+ * - ReadRawData / ReadScaledData: the full one-shot paths, cached or not,
+ *   by thread count
+ * - LockContention: device lock acquisition by thread count and hold time
+ *
+ * Ioctl: dispatch plus copy through a real driver node, normally one on
+ * the virtual bus (make MPU6050_VIRT=1). Set MPU6050_BENCH_DEVICE to pick
+ * the node, /dev/mpu6050 by default; the benchmark is skipped without one.
+ *
+ * Run with --benchmark_out=<file> --benchmark_out_format=json, or through
+ * the bench build target, to keep results for comparison.
+ *
+ * Copyright (C) 2025 Murray Kopit <murr2k@gmail.com>
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "bench_device.h"
+
+namespace {
+
+mpu6050_data* g_device = nullptr;
+
+constexpr int kCached = 0;
+constexpr int kUncached = 1;
+
+// Device configuration comes first in the argument list of a benchmark
+void setChannels(const benchmark::State& state)
+{
+    mpu6050_set_channels(g_device, static_cast<u32>(state.range(0)));
+}
+
+// A range argument sets the gyroscope and accelerometer full scale together
+void setRanges(const benchmark::State& state)
+{
+    mpu6050_config config = {0, 0, 0, 1};
+
+    config.gyro_range = static_cast<u8>(state.range(0));
+    config.accel_range = static_cast<u8>(state.range(0));
+    mpu6050_set_config(g_device, &config);
+}
+
+void restoreDefaults(const benchmark::State&)
+{
+    mpu6050_config config = {0, MPU6050_GYRO_FS_250, MPU6050_ACCEL_FS_2G, 1};
+
+    mpu6050_set_channels(g_device, MPU6050_CHAN_ALL);
+    mpu6050_set_config(g_device, &config);
+}
+
+unsigned int frameSize(u32 channels)
+{
+    unsigned int size = (channels & MPU6050_CHAN_ACCEL) ? 6 : 0;
+
+    for (int chan = 3; chan < MPU6050_NUM_CHANNELS; chan++) {
+        if (channels & BIT(chan)) {
+            size += 2;
+        }
+    }
+    return size;
+}
+
+void BM_FetchSample(benchmark::State& state)
+{
+    mpu6050_raw_data raw;
+
+    for (auto _ : state) {
+        mpu6050_lock(g_device);
+        mpu6050_fetch_sample(g_device, &raw);
+        bench_device_unlock(g_device);
+        benchmark::DoNotOptimize(raw);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FetchSample)
+    ->Setup(setChannels)
+    ->Teardown(restoreDefaults)
+    ->ArgName("channels")
+    ->Arg(MPU6050_CHAN_ALL)
+    ->Arg(MPU6050_CHAN_ACCEL)
+    ->Arg(MPU6050_CHAN_GYRO);
+
+void BM_ReadFifo(benchmark::State& state)
+{
+    u32 channels = static_cast<u32>(state.range(0));
+    unsigned int frames = std::min<unsigned int>(static_cast<unsigned int>(state.range(1)),
+                                                 MPU6050_FIFO_SIZE / frameSize(channels));
+    std::vector<mpu6050_raw_data> samples(frames);
+
+    for (auto _ : state) {
+        mpu6050_lock(g_device);
+        mpu6050_read_fifo(g_device, samples.data(), frames);
+        bench_device_unlock(g_device);
+        benchmark::DoNotOptimize(samples.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * frames);
+    state.SetBytesProcessed(state.iterations() * frames * frameSize(channels));
+}
+BENCHMARK(BM_ReadFifo)
+    ->Setup(setChannels)
+    ->Teardown(restoreDefaults)
+    ->ArgNames({"channels", "batch"})
+    ->ArgsProduct({{MPU6050_CHAN_ALL, MPU6050_CHAN_ACCEL}, {1, 8, 32, 73}});
+
+void BM_ScaleBatch(benchmark::State& state)
+{
+    size_t batch = static_cast<size_t>(state.range(1));
+    std::vector<mpu6050_raw_data> raw(batch);
+    std::vector<mpu6050_scaled_data> scaled(batch);
+    mpu6050_scale scale;
+
+    for (size_t i = 0; i < batch; i++) {
+        for (int chan = 0; chan < MPU6050_NUM_CHANNELS; chan++) {
+            mpu6050_raw_chan(&raw[i], chan) = static_cast<s16>(i * 131 + chan * 4099);
+        }
+    }
+
+    for (auto _ : state) {
+        mpu6050_scale_get(g_device, &scale);
+        for (size_t i = 0; i < batch; i++) {
+            mpu6050_scale_raw(&raw[i], &scale, &scaled[i]);
+        }
+        benchmark::DoNotOptimize(scaled.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(BM_ScaleBatch)
+    ->Setup(setRanges)
+    ->Teardown(restoreDefaults)
+    ->ArgNames({"range", "batch"})
+    ->ArgsProduct({{0, 1, 2, 3}, {1, 16, 256}});
+
+// Cached reads hit the latest-sample cache, uncached ones always burst
+void BM_ReadRawData(benchmark::State& state)
+{
+    mpu6050_raw_data raw;
+    int ret = 0;
+
+    for (auto _ : state) {
+        if (state.range(0) == kCached) {
+            ret |= mpu6050_read_raw_data(g_device, &raw);
+        } else {
+            ret |= mpu6050_read_sample(g_device, &raw, 0);
+        }
+        benchmark::DoNotOptimize(raw);
+    }
+    if (ret) {
+        state.SkipWithError("read failed");
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ReadRawData)
+    ->ArgName("uncached")
+    ->Arg(kCached)
+    ->Arg(kUncached)
+    ->ThreadRange(1, 8)
+    ->UseRealTime();
+
+void BM_ReadScaledData(benchmark::State& state)
+{
+    mpu6050_scaled_data scaled;
+    int ret = 0;
+
+    for (auto _ : state) {
+        ret |= mpu6050_read_scaled_data(g_device, &scaled);
+        benchmark::DoNotOptimize(scaled);
+    }
+    if (ret) {
+        state.SkipWithError("read failed");
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ReadScaledData)
+    ->Setup(setRanges)
+    ->Teardown(restoreDefaults)
+    ->ArgName("range")
+    ->DenseRange(0, 3)
+    ->ThreadRange(1, 8)
+    ->UseRealTime();
+
+// Hold is the number of spin iterations spent inside the lock
+void BM_LockContention(benchmark::State& state)
+{
+    int64_t hold = state.range(0);
+    u64 waits = state.thread_index() == 0 ? bench_device_lock_waits(g_device) : 0;
+
+    for (auto _ : state) {
+        mpu6050_lock(g_device);
+        for (int64_t i = 0; i < hold; i++) {
+            benchmark::DoNotOptimize(i);
+        }
+        bench_device_unlock(g_device);
+    }
+
+    // Threads start and stop together, so thread 0 brackets the whole run
+    if (state.thread_index() == 0) {
+        waits = bench_device_lock_waits(g_device) - waits;
+        state.counters["waits"] = benchmark::Counter(static_cast<double>(waits),
+                                                     benchmark::Counter::kAvgIterations);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LockContention)
+    ->ArgName("hold")
+    ->Arg(0)
+    ->Arg(100)
+    ->ThreadRange(1, 8)
+    ->UseRealTime();
+
+// Commands by benchmark argument; GET_CONFIG never touches the bus
+const unsigned long kIoctlCmds[] = {
+    MPU6050_IOC_GET_CONFIG,
+    MPU6050_IOC_READ_RAW,
+    MPU6050_IOC_READ_SCALED,
+};
+
+void BM_Ioctl(benchmark::State& state)
+{
+    const char* path = getenv("MPU6050_BENCH_DEVICE");
+    unsigned long cmd = kIoctlCmds[state.range(0)];
+    union {
+        mpu6050_raw_data raw;
+        mpu6050_scaled_data scaled;
+        mpu6050_config config;
+    } arg;
+    int fd = open(path ? path : "/dev/mpu6050", O_RDWR);
+    int ret = 0;
+
+    if (fd < 0) {
+        state.SkipWithError("no driver node, load the driver or set MPU6050_BENCH_DEVICE");
+        return;
+    }
+
+    for (auto _ : state) {
+        ret |= ioctl(fd, cmd, &arg);
+        benchmark::DoNotOptimize(arg);
+    }
+    close(fd);
+
+    if (ret < 0) {
+        state.SkipWithError("ioctl failed");
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Ioctl)
+    ->ArgName("cmd")
+    ->DenseRange(0, 2)
+    ->ThreadRange(1, 8)
+    ->UseRealTime();
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    g_device = bench_device_create();
+    if (!g_device) {
+        fprintf(stderr, "Failed to set up the benchmark device\n");
+        return 1;
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    bench_device_destroy(g_device);
+    return 0;
+}
@@ -0,0 +1,169 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * In-memory register backend for the userspace kernel shim
+ *
+ * Every regmap handed to the driver is a 256-byte register file plus a
+ * FIFO image. Reads and writes are plain memory accesses with no range
+ * checks beyond the register file size, and FIFO_R_W reads wrap around
+ * the image, so the FIFO never runs dry. Raw I2C transfers on an adapter
+ * with I2C_FUNC_I2C read the same register file.
+ *
+ * Copyright (C) 2025 Murray Kopit <murr2k@gmail.com>
+ */
+
+#include "kernel_shim.h"
+#include "../../../include/mpu6050.h"
+
+#define SHIM_REGS		256
+
+struct regmap {
+	u8 regs[SHIM_REGS];
+	u8 fifo[MPU6050_FIFO_SIZE];
+	size_t fifo_pos;
+	size_t max_raw_read;
+	unsigned int raw_reads;
+	size_t raw_read_max_len;
+};
+
+struct regmap *shim_regmap_create(void)
+{
+	return calloc(1, sizeof(struct regmap));
+}
+
+void shim_regmap_destroy(struct regmap *map)
+{
+	free(map);
+}
+
+u8 *shim_regmap_regs(struct regmap *map)
+{
+	return map->regs;
+}
+
+u8 *shim_regmap_fifo(struct regmap *map)
+{
+	return map->fifo;
+}
+
+void shim_regmap_set_max_raw_read(struct regmap *map, size_t max_raw_read)
+{
+	map->max_raw_read = max_raw_read;
+}
+
+unsigned int shim_regmap_raw_reads(struct regmap *map, size_t *max_len)
+{
+	if (max_len)
+		*max_len = map->raw_read_max_len;
+	return map->raw_reads;
+}
+
+static void shim_fifo_read(struct regmap *map, u8 *out, size_t len)
+{
+	size_t chunk;
+	
+	while (len) {
+		chunk = min(len, sizeof(map->fifo) - map->fifo_pos);
+		memcpy(out, &map->fifo[map->fifo_pos], chunk);
+		map->fifo_pos = (map->fifo_pos + chunk) % sizeof(map->fifo);
+		out += chunk;
+		len -= chunk;
+	}
+}
+
+int regmap_read(struct regmap *map, unsigned int reg, unsigned int *val)
+{
+	if (reg >= SHIM_REGS)
+		return -EINVAL;
+	
+	*val = map->regs[reg];
+	return 0;
+}
+
+int regmap_write(struct regmap *map, unsigned int reg, unsigned int val)
+{
+	if (reg >= SHIM_REGS)
+		return -EINVAL;
+	
+	map->regs[reg] = val;
+	return 0;
+}
+
+int regmap_update_bits(struct regmap *map, unsigned int reg,
+		       unsigned int mask, unsigned int val)
+{
+	if (reg >= SHIM_REGS)
+		return -EINVAL;
+	
+	map->regs[reg] = (map->regs[reg] & ~mask) | (val & mask);
+	return 0;
+}
+
+int regmap_bulk_read(struct regmap *map, unsigned int reg, void *val,
+		     size_t val_count)
+{
+	if (reg + val_count > SHIM_REGS)
+		return -EINVAL;
+	
+	memcpy(val, &map->regs[reg], val_count);
+	return 0;
+}
+
+int regmap_noinc_read(struct regmap *map, unsigned int reg, void *val,
+		      size_t val_len)
+{
+	u8 *out = val;
+	size_t chunk;
+	
+	if (reg != MPU6050_REG_FIFO_R_W)
+		return -EINVAL;
+	
+	while (val_len) {
+		chunk = val_len;
+		if (map->max_raw_read)
+			chunk = min(chunk, map->max_raw_read);
+		shim_fifo_read(map, out, chunk);
+		map->raw_reads++;
+		map->raw_read_max_len = max(map->raw_read_max_len, chunk);
+		out += chunk;
+		val_len -= chunk;
+	}
+	
+	return 0;
+}
+
+/* A register address write followed by a read, as the driver issues them */
+int i2c_transfer(struct i2c_adapter *adap, struct i2c_msg *msgs, int num)
+{
+	struct regmap *map = adap->map;
+	unsigned int reg;
+	
+	if (!(adap->functionality & I2C_FUNC_I2C))
+		return -EOPNOTSUPP;
+	
+	if (num != 2 || msgs[0].len != 1 || (msgs[0].flags & I2C_M_RD) ||
+	    !(msgs[1].flags & I2C_M_RD))
+		return -EINVAL;
+	
+	reg = msgs[0].buf[0];
+	if (reg == MPU6050_REG_FIFO_R_W)
+		shim_fifo_read(map, msgs[1].buf, msgs[1].len);
+	else if (reg + msgs[1].len <= SHIM_REGS)
+		memcpy(msgs[1].buf, &map->regs[reg], msgs[1].len);
+	else
+		return -EINVAL;
+	
+	adap->nr_transfers++;
+	return num;
+}
+
+void *memchr_inv(const void *start, int c, size_t bytes)
+{
+	const u8 *p = start;
+	size_t i;
+	
+	for (i = 0; i < bytes; i++)
+		if (p[i] != (u8)c)
+			return (void *)&p[i];
+	
+	return NULL;
+}
@@ -0,0 +1,339 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Minimal userspace stand-in for the kernel APIs used by
+ * drivers/mpu6050_main.c
+ *
+ * Just enough of <linux/...> to compile the register and sample I/O layer
+ * unmodified into a benchmark binary. Locks are pthread mutexes, seqlocks
+ * are a sequence counter plus a mutex, per-CPU counters are shared relaxed
+ * atomics and tracepoints compile away. Regmap is a flat in-memory register
+ * file (see kernel_shim.c), so a "bus transfer" costs a memcpy and the
+ * numbers isolate the CPU side of each path.
+ *
+ * Copyright (C) 2025 Murray Kopit <murr2k@gmail.com>
+ */
+
+#ifndef _MPU6050_KERNEL_SHIM_H_
+#define _MPU6050_KERNEL_SHIM_H_
+
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <asm-generic/ioctl.h>
+#include <asm-generic/int-ll64.h>
+
+/* Types */
+typedef __u8 u8;
+typedef __s8 s8;
+typedef __u16 u16;
+typedef __s16 s16;
+typedef __u32 u32;
+typedef __s32 s32;
+typedef __u64 u64;
+typedef __s64 s64;
+typedef __u16 __be16;
+typedef __u32 __be32;
+typedef s64 ktime_t;
+
+#define __percpu
+#define __user
+
+#define U16_MAX			((u16)~0U)
+#define NSEC_PER_SEC		1000000000L
+#define NSEC_PER_USEC		1000L
+
+#define BIT(nr)			(1UL << (nr))
+#define BIT_ULL(nr)		(1ULL << (nr))
+#define container_of(ptr, type, member) \
+	((type *)((char *)(ptr) - offsetof(type, member)))
+#define ARRAY_SIZE(arr)		(sizeof(arr) / sizeof((arr)[0]))
+#define BUILD_BUG_ON(cond)	_Static_assert(!(cond), #cond)
+
+#define min(x, y)		({ __typeof__(x) _x = (x); __typeof__(y) _y = (y); \
+				   _x < _y ? _x : _y; })
+#define max(x, y)		({ __typeof__(x) _x = (x); __typeof__(y) _y = (y); \
+				   _x > _y ? _x : _y; })
+#define min_t(type, x, y)	min((type)(x), (type)(y))
+#define max_t(type, x, y)	max((type)(x), (type)(y))
+
+#define READ_ONCE(x)		__atomic_load_n(&(x), __ATOMIC_RELAXED)
+#define WRITE_ONCE(x, val)	__atomic_store_n(&(x), (val), __ATOMIC_RELAXED)
+
+/* Bit operations */
+static inline unsigned long __ffs(unsigned long word)
+{
+	return __builtin_ctzl(word);
+}
+
+static inline unsigned long __fls(unsigned long word)
+{
+	return 8 * sizeof(long) - 1 - __builtin_clzl(word);
+}
+
+static inline int fls64(u64 x)
+{
+	return x ? 64 - __builtin_clzll(x) : 0;
+}
+
+/* Byte order */
+static inline u16 be16_to_cpu(__be16 val)
+{
+	return __builtin_bswap16(val);
+}
+
+static inline u16 be16_to_cpup(const __be16 *p)
+{
+	return __builtin_bswap16(*p);
+}
+
+/* Arithmetic */
+static inline u64 div64_u64(u64 dividend, u64 divisor)
+{
+	return dividend / divisor;
+}
+
+/* Time */
+static inline ktime_t ktime_get(void)
+{
+	struct timespec ts;
+	
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (s64)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static inline u64 ktime_get_ns(void)
+{
+	return ktime_get();
+}
+
+#define ktime_to_ns(kt)		((s64)(kt))
+#define ktime_sub(a, b)		((a) - (b))
+#define ktime_us_delta(a, b)	(((a) - (b)) / NSEC_PER_USEC)
+
+/* Per-CPU counters, shared here */
+#define this_cpu_add(var, val)	__atomic_fetch_add(&(var), (val), __ATOMIC_RELAXED)
+#define this_cpu_inc(var)	this_cpu_add(var, 1)
+
+/* Locking */
+struct mutex {
+	pthread_mutex_t lock;
+};
+
+static inline void mutex_init(struct mutex *lock)
+{
+	pthread_mutex_init(&lock->lock, NULL);
+}
+
+static inline void mutex_destroy(struct mutex *lock)
+{
+	pthread_mutex_destroy(&lock->lock);
+}
+
+static inline void mutex_lock(struct mutex *lock)
+{
+	pthread_mutex_lock(&lock->lock);
+}
+
+static inline int mutex_trylock(struct mutex *lock)
+{
+	return pthread_mutex_trylock(&lock->lock) == 0;
+}
+
+static inline void mutex_unlock(struct mutex *lock)
+{
+	pthread_mutex_unlock(&lock->lock);
+}
+
+typedef struct {
+	unsigned int sequence;
+	struct mutex lock;
+} seqlock_t;
+
+static inline void seqlock_init(seqlock_t *sl)
+{
+	sl->sequence = 0;
+	mutex_init(&sl->lock);
+}
+
+static inline void write_seqlock(seqlock_t *sl)
+{
+	mutex_lock(&sl->lock);
+	__atomic_store_n(&sl->sequence, sl->sequence + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void write_sequnlock(seqlock_t *sl)
+{
+	__atomic_store_n(&sl->sequence, sl->sequence + 1, __ATOMIC_RELEASE);
+	mutex_unlock(&sl->lock);
+}
+
+static inline unsigned int read_seqbegin(const seqlock_t *sl)
+{
+	unsigned int seq;
+	
+	while ((seq = __atomic_load_n(&sl->sequence, __ATOMIC_ACQUIRE)) & 1)
+		;
+	return seq;
+}
+
+static inline unsigned int read_seqretry(const seqlock_t *sl, unsigned int start)
+{
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	return __atomic_load_n(&sl->sequence, __ATOMIC_RELAXED) != start;
+}
+
+/* Driver model, only what struct mpu6050_data embeds */
+struct list_head {
+	struct list_head *next, *prev;
+};
+
+struct device {
+	const char *init_name;
+};
+
+static inline const char *dev_name(const struct device *dev)
+{
+	return dev->init_name;
+}
+
+#define dev_err(dev, fmt, ...)	fprintf(stderr, "%s: " fmt, dev_name(dev), ##__VA_ARGS__)
+#define dev_warn		dev_err
+#define dev_info(dev, fmt, ...)	do { } while (0)
+#define dev_dbg(dev, fmt, ...)	do { } while (0)
+
+struct cdev {
+	int unused;
+};
+
+typedef struct {
+	int unused;
+} wait_queue_head_t;
+
+struct delayed_work {
+	int unused;
+};
+
+struct rw_semaphore {
+	int unused;
+};
+
+struct kref {
+	int unused;
+};
+
+/* I2C */
+#define I2C_M_RD		0x0001
+#define I2C_M_TEN		0x0010
+#define I2C_M_DMA_SAFE		0x0200
+
+#define I2C_FUNC_I2C			0x00000001
+#define I2C_FUNC_SMBUS_BYTE_DATA	0x00180000
+#define I2C_FUNC_SMBUS_I2C_BLOCK	0x0c000000
+#define I2C_SMBUS_BLOCK_MAX		32
+
+struct i2c_msg {
+	u16 addr;
+	u16 flags;
+	u16 len;
+	u8 *buf;
+};
+
+struct i2c_adapter_quirks {
+	u16 max_read_len;
+	u16 max_comb_2nd_msg_len;
+};
+
+struct regmap;
+
+/* One device per adapter; raw transfers are served from its registers */
+struct i2c_adapter {
+	const struct i2c_adapter_quirks *quirks;
+	u32 functionality;		/* I2C_FUNC_* */
+	struct regmap *map;		/* Device on the bus */
+	unsigned int nr_transfers;	/* i2c_transfer() calls served */
+};
+
+struct i2c_client {
+	unsigned short flags;
+	unsigned short addr;
+	char name[20];
+	struct i2c_adapter *adapter;
+	struct device dev;
+};
+
+static inline int i2c_check_functionality(struct i2c_adapter *adap, u32 func)
+{
+	return (adap->functionality & func) == func;
+}
+
+int i2c_transfer(struct i2c_adapter *adap, struct i2c_msg *msgs, int num);
+
+/* Regmap, backed by a flat register file */
+
+struct regmap_range {
+	unsigned int range_min;
+	unsigned int range_max;
+};
+
+#define regmap_reg_range(low, high)	{ .range_min = (low), .range_max = (high), }
+
+struct regmap_access_table {
+	const struct regmap_range *yes_ranges;
+	unsigned int n_yes_ranges;
+	const struct regmap_range *no_ranges;
+	unsigned int n_no_ranges;
+};
+
+enum regcache_type {
+	REGCACHE_NONE,
+	REGCACHE_RBTREE,
+	REGCACHE_FLAT,
+	REGCACHE_MAPLE,
+};
+
+struct regmap_config {
+	int reg_bits;
+	int val_bits;
+	unsigned int max_register;
+	const struct regmap_access_table *rd_table;
+	const struct regmap_access_table *wr_table;
+	const struct regmap_access_table *volatile_table;
+	const struct regmap_access_table *precious_table;
+	enum regcache_type cache_type;
+};
+
+int regmap_read(struct regmap *map, unsigned int reg, unsigned int *val);
+int regmap_write(struct regmap *map, unsigned int reg, unsigned int val);
+int regmap_update_bits(struct regmap *map, unsigned int reg,
+		       unsigned int mask, unsigned int val);
+int regmap_bulk_read(struct regmap *map, unsigned int reg, void *val,
+		     size_t val_count);
+int regmap_noinc_read(struct regmap *map, unsigned int reg, void *val,
+		      size_t val_len);
+
+/* Register file behind a shim regmap; FIFO_R_W reads cycle through @fifo */
+struct regmap *shim_regmap_create(void);
+void shim_regmap_destroy(struct regmap *map);
+u8 *shim_regmap_regs(struct regmap *map);
+u8 *shim_regmap_fifo(struct regmap *map);
+
+/*
+ * Bus reads issued by regmap_noinc_read(). A @max_raw_read of
+ * I2C_SMBUS_BLOCK_MAX splits them the way regmap-i2c does on an
+ * SMBus-only adapter; 0 means no limit.
+ */
+void shim_regmap_set_max_raw_read(struct regmap *map, size_t max_raw_read);
+unsigned int shim_regmap_raw_reads(struct regmap *map, size_t *max_len);
+
+/* Misc */
+void *memchr_inv(const void *start, int c, size_t bytes);
+
+#endif /* _MPU6050_KERNEL_SHIM_H_ */
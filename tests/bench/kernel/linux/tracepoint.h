@@ -0,0 +1,18 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Tracepoints compile to empty inline functions, so the hot paths pay
+ * nothing for them, as with tracing disabled in the kernel.
+ */
+
+#ifndef _MPU6050_SHIM_TRACEPOINT_H_
+#define _MPU6050_SHIM_TRACEPOINT_H_
+
+#include "../kernel_shim.h"
+
+#define TP_PROTO(...)	__VA_ARGS__
+#define TP_ARGS(...)	__VA_ARGS__
+
+#define TRACE_EVENT(name, proto, args, tstruct, assign, print) \
+	static inline void trace_##name(proto) { }
+
+#endif /* _MPU6050_SHIM_TRACEPOINT_H_ */
@@ -0,0 +1,1000 @@
+// CUSE character device backed by the I2C simulator
+//
+// Serves /dev/mpu6050 from userspace with the driver's ioctl and read()
+// ABI, so the e2e tests and ABI benchmarks run unmodified on machines that
+// cannot load the kernel module. One simulated sensor sits behind the
+// device and an acquisition thread plays the part of the driver's IRQ
+// thread: it polls DATA_RDY samples while any file is open and drains the
+// simulated FIFO into a record ring while streaming.
+//
+// Not served through CUSE: mmap() of the sample ring (CUSE has no mmap),
+// the auxiliary I2C master, decimation, cycle mode and capture groups.
+// Those ioctls fail with -EOPNOTSUPP.
+//
+// Build with "make cuse" (needs libfuse3) and run as root:
+//     ./cuse_mpu6050 -f [--name=mpu6050] [--pattern=N]
+#define _GNU_SOURCE
+#define FUSE_USE_VERSION 35
+
+#include "simulator.h"
+#include "../../../include/mpu6050.h"
+
+#include <cuse_lowlevel.h>
+#include <fuse_opt.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+
+#define CUSE_BUS               0
+#define CUSE_RING_SIZE         2048   // Records, power of two like the driver's ring
+#define CUSE_IOCTL_MAX         65536  // Largest transfer of one ioctl retry
+#define CUSE_WAIT_SLICE_NS     10000000ULL // Blocked requests check for interrupts this often
+#define CUSE_MIN_DRAIN_NS      1000000ULL
+
+// Per-file state, in fuse_file_info.fh
+typedef struct cuse_file {
+    struct cuse_file* next;
+    uint32_t ring_tail;           // Next streaming record to read
+    uint64_t lost;                // Records overwritten before they were read
+    uint32_t read_mode;           // MPU6050_READ_*
+    uint32_t sample_seen;         // Last one-shot sample returned in READ_NEW mode
+    uint64_t max_age_ns;          // Staleness bound, 0 for one output data period
+    bool nonblock;
+    struct fuse_pollhandle* ph;   // Pending poll, notified once
+} cuse_file_t;
+
+// The simulated sensor and everything the driver keeps in mpu6050_data
+typedef struct {
+    pthread_mutex_t lock;         // Everything below, and the bus
+    pthread_cond_t data_wait;     // New sample or records
+    pthread_cond_t acq_wait;      // Wakes the acquisition thread
+    uint8_t address;
+    data_pattern_t pattern;
+    struct mpu6050_config config;
+    struct mpu6050_calibration calib;
+    struct mpu6050_scale scale;
+    uint32_t channels;
+    // Latest sample, refreshed every output data period while open
+    struct mpu6050_raw_data latest;
+    uint64_t latest_ns;
+    uint32_t sample_seq;          // DATA_RDY samples fetched while not streaming
+    // Streaming
+    bool streaming;
+    uint32_t watermark;
+    struct mpu6050_sample ring[CUSE_RING_SIZE];
+    uint32_t head;                // Sequence number of the next record
+    uint32_t layout_seq;          // First record with the current channel layout
+    uint16_t ring_flags;          // Flags for the next record
+    cuse_file_t* files;
+    unsigned int users;
+    bool running;
+    pthread_t acq_thread;
+} cuse_dev_t;
+
+static cuse_dev_t g_dev = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .data_wait = PTHREAD_COND_INITIALIZER,
+    .acq_wait = PTHREAD_COND_INITIALIZER,
+    .address = MPU6050_I2C_ADDR,
+    .pattern = PATTERN_GRAVITY_ONLY,
+};
+
+// Command line
+typedef struct {
+    char* dev_name;
+    int pattern;
+    int is_help;
+} cuse_param_t;
+
+#define CUSE_OPT(t, p) { t, offsetof(cuse_param_t, p), 1 }
+
+static const struct fuse_opt cuse_opts[] = {
+    CUSE_OPT("-n %s", dev_name),
+    CUSE_OPT("--name=%s", dev_name),
+    CUSE_OPT("-p %d", pattern),
+    CUSE_OPT("--pattern=%d", pattern),
+    FUSE_OPT_KEY("-h", 0),
+    FUSE_OPT_KEY("--help", 0),
+    FUSE_OPT_END
+};
+
+// Register access, with g_dev.lock held
+
+static int dev_write(uint8_t reg, uint8_t val) {
+    return i2c_simulator_write_byte(CUSE_BUS, g_dev.address, reg, val);
+}
+
+static int dev_read(uint8_t reg, uint8_t* val) {
+    return i2c_simulator_read_byte(CUSE_BUS, g_dev.address, reg, val);
+}
+
+// Output data period in nanoseconds, as the driver derives it
+static uint64_t sample_period_ns(void) {
+    uint8_t dlpf = g_dev.config.dlpf_cfg;
+    uint64_t base_ns = (dlpf == 0 || dlpf >= 7) ? 125000 : 1000000;
+
+    return base_ns * (1 + g_dev.config.sample_rate_div);
+}
+
+// FIFO_EN sources and frame length for the enabled channels. The
+// accelerometer only goes to the FIFO as a whole.
+static uint8_t fifo_sources(void) {
+    uint8_t sources = 0;
+
+    if (g_dev.channels & MPU6050_CHAN_ACCEL) sources |= MPU6050_FIFO_EN_ACCEL;
+    if (g_dev.channels & MPU6050_CHAN_TEMP) sources |= MPU6050_FIFO_EN_TEMP;
+    if (g_dev.channels & MPU6050_CHAN_GYRO_X) sources |= MPU6050_FIFO_EN_XG;
+    if (g_dev.channels & MPU6050_CHAN_GYRO_Y) sources |= MPU6050_FIFO_EN_YG;
+    if (g_dev.channels & MPU6050_CHAN_GYRO_Z) sources |= MPU6050_FIFO_EN_ZG;
+    return sources;
+}
+
+static size_t fifo_frame_size(uint8_t sources) {
+    return ((sources & MPU6050_FIFO_EN_ACCEL) ? 6 : 0) +
+           (size_t)__builtin_popcount(sources & (MPU6050_FIFO_EN_TEMP | MPU6050_FIFO_EN_XG |
+                                                 MPU6050_FIFO_EN_YG | MPU6050_FIFO_EN_ZG)) * 2;
+}
+
+static int16_t be16(const uint8_t* p) {
+    return (int16_t)((p[0] << 8) | p[1]);
+}
+
+// Zero the readings of disabled channels
+static void mask_channels(struct mpu6050_raw_data* raw) {
+    for (int chan = 0; chan < MPU6050_NUM_CHANNELS; chan++) {
+        if (!(g_dev.channels & BIT(chan))) {
+            mpu6050_raw_chan(raw, chan) = 0;
+        }
+    }
+}
+
+// Same fixed-point factors as mpu6050_update_scale_factors()
+static void scale_init(unsigned int chan, uint64_t num, uint64_t den, int32_t bias, int32_t offset) {
+    int64_t mult = (int64_t)(((num << MPU6050_SCALE_SHIFT) + den / 2) / den);
+
+    g_dev.scale.mult[chan] = (int32_t)mult;
+    g_dev.scale.add[chan] = ((int64_t)offset << MPU6050_SCALE_SHIFT) - bias * mult +
+                            (1LL << (MPU6050_SCALE_SHIFT - 1));
+}
+
+static void update_scale(void) {
+    const struct mpu6050_calibration* cal = &g_dev.calib;
+    uint64_t accel_scale = mpu6050_accel_range_to_scale(g_dev.config.accel_range);
+    uint64_t gyro_scale = mpu6050_gyro_range_to_scale(g_dev.config.gyro_range);
+
+    for (int i = 0; i < 3; i++) {
+        scale_init(i, accel_scale * (1000000 + cal->accel_scale_ppm[i]),
+                   1000ULL * 1000000, cal->accel_bias[i], 0);
+        scale_init(4 + i, gyro_scale * (1000000 + cal->gyro_scale_ppm[i]),
+                   1000000ULL * 1000000, cal->gyro_bias[i], 0);
+    }
+    scale_init(3, 100, 340, 0, 3653);
+}
+
+static int apply_config(const struct mpu6050_config* config) {
+    int ret;
+
+    ret = dev_write(MPU6050_SMPLRT_DIV, config->sample_rate_div);
+    if (!ret) ret = dev_write(MPU6050_CONFIG, config->dlpf_cfg & MPU6050_DLPF_CFG_MASK);
+    if (!ret) ret = dev_write(MPU6050_GYRO_CONFIG, (config->gyro_range << 3) & MPU6050_GYRO_FS_SEL_MASK);
+    if (!ret) ret = dev_write(MPU6050_ACCEL_CONFIG, (config->accel_range << 3) & MPU6050_ACCEL_FS_SEL_MASK);
+    if (ret) return ret;
+
+    g_dev.config = *config;
+    update_scale();
+    return 0;
+}
+
+// Fetch one sample with a single burst of the data registers
+static int fetch_sample(struct mpu6050_raw_data* raw) {
+    uint8_t buf[MPU6050_FIFO_FRAME_SIZE];
+    int ret;
+
+    ret = i2c_simulator_read_burst(CUSE_BUS, g_dev.address, MPU6050_ACCEL_XOUT_H, buf, sizeof(buf));
+    if (ret) return ret;
+
+    raw->accel_x = be16(&buf[0]);
+    raw->accel_y = be16(&buf[2]);
+    raw->accel_z = be16(&buf[4]);
+    raw->temp = be16(&buf[6]);
+    raw->gyro_x = be16(&buf[8]);
+    raw->gyro_y = be16(&buf[10]);
+    raw->gyro_z = be16(&buf[12]);
+    mask_channels(raw);
+
+    g_dev.latest = *raw;
+    g_dev.latest_ns = sim_time_ns();
+    return 0;
+}
+
+static void ring_push(const struct mpu6050_raw_data* raw, uint64_t timestamp) {
+    struct mpu6050_sample* s = &g_dev.ring[g_dev.head & (CUSE_RING_SIZE - 1)];
+
+    memset(s, 0, sizeof(*s));
+    s->timestamp = (int64_t)timestamp;
+    s->seq = g_dev.head++;
+    s->flags = g_dev.ring_flags;
+    s->raw = *raw;
+    g_dev.ring_flags = 0;
+}
+
+static int fifo_restart(void) {
+    return dev_write(MPU6050_USER_CTRL, MPU6050_USER_CTRL_FIFO_EN | MPU6050_USER_CTRL_FIFO_RST);
+}
+
+// Move every whole frame out of the FIFO into the ring, one count read and
+// one burst per call. Frames are timestamped one period apart, backwards
+// from now.
+static void drain_fifo(void) {
+    static uint8_t buf[MPU6050_FIFO_SIZE];
+    uint8_t sources = fifo_sources();
+    size_t frame = fifo_frame_size(sources);
+    uint8_t status, count[2];
+
+    if (dev_read(MPU6050_INT_STATUS, &status)) return;
+    if (status & MPU6050_INT_FIFO_OFLOW) {
+        g_dev.ring_flags |= MPU6050_SAMPLE_FIFO_OVERFLOW;
+        fifo_restart();
+        return;
+    }
+
+    if (i2c_simulator_read_burst(CUSE_BUS, g_dev.address, MPU6050_FIFO_COUNTH, count, 2)) return;
+    size_t frames = (size_t)((count[0] << 8) | count[1]) / frame;
+    if (frames == 0) return;
+    if (i2c_simulator_read_burst(CUSE_BUS, g_dev.address, MPU6050_FIFO_R_W, buf, frames * frame)) {
+        // A failed transfer leaves the FIFO misaligned
+        g_dev.ring_flags |= MPU6050_SAMPLE_FIFO_OVERFLOW;
+        fifo_restart();
+        return;
+    }
+
+    uint64_t now = sim_time_ns();
+    uint64_t period = sample_period_ns();
+    for (size_t i = 0; i < frames; i++) {
+        const uint8_t* p = &buf[i * frame];
+        struct mpu6050_raw_data raw = {0};
+
+        if (sources & MPU6050_FIFO_EN_ACCEL) {
+            raw.accel_x = be16(p);
+            raw.accel_y = be16(p + 2);
+            raw.accel_z = be16(p + 4);
+            p += 6;
+        }
+        if (sources & MPU6050_FIFO_EN_TEMP) { raw.temp = be16(p); p += 2; }
+        if (sources & MPU6050_FIFO_EN_XG) { raw.gyro_x = be16(p); p += 2; }
+        if (sources & MPU6050_FIFO_EN_YG) { raw.gyro_y = be16(p); p += 2; }
+        if (sources & MPU6050_FIFO_EN_ZG) { raw.gyro_z = be16(p); p += 2; }
+        mask_channels(&raw);
+
+        ring_push(&raw, now - (frames - 1 - i) * period);
+        g_dev.latest = raw;
+        g_dev.latest_ns = now;
+    }
+}
+
+// Streaming records @pf has not read yet, after catching up with the
+// record layout and skipping anything the ring overwrote
+static uint32_t file_unread(cuse_file_t* pf) {
+    if ((int32_t)(pf->ring_tail - g_dev.layout_seq) < 0) {
+        pf->ring_tail = g_dev.layout_seq;
+    }
+    uint32_t unread = g_dev.head - pf->ring_tail;
+    if (unread > CUSE_RING_SIZE) {
+        pf->lost += unread - CUSE_RING_SIZE;
+        pf->ring_tail = g_dev.head - CUSE_RING_SIZE;
+        unread = CUSE_RING_SIZE;
+    }
+    return unread;
+}
+
+static bool file_ready(cuse_file_t* pf) {
+    if (g_dev.streaming) return file_unread(pf) > 0;
+    if (pf->read_mode == MPU6050_READ_NEW) return g_dev.sample_seq != pf->sample_seen;
+    return true;
+}
+
+// Wake blocked readers and notify pending polls that became ready
+static void notify_readers(void) {
+    pthread_cond_broadcast(&g_dev.data_wait);
+
+    for (cuse_file_t* pf = g_dev.files; pf; pf = pf->next) {
+        if (pf->ph && file_ready(pf)) {
+            fuse_lowlevel_notify_poll(pf->ph);
+            fuse_pollhandle_destroy(pf->ph);
+            pf->ph = NULL;
+        }
+    }
+}
+
+static void timespec_at(struct timespec* ts, uint64_t ns) {
+    ts->tv_sec = (time_t)(ns / 1000000000ULL);
+    ts->tv_nsec = (long)(ns % 1000000000ULL);
+}
+
+// Acquisition thread: the driver's IRQ thread. Polls for DATA_RDY samples
+// every output data period while a file is open, or drains the FIFO every
+// watermark frames while streaming, bounded so the FIFO never fills up.
+static void* acquisition_thread(void* arg) {
+    (void)arg;
+    uint64_t next = 0;
+
+    pthread_mutex_lock(&g_dev.lock);
+    while (g_dev.running) {
+        if (g_dev.users == 0) {
+            pthread_cond_wait(&g_dev.acq_wait, &g_dev.lock);
+            next = 0;
+            continue;
+        }
+
+        uint64_t now = sim_time_ns();
+        uint64_t period = sample_period_ns();
+        uint64_t interval = period;
+
+        if (g_dev.streaming) {
+            uint64_t fill_ns = MPU6050_FIFO_SIZE / fifo_frame_size(fifo_sources()) * period;
+
+            drain_fifo();
+            interval = g_dev.watermark * period;
+            if (interval > fill_ns / 2) interval = fill_ns / 2;
+            if (interval < CUSE_MIN_DRAIN_NS) interval = CUSE_MIN_DRAIN_NS;
+        } else {
+            struct mpu6050_raw_data raw;
+
+            if (fetch_sample(&raw) == 0) {
+                g_dev.sample_seq++;
+            }
+        }
+        notify_readers();
+
+        // Keep to the sample clock rather than drifting by the bus time
+        next = (next && next + interval > now) ? next + interval : now + interval;
+        struct timespec ts;
+        timespec_at(&ts, next);
+        pthread_cond_timedwait(&g_dev.acq_wait, &g_dev.lock, &ts);
+    }
+    pthread_mutex_unlock(&g_dev.lock);
+    return NULL;
+}
+
+// Wait on data_wait until @deadline_ns (0 for no limit) or until the
+// request is interrupted. Returns -EINTR or -ETIMEDOUT, else 0.
+static int wait_data(fuse_req_t req, uint64_t deadline_ns) {
+    uint64_t now = sim_time_ns();
+    uint64_t until = now + CUSE_WAIT_SLICE_NS;
+    struct timespec ts;
+
+    if (fuse_req_interrupted(req)) return -EINTR;
+    if (deadline_ns) {
+        if (now >= deadline_ns) return -ETIMEDOUT;
+        if (until > deadline_ns) until = deadline_ns;
+    }
+    timespec_at(&ts, until);
+    pthread_cond_timedwait(&g_dev.data_wait, &g_dev.lock, &ts);
+    return 0;
+}
+
+static size_t record_size(void) {
+    return MPU6050_RECORD_SIZE(__builtin_popcount(g_dev.channels));
+}
+
+// Copy @n records starting at the file's tail out as packed records
+static void pack_records(cuse_file_t* pf, uint32_t n, uint8_t* buf) {
+    size_t size = record_size();
+
+    for (uint32_t i = 0; i < n; i++, pf->ring_tail++) {
+        const struct mpu6050_sample* s = &g_dev.ring[pf->ring_tail & (CUSE_RING_SIZE - 1)];
+        struct mpu6050_record* rec = (struct mpu6050_record*)(buf + i * size);
+        int k = 0;
+
+        memset(rec, 0, size);
+        rec->timestamp = s->timestamp;
+        rec->seq = s->seq;
+        rec->flags = s->flags;
+        for (int chan = 0; chan < MPU6050_NUM_CHANNELS; chan++) {
+            if (g_dev.channels & BIT(chan)) {
+                rec->data[k++] = mpu6050_raw_chan(&s->raw, chan);
+            }
+        }
+    }
+}
+
+static void scale_records(cuse_file_t* pf, uint32_t n, struct mpu6050_scaled_sample* out) {
+    for (uint32_t i = 0; i < n; i++, pf->ring_tail++) {
+        const struct mpu6050_sample* s = &g_dev.ring[pf->ring_tail & (CUSE_RING_SIZE - 1)];
+
+        memset(&out[i], 0, sizeof(out[i]));
+        out[i].timestamp = s->timestamp;
+        out[i].seq = s->seq;
+        out[i].flags = s->flags;
+        mpu6050_scale_raw(&s->raw, &g_dev.scale, &out[i].scaled);
+        if (!(g_dev.channels & MPU6050_CHAN_ACCEL_X)) out[i].scaled.accel_x = 0;
+        if (!(g_dev.channels & MPU6050_CHAN_ACCEL_Y)) out[i].scaled.accel_y = 0;
+        if (!(g_dev.channels & MPU6050_CHAN_ACCEL_Z)) out[i].scaled.accel_z = 0;
+        if (!(g_dev.channels & MPU6050_CHAN_TEMP)) out[i].scaled.temp = 0;
+        if (!(g_dev.channels & MPU6050_CHAN_GYRO_X)) out[i].scaled.gyro_x = 0;
+        if (!(g_dev.channels & MPU6050_CHAN_GYRO_Y)) out[i].scaled.gyro_y = 0;
+        if (!(g_dev.channels & MPU6050_CHAN_GYRO_Z)) out[i].scaled.gyro_z = 0;
+    }
+}
+
+// Latest sample no older than the file's staleness bound
+static int read_latest(cuse_file_t* pf, struct mpu6050_raw_data* raw) {
+    uint64_t max_age = pf->max_age_ns ? pf->max_age_ns : sample_period_ns();
+
+    if (g_dev.latest_ns && sim_time_ns() - g_dev.latest_ns <= max_age) {
+        *raw = g_dev.latest;
+        return 0;
+    }
+    return fetch_sample(raw);
+}
+
+static int set_streaming(bool enable) {
+    int ret;
+
+    if (enable == g_dev.streaming) return 0;
+
+    if (enable) {
+        uint8_t status;
+
+        ret = dev_write(MPU6050_FIFO_EN, fifo_sources());
+        if (!ret) ret = fifo_restart();
+        if (!ret) ret = dev_read(MPU6050_INT_STATUS, &status);
+        if (ret) return ret;
+        g_dev.layout_seq = g_dev.head;
+        g_dev.ring_flags = 0;
+    } else {
+        ret = dev_write(MPU6050_USER_CTRL, 0);
+        if (!ret) ret = dev_write(MPU6050_FIFO_EN, 0);
+        if (ret) return ret;
+    }
+
+    g_dev.streaming = enable;
+    pthread_cond_signal(&g_dev.acq_wait);
+    notify_readers();
+    return 0;
+}
+
+static int set_channels(uint32_t mask) {
+    uint8_t pwr2 = 0;
+
+    if (!mask || (mask & ~MPU6050_CHAN_ALL)) return -EINVAL;
+    if (g_dev.streaming) return -EBUSY;
+
+    // PWR_MGMT_2 STBY_XA..STBY_ZG, temperature has no standby bit
+    if (!(mask & MPU6050_CHAN_ACCEL_X)) pwr2 |= BIT(5);
+    if (!(mask & MPU6050_CHAN_ACCEL_Y)) pwr2 |= BIT(4);
+    if (!(mask & MPU6050_CHAN_ACCEL_Z)) pwr2 |= BIT(3);
+    if (!(mask & MPU6050_CHAN_GYRO_X)) pwr2 |= BIT(2);
+    if (!(mask & MPU6050_CHAN_GYRO_Y)) pwr2 |= BIT(1);
+    if (!(mask & MPU6050_CHAN_GYRO_Z)) pwr2 |= BIT(0);
+
+    int ret = dev_write(MPU6050_PWR_MGMT_2, pwr2);
+    if (ret) return ret;
+
+    g_dev.channels = mask;
+    g_dev.latest_ns = 0;
+    return 0;
+}
+
+static int set_calibration(const struct mpu6050_calibration* cal) {
+    for (int i = 0; i < 3; i++) {
+        if (abs(cal->accel_bias[i]) > MPU6050_CALIB_MAX_BIAS ||
+            abs(cal->gyro_bias[i]) > MPU6050_CALIB_MAX_BIAS ||
+            abs(cal->accel_scale_ppm[i]) > MPU6050_CALIB_MAX_SCALE_PPM ||
+            abs(cal->gyro_scale_ppm[i]) > MPU6050_CALIB_MAX_SCALE_PPM) {
+            return -EINVAL;
+        }
+    }
+    g_dev.calib = *cal;
+    update_scale();
+    return 0;
+}
+
+// Wake the part and program the driver's defaults
+static int init_device(void) {
+    struct mpu6050_config config = {
+        .sample_rate_div = MPU6050_DEFAULT_SMPLRT_DIV,
+        .gyro_range = MPU6050_GYRO_FS_250,
+        .accel_range = MPU6050_ACCEL_FS_2G,
+        .dlpf_cfg = 0x00,
+    };
+    uint8_t who_am_i;
+    int ret;
+
+    ret = dev_read(MPU6050_WHO_AM_I, &who_am_i);
+    if (ret) return ret;
+    if (who_am_i != MPU6050_WHO_AM_I_VAL) return -ENODEV;
+
+    ret = dev_write(MPU6050_PWR_MGMT_1, 0x01); // CLKSEL PLL with X gyro reference
+    if (!ret) ret = apply_config(&config);
+    if (!ret) ret = set_channels(MPU6050_CHAN_ALL);
+    return ret;
+}
+
+static int reset_device(void) {
+    bool streaming = g_dev.streaming;
+    struct mpu6050_config config = g_dev.config;
+    uint32_t channels = g_dev.channels;
+    int ret;
+
+    // The simulated reset completes within the write
+    ret = dev_write(MPU6050_PWR_MGMT_1, 0x80);
+    if (!ret) ret = dev_write(MPU6050_PWR_MGMT_1, 0x01);
+    if (!ret) ret = apply_config(&config);
+    if (ret) return ret;
+
+    g_dev.streaming = false;
+    g_dev.channels = 0;
+    ret = set_channels(channels);
+    if (!ret && streaming) {
+        ret = set_streaming(true);
+        g_dev.ring_flags |= MPU6050_SAMPLE_FIFO_OVERFLOW;
+    }
+    g_dev.latest_ns = 0;
+    return ret;
+}
+
+// File operations
+
+static void cuse_mpu6050_init(void* userdata, struct fuse_conn_info* conn) {
+    (void)userdata;
+    (void)conn;
+
+    // After daemonizing, which would lose the simulator's threads
+    if (i2c_simulator_init() != 0 ||
+        i2c_simulator_add_device(CUSE_BUS, g_dev.address, "mpu6050") != 0) {
+        fprintf(stderr, "cuse_mpu6050: failed to set up the simulator\n");
+        exit(EXIT_FAILURE);
+    }
+    mpu6050_simulator_set_pattern(g_dev.address, g_dev.pattern);
+
+    pthread_mutex_lock(&g_dev.lock);
+    int ret = init_device();
+    g_dev.watermark = 1;
+    g_dev.running = true;
+    pthread_mutex_unlock(&g_dev.lock);
+    if (ret) {
+        fprintf(stderr, "cuse_mpu6050: failed to initialize the device: %s\n", strerror(-ret));
+        exit(EXIT_FAILURE);
+    }
+
+    pthread_create(&g_dev.acq_thread, NULL, acquisition_thread, NULL);
+}
+
+static void cuse_mpu6050_destroy(void* userdata) {
+    (void)userdata;
+
+    pthread_mutex_lock(&g_dev.lock);
+    g_dev.running = false;
+    pthread_cond_signal(&g_dev.acq_wait);
+    pthread_mutex_unlock(&g_dev.lock);
+    pthread_join(g_dev.acq_thread, NULL);
+
+    i2c_simulator_cleanup();
+}
+
+static void cuse_mpu6050_open(fuse_req_t req, struct fuse_file_info* fi) {
+    cuse_file_t* pf = calloc(1, sizeof(*pf));
+
+    if (!pf) {
+        fuse_reply_err(req, ENOMEM);
+        return;
+    }
+    pf->nonblock = (fi->flags & O_NONBLOCK) != 0;
+
+    pthread_mutex_lock(&g_dev.lock);
+    pf->ring_tail = g_dev.head;
+    pf->sample_seen = g_dev.sample_seq;
+    pf->next = g_dev.files;
+    g_dev.files = pf;
+    if (g_dev.users++ == 0) {
+        pthread_cond_signal(&g_dev.acq_wait);
+    }
+    pthread_mutex_unlock(&g_dev.lock);
+
+    fi->fh = (uintptr_t)pf;
+    fi->direct_io = 1;
+    fi->nonseekable = 1;
+    fuse_reply_open(req, fi);
+}
+
+static void cuse_mpu6050_release(fuse_req_t req, struct fuse_file_info* fi) {
+    cuse_file_t* pf = (cuse_file_t*)(uintptr_t)fi->fh;
+
+    pthread_mutex_lock(&g_dev.lock);
+    for (cuse_file_t** p = &g_dev.files; *p; p = &(*p)->next) {
+        if (*p == pf) {
+            *p = pf->next;
+            break;
+        }
+    }
+    // As in the driver, streaming stays on; acquisition pauses until the
+    // next open and the FIFO overflow is flagged then
+    g_dev.users--;
+    if (pf->ph) {
+        fuse_pollhandle_destroy(pf->ph);
+    }
+    pthread_mutex_unlock(&g_dev.lock);
+
+    free(pf);
+    fuse_reply_err(req, 0);
+}
+
+// Streaming read(): as many whole records as fit, at least one
+static void read_stream(fuse_req_t req, cuse_file_t* pf, size_t size) {
+    size_t rec = record_size();
+    uint32_t unread;
+    int ret = 0;
+
+    if (size < rec) {
+        fuse_reply_err(req, EINVAL);
+        return;
+    }
+    while ((unread = file_unread(pf)) == 0) {
+        if (!g_dev.streaming) {
+            ret = -EINVAL;
+            break;
+        }
+        if (pf->nonblock) {
+            ret = -EAGAIN;
+            break;
+        }
+        ret = wait_data(req, 0);
+        if (ret) break;
+    }
+    if (ret) {
+        fuse_reply_err(req, -ret);
+        return;
+    }
+
+    uint32_t n = (uint32_t)(size / rec) < unread ? (uint32_t)(size / rec) : unread;
+    uint8_t* buf = malloc(n * rec);
+    if (!buf) {
+        fuse_reply_err(req, ENOMEM);
+        return;
+    }
+    pack_records(pf, n, buf);
+    fuse_reply_buf(req, (const char*)buf, n * rec);
+    free(buf);
+}
+
+// One-shot read() in MPU6050_READ_NEW mode
+static void read_new(fuse_req_t req, cuse_file_t* pf, size_t size) {
+    struct mpu6050_sample s = {0};
+    int ret = 0;
+
+    if (size < sizeof(s)) {
+        fuse_reply_err(req, EINVAL);
+        return;
+    }
+    while (g_dev.sample_seq == pf->sample_seen) {
+        if (pf->nonblock) {
+            ret = -EAGAIN;
+            break;
+        }
+        ret = wait_data(req, 0);
+        if (ret) break;
+    }
+    if (ret) {
+        fuse_reply_err(req, -ret);
+        return;
+    }
+
+    if (g_dev.sample_seq - pf->sample_seen > 1) {
+        s.flags = MPU6050_SAMPLE_FIFO_OVERFLOW;
+    }
+    pf->sample_seen = g_dev.sample_seq;
+    s.timestamp = (int64_t)g_dev.latest_ns;
+    s.seq = g_dev.sample_seq;
+    s.raw = g_dev.latest;
+    fuse_reply_buf(req, (const char*)&s, sizeof(s));
+}
+
+static void cuse_mpu6050_read(fuse_req_t req, size_t size, off_t off, struct fuse_file_info* fi) {
+    cuse_file_t* pf = (cuse_file_t*)(uintptr_t)fi->fh;
+    (void)off;
+
+    pthread_mutex_lock(&g_dev.lock);
+    if (g_dev.streaming) {
+        read_stream(req, pf, size);
+    } else if (pf->read_mode == MPU6050_READ_NEW) {
+        read_new(req, pf, size);
+    } else {
+        struct mpu6050_raw_data raw;
+        int ret = size < sizeof(raw) ? -EINVAL : read_latest(pf, &raw);
+
+        if (ret) {
+            fuse_reply_err(req, -ret);
+        } else {
+            fuse_reply_buf(req, (const char*)&raw, sizeof(raw));
+        }
+    }
+    pthread_mutex_unlock(&g_dev.lock);
+}
+
+static void cuse_mpu6050_poll(fuse_req_t req, struct fuse_file_info* fi, struct fuse_pollhandle* ph) {
+    cuse_file_t* pf = (cuse_file_t*)(uintptr_t)fi->fh;
+    unsigned int revents = 0;
+
+    pthread_mutex_lock(&g_dev.lock);
+    if (file_ready(pf)) {
+        revents = POLLIN | POLLRDNORM;
+    }
+    if (ph) {
+        if (pf->ph) {
+            fuse_pollhandle_destroy(pf->ph);
+        }
+        pf->ph = revents ? NULL : ph;
+        if (revents) {
+            fuse_pollhandle_destroy(ph);
+        }
+    }
+    pthread_mutex_unlock(&g_dev.lock);
+
+    fuse_reply_poll(req, revents);
+}
+
+// Batch ioctls. The argument comes in, then a second retry maps the
+// caller's buffer for the records.
+static void ioctl_batch(fuse_req_t req, cuse_file_t* pf, unsigned int cmd, void* arg,
+                        const void* in_buf, size_t out_bufsz) {
+    struct mpu6050_batch batch;
+    bool scaled = cmd == MPU6050_IOC_READ_SCALED_BATCH;
+    size_t rec = scaled ? sizeof(struct mpu6050_scaled_sample) : record_size();
+    int ret = 0;
+
+    memcpy(&batch, in_buf, sizeof(batch));
+    if (!g_dev.streaming) {
+        fuse_reply_err(req, EINVAL);
+        return;
+    }
+
+    uint32_t count = batch.count;
+    if (count > CUSE_RING_SIZE) count = CUSE_RING_SIZE;
+    if (count > (CUSE_IOCTL_MAX - sizeof(batch)) / rec) count = (CUSE_IOCTL_MAX - sizeof(batch)) / rec;
+
+    if (count && out_bufsz < sizeof(batch) + count * rec) {
+        struct iovec in_iov = { arg, sizeof(batch) };
+        struct iovec out_iov[2] = {
+            { arg, sizeof(batch) },
+            { (void*)(uintptr_t)batch.buf, count * rec },
+        };
+        fuse_reply_ioctl_retry(req, &in_iov, 1, out_iov, 2);
+        return;
+    }
+
+    uint64_t deadline = 0;
+    if (batch.timeout_ms > 0) {
+        deadline = sim_time_ns() + (uint64_t)batch.timeout_ms * 1000000ULL;
+    }
+    while (batch.timeout_ms != 0 && file_unread(pf) < count && g_dev.streaming) {
+        ret = wait_data(req, deadline);
+        if (ret) break;
+    }
+    if (ret == -EINTR) {
+        fuse_reply_err(req, EINTR);
+        return;
+    }
+
+    uint32_t n = g_dev.streaming ? file_unread(pf) : 0;
+    if (n > count) n = count;
+    uint8_t* buf = calloc(count ? count : 1, rec);
+    if (!buf) {
+        fuse_reply_err(req, ENOMEM);
+        return;
+    }
+    if (scaled) {
+        scale_records(pf, n, (struct mpu6050_scaled_sample*)buf);
+    } else {
+        pack_records(pf, n, buf);
+    }
+    batch.count = n;
+    batch.lost = pf->lost;
+
+    struct iovec iov[2] = {
+        { &batch, sizeof(batch) },
+        { buf, count * rec },
+    };
+    fuse_reply_ioctl_iov(req, 0, iov, count ? 2 : 1);
+    free(buf);
+}
+
+// Argument-less and fixed-size ioctls; Returns the reply size or a
+// negative errno
+static int ioctl_simple(cuse_file_t* pf, unsigned int cmd, const void* in, void* out) {
+    uint32_t val;
+
+    switch (cmd) {
+    case MPU6050_IOC_READ_RAW: {
+        int ret = read_latest(pf, out);
+        return ret ? ret : (int)sizeof(struct mpu6050_raw_data);
+    }
+
+    case MPU6050_IOC_READ_SCALED: {
+        struct mpu6050_raw_data raw;
+        int ret = read_latest(pf, &raw);
+        if (ret) return ret;
+        mpu6050_scale_raw(&raw, &g_dev.scale, out);
+        return sizeof(struct mpu6050_scaled_data);
+    }
+
+    case MPU6050_IOC_SET_CONFIG:
+        return apply_config(in);
+
+    case MPU6050_IOC_GET_CONFIG:
+        memcpy(out, &g_dev.config, sizeof(g_dev.config));
+        return sizeof(g_dev.config);
+
+    case MPU6050_IOC_RESET:
+        return reset_device();
+
+    case MPU6050_IOC_WHO_AM_I: {
+        int ret = dev_read(MPU6050_WHO_AM_I, out);
+        return ret ? ret : (int)sizeof(u8);
+    }
+
+    case MPU6050_IOC_SELF_TEST:
+        // The simulated part always passes
+        return 0;
+
+    case MPU6050_IOC_SET_STREAMING:
+        return set_streaming(*(const int*)in != 0);
+
+    case MPU6050_IOC_SET_WATERMARK:
+        memcpy(&val, in, sizeof(val));
+        if (val < 1 || val > MPU6050_FIFO_SIZE / MPU6050_FIFO_FRAME_SIZE) return -EINVAL;
+        g_dev.watermark = val;
+        pthread_cond_signal(&g_dev.acq_wait);
+        return 0;
+
+    case MPU6050_IOC_GET_LOST:
+        if (g_dev.streaming) file_unread(pf);
+        memcpy(out, &pf->lost, sizeof(pf->lost));
+        return sizeof(pf->lost);
+
+    case MPU6050_IOC_SET_STALENESS:
+        memcpy(&val, in, sizeof(val));
+        pf->max_age_ns = (uint64_t)val * 1000;
+        return 0;
+
+    case MPU6050_IOC_SET_CHANNELS:
+        memcpy(&val, in, sizeof(val));
+        return set_channels(val);
+
+    case MPU6050_IOC_GET_CHANNELS:
+        memcpy(out, &g_dev.channels, sizeof(g_dev.channels));
+        return sizeof(g_dev.channels);
+
+    case MPU6050_IOC_SET_READ_MODE:
+        memcpy(&val, in, sizeof(val));
+        if (val > MPU6050_READ_NEW) return -EINVAL;
+        pf->read_mode = val;
+        pf->sample_seen = g_dev.sample_seq;
+        return 0;
+
+    case MPU6050_IOC_SET_CALIBRATION:
+        return set_calibration(in);
+
+    case MPU6050_IOC_GET_CALIBRATION:
+        memcpy(out, &g_dev.calib, sizeof(g_dev.calib));
+        return sizeof(g_dev.calib);
+
+    case MPU6050_IOC_SET_AUX:
+    case MPU6050_IOC_GET_AUX:
+    case MPU6050_IOC_READ_EXT:
+    case MPU6050_IOC_SET_DECIMATION:
+    case MPU6050_IOC_GET_DECIMATION:
+    case MPU6050_IOC_SET_CYCLE:
+    case MPU6050_IOC_SET_GROUP:
+    case MPU6050_IOC_SET_GROUP_STREAMING:
+    case MPU6050_IOC_READ_GROUP:
+        return -EOPNOTSUPP;
+
+    default:
+        return -ENOTTY;
+    }
+}
+
+static void cuse_mpu6050_ioctl(fuse_req_t req, unsigned int cmd, void* arg,
+                               struct fuse_file_info* fi, unsigned int flags,
+                               const void* in_buf, size_t in_bufsz, size_t out_bufsz) {
+    cuse_file_t* pf = (cuse_file_t*)(uintptr_t)fi->fh;
+    size_t in_size = (_IOC_DIR(cmd) & _IOC_WRITE) ? _IOC_SIZE(cmd) : 0;
+    size_t out_size = (_IOC_DIR(cmd) & _IOC_READ) ? _IOC_SIZE(cmd) : 0;
+    uint64_t out[16];             // Largest fixed-size reply, aligned for any of them
+
+    if (flags & FUSE_IOCTL_COMPAT) {
+        fuse_reply_err(req, ENOSYS);
+        return;
+    }
+
+    // Unrestricted ioctl: ask the kernel for the argument first
+    if (in_bufsz < in_size || (out_size && out_bufsz < out_size)) {
+        struct iovec in_iov = { arg, in_size };
+        struct iovec out_iov = { arg, out_size };
+        fuse_reply_ioctl_retry(req, in_size ? &in_iov : NULL, in_size ? 1 : 0,
+                               out_size ? &out_iov : NULL, out_size ? 1 : 0);
+        return;
+    }
+
+    pthread_mutex_lock(&g_dev.lock);
+    if (cmd == MPU6050_IOC_READ_BATCH || cmd == MPU6050_IOC_READ_SCALED_BATCH) {
+        ioctl_batch(req, pf, cmd, arg, in_buf, out_bufsz);
+    } else {
+        int ret = out_size > sizeof(out) ? -ENOTTY : ioctl_simple(pf, cmd, in_buf, out);
+
+        if (ret < 0) {
+            fuse_reply_err(req, -ret);
+        } else {
+            fuse_reply_ioctl(req, 0, out_size ? out : NULL, out_size);
+        }
+    }
+    pthread_mutex_unlock(&g_dev.lock);
+}
+
+static const struct cuse_lowlevel_ops cuse_mpu6050_ops = {
+    .init = cuse_mpu6050_init,
+    .destroy = cuse_mpu6050_destroy,
+    .open = cuse_mpu6050_open,
+    .read = cuse_mpu6050_read,
+    .release = cuse_mpu6050_release,
+    .ioctl = cuse_mpu6050_ioctl,
+    .poll = cuse_mpu6050_poll,
+};
+
+static int process_arg(void* data, const char* arg, int key, struct fuse_args* outargs) {
+    cuse_param_t* param = data;
+    (void)outargs;
+    (void)arg;
+
+    if (key == 0) {
+        param->is_help = 1;
+        fprintf(stderr,
+                "usage: cuse_mpu6050 [options]\n"
+                "\n"
+                "options:\n"
+                "    --help|-h             print this help message\n"
+                "    --name=NAME|-n NAME   device name (default: mpu6050)\n"
+                "    --pattern=N|-p N      data pattern, 0-%d (default: %d, gravity only)\n"
+                "    -d   -o debug         enable debug output (implies -f)\n"
+                "    -f                    foreground operation\n"
+                "    -s                    disable multi-threaded operation\n",
+                PATTERN_COUNT - 1, PATTERN_GRAVITY_ONLY);
+        return fuse_opt_add_arg(outargs, "-ho");
+    }
+    return 1;
+}
+
+int main(int argc, char** argv) {
+    struct fuse_args args = FUSE_ARGS_INIT(argc, argv);
+    cuse_param_t param = { .pattern = PATTERN_GRAVITY_ONLY };
+    char dev_name[128] = "DEVNAME=";
+    const char* dev_info_argv[] = { dev_name };
+    struct cuse_info ci = {0};
+
+    if (fuse_opt_parse(&args, &param, cuse_opts, process_arg)) {
+        fprintf(stderr, "cuse_mpu6050: failed to parse options\n");
+        return EXIT_FAILURE;
+    }
+    if (param.pattern < 0 || param.pattern >= PATTERN_COUNT) {
+        fprintf(stderr, "cuse_mpu6050: pattern must be 0-%d\n", PATTERN_COUNT - 1);
+        return EXIT_FAILURE;
+    }
+    g_dev.pattern = (data_pattern_t)param.pattern;
+
+    strncat(dev_name, param.dev_name ? param.dev_name : "mpu6050",
+            sizeof(dev_name) - strlen(dev_name) - 1);
+
+    ci.dev_info_argc = 1;
+    ci.dev_info_argv = dev_info_argv;
+    ci.flags = CUSE_UNRESTRICTED_IOCTL;
+
+    int ret = cuse_lowlevel_main(args.argc, args.argv, &ci, &cuse_mpu6050_ops, NULL);
+    fuse_opt_free_args(&args);
+    return ret;
+}
@@ -6,17 +6,45 @@
 #include <unistd.h>
 #include <errno.h>
 #include <math.h>
+#include <stddef.h>
 #include <sys/time.h>
 
-// Global simulator instance
-static i2c_simulator_t g_simulator = {0};
-static bool g_simulator_initialized = false;
-static uint32_t g_global_latency_us = 100; // Default 100us latency
+// Default context and the one each thread selected, if any. Running
+// contexts are linked from g_simulators for the virtual clock.
+static i2c_simulator_t g_default_simulator;
+static __thread i2c_simulator_t* t_simulator = NULL;
+static i2c_simulator_t* g_simulators = NULL;
+static pthread_mutex_t g_simulators_lock = PTHREAD_MUTEX_INITIALIZER;
 static bool g_debug_logging = false;
-
-// Global access functions
-i2c_simulator_t* get_global_simulator(void) {
-    return &g_simulator;
+static uint32_t g_next_shard = 0;
+static uint32_t g_next_seed = 0;
+static __thread int t_shard = -1;
+static __thread uint32_t t_rand_state = 0;
+
+// Discrete-event clock for virtual time. A thread's slot bit is set in
+// participants from its first sleep until it exits or joins another
+// thread, and in sleeping while it waits for wakeup_ns[slot].
+typedef struct {
+    bool enabled;
+    uint64_t now_ns;
+    uint64_t participants;
+    uint64_t sleeping;
+    uint64_t wakeup_ns[SIM_CLOCK_THREADS];
+    pthread_mutex_t lock;
+    pthread_cond_t advanced;
+    pthread_key_t thread_key;     // Slot + 1, to release it on thread exit
+} sim_clock_t;
+
+static sim_clock_t g_clock = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .advanced = PTHREAD_COND_INITIALIZER,
+};
+static pthread_once_t g_clock_once = PTHREAD_ONCE_INIT;
+static __thread int t_clock_slot = -1;
+static __thread uint64_t t_pending_delay_us = 0;
+
+i2c_simulator_t* i2c_simulator_current(void) {
+    return t_simulator ? t_simulator : &g_default_simulator;
 }
 
 bool* get_debug_logging_flag(void) {
@@ -25,43 +53,112 @@ bool* get_debug_logging_flag(void) {
 
 // Private function declarations
 static void* background_simulation_thread(void* arg);
-static void update_performance_metrics(struct timespec* start, struct timespec* end, bool error);
-static i2c_device_t* find_device(int bus, uint8_t address);
+static void run_due_events(i2c_simulator_t* sim, uint64_t now_ns);
+static void event_schedule_locked(i2c_simulator_t* sim, int device, uint64_t due_ns);
+static void event_pop_locked(i2c_simulator_t* sim);
+static void event_move_locked(i2c_simulator_t* sim, int pos, sim_event_t event);
+static int simulator_start(i2c_simulator_t* sim);
+static void metrics_reset(i2c_simulator_t* sim);
+static void simulator_stop(i2c_simulator_t* sim);
+static void clock_key_init(void);
+static int clock_attach_locked(void);
+static void clock_release_slot(void* slot);
+static void clock_advance_locked(void);
+static uint64_t settle_delays(void);
+static void update_performance_metrics(uint64_t start_ns, uint64_t end_ns, bool error);
+static sim_metrics_shard_t* metrics_shard(void);
+static void metrics_add(uint32_t* counter, uint32_t n);
+static i2c_device_t* get_device(int bus, uint8_t address);
+static void put_device(int bus, i2c_device_t* device);
 static void simulate_bus_conditions(int bus);
 
 int i2c_simulator_init(void) {
-    if (g_simulator_initialized) {
+    return simulator_start(i2c_simulator_current());
+}
+
+void i2c_simulator_cleanup(void) {
+    simulator_stop(i2c_simulator_current());
+}
+
+i2c_simulator_t* i2c_simulator_create(void) {
+    void* sim = NULL;
+
+    // The device and metrics arrays are cache line aligned
+    if (posix_memalign(&sim, SIM_CACHELINE, sizeof(i2c_simulator_t)) != 0) {
+        return NULL;
+    }
+    if (simulator_start(sim) < 0) {
+        free(sim);
+        return NULL;
+    }
+    return sim;
+}
+
+void i2c_simulator_destroy(i2c_simulator_t* sim) {
+    if (sim == NULL || sim == &g_default_simulator) {
+        return;
+    }
+    if (t_simulator == sim) {
+        t_simulator = NULL;
+    }
+    simulator_stop(sim);
+    free(sim);
+}
+
+i2c_simulator_t* i2c_simulator_use(i2c_simulator_t* sim) {
+    i2c_simulator_t* previous = t_simulator;
+
+    t_simulator = sim == &g_default_simulator ? NULL : sim;
+    return previous;
+}
+
+static int simulator_start(i2c_simulator_t* sim) {
+    if (sim->initialized) {
         return 0; // Already initialized
     }
 
-    memset(&g_simulator, 0, sizeof(g_simulator));
+    memset(sim, 0, sizeof(*sim));
+    sim->latency_us = 100; // Default 100us latency
     
     // Initialize buses
     for (int i = 0; i < I2C_BUS_COUNT; i++) {
-        pthread_mutex_init(&g_simulator.buses[i].bus_mutex, NULL);
-        g_simulator.buses[i].device_count = 0;
-        g_simulator.buses[i].bus_error = false;
-        g_simulator.buses[i].noise_level = 0.01; // 1% noise by default
+        pthread_rwlock_init(&sim->buses[i].bus_lock, NULL);
+        sim->buses[i].device_count = 0;
+        sim->buses[i].bus_error = false;
+        sim->buses[i].noise_level = 0.01; // 1% noise by default
     }
 
     // Initialize MPU-6050 device states
     for (int i = 0; i < MAX_I2C_DEVICES; i++) {
-        pthread_mutex_init(&g_simulator.mpu6050_devices[i].mutex, NULL);
-        pthread_mutex_init(&g_simulator.mpu6050_devices[i].fifo.mutex, NULL);
-        g_simulator.mpu6050_devices[i].initialized = false;
+        pthread_mutex_init(&sim->mpu6050_devices[i].mutex, NULL);
+        pthread_mutex_init(&sim->mpu6050_devices[i].fifo.producer_lock, NULL);
+        sim->mpu6050_devices[i].initialized = false;
     }
-
-    // Record simulation start time
-    clock_gettime(CLOCK_MONOTONIC, &g_simulator.simulation_start);
-
-    // Start background simulation thread
-    g_simulator.running = true;
-    if (pthread_create(&g_simulator.background_thread, NULL, background_simulation_thread, NULL) != 0) {
+    metrics_reset(sim);
+    
+    // Event deadlines are sim_time_ns() values, so wait on the same clock
+    pthread_condattr_t cond_attr;
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&sim->event_cond, &cond_attr);
+    pthread_condattr_destroy(&cond_attr);
+    pthread_mutex_init(&sim->event_lock, NULL);
+
+    // Start background simulation thread; in virtual time the clock runs
+    // the devices whenever it advances
+    sim->running = true;
+    if (!g_clock.enabled &&
+        pthread_create(&sim->background_thread, NULL, background_simulation_thread, sim) != 0) {
         fprintf(stderr, "Failed to create background simulation thread\n");
         return -1;
     }
 
-    g_simulator_initialized = true;
+    sim->initialized = true;
+
+    pthread_mutex_lock(&g_simulators_lock);
+    sim->next = g_simulators;
+    g_simulators = sim;
+    pthread_mutex_unlock(&g_simulators_lock);
     
     if (g_debug_logging) {
         printf("[I2C_SIM] Simulator initialized successfully\n");
@@ -70,26 +167,45 @@ int i2c_simulator_init(void) {
     return 0;
 }
 
-void i2c_simulator_cleanup(void) {
-    if (!g_simulator_initialized) {
+static void simulator_stop(i2c_simulator_t* sim) {
+    if (!sim->initialized) {
         return;
     }
 
+    // Unlinked under the clock lock too, so an advance never sees it freed
+    pthread_mutex_lock(&g_clock.lock);
+    pthread_mutex_lock(&g_simulators_lock);
+    for (i2c_simulator_t** p = &g_simulators; *p; p = &(*p)->next) {
+        if (*p == sim) {
+            *p = sim->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g_simulators_lock);
+    pthread_mutex_unlock(&g_clock.lock);
+
     // Stop background thread
-    g_simulator.running = false;
-    pthread_join(g_simulator.background_thread, NULL);
+    pthread_mutex_lock(&sim->event_lock);
+    sim->running = false;
+    pthread_cond_signal(&sim->event_cond);
+    pthread_mutex_unlock(&sim->event_lock);
+    if (!g_clock.enabled) {
+        pthread_join(sim->background_thread, NULL);
+    }
+    pthread_cond_destroy(&sim->event_cond);
+    pthread_mutex_destroy(&sim->event_lock);
 
     // Cleanup mutexes
     for (int i = 0; i < I2C_BUS_COUNT; i++) {
-        pthread_mutex_destroy(&g_simulator.buses[i].bus_mutex);
+        pthread_rwlock_destroy(&sim->buses[i].bus_lock);
     }
 
     for (int i = 0; i < MAX_I2C_DEVICES; i++) {
-        pthread_mutex_destroy(&g_simulator.mpu6050_devices[i].mutex);
-        pthread_mutex_destroy(&g_simulator.mpu6050_devices[i].fifo.mutex);
+        pthread_mutex_destroy(&sim->mpu6050_devices[i].mutex);
+        pthread_mutex_destroy(&sim->mpu6050_devices[i].fifo.producer_lock);
     }
 
-    g_simulator_initialized = false;
+    sim->initialized = false;
 
     if (g_debug_logging) {
         printf("[I2C_SIM] Simulator cleanup completed\n");
@@ -97,49 +213,57 @@ void i2c_simulator_cleanup(void) {
 }
 
 int i2c_simulator_add_device(int bus, uint8_t address, const char* device_type) {
-    if (!g_simulator_initialized || bus < 0 || bus >= I2C_BUS_COUNT) {
+    i2c_simulator_t* sim = i2c_simulator_current();
+    if (!sim->initialized || bus < 0 || bus >= I2C_BUS_COUNT) {
         return -EINVAL;
     }
 
     acquire_bus_lock(bus);
 
     // Check if device already exists
-    if (find_device(bus, address) != NULL) {
+    i2c_bus_t* i2c_bus = &sim->buses[bus];
+    if (i2c_bus->lookup[address] != NULL) {
         release_bus_lock(bus);
         return -EEXIST;
     }
 
-    // Find free slot
-    i2c_bus_t* i2c_bus = &g_simulator.buses[bus];
-    if (i2c_bus->device_count >= MAX_I2C_DEVICES) {
+    // Find free slot, reusing those of removed devices first
+    int slot = 0;
+    while (slot < i2c_bus->device_count && i2c_bus->devices[slot].present) {
+        slot++;
+    }
+    if (slot >= MAX_I2C_DEVICES) {
         release_bus_lock(bus);
         return -ENOMEM;
     }
-
-    // Add device
-    int slot = i2c_bus->device_count++;
     i2c_device_t* device = &i2c_bus->devices[slot];
-    device->address = address;
-    device->present = true;
 
     // Initialize device based on type
     if (strcmp(device_type, "mpu6050") == 0) {
         int result = mpu6050_simulator_create(address);
         if (result < 0) {
-            i2c_bus->device_count--;
             release_bus_lock(bus);
             return result;
         }
-        device->device_data = &g_simulator.mpu6050_devices[address % MAX_I2C_DEVICES];
+        mpu6050_state_t* state = &sim->mpu6050_devices[address % MAX_I2C_DEVICES];
+        device->device_data = state;
+        device->lock = &state->mutex;
         device->read_register = mpu6050_read_register;
         device->write_register = mpu6050_write_register;
         device->read_burst = mpu6050_read_burst;
     } else {
-        i2c_bus->device_count--;
         release_bus_lock(bus);
         return -ENOTSUP;
     }
 
+    // Publish the device
+    device->address = address;
+    device->present = true;
+    i2c_bus->lookup[address] = device;
+    if (slot == i2c_bus->device_count) {
+        i2c_bus->device_count++;
+    }
+
     release_bus_lock(bus);
 
     if (g_debug_logging) {
@@ -151,21 +275,24 @@ int i2c_simulator_add_device(int bus, uint8_t address, const char* device_type)
 }
 
 int i2c_simulator_remove_device(int bus, uint8_t address) {
-    if (!g_simulator_initialized || bus < 0 || bus >= I2C_BUS_COUNT) {
+    i2c_simulator_t* sim = i2c_simulator_current();
+    if (!sim->initialized || bus < 0 || bus >= I2C_BUS_COUNT) {
         return -EINVAL;
     }
 
     acquire_bus_lock(bus);
 
-    i2c_device_t* device = find_device(bus, address);
+    i2c_device_t* device = sim->buses[bus].lookup[address];
     if (device == NULL) {
         release_bus_lock(bus);
         return -ENODEV;
     }
 
-    // Mark device as not present
+    // Mark device as not present, freeing its slot
+    sim->buses[bus].lookup[address] = NULL;
     device->present = false;
     device->device_data = NULL;
+    device->lock = NULL;
 
     // Cleanup MPU-6050 state if applicable
     mpu6050_simulator_destroy(address);
@@ -180,24 +307,20 @@ int i2c_simulator_remove_device(int bus, uint8_t address) {
 }
 
 int i2c_simulator_read_byte(int bus, uint8_t device_addr, uint8_t reg_addr, uint8_t* data) {
-    if (!g_simulator_initialized || data == NULL) {
+    i2c_simulator_t* sim = i2c_simulator_current();
+    if (!sim->initialized || data == NULL) {
         return -EINVAL;
     }
 
-    struct timespec start, end;
-    clock_gettime(CLOCK_MONOTONIC, &start);
+    uint64_t start = sim_time_ns();
 
     simulate_processing_delay();
     simulate_bus_conditions(bus);
 
-    acquire_bus_lock(bus);
-
-    i2c_device_t* device = find_device(bus, device_addr);
-    if (device == NULL || !device->present) {
-        release_bus_lock(bus);
-        clock_gettime(CLOCK_MONOTONIC, &end);
-        update_performance_metrics(&start, &end, true);
-        g_simulator.metrics.errors_injected++;
+    i2c_device_t* device = get_device(bus, device_addr);
+    if (device == NULL) {
+        update_performance_metrics(start, settle_delays(), true);
+        metrics_add(&metrics_shard()->errors_injected, 1);
         return -ENODEV;
     }
 
@@ -206,11 +329,10 @@ int i2c_simulator_read_byte(int bus, uint8_t device_addr, uint8_t reg_addr, uint
         result = device->read_register(device->device_data, reg_addr, data);
     }
 
-    g_simulator.metrics.total_reads++;
-    release_bus_lock(bus);
+    put_device(bus, device);
+    metrics_add(&metrics_shard()->total_reads, 1);
 
-    clock_gettime(CLOCK_MONOTONIC, &end);
-    update_performance_metrics(&start, &end, result < 0);
+    update_performance_metrics(start, settle_delays(), result < 0);
 
     if (g_debug_logging && result >= 0) {
         printf("[I2C_SIM] Read: bus=%d, addr=0x%02X, reg=0x%02X, data=0x%02X\n", 
@@ -221,24 +343,20 @@ int i2c_simulator_read_byte(int bus, uint8_t device_addr, uint8_t reg_addr, uint
 }
 
 int i2c_simulator_write_byte(int bus, uint8_t device_addr, uint8_t reg_addr, uint8_t data) {
-    if (!g_simulator_initialized) {
+    i2c_simulator_t* sim = i2c_simulator_current();
+    if (!sim->initialized) {
         return -EINVAL;
     }
 
-    struct timespec start, end;
-    clock_gettime(CLOCK_MONOTONIC, &start);
+    uint64_t start = sim_time_ns();
 
     simulate_processing_delay();
     simulate_bus_conditions(bus);
 
-    acquire_bus_lock(bus);
-
-    i2c_device_t* device = find_device(bus, device_addr);
-    if (device == NULL || !device->present) {
-        release_bus_lock(bus);
-        clock_gettime(CLOCK_MONOTONIC, &end);
-        update_performance_metrics(&start, &end, true);
-        g_simulator.metrics.errors_injected++;
+    i2c_device_t* device = get_device(bus, device_addr);
+    if (device == NULL) {
+        update_performance_metrics(start, settle_delays(), true);
+        metrics_add(&metrics_shard()->errors_injected, 1);
         return -ENODEV;
     }
 
@@ -247,11 +365,10 @@ int i2c_simulator_write_byte(int bus, uint8_t device_addr, uint8_t reg_addr, uin
         result = device->write_register(device->device_data, reg_addr, data);
     }
 
-    g_simulator.metrics.total_writes++;
-    release_bus_lock(bus);
+    put_device(bus, device);
+    metrics_add(&metrics_shard()->total_writes, 1);
 
-    clock_gettime(CLOCK_MONOTONIC, &end);
-    update_performance_metrics(&start, &end, result < 0);
+    update_performance_metrics(start, settle_delays(), result < 0);
 
     if (g_debug_logging && result >= 0) {
         printf("[I2C_SIM] Write: bus=%d, addr=0x%02X, reg=0x%02X, data=0x%02X\n", 
@@ -262,24 +379,26 @@ int i2c_simulator_write_byte(int bus, uint8_t device_addr, uint8_t reg_addr, uin
 }
 
 int i2c_simulator_read_burst(int bus, uint8_t device_addr, uint8_t reg_addr, uint8_t* data, size_t len) {
-    if (!g_simulator_initialized || data == NULL || len == 0) {
+    i2c_simulator_t* sim = i2c_simulator_current();
+    if (!sim->initialized || data == NULL || len == 0) {
         return -EINVAL;
     }
+    
+    // SMBus-only adapters cannot read more than one block per transaction
+    if (bus >= 0 && bus < I2C_BUS_COUNT && sim->buses[bus].smbus_only &&
+        len > I2C_SMBUS_BLOCK_MAX) {
+        return -EOPNOTSUPP;
+    }
 
-    struct timespec start, end;
-    clock_gettime(CLOCK_MONOTONIC, &start);
+    uint64_t start = sim_time_ns();
 
     simulate_processing_delay();
     simulate_bus_conditions(bus);
 
-    acquire_bus_lock(bus);
-
-    i2c_device_t* device = find_device(bus, device_addr);
-    if (device == NULL || !device->present) {
-        release_bus_lock(bus);
-        clock_gettime(CLOCK_MONOTONIC, &end);
-        update_performance_metrics(&start, &end, true);
-        g_simulator.metrics.errors_injected++;
+    i2c_device_t* device = get_device(bus, device_addr);
+    if (device == NULL) {
+        update_performance_metrics(start, settle_delays(), true);
+        metrics_add(&metrics_shard()->errors_injected, 1);
         return -ENODEV;
     }
 
@@ -298,11 +417,10 @@ int i2c_simulator_read_burst(int bus, uint8_t device_addr, uint8_t reg_addr, uin
         }
     }
 
-    g_simulator.metrics.total_reads += len;
-    release_bus_lock(bus);
+    put_device(bus, device);
+    metrics_add(&metrics_shard()->total_reads, len);
 
-    clock_gettime(CLOCK_MONOTONIC, &end);
-    update_performance_metrics(&start, &end, result < 0);
+    update_performance_metrics(start, settle_delays(), result < 0);
 
     if (g_debug_logging && result >= 0) {
         printf("[I2C_SIM] Burst read: bus=%d, addr=0x%02X, reg=0x%02X, len=%zu\n", 
@@ -313,24 +431,20 @@ int i2c_simulator_read_burst(int bus, uint8_t device_addr, uint8_t reg_addr, uin
 }
 
 int i2c_simulator_write_burst(int bus, uint8_t device_addr, uint8_t reg_addr, const uint8_t* data, size_t len) {
-    if (!g_simulator_initialized || data == NULL || len == 0) {
+    i2c_simulator_t* sim = i2c_simulator_current();
+    if (!sim->initialized || data == NULL || len == 0) {
         return -EINVAL;
     }
 
-    struct timespec start, end;
-    clock_gettime(CLOCK_MONOTONIC, &start);
+    uint64_t start = sim_time_ns();
 
     simulate_processing_delay();
     simulate_bus_conditions(bus);
 
-    acquire_bus_lock(bus);
-
-    i2c_device_t* device = find_device(bus, device_addr);
-    if (device == NULL || !device->present) {
-        release_bus_lock(bus);
-        clock_gettime(CLOCK_MONOTONIC, &end);
-        update_performance_metrics(&start, &end, true);
-        g_simulator.metrics.errors_injected++;
+    i2c_device_t* device = get_device(bus, device_addr);
+    if (device == NULL) {
+        update_performance_metrics(start, settle_delays(), true);
+        metrics_add(&metrics_shard()->errors_injected, 1);
         return -ENODEV;
     }
 
@@ -347,11 +461,10 @@ int i2c_simulator_write_burst(int bus, uint8_t device_addr, uint8_t reg_addr, co
         }
     }
 
-    g_simulator.metrics.total_writes += len;
-    release_bus_lock(bus);
+    put_device(bus, device);
+    metrics_add(&metrics_shard()->total_writes, len);
 
-    clock_gettime(CLOCK_MONOTONIC, &end);
-    update_performance_metrics(&start, &end, result < 0);
+    update_performance_metrics(start, settle_delays(), result < 0);
 
     if (g_debug_logging && result >= 0) {
         printf("[I2C_SIM] Burst write: bus=%d, addr=0x%02X, reg=0x%02X, len=%zu\n", 
@@ -362,18 +475,76 @@ int i2c_simulator_write_burst(int bus, uint8_t device_addr, uint8_t reg_addr, co
 }
 
 void reset_performance_metrics(void) {
-    memset(&g_simulator.metrics, 0, sizeof(performance_metrics_t));
-    g_simulator.metrics.min_response_time_us = UINT32_MAX;
-    clock_gettime(CLOCK_MONOTONIC, &g_simulator.simulation_start);
+    metrics_reset(i2c_simulator_current());
+}
+
+// Also restarts the simulation time the report divides by
+static void metrics_reset(i2c_simulator_t* sim) {
+    // Racing transactions may land on either side of the reset
+    for (int i = 0; i < SIM_METRICS_SHARDS; i++) {
+        sim_metrics_shard_t* shard = &sim->metrics[i];
+        __atomic_store_n(&shard->total_reads, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&shard->total_writes, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&shard->errors_injected, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&shard->timeouts, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&shard->max_response_time_us, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&shard->min_response_time_us, UINT32_MAX, __ATOMIC_RELAXED);
+        __atomic_store_n(&shard->responses, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&shard->response_time_us, 0, __ATOMIC_RELAXED);
+        for (int bus = 0; bus < I2C_BUS_COUNT; bus++) {
+            __atomic_store_n(&shard->transactions[bus], 0, __ATOMIC_RELAXED);
+        }
+    }
+    sim->simulation_start_ns = sim_time_ns();
 }
 
 performance_metrics_t get_performance_metrics(void) {
-    return g_simulator.metrics;
+    i2c_simulator_t* sim = i2c_simulator_current();
+    performance_metrics_t m = {0};
+    uint64_t response_time_us = 0;
+    uint32_t responses = 0;
+
+    m.min_response_time_us = UINT32_MAX;
+    for (int i = 0; i < SIM_METRICS_SHARDS; i++) {
+        sim_metrics_shard_t* shard = &sim->metrics[i];
+        uint32_t min = __atomic_load_n(&shard->min_response_time_us, __ATOMIC_RELAXED);
+        uint32_t max = __atomic_load_n(&shard->max_response_time_us, __ATOMIC_RELAXED);
+
+        m.total_reads += __atomic_load_n(&shard->total_reads, __ATOMIC_RELAXED);
+        m.total_writes += __atomic_load_n(&shard->total_writes, __ATOMIC_RELAXED);
+        m.errors_injected += __atomic_load_n(&shard->errors_injected, __ATOMIC_RELAXED);
+        m.timeouts += __atomic_load_n(&shard->timeouts, __ATOMIC_RELAXED);
+        responses += __atomic_load_n(&shard->responses, __ATOMIC_RELAXED);
+        response_time_us += __atomic_load_n(&shard->response_time_us, __ATOMIC_RELAXED);
+        if (min < m.min_response_time_us) {
+            m.min_response_time_us = min;
+        }
+        if (max > m.max_response_time_us) {
+            m.max_response_time_us = max;
+        }
+    }
+
+    if (responses > 0) {
+        m.avg_response_time_us = (double)response_time_us / responses;
+    } else {
+        m.min_response_time_us = 0;
+    }
+    return m;
 }
 
 void print_performance_report(void) {
-    performance_metrics_t* m = &g_simulator.metrics;
+    i2c_simulator_t* sim = i2c_simulator_current();
+    performance_metrics_t metrics = get_performance_metrics();
+    performance_metrics_t* m = &metrics;
     double sim_time = get_simulation_time_ms();
+    uint32_t transactions[I2C_BUS_COUNT] = {0};
+
+    for (int i = 0; i < SIM_METRICS_SHARDS; i++) {
+        for (int bus = 0; bus < I2C_BUS_COUNT; bus++) {
+            transactions[bus] += __atomic_load_n(&sim->metrics[i].transactions[bus],
+                                                 __ATOMIC_RELAXED);
+        }
+    }
     
     printf("\n=== I2C Simulator Performance Report ===\n");
     printf("Simulation time: %.2f ms\n", sim_time);
@@ -384,6 +555,9 @@ void print_performance_report(void) {
     printf("Average response time: %.2f µs\n", m->avg_response_time_us);
     printf("Min response time: %u µs\n", m->min_response_time_us);
     printf("Max response time: %u µs\n", m->max_response_time_us);
+    for (int bus = 0; bus < I2C_BUS_COUNT; bus++) {
+        printf("Bus %d transactions: %u\n", bus, transactions[bus]);
+    }
     
     if (m->total_reads + m->total_writes > 0) {
         double error_rate = (double)m->errors_injected / (m->total_reads + m->total_writes) * 100.0;
@@ -394,17 +568,29 @@ void print_performance_report(void) {
     printf("=====================================\n\n");
 }
 
+int set_bus_smbus_only(int bus, bool smbus_only) {
+    i2c_simulator_t* sim = i2c_simulator_current();
+    if (bus < 0 || bus >= I2C_BUS_COUNT) {
+        return -EINVAL;
+    }
+    
+    sim->buses[bus].smbus_only = smbus_only;
+    return 0;
+}
+
 int set_bus_noise_level(int bus, double noise_level) {
+    i2c_simulator_t* sim = i2c_simulator_current();
     if (bus < 0 || bus >= I2C_BUS_COUNT || noise_level < 0.0 || noise_level > 1.0) {
         return -EINVAL;
     }
     
-    g_simulator.buses[bus].noise_level = noise_level;
+    sim->buses[bus].noise_level = noise_level;
     return 0;
 }
 
 int set_global_latency(uint32_t latency_us) {
-    g_global_latency_us = latency_us;
+    i2c_simulator_t* sim = i2c_simulator_current();
+    sim->latency_us = latency_us;
     return 0;
 }
 
@@ -414,51 +600,143 @@ int enable_debug_logging(bool enable) {
 }
 
 double get_simulation_time_ms(void) {
+    i2c_simulator_t* sim = i2c_simulator_current();
+    return (sim_time_ns() - sim->simulation_start_ns) / 1e6;
+}
+
+uint32_t generate_realistic_timestamp(void) {
+    return (uint32_t)(sim_time_ns() / 1000000);
+}
+
+void simulate_processing_delay(void) {
+    i2c_simulator_t* sim = i2c_simulator_current();
+    if (sim->latency_us > 0) {
+        sim_delay_us(sim->latency_us);
+    }
+}
+
+int i2c_simulator_set_virtual_time(bool enable) {
+    if (__atomic_load_n(&g_simulators, __ATOMIC_RELAXED) != NULL) {
+        return -EBUSY;
+    }
+    
+    pthread_once(&g_clock_once, clock_key_init);
+    g_clock.enabled = enable;
+    __atomic_store_n(&g_clock.now_ns, 0, __ATOMIC_RELEASE);
+    return 0;
+}
+
+bool i2c_simulator_virtual_time(void) {
+    return g_clock.enabled;
+}
+
+uint64_t sim_time_ns(void) {
+    if (g_clock.enabled) {
+        return __atomic_load_n(&g_clock.now_ns, __ATOMIC_ACQUIRE);
+    }
+    
     struct timespec now;
     clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+void sim_sleep_us(uint64_t us) {
+    if (!g_clock.enabled) {
+        usleep(us);
+        return;
+    }
     
-    double elapsed_sec = (now.tv_sec - g_simulator.simulation_start.tv_sec) + 
-                        (now.tv_nsec - g_simulator.simulation_start.tv_nsec) / 1e9;
-    return elapsed_sec * 1000.0;
+    // Delays charged by earlier transactions are served first
+    us += t_pending_delay_us;
+    t_pending_delay_us = 0;
+    
+    pthread_mutex_lock(&g_clock.lock);
+    int slot = clock_attach_locked();
+    if (slot >= 0) {
+        g_clock.wakeup_ns[slot] = g_clock.now_ns + us * 1000;
+        g_clock.sleeping |= 1ULL << slot;
+        clock_advance_locked();
+        while (g_clock.sleeping & (1ULL << slot)) {
+            pthread_cond_wait(&g_clock.advanced, &g_clock.lock);
+        }
+    }
+    pthread_mutex_unlock(&g_clock.lock);
 }
 
-uint32_t generate_realistic_timestamp(void) {
-    struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+// Transactions run with the device locked, where waiting on the virtual
+// clock could stall the threads queued behind them. Their time is charged
+// here and served once the locks are dropped.
+void sim_delay_us(uint64_t us) {
+    if (g_clock.enabled) {
+        t_pending_delay_us += us;
+    } else {
+        usleep(us);
+    }
 }
 
-void simulate_processing_delay(void) {
-    if (g_global_latency_us > 0) {
-        usleep(g_global_latency_us);
+int sim_thread_join(pthread_t thread, void** retval) {
+    int slot = t_clock_slot;
+    
+    // Stop counting for the clock, or the thread joined never gets to run
+    if (slot >= 0) {
+        pthread_setspecific(g_clock.thread_key, NULL);
+        clock_release_slot((void*)(intptr_t)(slot + 1));
+    }
+    
+    int result = pthread_join(thread, retval);
+    
+    if (slot >= 0) {
+        pthread_mutex_lock(&g_clock.lock);
+        clock_attach_locked();
+        pthread_mutex_unlock(&g_clock.lock);
     }
+    return result;
 }
 
 bool should_inject_error(double probability) {
     if (probability <= 0.0) return false;
     if (probability >= 1.0) return true;
     
-    return (rand() / (double)RAND_MAX) < probability;
+    return (sim_rand() / (double)SIM_RAND_MAX) < probability;
+}
+
+uint32_t sim_rand(void) {
+    // xorshift32 per thread: rand() takes a process-wide lock
+    uint32_t x = t_rand_state;
+    if (x == 0) {
+        uint32_t seed = __atomic_add_fetch(&g_next_seed, 1, __ATOMIC_RELAXED);
+        x = seed * 0x9E3779B9u;
+    }
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    t_rand_state = x;
+    return x;
 }
 
 int acquire_device_lock(uint8_t address) {
+    i2c_simulator_t* sim = i2c_simulator_current();
     int index = address % MAX_I2C_DEVICES;
-    return pthread_mutex_lock(&g_simulator.mpu6050_devices[index].mutex);
+    return pthread_mutex_lock(&sim->mpu6050_devices[index].mutex);
 }
 
 int release_device_lock(uint8_t address) {
+    i2c_simulator_t* sim = i2c_simulator_current();
     int index = address % MAX_I2C_DEVICES;
-    return pthread_mutex_unlock(&g_simulator.mpu6050_devices[index].mutex);
+    return pthread_mutex_unlock(&sim->mpu6050_devices[index].mutex);
 }
 
+// Exclusive bus access, waiting out all transactions in flight
 int acquire_bus_lock(int bus) {
+    i2c_simulator_t* sim = i2c_simulator_current();
     if (bus < 0 || bus >= I2C_BUS_COUNT) return -EINVAL;
-    return pthread_mutex_lock(&g_simulator.buses[bus].bus_mutex);
+    return pthread_rwlock_wrlock(&sim->buses[bus].bus_lock);
 }
 
 int release_bus_lock(int bus) {
+    i2c_simulator_t* sim = i2c_simulator_current();
     if (bus < 0 || bus >= I2C_BUS_COUNT) return -EINVAL;
-    return pthread_mutex_unlock(&g_simulator.buses[bus].bus_mutex);
+    return pthread_rwlock_unlock(&sim->buses[bus].bus_lock);
 }
 
 const char* error_type_to_string(error_type_t error) {
@@ -495,74 +773,276 @@ const char* power_state_to_string(power_state_t state) {
 
 // Private helper functions
 
+// Sleeps until the earliest sample event of @sim, or until one is queued,
+// so the thread costs nothing while no device streams
 static void* background_simulation_thread(void* arg) {
-    (void)arg; // Unused parameter
-    
-    while (g_simulator.running) {
-        // Update all active MPU-6050 devices
-        for (int i = 0; i < MAX_I2C_DEVICES; i++) {
-            if (g_simulator.mpu6050_devices[i].initialized) {
-                // This will be implemented in mpu6050_virtual.c
-                // mpu6050_update_background(&g_simulator.mpu6050_devices[i]);
-            }
+    i2c_simulator_t* sim = arg;
+    
+    pthread_mutex_lock(&sim->event_lock);
+    while (sim->running) {
+        if (sim->event_count == 0) {
+            pthread_cond_wait(&sim->event_cond, &sim->event_lock);
+            continue;
         }
         
-        // Sleep for 10ms (100Hz update rate)
-        usleep(10000);
+        uint64_t due_ns = sim->events[0].due_ns;
+        uint64_t now_ns = sim_time_ns();
+        if (due_ns > now_ns) {
+            struct timespec deadline = {
+                .tv_sec = (time_t)(due_ns / 1000000000ULL),
+                .tv_nsec = (long)(due_ns % 1000000000ULL),
+            };
+            pthread_cond_timedwait(&sim->event_cond, &sim->event_lock, &deadline);
+            continue;
+        }
+        
+        pthread_mutex_unlock(&sim->event_lock);
+        run_due_events(sim, now_ns);
+        pthread_mutex_lock(&sim->event_lock);
     }
+    pthread_mutex_unlock(&sim->event_lock);
     
     return NULL;
 }
 
-static void update_performance_metrics(struct timespec* start, struct timespec* end, bool error) {
-    uint32_t elapsed_us = (uint32_t)((end->tv_sec - start->tv_sec) * 1000000 + 
-                                    (end->tv_nsec - start->tv_nsec) / 1000);
+void mpu6050_schedule(mpu6050_state_t* state) {
+    i2c_simulator_t* sim = i2c_simulator_current();
+    ptrdiff_t device = state - sim->mpu6050_devices;
+    if (device < 0 || device >= MAX_I2C_DEVICES) {
+        return;
+    }
     
-    // Update average response time
-    uint32_t total_ops = g_simulator.metrics.total_reads + g_simulator.metrics.total_writes;
-    if (total_ops == 0) {
-        g_simulator.metrics.avg_response_time_us = elapsed_us;
-    } else {
-        g_simulator.metrics.avg_response_time_us = 
-            (g_simulator.metrics.avg_response_time_us * total_ops + elapsed_us) / (total_ops + 1);
+    // Due now: the generator works out whether and how fast it streams
+    pthread_mutex_lock(&sim->event_lock);
+    event_schedule_locked(sim, (int)device, sim_time_ns());
+    pthread_mutex_unlock(&sim->event_lock);
+}
+
+// Generate the samples of every device due by @now_ns and queue each one's
+// next event; devices that stopped streaming drop out
+static void run_due_events(i2c_simulator_t* sim, uint64_t now_ns) {
+    pthread_mutex_lock(&sim->event_lock);
+    while (sim->event_count > 0 && sim->events[0].due_ns <= now_ns) {
+        int device = sim->events[0].device;
+        event_pop_locked(sim);
+        
+        // Without the event lock, so transactions can reschedule meanwhile
+        pthread_mutex_unlock(&sim->event_lock);
+        uint64_t next_ns = mpu6050_update_background(&sim->mpu6050_devices[device], now_ns);
+        pthread_mutex_lock(&sim->event_lock);
+        
+        if (next_ns != UINT64_MAX) {
+            event_schedule_locked(sim, device, next_ns);
+        }
     }
+    pthread_mutex_unlock(&sim->event_lock);
+}
+
+// Queue @device for @due_ns, or move its event up if already queued later
+static void event_schedule_locked(i2c_simulator_t* sim, int device, uint64_t due_ns) {
+    int pos = sim->event_pos[device] - 1;
     
-    // Update min/max
-    if (elapsed_us < g_simulator.metrics.min_response_time_us) {
-        g_simulator.metrics.min_response_time_us = elapsed_us;
+    if (pos < 0) {
+        pos = sim->event_count++;
+    } else if (sim->events[pos].due_ns <= due_ns) {
+        return;
     }
-    if (elapsed_us > g_simulator.metrics.max_response_time_us) {
-        g_simulator.metrics.max_response_time_us = elapsed_us;
+    
+    // Sift up
+    sim_event_t event = { .due_ns = due_ns, .device = (uint16_t)device };
+    while (pos > 0 && sim->events[(pos - 1) / 2].due_ns > due_ns) {
+        event_move_locked(sim, pos, sim->events[(pos - 1) / 2]);
+        pos = (pos - 1) / 2;
+    }
+    event_move_locked(sim, pos, event);
+    
+    if (pos == 0) {
+        pthread_cond_signal(&sim->event_cond);
+    }
+}
+
+// Remove the earliest event
+static void event_pop_locked(i2c_simulator_t* sim) {
+    sim->event_pos[sim->events[0].device] = 0;
+    sim_event_t last = sim->events[--sim->event_count];
+    if (sim->event_count == 0) {
+        return;
+    }
+    
+    // Sift the last event down from the root
+    int pos = 0;
+    for (;;) {
+        int child = 2 * pos + 1;
+        if (child >= sim->event_count) {
+            break;
+        }
+        if (child + 1 < sim->event_count &&
+            sim->events[child + 1].due_ns < sim->events[child].due_ns) {
+            child++;
+        }
+        if (sim->events[child].due_ns >= last.due_ns) {
+            break;
+        }
+        event_move_locked(sim, pos, sim->events[child]);
+        pos = child;
+    }
+    event_move_locked(sim, pos, last);
+}
+
+static void event_move_locked(i2c_simulator_t* sim, int pos, sim_event_t event) {
+    sim->events[pos] = event;
+    sim->event_pos[event.device] = (uint16_t)(pos + 1);
+}
+
+static void clock_key_init(void) {
+    pthread_key_create(&g_clock.thread_key, clock_release_slot);
+}
+
+// Count the calling thread for the clock; Returns its slot, or -1 if all
+// are taken
+static int clock_attach_locked(void) {
+    if (t_clock_slot < 0) {
+        uint64_t free = ~g_clock.participants;
+        if (free == 0) {
+            return -1;
+        }
+        t_clock_slot = __builtin_ctzll(free);
+        g_clock.participants |= 1ULL << t_clock_slot;
+        pthread_setspecific(g_clock.thread_key, (void*)(intptr_t)(t_clock_slot + 1));
+    }
+    return t_clock_slot;
+}
+
+// Thread exit destructor, also used by sim_thread_join()
+static void clock_release_slot(void* slot) {
+    int index = (int)(intptr_t)slot - 1;
+    
+    pthread_mutex_lock(&g_clock.lock);
+    g_clock.participants &= ~(1ULL << index);
+    t_clock_slot = -1;
+    clock_advance_locked();
+    pthread_mutex_unlock(&g_clock.lock);
+}
+
+// Once every participant sleeps, jump to the earliest wakeup, let the
+// devices generate their samples up to it and release the threads due
+static void clock_advance_locked(void) {
+    if (g_clock.participants == 0 || g_clock.sleeping != g_clock.participants) {
+        return;
+    }
+    
+    uint64_t next = UINT64_MAX;
+    for (uint64_t s = g_clock.sleeping; s; s &= s - 1) {
+        int slot = __builtin_ctzll(s);
+        if (g_clock.wakeup_ns[slot] < next) {
+            next = g_clock.wakeup_ns[slot];
+        }
+    }
+    if (next > g_clock.now_ns) {
+        // Catch up first, so that devices started since the last jump
+        // stream from now rather than from the wakeup
+        pthread_mutex_lock(&g_simulators_lock);
+        for (i2c_simulator_t* sim = g_simulators; sim; sim = sim->next) {
+            run_due_events(sim, g_clock.now_ns);
+        }
+        __atomic_store_n(&g_clock.now_ns, next, __ATOMIC_RELEASE);
+        for (i2c_simulator_t* sim = g_simulators; sim; sim = sim->next) {
+            run_due_events(sim, next);
+        }
+        pthread_mutex_unlock(&g_simulators_lock);
+    }
+    
+    for (uint64_t s = g_clock.sleeping; s; s &= s - 1) {
+        int slot = __builtin_ctzll(s);
+        if (g_clock.wakeup_ns[slot] <= next) {
+            g_clock.sleeping &= ~(1ULL << slot);
+        }
+    }
+    pthread_cond_broadcast(&g_clock.advanced);
+}
+
+// Serve the delays charged during a transaction; Returns the time it ended
+static uint64_t settle_delays(void) {
+    if (t_pending_delay_us > 0) {
+        sim_sleep_us(0);
+    }
+    return sim_time_ns();
+}
+
+static void update_performance_metrics(uint64_t start_ns, uint64_t end_ns, bool error) {
+    uint32_t elapsed_us = (uint32_t)((end_ns - start_ns) / 1000);
+    
+    sim_metrics_shard_t* shard = metrics_shard();
+    
+    // Accumulate for the average response time
+    metrics_add(&shard->responses, 1);
+    __atomic_fetch_add(&shard->response_time_us, elapsed_us, __ATOMIC_RELAXED);
+    
+    // Update min/max, racing only threads that share the shard
+    uint32_t min = __atomic_load_n(&shard->min_response_time_us, __ATOMIC_RELAXED);
+    while (elapsed_us < min &&
+           !__atomic_compare_exchange_n(&shard->min_response_time_us, &min, elapsed_us,
+                                        true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+    uint32_t max = __atomic_load_n(&shard->max_response_time_us, __ATOMIC_RELAXED);
+    while (elapsed_us > max &&
+           !__atomic_compare_exchange_n(&shard->max_response_time_us, &max, elapsed_us,
+                                        true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
     }
     
     if (error) {
-        g_simulator.metrics.errors_injected++;
+        metrics_add(&shard->errors_injected, 1);
     }
 }
 
-static i2c_device_t* find_device(int bus, uint8_t address) {
+static sim_metrics_shard_t* metrics_shard(void) {
+    i2c_simulator_t* sim = i2c_simulator_current();
+    if (t_shard < 0) {
+        t_shard = __atomic_fetch_add(&g_next_shard, 1, __ATOMIC_RELAXED) % SIM_METRICS_SHARDS;
+    }
+    return &sim->metrics[t_shard];
+}
+
+static void metrics_add(uint32_t* counter, uint32_t n) {
+    __atomic_fetch_add(counter, n, __ATOMIC_RELAXED);
+}
+
+// Look up a device for one transaction. On success the bus stays read-locked
+// and the device locked until put_device().
+static i2c_device_t* get_device(int bus, uint8_t address) {
+    i2c_simulator_t* sim = i2c_simulator_current();
     if (bus < 0 || bus >= I2C_BUS_COUNT) return NULL;
     
-    i2c_bus_t* i2c_bus = &g_simulator.buses[bus];
-    for (int i = 0; i < i2c_bus->device_count; i++) {
-        if (i2c_bus->devices[i].address == address && i2c_bus->devices[i].present) {
-            return &i2c_bus->devices[i];
-        }
+    i2c_bus_t* i2c_bus = &sim->buses[bus];
+    pthread_rwlock_rdlock(&i2c_bus->bus_lock);
+    
+    i2c_device_t* device = i2c_bus->lookup[address];
+    if (device == NULL) {
+        pthread_rwlock_unlock(&i2c_bus->bus_lock);
+        return NULL;
     }
-    return NULL;
+    pthread_mutex_lock(device->lock);
+    return device;
+}
+
+static void put_device(int bus, i2c_device_t* device) {
+    i2c_simulator_t* sim = i2c_simulator_current();
+    pthread_mutex_unlock(device->lock);
+    pthread_rwlock_unlock(&sim->buses[bus].bus_lock);
 }
 
 static void simulate_bus_conditions(int bus) {
+    i2c_simulator_t* sim = i2c_simulator_current();
     if (bus < 0 || bus >= I2C_BUS_COUNT) return;
     
-    i2c_bus_t* i2c_bus = &g_simulator.buses[bus];
+    i2c_bus_t* i2c_bus = &sim->buses[bus];
     
     // Simulate bus noise by occasionally injecting small delays
     if (i2c_bus->noise_level > 0.0) {
         if (should_inject_error(i2c_bus->noise_level)) {
-            usleep(rand() % 50); // 0-50µs random noise delay
+            sim_delay_us(sim_rand() % 50); // 0-50µs random noise delay
         }
     }
     
-    i2c_bus->transaction_count++;
+    metrics_add(&metrics_shard()->transactions[bus], 1);
 }
\ No newline at end of file
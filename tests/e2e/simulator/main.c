@@ -32,6 +32,7 @@ static void print_usage(const char* program_name) {
     printf("  -c, --continuous    Run continuous testing until interrupted\n");
     printf("  -n, --noise LEVEL   Set bus noise level (0.0-1.0)\n");
     printf("  -d, --delay US      Set global I2C delay in microseconds\n");
+    printf("  -t, --virtual-time  Run on a virtual clock that skips idle time\n");
     printf("\nTest Scenarios:\n");
     printf("  normal_operation    - Basic MPU-6050 functionality\n");
     printf("  fifo_operation      - FIFO buffer testing\n");
@@ -45,6 +46,7 @@ static void print_usage(const char* program_name) {
     printf("  %s -s stress_test       # Run specific scenario\n", program_name);
     printf("  %s -b                   # Run benchmarks\n", program_name);
     printf("  %s -c                   # Continuous testing\n", program_name);
+    printf("  %s -t                   # Run all tests in virtual time\n", program_name);
 }
 
 static void list_scenarios(void) {
@@ -66,6 +68,77 @@ static void list_scenarios(void) {
     printf("14. stress_test        - Combined high-load with error injection\n");
 }
 
+// Parallel burst read benchmark: one thread per device
+#define PARALLEL_MAX_DEVICES 16
+#define PARALLEL_FIRST_ADDR  0x10
+
+typedef struct {
+    int bus;
+    uint8_t address;
+    int iterations;
+    int failures;
+} burst_thread_params_t;
+
+static void* burst_read_thread(void* arg) {
+    burst_thread_params_t* params = (burst_thread_params_t*)arg;
+    
+    for (int i = 0; i < params->iterations; i++) {
+        uint8_t data[14];
+        if (i2c_simulator_read_burst(params->bus, params->address, MPU6050_ACCEL_XOUT_H,
+                                     data, sizeof(data)) != 0) {
+            params->failures++;
+        }
+    }
+    return NULL;
+}
+
+static void run_parallel_burst_benchmark(int bus) {
+    const int iterations = 5000;
+    burst_thread_params_t params[PARALLEL_MAX_DEVICES];
+    pthread_t threads[PARALLEL_MAX_DEVICES];
+    double single = 0.0;
+    
+    for (int i = 0; i < PARALLEL_MAX_DEVICES; i++) {
+        uint8_t address = PARALLEL_FIRST_ADDR + i;
+        i2c_simulator_add_device(bus, address, "mpu6050");
+        mpu6050_simulator_set_pattern(address, PATTERN_STATIC);
+        mpu6050_set_power_state(address, POWER_ON);
+    }
+    
+    set_bus_noise_level(bus, 0.0);
+    for (int count = 1; count <= PARALLEL_MAX_DEVICES; count *= 2) {
+        struct timespec start, end;
+        int failures = 0;
+        
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int i = 0; i < count; i++) {
+            params[i] = (burst_thread_params_t){
+                .bus = bus,
+                .address = PARALLEL_FIRST_ADDR + i,
+                .iterations = iterations,
+            };
+            pthread_create(&threads[i], NULL, burst_read_thread, &params[i]);
+        }
+        for (int i = 0; i < count; i++) {
+            sim_thread_join(threads[i], NULL);
+            failures += params[i].failures;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        
+        double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+        double rate = count * iterations / elapsed;
+        if (count == 1) {
+            single = rate;
+        }
+        printf("  %2d threads: %.0f burst reads/second (%.2fx), %d failures\n",
+               count, rate, rate / single, failures);
+    }
+    
+    for (int i = 0; i < PARALLEL_MAX_DEVICES; i++) {
+        i2c_simulator_remove_device(bus, PARALLEL_FIRST_ADDR + i);
+    }
+}
+
 static int run_benchmark(void) {
     printf("\n=== Performance Benchmarks ===\n");
     
@@ -155,7 +228,7 @@ static int run_benchmark(void) {
     clock_gettime(CLOCK_MONOTONIC, &start);
     
     // Let FIFO fill up
-    usleep(100000); // 100ms
+    sim_sleep_us(100000); // 100ms
     
     const int fifo_reads = 1000;
     for (int i = 0; i < fifo_reads; i++) {
@@ -172,6 +245,11 @@ static int run_benchmark(void) {
     printf("  %d FIFO operations in %.3f seconds\n", fifo_reads, elapsed);
     printf("  Throughput: %.0f FIFO ops/second\n", fifo_reads / elapsed);
     
+    // Benchmark 5: Burst reads from one thread per device
+    printf("\nBenchmark 5: Parallel Burst Reads (one device per thread)\n");
+    reset_performance_metrics();
+    run_parallel_burst_benchmark(bus);
+    
     print_performance_report();
     
     i2c_simulator_remove_device(bus, device_addr);
@@ -234,7 +312,7 @@ static int run_quick_test(void) {
     
     printf("\nTest 4: FIFO Functionality\n");
     mpu6050_fifo_enable(device_addr, true);
-    usleep(50000); // Let some data accumulate
+    sim_sleep_us(50000); // Let some data accumulate
     
     uint16_t fifo_count;
     if (mpu6050_fifo_get_count(device_addr, &fifo_count) != 0) {
@@ -320,7 +398,7 @@ static int run_continuous_test(void) {
         }
         
         iteration++;
-        usleep(1000); // 1ms delay = ~1kHz sampling
+        sim_sleep_us(1000); // 1ms delay = ~1kHz sampling
     }
     
     printf("\nStopping continuous test...\n");
@@ -339,6 +417,7 @@ int main(int argc, char* argv[]) {
     bool list_only = false;
     bool quick_test = false;
     bool continuous = false;
+    bool virtual_time = false;
     char* scenario_name = NULL;
     double noise_level = -1.0;
     int delay_us = -1;
@@ -353,10 +432,11 @@ int main(int argc, char* argv[]) {
         {"continuous", no_argument, 0, 'c'},
         {"noise", required_argument, 0, 'n'},
         {"delay", required_argument, 0, 'd'},
+        {"virtual-time", no_argument, 0, 't'},
         {0, 0, 0, 0}
     };
     
-    while ((opt = getopt_long(argc, argv, "hvbs:lqcn:d:", long_options, NULL)) != -1) {
+    while ((opt = getopt_long(argc, argv, "hvbs:lqcn:d:t", long_options, NULL)) != -1) {
         switch (opt) {
             case 'h':
                 print_usage(argv[0]);
@@ -393,6 +473,9 @@ int main(int argc, char* argv[]) {
                     return 1;
                 }
                 break;
+            case 't':
+                virtual_time = true;
+                break;
             default:
                 print_usage(argv[0]);
                 return 1;
@@ -422,6 +505,11 @@ int main(int argc, char* argv[]) {
         printf("Global I2C delay set to %d µs\n", delay_us);
     }
     
+    if (virtual_time) {
+        i2c_simulator_set_virtual_time(true);
+        printf("Running in virtual time\n");
+    }
+    
     // Handle different modes
     if (list_only) {
         list_scenarios();
@@ -14,9 +14,10 @@
 #define TEMP_OFFSET                    36.53 // °C offset
 #define ACCEL_SCALE_2G                 16384 // LSB/g
 #define GYRO_SCALE_250DPS              131.0 // LSB/°/s
+#define FIFO_MASK                      (FIFO_BUFFER_SIZE - 1)
+#define FIFO_FRAME_MAX                 14    // Accel, temperature and gyro
 
 // Forward reference to global simulator - will be resolved at link time
-i2c_simulator_t* get_global_simulator(void);
 bool* get_debug_logging_flag(void);
 
 // Forward declarations
@@ -24,7 +25,12 @@ int mpu6050_read_register(void* device, uint8_t reg, uint8_t* data);
 int mpu6050_write_register(void* device, uint8_t reg, uint8_t data);
 int mpu6050_read_burst(void* device, uint8_t reg, uint8_t* data, size_t len);
 static void update_sensor_data(mpu6050_state_t* state);
-static void update_fifo_buffer(mpu6050_state_t* state);
+static uint16_t fifo_count(fifo_buffer_t* fifo);
+static bool fifo_push(fifo_buffer_t* fifo, const uint8_t* data, size_t len);
+static size_t fifo_pop(fifo_buffer_t* fifo, uint8_t* data, size_t len);
+static void fifo_reset(fifo_buffer_t* fifo);
+static uint32_t fifo_sample_rate_hz(const mpu6050_state_t* state);
+static size_t build_fifo_frame(uint8_t sources, const sensor_data_t* sample, uint8_t* frame);
 static bool is_register_readable(uint8_t reg);
 static bool is_register_writable(uint8_t reg);
 static void handle_power_management(mpu6050_state_t* state, uint8_t reg, uint8_t value);
@@ -32,7 +38,7 @@ static void handle_fifo_configuration(mpu6050_state_t* state, uint8_t reg, uint8
 
 int mpu6050_simulator_create(uint8_t address) {
     int index = address % MAX_I2C_DEVICES;
-    mpu6050_state_t* state = &get_global_simulator()->mpu6050_devices[index];
+    mpu6050_state_t* state = &i2c_simulator_current()->mpu6050_devices[index];
     
     acquire_device_lock(address);
     
@@ -51,9 +57,15 @@ int mpu6050_simulator_create(uint8_t address) {
     state->current_data.accel_z = ACCEL_SCALE_2G; // 1g downward (gravity)
     state->current_data.temperature = (int16_t)((MPU6050_DEFAULT_TEMP + TEMP_OFFSET) * TEMP_SENSITIVITY);
     
-    // Initialize FIFO
-    memset(&state->fifo, 0, sizeof(fifo_buffer_t));
+    // Initialize FIFO, waiting out a generator tick on the previous device
+    pthread_mutex_lock(&state->fifo.producer_lock);
+    state->fifo.head = 0;
+    state->fifo.tail = 0;
+    state->fifo.count_latch = 0;
     state->fifo.enabled = false;
+    state->fifo.int_status = 0;
+    state->fifo.streaming = false;
+    pthread_mutex_unlock(&state->fifo.producer_lock);
     
     // Set default behavior
     state->power_state = POWER_SLEEP;
@@ -64,7 +76,7 @@ int mpu6050_simulator_create(uint8_t address) {
     state->self_test_mode = false;
     state->sample_count = 0;
     
-    clock_gettime(CLOCK_MONOTONIC, &state->start_time);
+    state->start_time_ns = sim_time_ns();
     
     release_device_lock(address);
     
@@ -77,10 +89,11 @@ int mpu6050_simulator_create(uint8_t address) {
 
 int mpu6050_simulator_destroy(uint8_t address) {
     int index = address % MAX_I2C_DEVICES;
-    mpu6050_state_t* state = &get_global_simulator()->mpu6050_devices[index];
+    mpu6050_state_t* state = &i2c_simulator_current()->mpu6050_devices[index];
     
     acquire_device_lock(address);
     state->initialized = false;
+    mpu6050_schedule(state);
     release_device_lock(address);
     
     if (*get_debug_logging_flag()) {
@@ -98,7 +111,7 @@ int mpu6050_simulator_reset(uint8_t address) {
 
 int mpu6050_simulator_set_pattern(uint8_t address, data_pattern_t pattern) {
     int index = address % MAX_I2C_DEVICES;
-    mpu6050_state_t* state = &get_global_simulator()->mpu6050_devices[index];
+    mpu6050_state_t* state = &i2c_simulator_current()->mpu6050_devices[index];
     
     if (!state->initialized || pattern >= PATTERN_COUNT) {
         return -EINVAL;
@@ -118,7 +131,7 @@ int mpu6050_simulator_set_pattern(uint8_t address, data_pattern_t pattern) {
 
 int mpu6050_simulator_set_error_mode(uint8_t address, error_type_t error, double probability) {
     int index = address % MAX_I2C_DEVICES;
-    mpu6050_state_t* state = &get_global_simulator()->mpu6050_devices[index];
+    mpu6050_state_t* state = &i2c_simulator_current()->mpu6050_devices[index];
     
     if (!state->initialized || error >= ERROR_COUNT || probability < 0.0 || probability > 1.0) {
         return -EINVAL;
@@ -141,7 +154,7 @@ int mpu6050_simulator_get_data(uint8_t address, sensor_data_t* data) {
     if (data == NULL) return -EINVAL;
     
     int index = address % MAX_I2C_DEVICES;
-    mpu6050_state_t* state = &get_global_simulator()->mpu6050_devices[index];
+    mpu6050_state_t* state = &i2c_simulator_current()->mpu6050_devices[index];
     
     if (!state->initialized) {
         return -ENODEV;
@@ -156,7 +169,7 @@ int mpu6050_simulator_get_data(uint8_t address, sensor_data_t* data) {
 
 int mpu6050_simulator_inject_error(uint8_t address) {
     int index = address % MAX_I2C_DEVICES;
-    mpu6050_state_t* state = &get_global_simulator()->mpu6050_devices[index];
+    mpu6050_state_t* state = &i2c_simulator_current()->mpu6050_devices[index];
     
     if (!state->initialized) {
         return -ENODEV;
@@ -182,32 +195,33 @@ int mpu6050_simulator_inject_error(uint8_t address) {
 
 int mpu6050_fifo_enable(uint8_t address, bool enable) {
     int index = address % MAX_I2C_DEVICES;
-    mpu6050_state_t* state = &get_global_simulator()->mpu6050_devices[index];
+    mpu6050_state_t* state = &i2c_simulator_current()->mpu6050_devices[index];
     
     if (!state->initialized) {
         return -ENODEV;
     }
     
     acquire_device_lock(address);
-    pthread_mutex_lock(&state->fifo.mutex);
     
     state->fifo.enabled = enable;
     if (enable) {
         // Reset FIFO when enabling
-        state->fifo.head = 0;
-        state->fifo.tail = 0;
-        state->fifo.count = 0;
-        state->fifo.overflow = false;
+        fifo_reset(&state->fifo);
+        
+        // Buffer every sensor unless FIFO_EN was programmed already
+        if (state->registers[MPU6050_FIFO_EN] == 0) {
+            state->registers[MPU6050_FIFO_EN] = MPU6050_FIFO_EN_SENSORS;
+        }
     }
     
     // Update register
     if (enable) {
-        state->registers[MPU6050_USER_CTRL] |= 0x40; // FIFO_EN bit
+        state->registers[MPU6050_USER_CTRL] |= MPU6050_USER_CTRL_FIFO_EN;
     } else {
-        state->registers[MPU6050_USER_CTRL] &= ~0x40;
+        state->registers[MPU6050_USER_CTRL] &= ~MPU6050_USER_CTRL_FIFO_EN;
     }
+    mpu6050_schedule(state);
     
-    pthread_mutex_unlock(&state->fifo.mutex);
     release_device_lock(address);
     
     if (*get_debug_logging_flag()) {
@@ -220,21 +234,14 @@ int mpu6050_fifo_enable(uint8_t address, bool enable) {
 
 int mpu6050_fifo_reset(uint8_t address) {
     int index = address % MAX_I2C_DEVICES;
-    mpu6050_state_t* state = &get_global_simulator()->mpu6050_devices[index];
+    mpu6050_state_t* state = &i2c_simulator_current()->mpu6050_devices[index];
     
     if (!state->initialized) {
         return -ENODEV;
     }
     
     acquire_device_lock(address);
-    pthread_mutex_lock(&state->fifo.mutex);
-    
-    state->fifo.head = 0;
-    state->fifo.tail = 0;
-    state->fifo.count = 0;
-    state->fifo.overflow = false;
-    
-    pthread_mutex_unlock(&state->fifo.mutex);
+    fifo_reset(&state->fifo);
     release_device_lock(address);
     
     return 0;
@@ -244,16 +251,14 @@ int mpu6050_fifo_get_count(uint8_t address, uint16_t* count) {
     if (count == NULL) return -EINVAL;
     
     int index = address % MAX_I2C_DEVICES;
-    mpu6050_state_t* state = &get_global_simulator()->mpu6050_devices[index];
+    mpu6050_state_t* state = &i2c_simulator_current()->mpu6050_devices[index];
     
     if (!state->initialized) {
         return -ENODEV;
     }
     
     acquire_device_lock(address);
-    pthread_mutex_lock(&state->fifo.mutex);
-    *count = state->fifo.count;
-    pthread_mutex_unlock(&state->fifo.mutex);
+    *count = fifo_count(&state->fifo);
     release_device_lock(address);
     
     return 0;
@@ -263,32 +268,96 @@ int mpu6050_fifo_read(uint8_t address, uint8_t* data, size_t len) {
     if (data == NULL || len == 0) return -EINVAL;
     
     int index = address % MAX_I2C_DEVICES;
-    mpu6050_state_t* state = &get_global_simulator()->mpu6050_devices[index];
+    mpu6050_state_t* state = &i2c_simulator_current()->mpu6050_devices[index];
     
     if (!state->initialized) {
         return -ENODEV;
     }
     
     acquire_device_lock(address);
-    pthread_mutex_lock(&state->fifo.mutex);
+    size_t bytes_read = fifo_pop(&state->fifo, data, len);
+    release_device_lock(address);
     
-    size_t bytes_read = 0;
-    while (bytes_read < len && state->fifo.count > 0) {
-        data[bytes_read] = state->fifo.buffer[state->fifo.tail];
-        state->fifo.tail = (state->fifo.tail + 1) % FIFO_BUFFER_SIZE;
-        state->fifo.count--;
-        bytes_read++;
+    return (int)bytes_read;
+}
+
+// Sample generator, run for the device's events. Generates every FIFO
+// frame due by @now_ns at the configured sample rate.
+// Returns when the next frame is due, or UINT64_MAX if the device does
+// not stream into its FIFO.
+uint64_t mpu6050_update_background(mpu6050_state_t* state, uint64_t now_ns) {
+    fifo_buffer_t* fifo = &state->fifo;
+    
+    // Snapshot the configuration; the FIFO itself is filled without the
+    // device lock. A device busy in a transaction catches up shortly.
+    if (pthread_mutex_trylock(&state->mutex) != 0) {
+        return now_ns + SIM_EVENT_RETRY_NS;
+    }
+    bool streaming = state->initialized && fifo->enabled && state->power_state == POWER_ON;
+    data_pattern_t pattern = state->pattern;
+    uint8_t sources = state->registers[MPU6050_FIFO_EN] & MPU6050_FIFO_EN_SENSORS;
+    uint32_t rate_hz = fifo_sample_rate_hz(state);
+    pthread_mutex_unlock(&state->mutex);
+    
+    pthread_mutex_lock(&fifo->producer_lock);
+    
+    if (!streaming) {
+        fifo->streaming = false;
+        pthread_mutex_unlock(&fifo->producer_lock);
+        return UINT64_MAX;
+    }
+    if (!fifo->streaming) {
+        fifo->streaming = true;
+        fifo->origin_ns = now_ns;
+        fifo->frames = 0;
+        fifo->rate_hz = rate_hz;
+    } else if (fifo->rate_hz != rate_hz) {
+        // New rate from the last frame on, as SMPLRT_DIV takes effect
+        fifo->origin_ns += fifo->frames * 1000000000ULL / fifo->rate_hz;
+        fifo->frames = 0;
+        fifo->rate_hz = rate_hz;
+    }
+    
+    uint64_t due = (now_ns - fifo->origin_ns) * rate_hz / 1000000000ULL;
+    uint8_t frame[FIFO_FRAME_MAX];
+    sensor_data_t sample = {0};
+    size_t len = build_fifo_frame(sources, &sample, frame);
+    
+    // Frames beyond what a drained FIFO holds would all be dropped
+    if (len > 0 && due - fifo->frames > FIFO_BUFFER_SIZE / len) {
+        fifo->frames = due - FIFO_BUFFER_SIZE / len;
+        __atomic_fetch_or(&fifo->int_status, MPU6050_INT_FIFO_OFLOW, __ATOMIC_RELAXED);
+    }
+    
+    for (; fifo->frames < due; fifo->frames++) {
+        // The data patterns are defined over 1 kHz sample numbers
+        uint32_t sample_num = (uint32_t)(fifo->frames * 1000 / rate_hz);
+        
+        if (len > 0) {
+            sample.accel_x = generate_accel_data(pattern, 0, sample_num);
+            sample.accel_y = generate_accel_data(pattern, 1, sample_num);
+            sample.accel_z = generate_accel_data(pattern, 2, sample_num);
+            sample.gyro_x = generate_gyro_data(pattern, 0, sample_num);
+            sample.gyro_y = generate_gyro_data(pattern, 1, sample_num);
+            sample.gyro_z = generate_gyro_data(pattern, 2, sample_num);
+            sample.temperature = generate_temp_data(pattern, sample_num);
+            build_fifo_frame(sources, &sample, frame);
+            fifo_push(fifo, frame, len);
+        }
+        __atomic_fetch_or(&fifo->int_status, MPU6050_INT_DATA_RDY, __ATOMIC_RELAXED);
     }
     
-    pthread_mutex_unlock(&state->fifo.mutex);
-    release_device_lock(address);
+    // Frame n is due once n periods have passed, rounded up to the ns
+    uint64_t next_ns = fifo->origin_ns +
+                       ((fifo->frames + 1) * 1000000000ULL + rate_hz - 1) / rate_hz;
     
-    return (int)bytes_read;
+    pthread_mutex_unlock(&fifo->producer_lock);
+    return next_ns;
 }
 
 int mpu6050_set_power_state(uint8_t address, power_state_t power_state) {
     int index = address % MAX_I2C_DEVICES;
-    mpu6050_state_t* state = &get_global_simulator()->mpu6050_devices[index];
+    mpu6050_state_t* state = &i2c_simulator_current()->mpu6050_devices[index];
     
     if (!state->initialized || power_state >= POWER_COUNT) {
         return -EINVAL;
@@ -315,6 +384,7 @@ int mpu6050_set_power_state(uint8_t address, power_state_t power_state) {
             // Invalid state, ignore
             break;
     }
+    mpu6050_schedule(state);
     
     release_device_lock(address);
     
@@ -328,7 +398,7 @@ int mpu6050_set_power_state(uint8_t address, power_state_t power_state) {
 
 power_state_t mpu6050_get_power_state(uint8_t address) {
     int index = address % MAX_I2C_DEVICES;
-    mpu6050_state_t* state = &get_global_simulator()->mpu6050_devices[index];
+    mpu6050_state_t* state = &i2c_simulator_current()->mpu6050_devices[index];
     
     if (!state->initialized) {
         return POWER_OFF;
@@ -342,6 +412,37 @@ power_state_t mpu6050_get_power_state(uint8_t address) {
 }
 
 // Data generation helper functions
+
+/*
+ * Waveforms are read from a shared sine table with linear interpolation
+ * rather than calling sin() for every axis of every sample; the error is
+ * below 1e-5 of the amplitude, far under one LSB.
+ */
+#define WAVE_TABLE_BITS                10
+#define WAVE_TABLE_SIZE                (1 << WAVE_TABLE_BITS)
+
+static double wave_table[WAVE_TABLE_SIZE + 1];
+static pthread_once_t wave_table_once = PTHREAD_ONCE_INIT;
+
+static void wave_table_init(void) {
+    for (int i = 0; i <= WAVE_TABLE_SIZE; i++) {
+        wave_table[i] = sin(2 * M_PI * i / WAVE_TABLE_SIZE);
+    }
+}
+
+// sin() of an angle given in turns (cycles) rather than radians
+static double wave_sin(double turns) {
+    double pos = (turns - floor(turns)) * WAVE_TABLE_SIZE;
+    int index = (int)pos;
+    
+    pthread_once(&wave_table_once, wave_table_init);
+    return wave_table[index] + (wave_table[index + 1] - wave_table[index]) * (pos - index);
+}
+
+static double wave_cos(double turns) {
+    return wave_sin(turns + 0.25);
+}
+
 int16_t generate_accel_data(data_pattern_t pattern, int axis, uint32_t sample_num) {
     double time_sec = sample_num / 1000.0; // Assume 1kHz sampling
     int16_t base_value = 0;
@@ -358,12 +459,12 @@ int16_t generate_accel_data(data_pattern_t pattern, int axis, uint32_t sample_nu
         case PATTERN_SINE_WAVE: {
             double freq_hz = 1.0 + axis * 0.5; // Different freq per axis
             double amplitude = ACCEL_SCALE_2G * 0.1; // 0.1g amplitude
-            return base_value + (int16_t)(amplitude * sin(2 * M_PI * freq_hz * time_sec));
+            return base_value + (int16_t)(amplitude * wave_sin(freq_hz * time_sec));
         }
         
         case PATTERN_NOISE: {
             // Generate white noise ±0.05g
-            double noise = (rand() / (double)RAND_MAX - 0.5) * 2.0;
+            double noise = (sim_rand() / (double)SIM_RAND_MAX - 0.5) * 2.0;
             return base_value + (int16_t)(noise * ACCEL_SCALE_2G * 0.05);
         }
         
@@ -374,9 +475,9 @@ int16_t generate_accel_data(data_pattern_t pattern, int axis, uint32_t sample_nu
             // Simulate device rotation
             double angle = time_sec * 0.5; // 0.5 rad/s
             switch (axis) {
-                case 0: return (int16_t)(ACCEL_SCALE_2G * sin(angle)); // X
-                case 1: return (int16_t)(ACCEL_SCALE_2G * 0.1 * cos(angle * 2)); // Y
-                case 2: return (int16_t)(ACCEL_SCALE_2G * cos(angle)); // Z
+                case 0: return (int16_t)(ACCEL_SCALE_2G * wave_sin(angle / (2 * M_PI))); // X
+                case 1: return (int16_t)(ACCEL_SCALE_2G * 0.1 * wave_cos(angle / M_PI)); // Y
+                case 2: return (int16_t)(ACCEL_SCALE_2G * wave_cos(angle / (2 * M_PI))); // Z
             }
             break;
         }
@@ -385,7 +486,7 @@ int16_t generate_accel_data(data_pattern_t pattern, int axis, uint32_t sample_nu
             // High-frequency vibration
             double freq = 50.0 + axis * 10.0; // 50-70 Hz
             double amplitude = ACCEL_SCALE_2G * 0.02; // 0.02g amplitude
-            return base_value + (int16_t)(amplitude * sin(2 * M_PI * freq * time_sec));
+            return base_value + (int16_t)(amplitude * wave_sin(freq * time_sec));
         }
         
         default:
@@ -406,12 +507,12 @@ int16_t generate_gyro_data(data_pattern_t pattern, int axis, uint32_t sample_num
         case PATTERN_SINE_WAVE: {
             double freq_hz = 0.5 + axis * 0.2; // Different freq per axis
             double amplitude = GYRO_SCALE_250DPS * 10.0; // 10°/s amplitude
-            return (int16_t)(amplitude * sin(2 * M_PI * freq_hz * time_sec));
+            return (int16_t)(amplitude * wave_sin(freq_hz * time_sec));
         }
         
         case PATTERN_NOISE: {
             // Generate gyro noise ±1°/s
-            double noise = (rand() / (double)RAND_MAX - 0.5) * 2.0;
+            double noise = (sim_rand() / (double)SIM_RAND_MAX - 0.5) * 2.0;
             return (int16_t)(noise * GYRO_SCALE_250DPS);
         }
         
@@ -420,7 +521,7 @@ int16_t generate_gyro_data(data_pattern_t pattern, int axis, uint32_t sample_num
             switch (axis) {
                 case 0: return (int16_t)(GYRO_SCALE_250DPS * 5.0); // 5°/s around X
                 case 1: return (int16_t)(GYRO_SCALE_250DPS * -2.0); // -2°/s around Y
-                case 2: return (int16_t)(GYRO_SCALE_250DPS * 10.0 * sin(time_sec)); // Variable Z
+                case 2: return (int16_t)(GYRO_SCALE_250DPS * 10.0 * wave_sin(time_sec / (2 * M_PI))); // Variable Z
             }
             break;
         }
@@ -429,7 +530,7 @@ int16_t generate_gyro_data(data_pattern_t pattern, int axis, uint32_t sample_num
             // High-frequency angular vibration
             double freq = 30.0 + axis * 5.0; // 30-40 Hz
             double amplitude = GYRO_SCALE_250DPS * 2.0; // 2°/s amplitude
-            return (int16_t)(amplitude * sin(2 * M_PI * freq * time_sec));
+            return (int16_t)(amplitude * wave_sin(freq * time_sec));
         }
         
         case PATTERN_COUNT:
@@ -449,12 +550,12 @@ int16_t generate_temp_data(data_pattern_t pattern, uint32_t sample_num) {
             
         case PATTERN_SINE_WAVE:
             // Slow temperature variation ±2°C
-            base_temp += 2.0 * sin(2 * M_PI * 0.01 * time_sec); // 0.01 Hz
+            base_temp += 2.0 * wave_sin(0.01 * time_sec); // 0.01 Hz
             break;
             
         case PATTERN_NOISE:
             // Temperature noise ±0.5°C
-            base_temp += (rand() / (double)RAND_MAX - 0.5) * 1.0;
+            base_temp += (sim_rand() / (double)SIM_RAND_MAX - 0.5) * 1.0;
             break;
             
         case PATTERN_ROTATION:
@@ -485,15 +586,15 @@ int mpu6050_read_register(void* device, uint8_t reg, uint8_t* data) {
             case ERROR_DEVICE_NOT_FOUND:
                 return -ENODEV;
             case ERROR_TIMEOUT:
-                usleep(100000); // 100ms timeout
+                sim_delay_us(100000); // 100ms timeout
                 return -ETIMEDOUT;
             case ERROR_BUS_ERROR:
                 return -EIO;
             case ERROR_CORRUPT_DATA:
-                *data = rand() % 256; // Random corrupted data
+                *data = sim_rand() % 256; // Random corrupted data
                 return 0;
             case ERROR_INTERMITTENT:
-                if (rand() % 10 < 3) { // 30% chance of intermittent error
+                if (sim_rand() % 10 < 3) { // 30% chance of intermittent error
                     return -EIO;
                 }
                 break;
@@ -552,23 +653,22 @@ int mpu6050_read_register(void* device, uint8_t reg, uint8_t* data) {
             *data = state->current_data.temperature & 0xFF;
             break;
         case MPU6050_FIFO_COUNTH:
-            *data = (state->fifo.count >> 8) & 0xFF;
+            // Latch the count so that COUNTH and COUNTL agree
+            state->fifo.count_latch = fifo_count(&state->fifo);
+            *data = (state->fifo.count_latch >> 8) & 0xFF;
             break;
         case MPU6050_FIFO_COUNTL:
-            *data = state->fifo.count & 0xFF;
+            *data = state->fifo.count_latch & 0xFF;
             break;
         case MPU6050_FIFO_R_W:
             // Read one byte from FIFO
-            if (state->fifo.count > 0) {
-                pthread_mutex_lock(&state->fifo.mutex);
-                *data = state->fifo.buffer[state->fifo.tail];
-                state->fifo.tail = (state->fifo.tail + 1) % FIFO_BUFFER_SIZE;
-                state->fifo.count--;
-                pthread_mutex_unlock(&state->fifo.mutex);
-            } else {
+            if (fifo_pop(&state->fifo, data, 1) == 0) {
                 *data = 0;
             }
             break;
+        case MPU6050_INT_STATUS:
+            *data = __atomic_exchange_n(&state->fifo.int_status, 0, __ATOMIC_RELAXED);
+            break;
         default:
             *data = state->registers[reg];
             break;
@@ -589,7 +689,7 @@ int mpu6050_write_register(void* device, uint8_t reg, uint8_t data) {
             case ERROR_DEVICE_NOT_FOUND:
                 return -ENODEV;
             case ERROR_TIMEOUT:
-                usleep(100000); // 100ms timeout
+                sim_delay_us(100000); // 100ms timeout
                 return -ETIMEDOUT;
             case ERROR_BUS_ERROR:
                 return -EIO;
@@ -613,28 +713,49 @@ int mpu6050_write_register(void* device, uint8_t reg, uint8_t data) {
             break;
         case MPU6050_FIFO_R_W:
             // Write to FIFO (usually not done, but supported)
-            pthread_mutex_lock(&state->fifo.mutex);
-            if (state->fifo.count < FIFO_BUFFER_SIZE) {
-                state->fifo.buffer[state->fifo.head] = data;
-                state->fifo.head = (state->fifo.head + 1) % FIFO_BUFFER_SIZE;
-                state->fifo.count++;
-            } else {
-                state->fifo.overflow = true;
-            }
-            pthread_mutex_unlock(&state->fifo.mutex);
+            pthread_mutex_lock(&state->fifo.producer_lock);
+            fifo_push(&state->fifo, &data, 1);
+            pthread_mutex_unlock(&state->fifo.producer_lock);
             break;
         default:
             state->registers[reg] = data;
             break;
     }
     
+    // Anything that starts, stops or paces the sample stream
+    switch (reg) {
+        case MPU6050_PWR_MGMT_1:
+        case MPU6050_USER_CTRL:
+        case MPU6050_FIFO_EN:
+        case MPU6050_SMPLRT_DIV:
+        case MPU6050_CONFIG:
+            mpu6050_schedule(state);
+            break;
+        default:
+            break;
+    }
+    
     return 0;
 }
 
 int mpu6050_read_burst(void* device, uint8_t reg, uint8_t* data, size_t len) {
-    // For MPU-6050, burst reads are typically sequential register reads
+    // Burst reads auto-increment the register address, except on FIFO_R_W
+    // where every byte is the next one out of the FIFO
+    if (reg == MPU6050_FIFO_R_W) {
+        mpu6050_state_t* state = (mpu6050_state_t*)device;
+        
+        // The first byte takes the error injection path for the transfer
+        int result = mpu6050_read_register(device, reg, &data[0]);
+        if (result < 0 || len == 1) {
+            return result;
+        }
+        size_t popped = fifo_pop(&state->fifo, &data[1], len - 1);
+        memset(&data[1 + popped], 0, len - 1 - popped);
+        return 0;
+    }
+    
     for (size_t i = 0; i < len; i++) {
-        int result = mpu6050_read_register(device, reg + i, &data[i]);
+        int result = mpu6050_read_register(device, (uint8_t)(reg + i), &data[i]);
         if (result < 0) {
             return result;
         }
@@ -660,45 +781,101 @@ static void update_sensor_data(mpu6050_state_t* state) {
     
     state->current_data.temperature = generate_temp_data(state->pattern, state->sample_count);
     state->current_data.timestamp = generate_realistic_timestamp();
+}
+
+// FIFO ring. head and tail run freely and wrap by mask, so head - tail is
+// the fill level and a full FIFO holds all FIFO_BUFFER_SIZE bytes.
+
+// Consumer: bytes ready to be read
+static uint16_t fifo_count(fifo_buffer_t* fifo) {
+    return (uint16_t)(__atomic_load_n(&fifo->head, __ATOMIC_ACQUIRE) - fifo->tail);
+}
+
+// Producer: append all of @data or, if it does not fit, drop it and flag
+// the overflow
+static bool fifo_push(fifo_buffer_t* fifo, const uint8_t* data, size_t len) {
+    uint32_t head = fifo->head;
+    uint32_t used = head - __atomic_load_n(&fifo->tail, __ATOMIC_ACQUIRE);
     
-    // Update FIFO if enabled
-    if (state->fifo.enabled) {
-        update_fifo_buffer(state);
-    }
-}
-
-static void update_fifo_buffer(mpu6050_state_t* state) {
-    // Add sensor data to FIFO buffer (14 bytes per sample)
-    pthread_mutex_lock(&state->fifo.mutex);
-    
-    uint8_t fifo_data[14];
-    fifo_data[0] = (state->current_data.accel_x >> 8) & 0xFF;
-    fifo_data[1] = state->current_data.accel_x & 0xFF;
-    fifo_data[2] = (state->current_data.accel_y >> 8) & 0xFF;
-    fifo_data[3] = state->current_data.accel_y & 0xFF;
-    fifo_data[4] = (state->current_data.accel_z >> 8) & 0xFF;
-    fifo_data[5] = state->current_data.accel_z & 0xFF;
-    fifo_data[6] = (state->current_data.temperature >> 8) & 0xFF;
-    fifo_data[7] = state->current_data.temperature & 0xFF;
-    fifo_data[8] = (state->current_data.gyro_x >> 8) & 0xFF;
-    fifo_data[9] = state->current_data.gyro_x & 0xFF;
-    fifo_data[10] = (state->current_data.gyro_y >> 8) & 0xFF;
-    fifo_data[11] = state->current_data.gyro_y & 0xFF;
-    fifo_data[12] = (state->current_data.gyro_z >> 8) & 0xFF;
-    fifo_data[13] = state->current_data.gyro_z & 0xFF;
-    
-    for (int i = 0; i < 14; i++) {
-        if (state->fifo.count < FIFO_BUFFER_SIZE) {
-            state->fifo.buffer[state->fifo.head] = fifo_data[i];
-            state->fifo.head = (state->fifo.head + 1) % FIFO_BUFFER_SIZE;
-            state->fifo.count++;
-        } else {
-            state->fifo.overflow = true;
-            break;
-        }
+    if (FIFO_BUFFER_SIZE - used < len) {
+        __atomic_fetch_or(&fifo->int_status, MPU6050_INT_FIFO_OFLOW, __ATOMIC_RELAXED);
+        return false;
+    }
+    
+    size_t first = FIFO_BUFFER_SIZE - (head & FIFO_MASK);
+    if (first > len) {
+        first = len;
+    }
+    memcpy(&fifo->buffer[head & FIFO_MASK], data, first);
+    memcpy(fifo->buffer, data + first, len - first);
+    __atomic_store_n(&fifo->head, head + (uint32_t)len, __ATOMIC_RELEASE);
+    return true;
+}
+
+// Consumer: move up to @len bytes out; Returns the number moved
+static size_t fifo_pop(fifo_buffer_t* fifo, uint8_t* data, size_t len) {
+    uint32_t tail = fifo->tail;
+    uint32_t avail = __atomic_load_n(&fifo->head, __ATOMIC_ACQUIRE) - tail;
+    
+    if (len > avail) {
+        len = avail;
+    }
+    
+    size_t first = FIFO_BUFFER_SIZE - (tail & FIFO_MASK);
+    if (first > len) {
+        first = len;
+    }
+    memcpy(data, &fifo->buffer[tail & FIFO_MASK], first);
+    memcpy(data + first, fifo->buffer, len - first);
+    __atomic_store_n(&fifo->tail, tail + (uint32_t)len, __ATOMIC_RELEASE);
+    return len;
+}
+
+// Consumer: discard everything pushed so far. Frames are published whole,
+// so the FIFO stays frame aligned.
+static void fifo_reset(fifo_buffer_t* fifo) {
+    __atomic_store_n(&fifo->tail, __atomic_load_n(&fifo->head, __ATOMIC_ACQUIRE),
+                     __ATOMIC_RELEASE);
+    __atomic_fetch_and(&fifo->int_status, (uint8_t)~MPU6050_INT_FIFO_OFLOW, __ATOMIC_RELAXED);
+}
+
+static uint32_t fifo_sample_rate_hz(const mpu6050_state_t* state) {
+    // Gyro output rate is 8 kHz with the DLPF off (DLPF_CFG 0 or 7), else 1 kHz
+    uint8_t dlpf_cfg = state->registers[MPU6050_CONFIG] & 0x07;
+    uint32_t gyro_rate_hz = (dlpf_cfg == 0 || dlpf_cfg == 7) ? 8000 : 1000;
+    
+    return gyro_rate_hz / (1 + state->registers[MPU6050_SMPLRT_DIV]);
+}
+
+// Lay out a FIFO frame as the hardware does, in register order of the
+// FIFO_EN @sources; Returns the frame length
+static size_t build_fifo_frame(uint8_t sources, const sensor_data_t* sample, uint8_t* frame) {
+    int16_t words[7];
+    size_t n = 0;
+    
+    if (sources & MPU6050_FIFO_EN_ACCEL) {
+        words[n++] = sample->accel_x;
+        words[n++] = sample->accel_y;
+        words[n++] = sample->accel_z;
+    }
+    if (sources & MPU6050_FIFO_EN_TEMP) {
+        words[n++] = sample->temperature;
+    }
+    if (sources & MPU6050_FIFO_EN_XG) {
+        words[n++] = sample->gyro_x;
+    }
+    if (sources & MPU6050_FIFO_EN_YG) {
+        words[n++] = sample->gyro_y;
+    }
+    if (sources & MPU6050_FIFO_EN_ZG) {
+        words[n++] = sample->gyro_z;
     }
     
-    pthread_mutex_unlock(&state->fifo.mutex);
+    for (size_t i = 0; i < n; i++) {
+        frame[2 * i] = (words[i] >> 8) & 0xFF;
+        frame[2 * i + 1] = words[i] & 0xFF;
+    }
+    return 2 * n;
 }
 
 static bool is_register_readable(uint8_t reg) {
@@ -753,8 +930,9 @@ static void handle_power_management(mpu6050_state_t* state, uint8_t reg, uint8_t
         state->registers[MPU6050_PWR_MGMT_1] = 0x40; // Back to sleep mode
         state->power_state = POWER_SLEEP;
         
-        // Reset FIFO
-        mpu6050_fifo_reset(0); // Address doesn't matter for internal reset
+        // Reset FIFO; the device lock is already held by the transaction
+        state->fifo.enabled = false;
+        fifo_reset(&state->fifo);
     }
 }
 
@@ -762,19 +940,11 @@ static void handle_fifo_configuration(mpu6050_state_t* state, uint8_t reg, uint8
     state->registers[reg] = value;
     
     if (reg == MPU6050_USER_CTRL) {
-        if (value & 0x40) { // FIFO_EN bit
-            state->fifo.enabled = true;
-        } else {
-            state->fifo.enabled = false;
-        }
+        state->fifo.enabled = (value & MPU6050_USER_CTRL_FIFO_EN) != 0;
         
-        if (value & 0x04) { // FIFO_RESET bit
-            pthread_mutex_lock(&state->fifo.mutex);
-            state->fifo.head = 0;
-            state->fifo.tail = 0;
-            state->fifo.count = 0;
-            state->fifo.overflow = false;
-            pthread_mutex_unlock(&state->fifo.mutex);
+        if (value & MPU6050_USER_CTRL_FIFO_RST) { // Self-clearing
+            state->registers[reg] &= ~MPU6050_USER_CTRL_FIFO_RST;
+            fifo_reset(&state->fifo);
         }
     }
 }
\ No newline at end of file
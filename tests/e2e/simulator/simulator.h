@@ -8,6 +8,8 @@
 
 // MPU-6050 register addresses
 #define MPU6050_ADDR                0x68
+#define MPU6050_SMPLRT_DIV         0x19
+#define MPU6050_CONFIG             0x1A
 #define MPU6050_WHO_AM_I           0x75
 #define MPU6050_PWR_MGMT_1         0x6B
 #define MPU6050_PWR_MGMT_2         0x6C
@@ -36,13 +38,34 @@
 #define MPU6050_INT_ENABLE         0x38
 #define MPU6050_INT_STATUS         0x3A
 
-// MPU-6050 specific values
+// MPU-6050 specific values. Bits are spelled as in include/mpu6050.h so
+// the CUSE server can include both headers.
+#ifndef BIT
+#define BIT(nr)                    (1UL << (nr))
+#endif
 #define MPU6050_WHO_AM_I_VALUE     0x68
+#define MPU6050_FIFO_EN_TEMP       BIT(7)  // FIFO_EN sources, in frame order
+#define MPU6050_FIFO_EN_XG         BIT(6)  // after the accelerometer
+#define MPU6050_FIFO_EN_YG         BIT(5)
+#define MPU6050_FIFO_EN_ZG         BIT(4)
+#define MPU6050_FIFO_EN_ACCEL      BIT(3)
+#define MPU6050_FIFO_EN_SENSORS    0xF8
+#define MPU6050_USER_CTRL_FIFO_EN  BIT(6)
+#define MPU6050_USER_CTRL_FIFO_RST 0x04
+#define MPU6050_INT_FIFO_OFLOW     BIT(4)  // INT_STATUS bits, cleared on read
+#define MPU6050_INT_DATA_RDY       BIT(0)
 
 // I2C simulator constants
 #define MAX_I2C_DEVICES            128
 #define I2C_BUS_COUNT              2
-#define FIFO_BUFFER_SIZE           1024
+#define I2C_SMBUS_BLOCK_MAX        32    // Largest SMBus block transfer
+#define FIFO_BUFFER_SIZE           1024  // Power of two, ring indexes wrap by mask
+#define I2C_ADDRESS_COUNT          256   // Lookup table covers every uint8_t address
+#define SIM_CACHELINE              64
+#define SIM_METRICS_SHARDS         64    // Threads beyond this share shards
+#define SIM_RAND_MAX               UINT32_MAX
+#define SIM_CLOCK_THREADS          64    // Threads beyond this do not wait on the virtual clock
+#define SIM_EVENT_RETRY_NS         100000 // Device busy in a transaction, try its event again
 
 // Error injection types
 typedef enum {
@@ -83,19 +106,29 @@ typedef struct {
     uint32_t timestamp;
 } sensor_data_t;
 
-// FIFO buffer
+// FIFO buffer: a single-producer/single-consumer ring. The background
+// sample generator produces whole frames and the host side (I2C reads and
+// the mpu6050_fifo_* calls, serialized by the device lock) consumes, with
+// no lock between the two. Host writes to FIFO_R_W join the producer side
+// through producer_lock, which the consumer never takes.
 typedef struct {
     uint8_t buffer[FIFO_BUFFER_SIZE];
-    uint16_t head;
-    uint16_t tail;
-    uint16_t count;
-    bool enabled;
-    bool overflow;
-    pthread_mutex_t mutex;
+    uint32_t head __attribute__((aligned(SIM_CACHELINE))); // Bytes ever pushed
+    uint32_t tail __attribute__((aligned(SIM_CACHELINE))); // Bytes ever popped
+    uint16_t count_latch;         // FIFO_COUNT as of the last FIFO_COUNTH read
+    bool enabled;                 // USER_CTRL FIFO_EN, under the device lock
+    uint8_t int_status __attribute__((aligned(SIM_CACHELINE))); // Raised by the producer
+    pthread_mutex_t producer_lock;
+    // Generator state, owned by the producer
+    bool streaming;
+    uint64_t origin_ns;           // When streaming started
+    uint64_t frames;              // Frames generated since origin_ns
+    uint32_t rate_hz;             // Output data rate origin_ns counts in
 } fifo_buffer_t;
 
-// MPU-6050 device state
-typedef struct {
+// MPU-6050 device state, one cache line apart so devices driven from
+// different threads never share a line
+typedef struct __attribute__((aligned(SIM_CACHELINE))) {
     uint8_t registers[256];        // Register map
     sensor_data_t current_data;    // Current sensor readings
     fifo_buffer_t fifo;           // FIFO buffer
@@ -106,8 +139,8 @@ typedef struct {
     bool initialized;             // Device initialization state
     bool self_test_mode;          // Self-test mode flag
     uint32_t sample_count;        // Total samples generated
-    struct timespec start_time;   // Simulation start time
-    pthread_mutex_t mutex;        // Thread safety
+    uint64_t start_time_ns;       // Simulation time at creation
+    pthread_mutex_t mutex;        // Held for every transaction on the device
 } mpu6050_state_t;
 
 // I2C device interface
@@ -115,6 +148,7 @@ typedef struct {
     uint8_t address;
     bool present;
     void* device_data;
+    pthread_mutex_t* lock;        // Serializes transactions on this device
     int (*read_register)(void* device, uint8_t reg, uint8_t* data);
     int (*write_register)(void* device, uint8_t reg, uint8_t data);
     int (*read_burst)(void* device, uint8_t reg, uint8_t* data, size_t len);
@@ -123,11 +157,14 @@ typedef struct {
 // I2C bus simulator
 typedef struct {
     i2c_device_t devices[MAX_I2C_DEVICES];
-    int device_count;
+    i2c_device_t* lookup[I2C_ADDRESS_COUNT]; // Present devices by address
+    int device_count;             // Slots in use or freed for reuse
     bool bus_error;
     double noise_level;           // Bus noise simulation (0.0-1.0)
-    uint32_t transaction_count;   // Total transactions
-    pthread_mutex_t bus_mutex;    // Bus access synchronization
+    bool smbus_only;              // Adapter limited to SMBus block transfers
+    // Transactions hold the read side, so only devices contend with each
+    // other; adding and removing devices takes the write side
+    pthread_rwlock_t bus_lock __attribute__((aligned(SIM_CACHELINE)));
 } i2c_bus_t;
 
 // Test scenario configuration
@@ -155,19 +192,61 @@ typedef struct {
     uint32_t min_response_time_us;
 } performance_metrics_t;
 
-// Global simulator state
+// Per-thread share of the performance metrics. Each thread updates the
+// shard it was handed on first use with relaxed atomics, and
+// get_performance_metrics() adds them up.
+typedef struct __attribute__((aligned(SIM_CACHELINE))) {
+    uint32_t total_reads;
+    uint32_t total_writes;
+    uint32_t errors_injected;
+    uint32_t timeouts;
+    uint32_t max_response_time_us;
+    uint32_t min_response_time_us;
+    uint32_t responses;           // Transactions timed
+    uint64_t response_time_us;    // Sum over the timed transactions
+    uint32_t transactions[I2C_BUS_COUNT];
+} sim_metrics_shard_t;
+
+// When a device's next FIFO frame is due
 typedef struct {
+    uint64_t due_ns;
+    uint16_t device;              // Index into mpu6050_devices
+} sim_event_t;
+
+// Simulator context: buses, devices, metrics and the background thread
+// that generates samples. Contexts share nothing but the virtual clock.
+typedef struct i2c_simulator {
     i2c_bus_t buses[I2C_BUS_COUNT];
     mpu6050_state_t mpu6050_devices[MAX_I2C_DEVICES];
-    performance_metrics_t metrics;
+    sim_metrics_shard_t metrics[SIM_METRICS_SHARDS];
+    // Sample events of the streaming devices, a binary min-heap on due_ns.
+    // Devices that do not stream are not queued and cost nothing.
+    sim_event_t events[MAX_I2C_DEVICES];
+    uint16_t event_count;
+    uint16_t event_pos[MAX_I2C_DEVICES]; // Heap index + 1, 0 when not queued
+    pthread_mutex_t event_lock;
+    pthread_cond_t event_cond;    // Earlier event queued, or stopping
     bool running;
-    pthread_t background_thread;
-    struct timespec simulation_start;
+    pthread_t background_thread;  // Not started in virtual time
+    uint64_t simulation_start_ns;
+    uint32_t latency_us;          // Charged per transaction, set_global_latency()
+    bool initialized;
+    struct i2c_simulator* next;   // Running contexts, for the virtual clock
 } i2c_simulator_t;
 
-// Core simulator functions
+// Core simulator functions. Every call works on the calling thread's
+// current context: the one it selected with i2c_simulator_use(), or the
+// process-wide default. i2c_simulator_init() starts the current context.
 int i2c_simulator_init(void);
 void i2c_simulator_cleanup(void);
+
+// Independent contexts, so tests running in parallel do not share devices
+// or metrics. New threads start on the default context; a thread working
+// on another one selects it first.
+i2c_simulator_t* i2c_simulator_create(void);     // Started, NULL on failure
+void i2c_simulator_destroy(i2c_simulator_t* sim);
+i2c_simulator_t* i2c_simulator_use(i2c_simulator_t* sim); // NULL for the default; Returns the previous
+i2c_simulator_t* i2c_simulator_current(void);
 int i2c_simulator_add_device(int bus, uint8_t address, const char* device_type);
 int i2c_simulator_remove_device(int bus, uint8_t address);
 
@@ -191,6 +270,8 @@ int mpu6050_fifo_enable(uint8_t address, bool enable);
 int mpu6050_fifo_reset(uint8_t address);
 int mpu6050_fifo_get_count(uint8_t address, uint16_t* count);
 int mpu6050_fifo_read(uint8_t address, uint8_t* data, size_t len);
+uint64_t mpu6050_update_background(mpu6050_state_t* state, uint64_t now_ns);
+void mpu6050_schedule(mpu6050_state_t* state); // After a change to whether or how fast it streams
 
 // Power management
 int mpu6050_set_power_state(uint8_t address, power_state_t state);
@@ -208,14 +289,30 @@ void print_performance_report(void);
 
 // Configuration
 int set_bus_noise_level(int bus, double noise_level);
-int set_global_latency(uint32_t latency_us);
+int set_bus_smbus_only(int bus, bool smbus_only);
+int set_global_latency(uint32_t latency_us);       // Of the current context
 int enable_debug_logging(bool enable);
 
+// Simulated time. The simulator reads sim_time_ns(), which is the real
+// CLOCK_MONOTONIC unless i2c_simulator_set_virtual_time() selected the
+// discrete-event clock. That clock stands still while any participating
+// thread runs; once every one waits in sim_sleep_us() it jumps straight to
+// the earliest wakeup and the devices generate the samples due by then.
+// Threads take part from their first sleep until they exit, and wait for
+// other threads through sim_thread_join() so that they stop counting.
+int i2c_simulator_set_virtual_time(bool enable); // While no context runs
+bool i2c_simulator_virtual_time(void);
+uint64_t sim_time_ns(void);
+void sim_sleep_us(uint64_t us);
+void sim_delay_us(uint64_t us);   // Time spent inside a transaction
+int sim_thread_join(pthread_t thread, void** retval);
+
 // Utility functions
 double get_simulation_time_ms(void);
 uint32_t generate_realistic_timestamp(void);
 void simulate_processing_delay(void);
 bool should_inject_error(double probability);
+uint32_t sim_rand(void);          // Per-thread generator, 0 to SIM_RAND_MAX
 
 // Device function declarations
 int mpu6050_read_register(void* device, uint8_t reg, uint8_t* data);
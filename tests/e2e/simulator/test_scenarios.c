@@ -3,6 +3,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
 #include <unistd.h>
 #include <time.h>
 #include <math.h>
@@ -189,10 +190,15 @@ static int test_error_injection(void);
 static int test_power_management(void);
 static int test_concurrent_access(void);
 static int test_performance_limits(void);
+static int test_fifo_bulk_drain(void);
+static int test_fifo_streaming(void);
+static int test_independent_contexts(void);
+static int test_sample_scheduling(void);
 static int validate_sensor_data_ranges(const sensor_data_t* data);
 static int run_basic_i2c_tests(void);
 static void* concurrent_read_thread(void* arg);
 static void* concurrent_write_thread(void* arg);
+static void* context_thread(void* arg);
 
 // Thread parameters for concurrent testing
 typedef struct {
@@ -260,8 +266,7 @@ int run_test_scenario(const test_scenario_t* scenario) {
     // Reset performance metrics
     reset_performance_metrics();
     
-    struct timespec start_time, current_time;
-    clock_gettime(CLOCK_MONOTONIC, &start_time);
+    uint64_t start_time = sim_time_ns();
     
     int total_samples = 0;
     int successful_reads = 0;
@@ -330,11 +335,9 @@ int run_test_scenario(const test_scenario_t* scenario) {
         }
         
         // Sleep until next sample
-        usleep(sample_interval_us);
+        sim_sleep_us(sample_interval_us);
         
-        clock_gettime(CLOCK_MONOTONIC, &current_time);
-        elapsed_ms = (uint32_t)((current_time.tv_sec - start_time.tv_sec) * 1000 + 
-                               (current_time.tv_nsec - start_time.tv_nsec) / 1000000);
+        elapsed_ms = (uint32_t)((sim_time_ns() - start_time) / 1000000);
     }
     
     printf("Test completed: %d total samples, %d successful reads, %d errors\n", 
@@ -495,7 +498,7 @@ static int test_concurrent_access(void) {
     
     // Wait for all threads to complete
     for (int i = 0; i < num_threads; i++) {
-        pthread_join(threads[i], NULL);
+        sim_thread_join(threads[i], NULL);
     }
     
     printf("Concurrent access test: %d success, %d errors\n", 
@@ -515,6 +518,352 @@ static int test_performance_limits(void) {
     return run_test_scenario(scenario);
 }
 
+// Queue a full FIFO of known bytes through FIFO_R_W
+static int fill_fifo_pattern(int bus, uint8_t device_addr, uint8_t* expected) {
+    if (mpu6050_fifo_reset(device_addr) != 0) {
+        return -1;
+    }
+    
+    for (int i = 0; i < FIFO_BUFFER_SIZE; i++) {
+        expected[i] = (uint8_t)(i * 7);
+        if (i2c_simulator_write_byte(bus, device_addr, MPU6050_FIFO_R_W, expected[i]) != 0) {
+            return -1;
+        }
+    }
+    
+    return 0;
+}
+
+static int test_fifo_bulk_drain(void) {
+    printf("\n=== Testing FIFO Bulk Drain ===\n");
+    
+    if (i2c_simulator_init() != 0) {
+        printf("ERROR: Failed to initialize simulator\n");
+        return -1;
+    }
+    
+    const uint8_t device_addr = MPU6050_ADDR;
+    const int bus = 1;
+    uint8_t expected[FIFO_BUFFER_SIZE];
+    uint8_t drained[FIFO_BUFFER_SIZE];
+    uint16_t count = 0;
+    int failures = 0;
+    
+    if (i2c_simulator_add_device(bus, device_addr, "mpu6050") != 0) {
+        printf("ERROR: Failed to add device\n");
+        return -1;
+    }
+    
+    // Plain I2C adapter: the whole FIFO comes out in one transaction
+    set_bus_smbus_only(bus, false);
+    if (fill_fifo_pattern(bus, device_addr, expected) != 0 ||
+        i2c_simulator_read_burst(bus, device_addr, MPU6050_FIFO_R_W, drained,
+                                 sizeof(drained)) != 0 ||
+        memcmp(drained, expected, sizeof(drained)) != 0 ||
+        mpu6050_fifo_get_count(device_addr, &count) != 0 || count != 0) {
+        printf("FAIL: Single %d-byte FIFO burst\n", FIFO_BUFFER_SIZE);
+        failures++;
+    } else {
+        printf("PASS: Drained %d bytes in one I2C transaction\n", FIFO_BUFFER_SIZE);
+    }
+    
+    // SMBus-only adapter: large bursts are refused, 32-byte chunks work
+    set_bus_smbus_only(bus, true);
+    int chunks = 0;
+    int ret = fill_fifo_pattern(bus, device_addr, expected);
+    if (ret == 0 &&
+        i2c_simulator_read_burst(bus, device_addr, MPU6050_FIFO_R_W, drained,
+                                 sizeof(drained)) != -EOPNOTSUPP) {
+        ret = -1;
+    }
+    for (size_t done = 0; ret == 0 && done < sizeof(drained); done += I2C_SMBUS_BLOCK_MAX) {
+        ret = i2c_simulator_read_burst(bus, device_addr, MPU6050_FIFO_R_W, &drained[done],
+                                       I2C_SMBUS_BLOCK_MAX);
+        chunks++;
+    }
+    if (ret != 0 || memcmp(drained, expected, sizeof(drained)) != 0 ||
+        chunks != FIFO_BUFFER_SIZE / I2C_SMBUS_BLOCK_MAX) {
+        printf("FAIL: Chunked SMBus FIFO drain\n");
+        failures++;
+    } else {
+        printf("PASS: Drained %d bytes in %d SMBus block reads\n", FIFO_BUFFER_SIZE, chunks);
+    }
+    
+    set_bus_smbus_only(bus, false);
+    i2c_simulator_remove_device(bus, device_addr);
+    
+    return failures > 0 ? -1 : 0;
+}
+
+// Read FIFO_COUNT as the driver does, COUNTH first so the pair is latched
+static int read_fifo_count(int bus, uint8_t device_addr, uint16_t* count) {
+    uint8_t buf[2];
+    int ret = i2c_simulator_read_burst(bus, device_addr, MPU6050_FIFO_COUNTH, buf, sizeof(buf));
+    if (ret == 0) {
+        *count = (uint16_t)((buf[0] << 8) | buf[1]);
+    }
+    return ret;
+}
+
+static int test_fifo_streaming(void) {
+    printf("\n=== Testing FIFO Streaming ===\n");
+    
+    if (i2c_simulator_init() != 0) {
+        printf("ERROR: Failed to initialize simulator\n");
+        return -1;
+    }
+    
+    const uint8_t device_addr = MPU6050_ADDR;
+    const int bus = 0;
+    const int frame = 14;
+    uint8_t data[FIFO_BUFFER_SIZE];
+    uint8_t status;
+    uint16_t count = 0;
+    int failures = 0;
+    
+    if (i2c_simulator_add_device(bus, device_addr, "mpu6050") != 0) {
+        printf("ERROR: Failed to add device\n");
+        return -1;
+    }
+    mpu6050_simulator_set_pattern(device_addr, PATTERN_STATIC);
+    
+    // Program the FIFO as the driver does: 1 kHz, accel, temperature and gyro
+    i2c_simulator_write_byte(bus, device_addr, MPU6050_PWR_MGMT_1, 0x00);
+    i2c_simulator_write_byte(bus, device_addr, MPU6050_CONFIG, 0x01);
+    i2c_simulator_write_byte(bus, device_addr, MPU6050_SMPLRT_DIV, 0x00);
+    i2c_simulator_write_byte(bus, device_addr, MPU6050_FIFO_EN, MPU6050_FIFO_EN_SENSORS);
+    i2c_simulator_write_byte(bus, device_addr, MPU6050_USER_CTRL,
+                             MPU6050_USER_CTRL_FIFO_EN | MPU6050_USER_CTRL_FIFO_RST);
+    i2c_simulator_read_byte(bus, device_addr, MPU6050_INT_STATUS, &status);
+    
+    // Drain whole frames for 200 ms
+    uint64_t start = sim_time_ns();
+    int frames = 0, misaligned = 0, corrupt = 0;
+    uint32_t elapsed_ms = 0;
+
+    while (elapsed_ms < 200) {
+        if (read_fifo_count(bus, device_addr, &count) == 0) {
+            misaligned += count % frame != 0;
+            size_t len = count - count % frame;
+            if (len > 0 && i2c_simulator_read_burst(bus, device_addr, MPU6050_FIFO_R_W,
+                                                    data, len) == 0) {
+                for (size_t i = 0; i < len; i += frame) {
+                    int16_t az = (int16_t)((data[i + 4] << 8) | data[i + 5]);
+                    corrupt += az != 16384;
+                }
+                frames += len / frame;
+            }
+        }
+        sim_sleep_us(5000);
+        elapsed_ms = (uint32_t)((sim_time_ns() - start) / 1000000);
+    }
+    i2c_simulator_read_byte(bus, device_addr, MPU6050_INT_STATUS, &status);
+    
+    double expected = elapsed_ms; // One frame per millisecond
+    if (misaligned || corrupt || frames < expected * 0.75 || frames > expected * 1.1 ||
+        (status & MPU6050_INT_FIFO_OFLOW)) {
+        printf("FAIL: Streamed %d frames in %u ms (%d misaligned counts, %d corrupt)\n",
+               frames, elapsed_ms, misaligned, corrupt);
+        failures++;
+    } else {
+        printf("PASS: Streamed %d whole frames at 1 kHz in %u ms\n", frames, elapsed_ms);
+    }
+    
+    // Stop draining: the FIFO keeps whole frames and flags the overflow.
+    // Then put the sensor to sleep, so no later frame raises the flag again
+    // between the two INT_STATUS reads.
+    sim_sleep_us(150000);
+    i2c_simulator_write_byte(bus, device_addr, MPU6050_PWR_MGMT_1, 0x40);
+    sim_sleep_us(2000);
+    read_fifo_count(bus, device_addr, &count);
+    i2c_simulator_read_byte(bus, device_addr, MPU6050_INT_STATUS, &status);
+    uint8_t cleared;
+    i2c_simulator_read_byte(bus, device_addr, MPU6050_INT_STATUS, &cleared);
+    if (count != FIFO_BUFFER_SIZE / frame * frame || !(status & MPU6050_INT_FIFO_OFLOW) ||
+        (cleared & MPU6050_INT_FIFO_OFLOW)) {
+        printf("FAIL: Overflow left %u bytes, INT_STATUS 0x%02X then 0x%02X\n",
+               count, status, cleared);
+        failures++;
+    } else {
+        printf("PASS: Overflow kept %u bytes and raised FIFO_OFLOW_INT\n", count);
+    }
+    
+    // FIFO_RESET empties it
+    i2c_simulator_write_byte(bus, device_addr, MPU6050_USER_CTRL,
+                             MPU6050_USER_CTRL_FIFO_EN | MPU6050_USER_CTRL_FIFO_RST);
+    read_fifo_count(bus, device_addr, &count);
+    if (count >= 3 * frame) {
+        printf("FAIL: %u bytes left after FIFO_RESET\n", count);
+        failures++;
+    } else {
+        printf("PASS: FIFO_RESET emptied the FIFO\n");
+    }
+    
+    i2c_simulator_write_byte(bus, device_addr, MPU6050_USER_CTRL, 0x00);
+    i2c_simulator_remove_device(bus, device_addr);
+    
+    return failures > 0 ? -1 : 0;
+}
+
+// Start a FIFO stream of whole 14-byte frames at 1 kHz / (1 + @div)
+static void start_fifo_stream(int bus, uint8_t device_addr, uint8_t div) {
+    i2c_simulator_write_byte(bus, device_addr, MPU6050_PWR_MGMT_1, 0x00);
+    i2c_simulator_write_byte(bus, device_addr, MPU6050_CONFIG, 0x01);
+    i2c_simulator_write_byte(bus, device_addr, MPU6050_SMPLRT_DIV, div);
+    i2c_simulator_write_byte(bus, device_addr, MPU6050_FIFO_EN, MPU6050_FIFO_EN_SENSORS);
+    i2c_simulator_write_byte(bus, device_addr, MPU6050_USER_CTRL,
+                             MPU6050_USER_CTRL_FIFO_EN | MPU6050_USER_CTRL_FIFO_RST);
+}
+
+static int test_sample_scheduling(void) {
+    printf("\n=== Testing Per-Device Sample Scheduling ===\n");
+    
+    if (i2c_simulator_init() != 0) {
+        printf("ERROR: Failed to initialize simulator\n");
+        return -1;
+    }
+    
+    const int bus = 0;
+    const uint8_t fast = 0x68, slow = 0x69, asleep = 0x6A;
+    const int frame = 14;
+    uint16_t count_fast = 0, count_slow = 0, count_asleep = 0;
+    uint8_t status;
+    int failures = 0;
+    
+    if (i2c_simulator_add_device(bus, fast, "mpu6050") != 0 ||
+        i2c_simulator_add_device(bus, slow, "mpu6050") != 0 ||
+        i2c_simulator_add_device(bus, asleep, "mpu6050") != 0) {
+        printf("ERROR: Failed to add devices\n");
+        return -1;
+    }
+    
+    // 1 kHz and 200 Hz, and a third configured alike but put back to sleep
+    uint64_t start = sim_time_ns();
+    start_fifo_stream(bus, fast, 0);
+    start_fifo_stream(bus, slow, 4);
+    start_fifo_stream(bus, asleep, 0);
+    i2c_simulator_write_byte(bus, asleep, MPU6050_PWR_MGMT_1, 0x40);
+    i2c_simulator_write_byte(bus, asleep, MPU6050_USER_CTRL,
+                             MPU6050_USER_CTRL_FIFO_EN | MPU6050_USER_CTRL_FIFO_RST);
+    i2c_simulator_read_byte(bus, fast, MPU6050_INT_STATUS, &status);
+    
+    // The 1 kHz FIFO holds 73 frames, so overflows 74 ms in
+    sim_sleep_us(60000);
+    read_fifo_count(bus, fast, &count_fast);
+    read_fifo_count(bus, slow, &count_slow);
+    read_fifo_count(bus, asleep, &count_asleep);
+    i2c_simulator_read_byte(bus, fast, MPU6050_INT_STATUS, &status);
+    uint32_t elapsed_ms = (uint32_t)((sim_time_ns() - start) / 1000000);
+    
+    uint32_t frames_fast = count_fast / frame, frames_slow = count_slow / frame;
+    if (frames_fast < elapsed_ms * 0.85 || frames_fast > elapsed_ms + 1 ||
+        frames_slow < elapsed_ms / 5 * 0.85 || frames_slow > elapsed_ms / 5 + 1) {
+        printf("FAIL: %u and %u frames in %u ms at 1 kHz and 200 Hz\n",
+               frames_fast, frames_slow, elapsed_ms);
+        failures++;
+    } else {
+        printf("PASS: %u and %u frames in %u ms at 1 kHz and 200 Hz\n",
+               frames_fast, frames_slow, elapsed_ms);
+    }
+    if (count_asleep != 0) {
+        printf("FAIL: Sleeping device produced %u bytes\n", count_asleep);
+        failures++;
+    } else {
+        printf("PASS: Sleeping device produced nothing\n");
+    }
+    if (status & MPU6050_INT_FIFO_OFLOW) {
+        printf("FAIL: FIFO_OFLOW_INT raised %u ms in, before the FIFO filled\n", elapsed_ms);
+        failures++;
+    }
+    
+    sim_sleep_us(30000);
+    i2c_simulator_read_byte(bus, fast, MPU6050_INT_STATUS, &status);
+    if (!(status & MPU6050_INT_FIFO_OFLOW)) {
+        printf("FAIL: No FIFO_OFLOW_INT %u ms in\n",
+               (uint32_t)((sim_time_ns() - start) / 1000000));
+        failures++;
+    } else {
+        printf("PASS: FIFO_OFLOW_INT raised between 60 and 90 ms\n");
+    }
+    
+    i2c_simulator_remove_device(bus, fast);
+    i2c_simulator_remove_device(bus, slow);
+    i2c_simulator_remove_device(bus, asleep);
+    
+    return failures > 0 ? -1 : 0;
+}
+
+#define CONTEXT_THREADS     4
+#define CONTEXT_ITERATIONS  200
+
+typedef struct {
+    uint8_t value;      // Written to SMPLRT_DIV, distinct per thread
+    int result;
+} context_params_t;
+
+// Each thread runs its own simulator with the same device at the same
+// address; nothing it writes or counts may show up in another
+static void* context_thread(void* arg) {
+    context_params_t* params = (context_params_t*)arg;
+    const int bus = 1;
+    
+    params->result = -1;
+    i2c_simulator_t* sim = i2c_simulator_create();
+    if (!sim) {
+        return NULL;
+    }
+    i2c_simulator_t* prev = i2c_simulator_use(sim);
+    
+    int ok = i2c_simulator_add_device(bus, MPU6050_ADDR, "mpu6050") == 0;
+    for (int i = 0; ok && i < CONTEXT_ITERATIONS; i++) {
+        uint8_t data = 0;
+        ok = i2c_simulator_write_byte(bus, MPU6050_ADDR, MPU6050_SMPLRT_DIV, params->value) == 0 &&
+             i2c_simulator_read_byte(bus, MPU6050_ADDR, MPU6050_SMPLRT_DIV, &data) == 0 &&
+             data == params->value;
+        sim_sleep_us(50);
+    }
+    
+    performance_metrics_t metrics = get_performance_metrics();
+    if (ok && metrics.total_reads == CONTEXT_ITERATIONS &&
+        metrics.total_writes == CONTEXT_ITERATIONS) {
+        params->result = 0;
+    }
+    
+    i2c_simulator_use(prev);
+    i2c_simulator_destroy(sim);
+    return NULL;
+}
+
+static int test_independent_contexts(void) {
+    printf("\n=== Testing Independent Simulator Contexts ===\n");
+    
+    pthread_t threads[CONTEXT_THREADS];
+    context_params_t params[CONTEXT_THREADS];
+    int failures = 0;
+    
+    for (int i = 0; i < CONTEXT_THREADS; i++) {
+        params[i].value = (uint8_t)(0x10 + i);
+        params[i].result = -1;
+        if (pthread_create(&threads[i], NULL, context_thread, &params[i]) != 0) {
+            printf("ERROR: Failed to create context thread %d\n", i);
+            return -1;
+        }
+    }
+    for (int i = 0; i < CONTEXT_THREADS; i++) {
+        sim_thread_join(threads[i], NULL);
+        if (params[i].result != 0) {
+            printf("FAIL: Context %d saw another context's registers or metrics\n", i);
+            failures++;
+        }
+    }
+    
+    if (failures == 0) {
+        printf("PASS: %d contexts ran %d transactions each in isolation\n",
+               CONTEXT_THREADS, 2 * CONTEXT_ITERATIONS);
+    }
+    return failures > 0 ? -1 : 0;
+}
+
 static int validate_sensor_data_ranges(const sensor_data_t* data) {
     if (!data) return -1;
     
@@ -629,7 +978,7 @@ static void* concurrent_read_thread(void* arg) {
         }
         
         // Small delay to allow other threads to run
-        usleep(100);
+        sim_sleep_us(100);
     }
     
     return NULL;
@@ -648,7 +997,7 @@ static void* concurrent_write_thread(void* arg) {
         }
         
         // Small delay to allow other threads to run
-        usleep(150);
+        sim_sleep_us(150);
     }
     
     return NULL;
@@ -682,7 +1031,11 @@ int run_all_test_scenarios(void) {
         {"Error Injection", test_error_injection},
         {"Power Management", test_power_management},
         {"Concurrent Access", test_concurrent_access},
-        {"Performance Limits", test_performance_limits}
+        {"Performance Limits", test_performance_limits},
+        {"FIFO Bulk Drain", test_fifo_bulk_drain},
+        {"FIFO Streaming", test_fifo_streaming},
+        {"Independent Contexts", test_independent_contexts},
+        {"Sample Scheduling", test_sample_scheduling}
     };
     
     for (size_t i = 0; i < sizeof(test_categories) / sizeof(test_categories[0]); i++) {
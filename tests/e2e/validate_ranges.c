@@ -10,6 +10,11 @@
  * - Temperature range validation
  * - Data integrity and consistency checks
  * - Range switching verification
+ * - Throughput and dropped samples per range and DLPF setting
+ *
+ * Samples are read ahead in batches from the streaming buffer and folded
+ * into running statistics as they arrive, so memory use is constant and a
+ * long run (-l) can validate millions of samples per range.
  *
  * Copyright (C) 2025 Murray Kopit <murr2k@gmail.com>
  *
@@ -34,11 +39,17 @@
 #include <time.h>
 #include <signal.h>
 #include <stdarg.h>
+#include <stdint.h>
 
 #include "../../include/mpu6050.h"
 
 #define DEVICE_PATH "/dev/mpu6050"
 #define NUM_SAMPLES_PER_RANGE 50
+#define LONG_SAMPLES_PER_RANGE 1000000ULL
+#define BATCH_RECORDS 256      /* Records per batch ioctl */
+#define BATCH_TIMEOUT_MS 200
+#define MAX_IDLE_BATCHES 10    /* Empty batches in a row before giving up */
+#define NUM_DLPF_SETTINGS 7
 #define STABILITY_THRESHOLD_ACCEL 0.1  /* 100mg stability threshold */
 #define STABILITY_THRESHOLD_GYRO 0.05  /* 50mdps stability threshold */
 
@@ -88,22 +99,49 @@ struct test_stats {
     struct timeval end_time;
 };
 
+/* Online statistics of one value stream */
+struct running_stats {
+    unsigned long long count;
+    double mean;
+    double m2;             /* Sum of squared deviations from the mean */
+    double min;
+    double max;
+};
+
+enum sensor_kind {
+    SENSOR_ACCEL,
+    SENSOR_GYRO,
+};
+
 /* Range test results */
 struct range_test_result {
     const struct range_config *range;
-    int samples_collected;
-    double mean_x, mean_y, mean_z;
-    double stdev_x, stdev_y, stdev_z;
-    double max_x, max_y, max_z;
-    double min_x, min_y, min_z;
+    enum sensor_kind kind;
+    u8 dlpf_cfg;
+    unsigned long long samples_requested;
+    unsigned long long samples_collected;
+    unsigned long long samples_dropped;    /* Sequence gaps while streaming */
+    unsigned long long fifo_overflows;     /* Records flagged MPU6050_SAMPLE_FIFO_OVERFLOW */
+    double elapsed;                        /* Seconds spent collecting */
+    int streamed;                          /* Batched rather than polled */
+    struct running_stats axis[3];
     int range_violations;
     int stability_violations;
     int passed;
 };
 
+/* Throughput of every range and DLPF setting tested, for the summary */
+#define MAX_THROUGHPUT_ROWS ((4 + 4) * NUM_DLPF_SETTINGS)
+static struct range_test_result g_throughput[MAX_THROUGHPUT_ROWS];
+static int g_throughput_rows;
+
 /* Global variables */
 static int g_verbose = 0;
 static int g_running = 1;
+static unsigned long long g_samples_per_range = NUM_SAMPLES_PER_RANGE;
+static u8 g_sample_rate_div = 7;      /* 125Hz with the DLPF enabled */
+static u8 g_dlpf_first = 3;           /* 44Hz low-pass filter */
+static u8 g_dlpf_last = 3;
 
 /**
  * Signal handler for graceful shutdown
@@ -149,288 +187,256 @@ static void verbose_log(const char *format, ...) {
 }
 
 /**
- * Calculate mean of an array
+ * Reset running statistics
  */
-static double calculate_mean(double *values, int count) {
-    if (count == 0) return 0.0;
-    
-    double sum = 0.0;
-    for (int i = 0; i < count; i++) {
-        sum += values[i];
-    }
-    return sum / count;
+static void stats_reset(struct running_stats *stats) {
+    memset(stats, 0, sizeof(*stats));
 }
 
 /**
- * Calculate standard deviation of an array
+ * Add one value to running statistics (Welford's method)
  */
-static double calculate_stdev(double *values, int count, double mean) {
-    if (count <= 1) return 0.0;
+static void stats_add(struct running_stats *stats, double value) {
+    double delta = value - stats->mean;
     
-    double sum_sq = 0.0;
-    for (int i = 0; i < count; i++) {
-        double diff = values[i] - mean;
-        sum_sq += diff * diff;
+    if (stats->count == 0 || value < stats->min) {
+        stats->min = value;
+    }
+    if (stats->count == 0 || value > stats->max) {
+        stats->max = value;
     }
-    return sqrt(sum_sq / (count - 1));
+    
+    stats->count++;
+    stats->mean += delta / stats->count;
+    stats->m2 += delta * (value - stats->mean);
 }
 
 /**
- * Find minimum value in array
+ * Sample standard deviation of running statistics
  */
-static double find_min(double *values, int count) {
-    if (count == 0) return 0.0;
+static double stats_stdev(const struct running_stats *stats) {
+    if (stats->count <= 1) return 0.0;
     
-    double min = values[0];
-    for (int i = 1; i < count; i++) {
-        if (values[i] < min) {
-            min = values[i];
-        }
-    }
-    return min;
+    return sqrt(stats->m2 / (stats->count - 1));
 }
 
 /**
- * Find maximum value in array
+ * Seconds elapsed since a CLOCK_MONOTONIC timestamp
  */
-static double find_max(double *values, int count) {
-    if (count == 0) return 0.0;
+static double elapsed_since(const struct timespec *start) {
+    struct timespec now;
     
-    double max = values[0];
-    for (int i = 1; i < count; i++) {
-        if (values[i] > max) {
-            max = values[i];
-        }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/**
+ * Feed the three axes of one reading into the range statistics
+ */
+static void add_reading(struct range_test_result *result, enum sensor_kind kind,
+                        const struct mpu6050_scaled_data *data) {
+    if (kind == SENSOR_ACCEL) {
+        stats_add(&result->axis[0], data->accel_x);
+        stats_add(&result->axis[1], data->accel_y);
+        stats_add(&result->axis[2], data->accel_z);
+    } else {
+        stats_add(&result->axis[0], data->gyro_x);
+        stats_add(&result->axis[1], data->gyro_y);
+        stats_add(&result->axis[2], data->gyro_z);
     }
-    return max;
 }
 
 /**
- * Test accelerometer range configuration
+ * Collect samples through the streaming buffer, a batch per ioctl
+ *
+ * The driver keeps sampling into its buffer while a batch is processed, so
+ * reads never gate acquisition. Sequence gaps count as dropped samples.
+ * Returns -1 if the device cannot stream.
  */
-static int test_accelerometer_range(int fd, const struct range_config *range, 
-                                   struct range_test_result *result) {
-    printf(COLOR_YELLOW "Testing accelerometer range: %s" COLOR_RESET "\n", range->name);
-    
-    memset(result, 0, sizeof(*result));
-    result->range = range;
-    
-    /* Set configuration for this range */
-    struct mpu6050_config config = {
-        .sample_rate_div = 7,  /* 125Hz */
-        .gyro_range = MPU6050_GYRO_FS_250,  /* Keep gyro at minimum range */
-        .accel_range = range->value,
-        .dlpf_cfg = 0x03  /* 44Hz low-pass filter */
-    };
-    
-    int ret = ioctl(fd, MPU6050_IOC_SET_CONFIG, &config);
-    if (ret < 0) {
-        verbose_log("Failed to set accelerometer range %s: %s", range->name, strerror(errno));
-        return 0;
+static int collect_streaming(int fd, enum sensor_kind kind, struct range_test_result *result) {
+    static struct mpu6050_scaled_sample records[BATCH_RECORDS];
+    uint32_t next_seq = 0;
+    int have_seq = 0;
+    int idle_batches = 0;
+    int enable = 1;
+    
+    if (ioctl(fd, MPU6050_IOC_SET_STREAMING, &enable) < 0) {
+        verbose_log("Streaming unavailable: %s", strerror(errno));
+        return -1;
+    }
+    result->streamed = 1;
+    
+    while (result->samples_collected < result->samples_requested && g_running) {
+        unsigned long long remaining = result->samples_requested - result->samples_collected;
+        struct mpu6050_batch batch = {
+            .buf = (uintptr_t)records,
+            .count = remaining < BATCH_RECORDS ? (uint32_t)remaining : BATCH_RECORDS,
+            .timeout_ms = BATCH_TIMEOUT_MS,
+        };
+        
+        if (ioctl(fd, MPU6050_IOC_READ_SCALED_BATCH, &batch) < 0) {
+            verbose_log("Batch read failed: %s", strerror(errno));
+            break;
+        }
+        
+        if (batch.count == 0) {
+            if (++idle_batches >= MAX_IDLE_BATCHES) {
+                verbose_log("No samples for %d ms, giving up", MAX_IDLE_BATCHES * BATCH_TIMEOUT_MS);
+                break;
+            }
+            continue;
+        }
+        idle_batches = 0;
+        
+        for (uint32_t i = 0; i < batch.count; i++) {
+            if (have_seq && (int32_t)(records[i].seq - next_seq) > 0) {
+                result->samples_dropped += records[i].seq - next_seq;
+            }
+            next_seq = records[i].seq + 1;
+            have_seq = 1;
+            
+            if (records[i].flags & MPU6050_SAMPLE_FIFO_OVERFLOW) {
+                result->fifo_overflows++;
+            }
+            add_reading(result, kind, &records[i].scaled);
+        }
+        result->samples_collected += batch.count;
     }
     
-    /* Wait for configuration to settle */
-    usleep(100000);  /* 100ms */
-    
-    /* Collect samples */
-    double accel_x[NUM_SAMPLES_PER_RANGE];
-    double accel_y[NUM_SAMPLES_PER_RANGE];
-    double accel_z[NUM_SAMPLES_PER_RANGE];
-    int samples_collected = 0;
+    enable = 0;
+    ioctl(fd, MPU6050_IOC_SET_STREAMING, &enable);
+    return 0;
+}
+
+/**
+ * Collect samples with one-shot reads, for devices that cannot stream
+ */
+static void collect_polled(int fd, enum sensor_kind kind, struct range_test_result *result) {
+    unsigned long long attempts = 0;
     
-    for (int i = 0; i < NUM_SAMPLES_PER_RANGE && g_running; i++) {
+    while (attempts < result->samples_requested && g_running) {
         struct mpu6050_scaled_data data;
-        ret = ioctl(fd, MPU6050_IOC_READ_SCALED, &data);
         
-        if (ret == 0) {
-            accel_x[samples_collected] = (double)data.accel_x;
-            accel_y[samples_collected] = (double)data.accel_y;
-            accel_z[samples_collected] = (double)data.accel_z;
-            samples_collected++;
-            
-            verbose_log("Sample %d: X=%d mg, Y=%d mg, Z=%d mg", 
-                       i, data.accel_x, data.accel_y, data.accel_z);
+        attempts++;
+        if (ioctl(fd, MPU6050_IOC_READ_SCALED, &data) == 0) {
+            add_reading(result, kind, &data);
+            result->samples_collected++;
         } else {
-            verbose_log("Failed to read sample %d: %s", i, strerror(errno));
+            verbose_log("Failed to read sample %llu: %s", attempts, strerror(errno));
         }
         
         usleep(10000);  /* 10ms between samples */
     }
-    
-    result->samples_collected = samples_collected;
-    
-    if (samples_collected < NUM_SAMPLES_PER_RANGE / 2) {
-        verbose_log("Insufficient samples collected: %d/%d", samples_collected, NUM_SAMPLES_PER_RANGE);
-        return 0;
-    }
-    
-    /* Calculate statistics */
-    result->mean_x = calculate_mean(accel_x, samples_collected);
-    result->mean_y = calculate_mean(accel_y, samples_collected);
-    result->mean_z = calculate_mean(accel_z, samples_collected);
-    
-    result->stdev_x = calculate_stdev(accel_x, samples_collected, result->mean_x);
-    result->stdev_y = calculate_stdev(accel_y, samples_collected, result->mean_y);
-    result->stdev_z = calculate_stdev(accel_z, samples_collected, result->mean_z);
-    
-    result->min_x = find_min(accel_x, samples_collected);
-    result->min_y = find_min(accel_y, samples_collected);
-    result->min_z = find_min(accel_z, samples_collected);
-    
-    result->max_x = find_max(accel_x, samples_collected);
-    result->max_y = find_max(accel_y, samples_collected);
-    result->max_z = find_max(accel_z, samples_collected);
-    
-    /* Check for range violations */
-    double max_expected = range->max_value;
-    double values[] = {result->max_x, result->max_y, result->max_z,
-                       -result->min_x, -result->min_y, -result->min_z};
-    
-    for (int i = 0; i < 6; i++) {
-        if (fabs(values[i]) > max_expected) {
-            result->range_violations++;
-        }
-    }
-    
-    /* Check for stability (noise should be reasonable) */
-    double noise_threshold = range->max_value * STABILITY_THRESHOLD_ACCEL;
-    if (result->stdev_x > noise_threshold || 
-        result->stdev_y > noise_threshold || 
-        result->stdev_z > noise_threshold) {
-        result->stability_violations++;
-    }
-    
-    /* Test passes if no range violations and reasonable stability */
-    result->passed = (result->range_violations == 0 && result->stability_violations == 0);
-    
-    /* Print results */
-    printf("  Samples collected: %d/%d\n", samples_collected, NUM_SAMPLES_PER_RANGE);
-    printf("  Mean: X=%.1f, Y=%.1f, Z=%.1f %s\n", 
-           result->mean_x, result->mean_y, result->mean_z, range->unit);
-    printf("  Std Dev: X=%.2f, Y=%.2f, Z=%.2f %s\n", 
-           result->stdev_x, result->stdev_y, result->stdev_z, range->unit);
-    printf("  Range: X=[%.1f,%.1f], Y=[%.1f,%.1f], Z=[%.1f,%.1f] %s\n",
-           result->min_x, result->max_x, result->min_y, result->max_y, 
-           result->min_z, result->max_z, range->unit);
-    printf("  Range violations: %d\n", result->range_violations);
-    printf("  Stability violations: %d\n", result->stability_violations);
-    
-    return result->passed;
 }
 
 /**
- * Test gyroscope range configuration
+ * Configure one range and DLPF setting, then validate it in a single pass
  */
-static int test_gyroscope_range(int fd, const struct range_config *range, 
-                               struct range_test_result *result) {
-    printf(COLOR_YELLOW "Testing gyroscope range: %s" COLOR_RESET "\n", range->name);
+static int test_sensor_range(int fd, enum sensor_kind kind, const struct range_config *range,
+                             u8 dlpf_cfg, struct range_test_result *result) {
+    const char *sensor = kind == SENSOR_ACCEL ? "accelerometer" : "gyroscope";
+    static const char *axis_names[] = {"X", "Y", "Z"};
+    
+    printf(COLOR_YELLOW "Testing %s range: %s, DLPF %u" COLOR_RESET "\n", sensor, range->name, dlpf_cfg);
     
     memset(result, 0, sizeof(*result));
     result->range = range;
+    result->kind = kind;
+    result->dlpf_cfg = dlpf_cfg;
+    result->samples_requested = g_samples_per_range;
+    for (int i = 0; i < 3; i++) {
+        stats_reset(&result->axis[i]);
+    }
     
-    /* Set configuration for this range */
+    /* Keep the other sensor at its minimum range */
     struct mpu6050_config config = {
-        .sample_rate_div = 7,  /* 125Hz */
-        .gyro_range = range->value,
-        .accel_range = MPU6050_ACCEL_FS_2G,  /* Keep accel at minimum range */
-        .dlpf_cfg = 0x03  /* 44Hz low-pass filter */
+        .sample_rate_div = g_sample_rate_div,
+        .gyro_range = kind == SENSOR_GYRO ? range->value : MPU6050_GYRO_FS_250,
+        .accel_range = kind == SENSOR_ACCEL ? range->value : MPU6050_ACCEL_FS_2G,
+        .dlpf_cfg = dlpf_cfg
     };
     
     int ret = ioctl(fd, MPU6050_IOC_SET_CONFIG, &config);
     if (ret < 0) {
-        verbose_log("Failed to set gyroscope range %s: %s", range->name, strerror(errno));
+        verbose_log("Failed to set %s range %s: %s", sensor, range->name, strerror(errno));
         return 0;
     }
     
     /* Wait for configuration to settle */
     usleep(100000);  /* 100ms */
     
-    /* Collect samples */
-    double gyro_x[NUM_SAMPLES_PER_RANGE];
-    double gyro_y[NUM_SAMPLES_PER_RANGE];
-    double gyro_z[NUM_SAMPLES_PER_RANGE];
-    int samples_collected = 0;
-    
-    for (int i = 0; i < NUM_SAMPLES_PER_RANGE && g_running; i++) {
-        struct mpu6050_scaled_data data;
-        ret = ioctl(fd, MPU6050_IOC_READ_SCALED, &data);
-        
-        if (ret == 0) {
-            gyro_x[samples_collected] = (double)data.gyro_x;
-            gyro_y[samples_collected] = (double)data.gyro_y;
-            gyro_z[samples_collected] = (double)data.gyro_z;
-            samples_collected++;
-            
-            verbose_log("Sample %d: X=%d mdps, Y=%d mdps, Z=%d mdps", 
-                       i, data.gyro_x, data.gyro_y, data.gyro_z);
-        } else {
-            verbose_log("Failed to read sample %d: %s", i, strerror(errno));
-        }
-        
-        usleep(10000);  /* 10ms between samples */
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (collect_streaming(fd, kind, result) < 0) {
+        collect_polled(fd, kind, result);
     }
+    result->elapsed = elapsed_since(&start);
     
-    result->samples_collected = samples_collected;
-    
-    if (samples_collected < NUM_SAMPLES_PER_RANGE / 2) {
-        verbose_log("Insufficient samples collected: %d/%d", samples_collected, NUM_SAMPLES_PER_RANGE);
+    if (result->samples_collected < result->samples_requested / 2) {
+        verbose_log("Insufficient samples collected: %llu/%llu",
+                    result->samples_collected, result->samples_requested);
         return 0;
     }
     
-    /* Calculate statistics */
-    result->mean_x = calculate_mean(gyro_x, samples_collected);
-    result->mean_y = calculate_mean(gyro_y, samples_collected);
-    result->mean_z = calculate_mean(gyro_z, samples_collected);
-    
-    result->stdev_x = calculate_stdev(gyro_x, samples_collected, result->mean_x);
-    result->stdev_y = calculate_stdev(gyro_y, samples_collected, result->mean_y);
-    result->stdev_z = calculate_stdev(gyro_z, samples_collected, result->mean_z);
-    
-    result->min_x = find_min(gyro_x, samples_collected);
-    result->min_y = find_min(gyro_y, samples_collected);
-    result->min_z = find_min(gyro_z, samples_collected);
-    
-    result->max_x = find_max(gyro_x, samples_collected);
-    result->max_y = find_max(gyro_y, samples_collected);
-    result->max_z = find_max(gyro_z, samples_collected);
-    
     /* Check for range violations */
     double max_expected = range->max_value;
-    double values[] = {result->max_x, result->max_y, result->max_z,
-                       -result->min_x, -result->min_y, -result->min_z};
-    
-    for (int i = 0; i < 6; i++) {
-        if (fabs(values[i]) > max_expected) {
+    for (int i = 0; i < 3; i++) {
+        if (fabs(result->axis[i].max) > max_expected) {
+            result->range_violations++;
+        }
+        if (fabs(result->axis[i].min) > max_expected) {
             result->range_violations++;
         }
     }
     
     /* Check for stability (noise should be reasonable) */
-    double noise_threshold = range->max_value * STABILITY_THRESHOLD_GYRO;
-    if (result->stdev_x > noise_threshold || 
-        result->stdev_y > noise_threshold || 
-        result->stdev_z > noise_threshold) {
-        result->stability_violations++;
+    double threshold = kind == SENSOR_ACCEL ? STABILITY_THRESHOLD_ACCEL : STABILITY_THRESHOLD_GYRO;
+    double noise_threshold = range->max_value * threshold;
+    for (int i = 0; i < 3; i++) {
+        if (stats_stdev(&result->axis[i]) > noise_threshold) {
+            result->stability_violations++;
+            break;
+        }
     }
     
     /* Test passes if no range violations and reasonable stability */
     result->passed = (result->range_violations == 0 && result->stability_violations == 0);
     
     /* Print results */
-    printf("  Samples collected: %d/%d\n", samples_collected, NUM_SAMPLES_PER_RANGE);
-    printf("  Mean: X=%.1f, Y=%.1f, Z=%.1f %s\n", 
-           result->mean_x, result->mean_y, result->mean_z, range->unit);
-    printf("  Std Dev: X=%.2f, Y=%.2f, Z=%.2f %s\n", 
-           result->stdev_x, result->stdev_y, result->stdev_z, range->unit);
-    printf("  Range: X=[%.1f,%.1f], Y=[%.1f,%.1f], Z=[%.1f,%.1f] %s\n",
-           result->min_x, result->max_x, result->min_y, result->max_y, 
-           result->min_z, result->max_z, range->unit);
+    unsigned long long expected = result->samples_collected + result->samples_dropped;
+    printf("  Samples collected: %llu/%llu (%s)\n", result->samples_collected,
+           result->samples_requested, result->streamed ? "batched" : "polled");
+    for (int i = 0; i < 3; i++) {
+        printf("  %s: mean=%.1f, stdev=%.2f, range=[%.1f,%.1f] %s\n", axis_names[i],
+               result->axis[i].mean, stats_stdev(&result->axis[i]),
+               result->axis[i].min, result->axis[i].max, range->unit);
+    }
+    printf("  Throughput: %.1f samples/s over %.2f s\n",
+           result->elapsed > 0 ? result->samples_collected / result->elapsed : 0.0, result->elapsed);
+    printf("  Dropped: %llu (%.3f%%), FIFO overflows: %llu\n", result->samples_dropped,
+           expected ? 100.0 * result->samples_dropped / expected : 0.0, result->fifo_overflows);
     printf("  Range violations: %d\n", result->range_violations);
     printf("  Stability violations: %d\n", result->stability_violations);
     
     return result->passed;
 }
 
+/**
+ * Test accelerometer range configuration
+ */
+static int test_accelerometer_range(int fd, const struct range_config *range, u8 dlpf_cfg,
+                                    struct range_test_result *result) {
+    return test_sensor_range(fd, SENSOR_ACCEL, range, dlpf_cfg, result);
+}
+
+/**
+ * Test gyroscope range configuration
+ */
+static int test_gyroscope_range(int fd, const struct range_config *range, u8 dlpf_cfg,
+                                struct range_test_result *result) {
+    return test_sensor_range(fd, SENSOR_GYRO, range, dlpf_cfg, result);
+}
+
 /**
  * Test temperature range validation
  */
@@ -438,18 +444,18 @@ static int test_temperature_range(int fd) {
     print_test_header("Temperature Range Validation");
     
     /* Collect temperature samples */
-    double temps[NUM_SAMPLES_PER_RANGE];
-    int samples_collected = 0;
+    struct running_stats temps;
+    stats_reset(&temps);
     
     for (int i = 0; i < NUM_SAMPLES_PER_RANGE && g_running; i++) {
         struct mpu6050_scaled_data data;
         int ret = ioctl(fd, MPU6050_IOC_READ_SCALED, &data);
         
         if (ret == 0) {
-            temps[samples_collected] = (double)data.temp / 100.0;  /* Convert to Celsius */
-            samples_collected++;
+            double temp = (double)data.temp / 100.0;  /* Convert to Celsius */
+            stats_add(&temps, temp);
             
-            verbose_log("Sample %d: Temperature = %.2f°C", i, temps[samples_collected-1]);
+            verbose_log("Sample %d: Temperature = %.2f°C", i, temp);
         } else {
             verbose_log("Failed to read temperature sample %d: %s", i, strerror(errno));
         }
@@ -457,16 +463,16 @@ static int test_temperature_range(int fd) {
         usleep(10000);  /* 10ms between samples */
     }
     
-    if (samples_collected == 0) {
+    if (temps.count == 0) {
         print_test_result("Temperature Range", 0, "No samples collected");
         return 0;
     }
     
     /* Calculate statistics */
-    double mean_temp = calculate_mean(temps, samples_collected);
-    double stdev_temp = calculate_stdev(temps, samples_collected, mean_temp);
-    double min_temp = find_min(temps, samples_collected);
-    double max_temp = find_max(temps, samples_collected);
+    double mean_temp = temps.mean;
+    double stdev_temp = stats_stdev(&temps);
+    double min_temp = temps.min;
+    double max_temp = temps.max;
     
     /* Validate temperature range (MPU-6050 operates from -40°C to +85°C) */
     int range_violations = 0;
@@ -482,7 +488,7 @@ static int test_temperature_range(int fd) {
     
     /* Print results */
     printf("Temperature Statistics:\n");
-    printf("  Samples collected: %d/%d\n", samples_collected, NUM_SAMPLES_PER_RANGE);
+    printf("  Samples collected: %llu/%d\n", temps.count, NUM_SAMPLES_PER_RANGE);
     printf("  Mean: %.2f°C\n", mean_temp);
     printf("  Std Dev: %.3f°C\n", stdev_temp);
     printf("  Range: [%.2f, %.2f]°C\n", min_temp, max_temp);
@@ -665,6 +671,29 @@ static int test_range_switching(int fd) {
     return tests_passed;
 }
 
+/**
+ * Print throughput and drop rate of every range and DLPF setting tested
+ */
+static void print_throughput_table(void) {
+    if (g_throughput_rows == 0) return;
+    
+    printf("\n" COLOR_MAGENTA "THROUGHPUT BY RANGE AND DLPF" COLOR_RESET "\n");
+    printf("%-6s %-10s %4s %12s %12s %10s %9s\n",
+           "Sensor", "Range", "DLPF", "Samples", "Samples/s", "Dropped", "Drop %");
+    for (int i = 0; i < g_throughput_rows; i++) {
+        const struct range_test_result *r = &g_throughput[i];
+        unsigned long long expected = r->samples_collected + r->samples_dropped;
+        
+        /* Range names contain two-byte '±' and '°', so pad by hand */
+        printf("%-6s %s%*s %4u %12llu %12.1f %10llu %8.3f%%\n",
+               r->kind == SENSOR_ACCEL ? "accel" : "gyro", r->range->name,
+               (int)(10 - (strlen(r->range->name) - (r->kind == SENSOR_ACCEL ? 1 : 2))), "",
+               r->dlpf_cfg, r->samples_collected,
+               r->elapsed > 0 ? r->samples_collected / r->elapsed : 0.0,
+               r->samples_dropped, expected ? 100.0 * r->samples_dropped / expected : 0.0);
+    }
+}
+
 /**
  * Print comprehensive test summary
  */
@@ -698,6 +727,12 @@ static void print_usage(const char *program_name) {
     printf("\n");
     printf("Options:\n");
     printf("  -v, --verbose    Enable verbose output\n");
+    printf("  -n, --samples N  Samples per range and DLPF setting (default %d)\n",
+           NUM_SAMPLES_PER_RANGE);
+    printf("  -d, --dlpf N     DLPF setting 0-6, or 'all' (default 3)\n");
+    printf("  -l, --long       Long run: %llu samples per range at the full\n",
+           LONG_SAMPLES_PER_RANGE);
+    printf("                   output data rate\n");
     printf("  -h, --help       Show this help message\n");
     printf("\n");
     printf("Description:\n");
@@ -712,9 +747,42 @@ static void print_usage(const char *program_name) {
     printf("  - Temperature range validation\n");
     printf("  - Range switching consistency\n");
     printf("  - Data integrity and noise analysis\n");
+    printf("  - Throughput and dropped samples per range and DLPF setting\n");
     printf("\n");
 }
 
+/**
+ * Run one range test, record its throughput and count its result
+ */
+static void run_range_test(int fd, enum sensor_kind kind, const struct range_config *range,
+                           u8 dlpf_cfg, struct test_stats *stats) {
+    struct range_test_result result;
+    int passed = kind == SENSOR_ACCEL ?
+        test_accelerometer_range(fd, range, dlpf_cfg, &result) :
+        test_gyroscope_range(fd, range, dlpf_cfg, &result);
+    
+    char test_name[64];
+    char details[256];
+    snprintf(test_name, sizeof(test_name), "%s DLPF %u", range->name, dlpf_cfg);
+    snprintf(details, sizeof(details), 
+             "Samples: %llu, Dropped: %llu, Violations: %d range + %d stability", 
+             result.samples_collected, result.samples_dropped,
+             result.range_violations, result.stability_violations);
+    
+    print_test_result(test_name, passed, details);
+    
+    if (g_throughput_rows < MAX_THROUGHPUT_ROWS) {
+        g_throughput[g_throughput_rows++] = result;
+    }
+    
+    stats->total_tests++;
+    if (passed) {
+        stats->passed_tests++;
+    } else {
+        stats->failed_tests++;
+    }
+}
+
 /**
  * Main function
  */
@@ -723,6 +791,29 @@ int main(int argc, char *argv[]) {
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "--verbose") == 0) {
             g_verbose = 1;
+        } else if ((strcmp(argv[i], "-n") == 0 || strcmp(argv[i], "--samples") == 0) && i + 1 < argc) {
+            g_samples_per_range = strtoull(argv[++i], NULL, 0);
+            if (g_samples_per_range == 0) {
+                fprintf(stderr, "Invalid sample count: %s\n", argv[i]);
+                return 1;
+            }
+        } else if ((strcmp(argv[i], "-d") == 0 || strcmp(argv[i], "--dlpf") == 0) && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "all") == 0) {
+                g_dlpf_first = 0;
+                g_dlpf_last = NUM_DLPF_SETTINGS - 1;
+            } else {
+                char *end;
+                unsigned long dlpf = strtoul(argv[i], &end, 0);
+                if (*end || dlpf >= NUM_DLPF_SETTINGS) {
+                    fprintf(stderr, "Invalid DLPF setting: %s\n", argv[i]);
+                    return 1;
+                }
+                g_dlpf_first = g_dlpf_last = dlpf;
+            }
+        } else if (strcmp(argv[i], "-l") == 0 || strcmp(argv[i], "--long") == 0) {
+            g_samples_per_range = LONG_SAMPLES_PER_RANGE;
+            g_sample_rate_div = 0;
         } else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
             print_usage(argv[0]);
             return 0;
@@ -756,45 +847,18 @@ int main(int argc, char *argv[]) {
     
     verbose_log("Device opened successfully");
     
-    /* Test all accelerometer ranges */
+    /* Test all accelerometer and gyroscope ranges at each DLPF setting */
     print_test_header("Accelerometer Range Validation");
     for (int i = 0; i < NUM_ACCEL_RANGES && g_running; i++) {
-        struct range_test_result result;
-        int passed = test_accelerometer_range(fd, &accel_ranges[i], &result);
-        
-        char details[256];
-        snprintf(details, sizeof(details), 
-                 "Samples: %d, Violations: %d range + %d stability", 
-                 result.samples_collected, result.range_violations, result.stability_violations);
-        
-        print_test_result(accel_ranges[i].name, passed, details);
-        
-        stats.total_tests++;
-        if (passed) {
-            stats.passed_tests++;
-        } else {
-            stats.failed_tests++;
+        for (int dlpf = g_dlpf_first; dlpf <= g_dlpf_last && g_running; dlpf++) {
+            run_range_test(fd, SENSOR_ACCEL, &accel_ranges[i], dlpf, &stats);
         }
     }
     
-    /* Test all gyroscope ranges */
     print_test_header("Gyroscope Range Validation");
     for (int i = 0; i < NUM_GYRO_RANGES && g_running; i++) {
-        struct range_test_result result;
-        int passed = test_gyroscope_range(fd, &gyro_ranges[i], &result);
-        
-        char details[256];
-        snprintf(details, sizeof(details), 
-                 "Samples: %d, Violations: %d range + %d stability", 
-                 result.samples_collected, result.range_violations, result.stability_violations);
-        
-        print_test_result(gyro_ranges[i].name, passed, details);
-        
-        stats.total_tests++;
-        if (passed) {
-            stats.passed_tests++;
-        } else {
-            stats.failed_tests++;
+        for (int dlpf = g_dlpf_first; dlpf <= g_dlpf_last && g_running; dlpf++) {
+            run_range_test(fd, SENSOR_GYRO, &gyro_ranges[i], dlpf, &stats);
         }
     }
     
@@ -829,6 +893,7 @@ int main(int argc, char *argv[]) {
                          (stats.end_time.tv_usec - stats.start_time.tv_usec) / 1000000.0;
     
     /* Print comprehensive summary */
+    print_throughput_table();
     print_test_summary(&stats);
     
     /* Return appropriate exit code */
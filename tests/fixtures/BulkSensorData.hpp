@@ -0,0 +1,464 @@
+
+#ifndef BULK_SENSOR_DATA_HPP
+#define BULK_SENSOR_DATA_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "MockSensorData.hpp"
+
+/**
+ * Bulk synthetic data for property and stress tests
+ *
+ * Produces the MockSensorData patterns in structure-of-arrays form, one
+ * int16_t column per channel in register order (accel x/y/z, temp, gyro
+ * x/y/z), for datasets too large to build a SensorReading at a time:
+ * - random draws come from a counter-based hash of (seed, channel, index),
+ *   so every lane is independent and the column loops vectorize
+ * - Gaussian noise is the sum of four 16-bit uniforms, good to about
+ *   three sigma, which is all test data needs
+ * - waveforms are a fixed-point phase accumulator over a shared sine table
+ *   with linear interpolation instead of a sin() per value
+ *
+ * Output depends only on pattern, seed and count, never on how the data is
+ * split into chunks, so a stream and a cached corpus agree sample for
+ * sample. The values follow the MockSensorData distributions but are not
+ * the same draws as MockSensorData::generate().
+ */
+class BulkSensorData {
+public:
+    using Pattern = MockSensorData::Pattern;
+
+    static constexpr size_t kChannels = 7;
+    static constexpr size_t kChunk = 4096;   // Default streaming chunk, 8 KiB per column
+
+    // Destination columns; a null entry skips that channel
+    struct Columns {
+        int16_t* chan[kChannels];
+    };
+
+    BulkSensorData(Pattern pattern, uint64_t seed, size_t count)
+        : pattern_(pattern), seed_(seed), count_(count) {
+        for (size_t c = 0; c < kChannels; c++) {
+            stream_[c] = hash32(static_cast<uint32_t>(seed) ^ hash32(static_cast<uint32_t>(seed >> 32) +
+                                                                     0x9E3779B9u * static_cast<uint32_t>(c + 1)));
+        }
+        rewind();
+    }
+
+    Pattern pattern() const { return pattern_; }
+    uint64_t seed() const { return seed_; }
+    size_t size() const { return count_; }
+    size_t position() const { return pos_; }
+    size_t remaining() const { return count_ - pos_; }
+
+    void rewind() {
+        pos_ = 0;
+        walk_ = {1000, 2000, 16384, 23000, 100, 200, 300};
+    }
+
+    /**
+     * Generate the next samples into @out
+     * @return Number of samples written, at most @n, zero at the end
+     */
+    size_t fill(const Columns& out, size_t n) {
+        n = std::min(n, remaining());
+        for (size_t c = 0; c < kChannels; c++) {
+            if (out.chan[c]) {
+                fillChannel(c, out.chan[c], n);
+            } else if (pattern_ == Pattern::RANDOM_WALK) {
+                advanceWalk(c, n);
+            }
+        }
+        pos_ += n;
+        return n;
+    }
+
+    /**
+     * Lazy chunked view for streaming consumers
+     *
+     * Each next() generates up to chunk samples into buffers the stream
+     * owns and returns their count, zero at the end; column(c) points at
+     * the current chunk until the following next().
+     */
+    class Stream;
+
+    /**
+     * Generated dataset cached as a memory-mapped file
+     *
+     * Files live under $MPU6050_TEST_DATA_CACHE, or mpu6050-test-data in
+     * $TMPDIR or /tmp, keyed by pattern, seed and count. A missing or stale
+     * file is generated straight into the mapping and renamed into place, so
+     * concurrent test processes never see a partial corpus. Throws
+     * std::system_error when the cache cannot be created or mapped.
+     */
+    class Corpus {
+    public:
+        static Corpus load(Pattern pattern, uint64_t seed, size_t count) {
+            std::string path = cachePath(pattern, seed, count);
+            Corpus corpus;
+
+            if (corpus.map(path, pattern, seed, count)) {
+                return corpus;
+            }
+
+            generate(path, pattern, seed, count);
+            if (!corpus.map(path, pattern, seed, count)) {
+                throw std::system_error(EINVAL, std::generic_category(), "corrupt corpus " + path);
+            }
+            return corpus;
+        }
+
+        Corpus(Corpus&& other) noexcept { *this = std::move(other); }
+
+        Corpus& operator=(Corpus&& other) noexcept {
+            std::swap(base_, other.base_);
+            std::swap(size_, other.size_);
+            std::swap(count_, other.count_);
+            return *this;
+        }
+
+        ~Corpus() {
+            if (base_) {
+                munmap(base_, size_);
+            }
+        }
+
+        size_t size() const { return count_; }
+
+        const int16_t* column(size_t c) const {
+            return reinterpret_cast<const int16_t*>(static_cast<const char*>(base_) +
+                                                    columnOffset(c, count_));
+        }
+
+        MockSensorData::SensorReading operator[](size_t i) const {
+            return MockSensorData::SensorReading(column(0)[i], column(1)[i], column(2)[i], column(3)[i],
+                                                 column(4)[i], column(5)[i], column(6)[i]);
+        }
+
+    private:
+        static constexpr uint64_t kMagic = 0x31414f534d555043ULL;   // "CPUMSOA1"
+        static constexpr size_t kHeaderSize = 64;
+
+        struct Header {
+            uint64_t magic;
+            uint32_t pattern;
+            uint32_t channels;
+            uint64_t seed;
+            uint64_t count;
+        };
+
+        void* base_ = nullptr;
+        size_t size_ = 0;
+        size_t count_ = 0;
+
+        Corpus() = default;
+
+        // Columns start on 64-byte boundaries after the header
+        static size_t columnOffset(size_t c, size_t count) {
+            return kHeaderSize + c * ((count * sizeof(int16_t) + 63) & ~size_t(63));
+        }
+
+        static size_t fileSize(size_t count) { return columnOffset(kChannels, count); }
+
+        static std::string cachePath(Pattern pattern, uint64_t seed, size_t count) {
+            const char* dir = getenv("MPU6050_TEST_DATA_CACHE");
+            std::string path;
+
+            if (dir) {
+                path = dir;
+            } else {
+                dir = getenv("TMPDIR");
+                path = std::string(dir ? dir : "/tmp") + "/mpu6050-test-data";
+            }
+            mkdir(path.c_str(), 0755);
+
+            char name[96];
+            snprintf(name, sizeof(name), "/pattern%u-seed%llx-n%zu.soa", static_cast<unsigned>(pattern),
+                     static_cast<unsigned long long>(seed), count);
+            return path + name;
+        }
+
+        // Map @path read-only if it holds the corpus asked for
+        bool map(const std::string& path, Pattern pattern, uint64_t seed, size_t count) {
+            int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            struct stat st;
+            void* base;
+
+            if (fd < 0) {
+                return false;
+            }
+            if (fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) != fileSize(count)) {
+                close(fd);
+                return false;
+            }
+
+            base = mmap(nullptr, fileSize(count), PROT_READ, MAP_SHARED, fd, 0);
+            close(fd);
+            if (base == MAP_FAILED) {
+                return false;
+            }
+
+            const Header* header = static_cast<const Header*>(base);
+            if (header->magic != kMagic || header->pattern != static_cast<uint32_t>(pattern) ||
+                header->channels != kChannels || header->seed != seed || header->count != count) {
+                munmap(base, fileSize(count));
+                return false;
+            }
+
+            base_ = base;
+            size_ = fileSize(count);
+            count_ = count;
+            return true;
+        }
+
+        static void generate(const std::string& path, Pattern pattern, uint64_t seed, size_t count) {
+            std::string tmp = path + "." + std::to_string(getpid()) + ".tmp";
+            size_t size = fileSize(count);
+            int fd = open(tmp.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            void* base;
+
+            if (fd < 0) {
+                throw std::system_error(errno, std::generic_category(), "create " + tmp);
+            }
+            if (ftruncate(fd, size) < 0 ||
+                (base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED) {
+                int err = errno;
+                close(fd);
+                unlink(tmp.c_str());
+                throw std::system_error(err, std::generic_category(), "map " + tmp);
+            }
+            close(fd);
+
+            BulkSensorData generator(pattern, seed, count);
+            Columns out;
+            for (size_t c = 0; c < kChannels; c++) {
+                out.chan[c] = reinterpret_cast<int16_t*>(static_cast<char*>(base) + columnOffset(c, count));
+            }
+            generator.fill(out, count);
+
+            // The header goes in last, so a torn file never validates
+            *static_cast<Header*>(base) = {kMagic, static_cast<uint32_t>(pattern),
+                                           static_cast<uint32_t>(kChannels), seed, count};
+            munmap(base, size);
+
+            if (rename(tmp.c_str(), path.c_str()) < 0) {
+                int err = errno;
+                unlink(tmp.c_str());
+                throw std::system_error(err, std::generic_category(), "rename " + tmp);
+            }
+        }
+    };
+
+private:
+    static constexpr unsigned kSineBits = 12;
+    static constexpr uint32_t kSineSize = 1u << kSineBits;
+
+    // Gaussian parameters per channel for NORMAL
+    static constexpr float kNormalMean[kChannels] = {0, 0, 16384, 23000, 0, 0, 0};
+    static constexpr float kNormalSigma[kChannels] = {2000, 2000, 200, 1000, 500, 500, 500};
+
+    // Amplitude, offset and radians per sample of each SINE_WAVE channel;
+    // a quarter-turn phase turns sin into cos
+    struct Wave {
+        float amplitude;
+        float offset;
+        double rate;
+        bool cosine;
+    };
+    static constexpr Wave kWaves[kChannels] = {
+        {8000, 0, 0.1, false},    {8000, 0, 0.1, true},     {2000, 16384, 0.05, false},
+        {0, 23000, 0, false},     {2000, 0, 0.2, false},    {2000, 0, 0.2, true},
+        {1000, 0, 0.3, false},
+    };
+
+    // RANDOM_WALK step scale and clamp per channel
+    static constexpr float kWalkScale[kChannels] = {1, 1, 0.1f, 0.01f, 0.5f, 0.5f, 0.5f};
+    static constexpr int32_t kWalkMin[kChannels] = {-32000, -32000, 0, -32768, -32768, -32768, -32768};
+    static constexpr int32_t kWalkMax[kChannels] = {32000, 32000, 32000, 32767, 32767, 32767, 32767};
+
+    static constexpr int16_t kNoisyBase[kChannels] = {2000, 1000, 15000, 24000, 300, 200, 100};
+    static constexpr int16_t kSteps[4][kChannels] = {
+        {0, 0, 16384, 23000, 0, 0, 0},
+        {8000, 0, 16384, 25000, 2000, 0, 0},
+        {0, 8000, 16384, 25000, 0, 2000, 0},
+        {0, 0, 24000, 27000, 0, 0, 2000},
+    };
+    static constexpr int16_t kExtremes[6][kChannels] = {
+        {32767, 32767, 32767, 32767, 32767, 32767, 32767},
+        {-32768, -32768, -32768, -32768, -32768, -32768, -32768},
+        {0, 0, 0, 0, 0, 0, 0},
+        {16384, 0, 0, 23000, 0, 0, 0},
+        {0, 16384, 0, 23000, 0, 0, 0},
+        {0, 0, 16384, 23000, 0, 0, 0},
+    };
+
+    Pattern pattern_;
+    uint64_t seed_;
+    size_t count_;
+    size_t pos_ = 0;
+    std::array<uint32_t, kChannels> stream_;
+    std::array<int32_t, kChannels> walk_;
+
+    // 32-bit integer hash (lowbias32); 32-bit multiplies vectorize everywhere
+    static uint32_t hash32(uint32_t x) {
+        x ^= x >> 16;
+        x *= 0x7feb352dU;
+        x ^= x >> 15;
+        x *= 0x846ca68bU;
+        x ^= x >> 16;
+        return x;
+    }
+
+    // Unit Gaussian from sample @i of stream @key, by the central limit theorem
+    static float gaussian(uint32_t key, uint32_t i) {
+        uint32_t a = hash32(key ^ (2 * i));
+        uint32_t b = hash32(key ^ (2 * i + 1));
+        int32_t sum = static_cast<int32_t>((a & 0xFFFF) + (a >> 16) + (b & 0xFFFF) + (b >> 16)) - 131070;
+
+        return static_cast<float>(sum) * (1.0f / 37837.23f);
+    }
+
+    static int16_t saturate(float value) {
+        return static_cast<int16_t>(std::min(32767.0f, std::max(-32768.0f, value)));
+    }
+
+    static const float* sineTable() {
+        static const std::vector<float> table = [] {
+            std::vector<float> t(kSineSize + 1);
+            for (uint32_t i = 0; i <= kSineSize; i++) {
+                t[i] = static_cast<float>(std::sin(2.0 * M_PI * i / kSineSize));
+            }
+            return t;
+        }();
+        return table.data();
+    }
+
+    void fillChannel(size_t c, int16_t* out, size_t n) {
+        uint32_t key = stream_[c];
+        uint32_t first = static_cast<uint32_t>(pos_);
+
+        switch (pattern_) {
+        case Pattern::NORMAL: {
+            float mean = kNormalMean[c];
+            float sigma = kNormalSigma[c];
+            for (size_t i = 0; i < n; i++) {
+                out[i] = saturate(mean + sigma * gaussian(key, first + static_cast<uint32_t>(i)));
+            }
+            break;
+        }
+        case Pattern::SINE_WAVE:
+            fillWave(kWaves[c], out, n);
+            break;
+        case Pattern::RANDOM_WALK:
+            fillWalk(c, out, n);
+            break;
+        case Pattern::STEP_FUNCTION: {
+            size_t step_size = std::max<size_t>(count_ / 4, 1);
+            for (size_t i = 0; i < n; i++) {
+                out[i] = kSteps[std::min<size_t>((pos_ + i) / step_size, 3)][c];
+            }
+            break;
+        }
+        case Pattern::NOISY_CONSTANT: {
+            float base = kNoisyBase[c];
+            float sigma = c == 3 ? 5.0f : 50.0f;
+            for (size_t i = 0; i < n; i++) {
+                out[i] = saturate(base + sigma * gaussian(key, first + static_cast<uint32_t>(i)));
+            }
+            break;
+        }
+        case Pattern::EXTREME_VALUES:
+            for (size_t i = 0; i < n; i++) {
+                out[i] = kExtremes[(pos_ + i) % 6][c];
+            }
+            break;
+        }
+    }
+
+    void fillWave(const Wave& wave, int16_t* out, size_t n) {
+        constexpr unsigned kFracBits = 32 - kSineBits;
+        const float* table = sineTable();
+        // Phase in 2^-32 turns; wrapping arithmetic keeps it exact modulo a turn
+        uint32_t step = static_cast<uint32_t>(std::llround(wave.rate / (2.0 * M_PI) * 4294967296.0));
+        uint32_t phase = static_cast<uint32_t>(pos_) * step + (wave.cosine ? 0x40000000u : 0);
+
+        for (size_t i = 0; i < n; i++) {
+            uint32_t p = phase + static_cast<uint32_t>(i) * step;
+            uint32_t index = p >> kFracBits;
+            float frac = static_cast<float>(p & ((1u << kFracBits) - 1)) * (1.0f / (1u << kFracBits));
+            float s = table[index] + (table[index + 1] - table[index]) * frac;
+            out[i] = saturate(wave.offset + wave.amplitude * s);
+        }
+    }
+
+    // Steps are N(-100, 100) scaled per channel; the running sum is serial
+    void fillWalk(size_t c, int16_t* out, size_t n) {
+        uint32_t key = stream_[c];
+        uint32_t first = static_cast<uint32_t>(pos_);
+        float scale = kWalkScale[c];
+        int32_t value = walk_[c];
+
+        for (size_t i = 0; i < n; i++) {
+            float step = (-100.0f + 100.0f * gaussian(key, first + static_cast<uint32_t>(i))) * scale;
+            value = std::clamp(value + static_cast<int32_t>(step), kWalkMin[c], kWalkMax[c]);
+            out[i] = static_cast<int16_t>(value);
+        }
+        walk_[c] = value;
+    }
+
+    // Keep a skipped RANDOM_WALK channel in step with the others
+    void advanceWalk(size_t c, size_t n) {
+        int16_t scratch[kChunk];
+        size_t saved = pos_;
+
+        while (n) {
+            size_t part = std::min(n, kChunk);
+            fillWalk(c, scratch, part);
+            pos_ += part;
+            n -= part;
+        }
+        pos_ = saved;
+    }
+};
+
+// Defined out of line: it holds a complete BulkSensorData
+class BulkSensorData::Stream {
+public:
+    explicit Stream(BulkSensorData generator, size_t chunk = kChunk)
+        : generator_(std::move(generator)), chunk_(chunk), buffer_(kChannels * chunk) {}
+
+    size_t next() {
+        Columns out;
+        for (size_t c = 0; c < kChannels; c++) {
+            out.chan[c] = &buffer_[c * chunk_];
+        }
+        count_ = generator_.fill(out, chunk_);
+        return count_;
+    }
+
+    const int16_t* column(size_t c) const { return &buffer_[c * chunk_]; }
+    size_t count() const { return count_; }
+    size_t position() const { return generator_.position() - count_; }
+
+private:
+    BulkSensorData generator_;
+    size_t chunk_;
+    std::vector<int16_t> buffer_;
+    size_t count_ = 0;
+};
+
+#endif // BULK_SENSOR_DATA_HPP
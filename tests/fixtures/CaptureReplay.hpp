@@ -0,0 +1,37 @@
+#ifndef CAPTURE_REPLAY_HPP
+#define CAPTURE_REPLAY_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MockSensorData.hpp"
+#include "../../lib/capture.hpp"
+
+/**
+ * Capture replay for C++ tests
+ * Kept apart from MockSensorData so only the capture tests link lib/capture.cpp
+ */
+
+// Replay a capture recorded with mpu6050::CaptureWriter, paced at
+// speed times the recorded rate (0: as fast as it decodes)
+inline std::vector<MockSensorData::SensorReading>
+replayCapture(const std::string& path, double speed = 0, size_t count = SIZE_MAX) {
+    std::vector<MockSensorData::SensorReading> readings;
+    mpu6050::CaptureReader reader(path.c_str());
+
+    reader.set_speed(speed);
+    while (readings.size() < count && reader.read()) {
+        for (const mpu6050::Sample& s : reader) {
+            if (readings.size() == count)
+                break;
+            readings.emplace_back(s.raw.accel_x, s.raw.accel_y, s.raw.accel_z,
+                                  s.raw.temp, s.raw.gyro_x, s.raw.gyro_y,
+                                  s.raw.gyro_z);
+        }
+    }
+
+    return readings;
+}
+
+#endif // CAPTURE_REPLAY_HPP
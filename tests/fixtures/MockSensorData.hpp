@@ -2,9 +2,11 @@
 #ifndef MOCK_SENSOR_DATA_HPP
 #define MOCK_SENSOR_DATA_HPP
 
+#include <algorithm>
 #include <vector>
 #include <random>
 #include <cmath>
+#include <cstdint>
 
 /**
  * Mock sensor data generator for C++ tests
@@ -162,6 +162,10 @@ static inline float temp_raw_to_celsius(int16_t raw) {
 #include <vector>
 #include <random>
 #include <cmath>
+#include <cstdint>
+#include <string>
+
+#include "../../lib/capture.hpp"
 
 /**
  * Mock sensor data generator for C++ tests
@@ -243,6 +247,27 @@ public:
         return SensorReading();  // Default: all zeros
     }
     
+    // Replay a capture recorded with mpu6050::CaptureWriter, paced at
+    // speed times the recorded rate (0: as fast as it decodes)
+    std::vector<SensorReading> replay(const std::string& path, double speed = 0,
+                                      size_t count = SIZE_MAX) {
+        mpu6050::CaptureReader reader(path.c_str());
+        
+        data_.clear();
+        reader.set_speed(speed);
+        while (data_.size() < count && reader.read()) {
+            for (const mpu6050::Sample& s : reader) {
+                if (data_.size() == count)
+                    break;
+                data_.emplace_back(s.raw.accel_x, s.raw.accel_y, s.raw.accel_z,
+                                   s.raw.temp, s.raw.gyro_x, s.raw.gyro_y,
+                                   s.raw.gyro_z);
+            }
+        }
+        
+        return data_;
+    }
+    
 private:
     void generateNormal(size_t count) {
         std::normal_distribution<float> accel_dist(0, 2000);
@@ -380,6 +405,63 @@ private:
         self.logger.info(f"Generated binary sensor data: {output_file} (14KB)")
         return str(output_file)
     
+    @staticmethod
+    def _varint(value: int) -> bytes:
+        """LEB128 encoding of a non-negative integer"""
+        out = bytearray()
+        while value >= 0x80:
+            out.append((value & 0x7f) | 0x80)
+            value >>= 7
+        out.append(value)
+        return bytes(out)
+    
+    def generate_capture_data(self, period_ns: int = 1000000,
+                              chunk_samples: int = 256) -> str:
+        """Convert sensor_data.bin to the capture format of include/mpu6050_capture.h"""
+        input_file = self.fixtures_dir / 'sensor_data.bin'
+        output_file = self.fixtures_dir / 'sensor_data.cap'
+        
+        raw = input_file.read_bytes()
+        readings = [struct.unpack_from('<7h', raw, off)
+                    for off in range(0, len(raw) - 13, 14)]
+        
+        header_size = 64
+        chunks = bytearray()
+        index = []
+        for first in range(0, len(readings), chunk_samples):
+            run = readings[first:first + chunk_samples]
+            body = bytearray()
+            prev = [0] * 7
+            for reading in run:
+                # Steady timestamps, no sequence gaps and no flags
+                body += self._varint(0)
+                body += self._varint(0)
+                for c in range(7):
+                    delta = ((reading[c] - prev[c] + 0x8000) & 0xffff) - 0x8000
+                    body += self._varint((delta << 1) ^ (delta >> 15))
+                prev = list(reading)
+            offset = header_size + len(chunks)
+            timestamp = first * period_ns
+            index.append((offset, timestamp))
+            chunks += struct.pack('<qIIII', timestamp, first, len(run), len(body), 0)
+            chunks += body
+            chunks += bytes(-len(chunks) % 8)
+        
+        # ±2g, ±250°/s, DLPF on, all channels, no external sensors
+        header = struct.pack('<IHH4BIIIIIQQ2Q', 0x3650434d, 1, header_size,
+                             0, 0, 0, 1, 0x7f, 0, period_ns, chunk_samples,
+                             len(index), len(readings),
+                             header_size + len(chunks), 0, 0)
+        with open(output_file, 'wb') as f:
+            f.write(header)
+            f.write(chunks)
+            for offset, timestamp in index:
+                f.write(struct.pack('<Qq', offset, timestamp))
+        
+        self.logger.info(f"Generated capture file: {output_file} "
+                         f"({len(readings)} samples, {output_file.stat().st_size} bytes)")
+        return str(output_file)
+    
     def generate_config_files(self) -> List[str]:
         """Generate various configuration files for testing"""
         files_created = []
@@ -594,6 +676,7 @@ private:
         
         # Generate binary data
         generated_files['binary_data'].append(self.generate_binary_data())
+        generated_files['binary_data'].append(self.generate_capture_data())
         
         # Generate configuration files
         generated_files['config_files'].extend(self.generate_config_files())
@@ -645,6 +728,8 @@ def main():
         elif args.type == 'binary':
             file_path = generator.generate_binary_data()
             print(f"Generated binary data: {file_path}")
+            file_path = generator.generate_capture_data()
+            print(f"Generated capture file: {file_path}")
         elif args.type == 'config':
             file_paths = generator.generate_config_files()
             print(f"Generated {len(file_paths)} config files:")
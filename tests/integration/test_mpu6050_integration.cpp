@@ -93,6 +93,10 @@ protected:
         cleanupTestEnvironment();
     }
     
+    // Mock owned by this test; getInstance() returns it while in scope
+    MockI2CInterface mock_;
+    MockI2CInterface::Scope mock_scope_{mock_};
+    
     // Test infrastructure
     struct i2c_client test_client_{};
     struct i2c_adapter test_adapter_{};
@@ -117,6 +121,7 @@ protected:
         
         test_adapter_.nr = 1;
         test_adapter_.name = "test-adapter";
+        mock_.attach(&test_adapter_);
         
         test_device_.init_name = "mpu6050-test";
         
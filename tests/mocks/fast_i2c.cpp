@@ -0,0 +1,300 @@
+/**
+ * @file fast_i2c.cpp
+ * @brief Implementation of the high-throughput I2C backend
+ */
+
+#include "fast_i2c.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// xorshift64*, one state per thread so injection never contends
+uint64_t nextRandom() {
+    static std::atomic<uint64_t> seed_sequence{0x9E3779B97F4A7C15ULL};
+    thread_local uint64_t state = seed_sequence.fetch_add(0x9E3779B97F4A7C15ULL,
+                                                          std::memory_order_relaxed) | 1;
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545F4914F6CDD1DULL;
+}
+
+s16 addNoise(s16 value, int amplitude) {
+    int offset = static_cast<int>(nextRandom() % (2 * amplitude + 1)) - amplitude;
+    return static_cast<s16>(std::clamp(value + offset, -32768, 32767));
+}
+
+} // namespace
+
+FastI2CBackend::FastI2CBackend() {
+    reset();
+}
+
+int FastI2CBackend::checkBus() {
+    if (!device_present_.load(std::memory_order_relaxed)) {
+        return -ENODEV;
+    }
+
+    if (error_injection_enabled_.load(std::memory_order_relaxed) &&
+        static_cast<uint32_t>(nextRandom() >> 32) < error_threshold_.load(std::memory_order_relaxed)) {
+        injected_errors_.fetch_add(1, std::memory_order_relaxed);
+        return -error_code_.load(std::memory_order_relaxed);
+    }
+
+    return 0;
+}
+
+void FastI2CBackend::readFrame(u8* out) {
+    size_t index = next_frame_.fetch_add(1, std::memory_order_relaxed) % frames_.size();
+    int amplitude = noise_amplitude_.load(std::memory_order_relaxed);
+
+    std::memcpy(out, frames_[index].data(), kFrameBytes);
+    if (amplitude == 0) {
+        return;
+    }
+
+    for (size_t i = 0; i < kFrameBytes; i += 2) {
+        s16 value = addNoise(static_cast<s16>((out[i] << 8) | out[i + 1]), amplitude);
+        out[i] = static_cast<u8>(static_cast<u16>(value) >> 8);
+        out[i + 1] = static_cast<u8>(value & 0xFF);
+    }
+}
+
+u8 FastI2CBackend::readRegisterByte(u8 reg) {
+    // The FIFO streams the frame sequence and never runs dry
+    if (reg == MPU6050_Registers::FIFO_R_W) {
+        if (frames_.empty()) {
+            return 0;
+        }
+        size_t pos = fifo_pos_.fetch_add(1, std::memory_order_relaxed) % (frames_.size() * kFrameBytes);
+        return frames_[pos / kFrameBytes][pos % kFrameBytes];
+    }
+
+    if (reg == MPU6050_Registers::FIFO_COUNTH || reg == MPU6050_Registers::FIFO_COUNTL) {
+        size_t count = frames_.empty() ? 0 : kFifoSize - kFifoSize % kFrameBytes;
+        return static_cast<u8>(reg == MPU6050_Registers::FIFO_COUNTH ? count >> 8 : count & 0xFF);
+    }
+
+    return registers_[reg].load(std::memory_order_relaxed);
+}
+
+void FastI2CBackend::readRegisters(u8 reg, u8* out, size_t len) {
+    // A full sample burst is one precomputed frame
+    if (reg == MPU6050_Registers::ACCEL_XOUT_H && len >= kFrameBytes && !frames_.empty()) {
+        readFrame(out);
+        out += kFrameBytes;
+        len -= kFrameBytes;
+        reg += kFrameBytes;
+    }
+
+    for (size_t i = 0; i < len; i++) {
+        out[i] = readRegisterByte(reg);
+        if (reg != MPU6050_Registers::FIFO_R_W) {
+            reg++;
+        }
+    }
+}
+
+int FastI2CBackend::i2c_transfer(struct i2c_adapter* /*adapter*/, struct i2c_msg* msgs, int num) {
+    transfer_count_.fetch_add(1, std::memory_order_relaxed);
+
+    int ret = checkBus();
+    if (ret) {
+        return ret;
+    }
+
+    // A write sets the register pointer, a read auto-increments from it
+    u8 reg = 0;
+    for (int i = 0; i < num; i++) {
+        if (msgs[i].flags & I2C_M_RD) {
+            read_count_.fetch_add(1, std::memory_order_relaxed);
+            readRegisters(reg, msgs[i].buf, msgs[i].len);
+        } else {
+            write_count_.fetch_add(1, std::memory_order_relaxed);
+            if (msgs[i].len > 0) {
+                reg = msgs[i].buf[0];
+            }
+            for (u16 j = 1; j < msgs[i].len; j++) {
+                registers_[reg++].store(msgs[i].buf[j], std::memory_order_relaxed);
+            }
+        }
+    }
+
+    return num;
+}
+
+s32 FastI2CBackend::i2c_smbus_read_byte_data(const struct i2c_client* /*client*/, u8 command) {
+    read_count_.fetch_add(1, std::memory_order_relaxed);
+
+    int ret = checkBus();
+    return ret ? ret : readRegisterByte(command);
+}
+
+s32 FastI2CBackend::i2c_smbus_write_byte_data(const struct i2c_client* /*client*/, u8 command, u8 value) {
+    write_count_.fetch_add(1, std::memory_order_relaxed);
+
+    int ret = checkBus();
+    if (ret) {
+        return ret;
+    }
+
+    registers_[command].store(value, std::memory_order_relaxed);
+    return 0;
+}
+
+// SMBus words are little-endian: low byte at @command, high byte after it
+s32 FastI2CBackend::i2c_smbus_read_word_data(const struct i2c_client* /*client*/, u8 command) {
+    read_count_.fetch_add(1, std::memory_order_relaxed);
+
+    int ret = checkBus();
+    if (ret) {
+        return ret;
+    }
+
+    u8 bytes[2];
+    readRegisters(command, bytes, sizeof(bytes));
+    return bytes[0] | (bytes[1] << 8);
+}
+
+s32 FastI2CBackend::i2c_smbus_write_word_data(const struct i2c_client* /*client*/, u8 command, u16 value) {
+    write_count_.fetch_add(1, std::memory_order_relaxed);
+
+    int ret = checkBus();
+    if (ret) {
+        return ret;
+    }
+
+    registers_[command].store(static_cast<u8>(value & 0xFF), std::memory_order_relaxed);
+    registers_[static_cast<u8>(command + 1)].store(static_cast<u8>(value >> 8), std::memory_order_relaxed);
+    return 0;
+}
+
+s32 FastI2CBackend::i2c_smbus_read_i2c_block_data(const struct i2c_client* /*client*/, u8 command,
+                                                  u8 length, u8* values) {
+    read_count_.fetch_add(1, std::memory_order_relaxed);
+
+    int ret = checkBus();
+    if (ret) {
+        return ret;
+    }
+
+    readRegisters(command, values, length);
+    return length;
+}
+
+s32 FastI2CBackend::i2c_smbus_write_i2c_block_data(const struct i2c_client* /*client*/, u8 command,
+                                                   u8 length, const u8* values) {
+    write_count_.fetch_add(1, std::memory_order_relaxed);
+
+    int ret = checkBus();
+    if (ret) {
+        return ret;
+    }
+
+    for (u8 i = 0; i < length; i++) {
+        registers_[static_cast<u8>(command + i)].store(values[i], std::memory_order_relaxed);
+    }
+    return 0;
+}
+
+void FastI2CBackend::reset() {
+    for (auto& reg : registers_) {
+        reg.store(0, std::memory_order_relaxed);
+    }
+    frames_.clear();
+    next_frame_.store(0, std::memory_order_relaxed);
+    fifo_pos_.store(0, std::memory_order_relaxed);
+
+    device_present_.store(true, std::memory_order_relaxed);
+    error_code_.store(EIO, std::memory_order_relaxed);
+    error_threshold_.store(0, std::memory_order_relaxed);
+    error_injection_enabled_.store(false, std::memory_order_relaxed);
+    noise_amplitude_.store(0, std::memory_order_relaxed);
+
+    resetStatistics();
+}
+
+void FastI2CBackend::simulateDevicePresent(bool present) {
+    device_present_.store(present, std::memory_order_relaxed);
+}
+
+void FastI2CBackend::simulateI2CError(int error_code) {
+    error_code_.store(error_code, std::memory_order_relaxed);
+    setErrorInjectionRate(1.0); // Always inject error
+    enableErrorInjection(true);
+}
+
+void FastI2CBackend::enableErrorInjection(bool enable) {
+    error_injection_enabled_.store(enable, std::memory_order_relaxed);
+}
+
+void FastI2CBackend::setErrorInjectionRate(double rate) {
+    // A rate of 1.0 saturates at UINT32_MAX, which still leaves a 2^-32 gap
+    double threshold = std::clamp(rate, 0.0, 1.0) * 4294967296.0;
+    error_threshold_.store(threshold >= 4294967295.0 ? UINT32_MAX : static_cast<uint32_t>(threshold),
+                           std::memory_order_relaxed);
+}
+
+void FastI2CBackend::simulateNoiseInReads(bool enable, double noise_level) {
+    // Noise is uniform over +/- noise_level of full scale, on sample frames only
+    int amplitude = static_cast<int>(std::clamp(noise_level, 0.0, 1.0) * 32767.0);
+    noise_amplitude_.store(enable ? amplitude : 0, std::memory_order_relaxed);
+}
+
+void FastI2CBackend::setRegisterValue(u8 reg, u8 value) {
+    registers_[reg].store(value, std::memory_order_relaxed);
+}
+
+u8 FastI2CBackend::getRegisterValue(u8 reg) const {
+    return registers_[reg].load(std::memory_order_relaxed);
+}
+
+void FastI2CBackend::setupMPU6050Defaults() {
+    setRegisterValue(MPU6050_Registers::WHO_AM_I, MPU6050_Registers::WHO_AM_I_VALUE);
+    setRegisterValue(MPU6050_Registers::PWR_MGMT_1, MPU6050_Registers::PWR_MGMT_1_RESET);
+    setRegisterValue(MPU6050_Registers::PWR_MGMT_2, 0x00);
+    setRegisterValue(MPU6050_Registers::CONFIG, 0x00);
+    setRegisterValue(MPU6050_Registers::GYRO_CONFIG, 0x00);
+    setRegisterValue(MPU6050_Registers::ACCEL_CONFIG, 0x00);
+}
+
+void FastI2CBackend::simulateSensorData(s16 accel_x, s16 accel_y, s16 accel_z,
+                                        s16 gyro_x, s16 gyro_y, s16 gyro_z, s16 temp) {
+    loadSampleFrames({{accel_x, accel_y, accel_z, temp, gyro_x, gyro_y, gyro_z}});
+}
+
+FastI2CBackend::Frame FastI2CBackend::encodeFrame(const Sample& sample) {
+    const s16 values[] = {sample.accel_x, sample.accel_y, sample.accel_z, sample.temp,
+                          sample.gyro_x, sample.gyro_y, sample.gyro_z};
+    Frame frame;
+
+    for (size_t i = 0; i < kFrameBytes / 2; i++) {
+        frame[2 * i] = static_cast<u8>(static_cast<u16>(values[i]) >> 8);
+        frame[2 * i + 1] = static_cast<u8>(values[i] & 0xFF);
+    }
+    return frame;
+}
+
+void FastI2CBackend::loadSampleFrames(const std::vector<Sample>& samples) {
+    frames_.clear();
+    frames_.reserve(samples.size());
+    for (const auto& sample : samples) {
+        frames_.push_back(encodeFrame(sample));
+    }
+    next_frame_.store(0, std::memory_order_relaxed);
+    fifo_pos_.store(0, std::memory_order_relaxed);
+
+    // Single-register reads see the first frame
+    for (size_t i = 0; i < kFrameBytes; i++) {
+        registers_[MPU6050_Registers::ACCEL_XOUT_H + i].store(frames_.empty() ? 0 : frames_[0][i],
+                                                             std::memory_order_relaxed);
+    }
+}
+
+void FastI2CBackend::resetStatistics() {
+    transfer_count_.store(0, std::memory_order_relaxed);
+    read_count_.store(0, std::memory_order_relaxed);
+    write_count_.store(0, std::memory_order_relaxed);
+    injected_errors_.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,108 @@
+/**
+ * @file fast_i2c.h
+ * @brief High-throughput I2C backend for throughput and property tests
+ *
+ * MockI2CInterface routes every call through gmock matching and keeps its
+ * registers in std::map, which costs more than the driver code the stress
+ * suites are trying to time. FastI2CBackend models the same MPU-6050
+ * behaviour for tests that need the device, not call expectations:
+ * - a flat 256-entry register file
+ * - sample frames precomputed in bus byte order, so a 14-byte burst from
+ *   ACCEL_XOUT_H is one memcpy and FIFO_R_W streams the same frames
+ * - atomic transfer counters
+ * - optional noise and error injection from a per-thread xorshift PRNG
+ *
+ * Fixtures own an instance and attach it to their test adapter, or open an
+ * I2CBackend::Scope for calls made without one; the mock_i2c_* C wrappers
+ * then call it instead of the gmock methods.
+ * Configure a backend before starting reader threads; register and counter
+ * accesses are thread safe, loading frames is not.
+ */
+
+#ifndef FAST_I2C_H
+#define FAST_I2C_H
+
+#include "mock_i2c.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+class FastI2CBackend : public I2CBackend {
+public:
+    static constexpr size_t kFrameBytes = 14;   // ACCEL_XOUT_H .. GYRO_ZOUT_L
+    static constexpr size_t kFifoSize = 1024;   // Hardware FIFO depth
+
+    // One sample in the order the registers lay it out
+    struct Sample {
+        s16 accel_x, accel_y, accel_z;
+        s16 temp;
+        s16 gyro_x, gyro_y, gyro_z;
+    };
+
+    using Frame = std::array<u8, kFrameBytes>;
+
+    FastI2CBackend();
+    FastI2CBackend(const FastI2CBackend&) = delete;
+    FastI2CBackend& operator=(const FastI2CBackend&) = delete;
+
+    // Bus operations, as the MockI2CInterface defaults except that words
+    // follow SMBus byte order within the register file
+    int i2c_transfer(struct i2c_adapter* adapter, struct i2c_msg* msgs, int num) override;
+    s32 i2c_smbus_read_byte_data(const struct i2c_client* client, u8 command) override;
+    s32 i2c_smbus_write_byte_data(const struct i2c_client* client, u8 command, u8 value) override;
+    s32 i2c_smbus_read_word_data(const struct i2c_client* client, u8 command) override;
+    s32 i2c_smbus_write_word_data(const struct i2c_client* client, u8 command, u16 value) override;
+    s32 i2c_smbus_read_i2c_block_data(const struct i2c_client* client, u8 command, u8 length, u8* values) override;
+    s32 i2c_smbus_write_i2c_block_data(const struct i2c_client* client, u8 command, u8 length, const u8* values) override;
+
+    // Configuration, named after the MockI2CInterface equivalents
+    void reset();
+    void simulateDevicePresent(bool present);
+    void simulateI2CError(int error_code);
+    void enableErrorInjection(bool enable);
+    void setErrorInjectionRate(double rate);
+    void simulateNoiseInReads(bool enable, double noise_level = 0.1);
+    void setRegisterValue(u8 reg, u8 value);
+    u8 getRegisterValue(u8 reg) const;
+    void setupMPU6050Defaults();
+    void simulateSensorData(s16 accel_x, s16 accel_y, s16 accel_z,
+                            s16 gyro_x, s16 gyro_y, s16 gyro_z, s16 temp);
+
+    // Replace the frame sequence; burst and FIFO reads cycle through it
+    void loadSampleFrames(const std::vector<Sample>& samples);
+    size_t getFrameCount() const { return frames_.size(); }
+    static Frame encodeFrame(const Sample& sample);
+
+    // Statistics
+    uint64_t getTransferCount() const { return transfer_count_.load(std::memory_order_relaxed); }
+    uint64_t getReadCount() const { return read_count_.load(std::memory_order_relaxed); }
+    uint64_t getWriteCount() const { return write_count_.load(std::memory_order_relaxed); }
+    uint64_t getInjectedErrorCount() const { return injected_errors_.load(std::memory_order_relaxed); }
+    void resetStatistics();
+
+private:
+    std::array<std::atomic<u8>, 256> registers_{};
+    std::vector<Frame> frames_;
+    std::atomic<size_t> next_frame_{0};
+    std::atomic<size_t> fifo_pos_{0};
+
+    std::atomic<bool> device_present_{true};
+    std::atomic<int> error_code_{EIO};
+    std::atomic<uint32_t> error_threshold_{0};  // Inject when rand32 < threshold
+    std::atomic<bool> error_injection_enabled_{false};
+    std::atomic<int> noise_amplitude_{0};       // LSB, zero when noise is off
+
+    std::atomic<uint64_t> transfer_count_{0};
+    std::atomic<uint64_t> read_count_{0};
+    std::atomic<uint64_t> write_count_{0};
+    std::atomic<uint64_t> injected_errors_{0};
+
+    // Returns 0 or the negative errno a transfer should fail with
+    int checkBus();
+    u8 readRegisterByte(u8 reg);
+    void readFrame(u8* out);
+    void readRegisters(u8 reg, u8* out, size_t len);
+};
+
+#endif // FAST_I2C_H
@@ -9,34 +9,46 @@
 #include <chrono>
 #include <cstring>
 
-// C function implementations that delegate to the mock
+// The adapter's attached backend, else the calling thread's Scope, else
+// the process-wide mock
+static I2CBackend& backendFor(const struct i2c_adapter* adapter) {
+    if (adapter && adapter->backend) {
+        return *adapter->backend;
+    }
+    if (I2CBackend* backend = I2CBackend::current()) {
+        return *backend;
+    }
+    return MockI2CInterface::getInstance();
+}
+
+// C function implementations that delegate to the selected backend
 extern "C" {
     int mock_i2c_transfer(struct i2c_adapter* adapter, struct i2c_msg* msgs, int num) {
-        return MockI2CInterface::getInstance().i2c_transfer(adapter, msgs, num);
+        return backendFor(adapter).i2c_transfer(adapter, msgs, num);
     }
     
     s32 mock_i2c_smbus_read_byte_data(const struct i2c_client* client, u8 command) {
-        return MockI2CInterface::getInstance().i2c_smbus_read_byte_data(client, command);
+        return backendFor(client ? client->adapter : nullptr).i2c_smbus_read_byte_data(client, command);
     }
     
     s32 mock_i2c_smbus_write_byte_data(const struct i2c_client* client, u8 command, u8 value) {
-        return MockI2CInterface::getInstance().i2c_smbus_write_byte_data(client, command, value);
+        return backendFor(client ? client->adapter : nullptr).i2c_smbus_write_byte_data(client, command, value);
     }
     
     s32 mock_i2c_smbus_read_word_data(const struct i2c_client* client, u8 command) {
-        return MockI2CInterface::getInstance().i2c_smbus_read_word_data(client, command);
+        return backendFor(client ? client->adapter : nullptr).i2c_smbus_read_word_data(client, command);
     }
     
     s32 mock_i2c_smbus_write_word_data(const struct i2c_client* client, u8 command, u16 value) {
-        return MockI2CInterface::getInstance().i2c_smbus_write_word_data(client, command, value);
+        return backendFor(client ? client->adapter : nullptr).i2c_smbus_write_word_data(client, command, value);
     }
     
     s32 mock_i2c_smbus_read_i2c_block_data(const struct i2c_client* client, u8 command, u8 length, u8* values) {
-        return MockI2CInterface::getInstance().i2c_smbus_read_i2c_block_data(client, command, length, values);
+        return backendFor(client ? client->adapter : nullptr).i2c_smbus_read_i2c_block_data(client, command, length, values);
     }
     
     s32 mock_i2c_smbus_write_i2c_block_data(const struct i2c_client* client, u8 command, u8 length, const u8* values) {
-        return MockI2CInterface::getInstance().i2c_smbus_write_i2c_block_data(client, command, length, values);
+        return backendFor(client ? client->adapter : nullptr).i2c_smbus_write_i2c_block_data(client, command, length, values);
     }
 }
 
@@ -64,17 +76,24 @@ void MockI2CInterface::setDefaultBehavior() {
                 std::this_thread::sleep_for(std::chrono::milliseconds(register_bank_.transfer_delay_ms));
             }
             
-            // Process each message
+            // Process each message; a write sets the register pointer
+            u8 reg = 0;
             for (int i = 0; i < num; i++) {
                 if (msgs[i].flags & I2C_M_RD) {
-                    // Read operation
+                    // Read operation, auto-incrementing the register pointer
                     read_count_++;
-                    // Simulate reading from register bank
-                    // This is a simplified implementation
+                    for (u16 j = 0; j < msgs[i].len; j++) {
+                        msgs[i].buf[j] = readRegisterByte(reg++);
+                    }
                 } else {
-                    // Write operation
+                    // Write operation: register address, then data bytes
                     write_count_++;
-                    // Simulate writing to register bank
+                    if (msgs[i].len > 0) {
+                        reg = msgs[i].buf[0];
+                    }
+                    for (u16 j = 1; j < msgs[i].len; j++) {
+                        register_bank_.byte_registers[reg++] = msgs[i].buf[j];
+                    }
                 }
             }
             
@@ -322,6 +341,12 @@ bool MockI2CInterface::shouldInjectError() const {
     return dis(gen) < register_bank_.error_injection_rate;
 }
 
+u8 MockI2CInterface::readRegisterByte(u8 reg) {
+    auto it = register_bank_.byte_registers.find(reg);
+    u8 value = (it != register_bank_.byte_registers.end()) ? it->second : 0;
+    return register_bank_.noise_enabled ? addNoise(value) : value;
+}
+
 u8 MockI2CInterface::addNoise(u8 value) const {
     static std::random_device rd;
     static std::mt19937 gen(rd());
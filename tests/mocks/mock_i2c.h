@@ -22,12 +22,20 @@ extern "C" {
     typedef unsigned short u16;
     typedef signed short s16;
     typedef int s32;
+    typedef unsigned int u32;
     
     #define EINVAL 22
     #define EIO 5
     #define ENODEV 19
     #define ETIMEDOUT 110
     #define EBUSY 16
+    #define EOPNOTSUPP 95
+    
+    // Adapter functionality bits
+    #define I2C_FUNC_I2C 0x00000001
+    #define I2C_FUNC_SMBUS_BYTE_DATA 0x00180000
+    #define I2C_FUNC_SMBUS_I2C_BLOCK 0x0c000000
+    #define I2C_SMBUS_BLOCK_MAX 32
     
     // I2C message flags
     #define I2C_M_RD 0x0001
@@ -46,6 +54,7 @@ struct i2c_adapter;
 struct i2c_client;
 struct i2c_msg;
 struct device;
+class I2CBackend;
 
 // Mock I2C message structure
 struct i2c_msg {
@@ -64,6 +73,10 @@ struct i2c_adapter {
     // Mock methods
     int (*master_xfer)(struct i2c_adapter*, struct i2c_msg*, int);
     u32 (*functionality)(struct i2c_adapter*);
+    
+    // Test backend bound with I2CBackend::attach(), nullptr for the
+    // calling thread's current MockI2CInterface
+    I2CBackend* backend;
 };
 
 // Mock I2C client structure  
@@ -81,6 +94,46 @@ struct device {
     void* driver_data;
 };
 
+/**
+ * @class I2CBackend
+ * @brief Bus operations the mock_i2c_* wrappers dispatch to
+ *
+ * A fixture owns its backend and attaches it to its test adapter, so the
+ * driver code, and any threads the test starts, reach that instance rather
+ * than one shared by every test in the process. Calls made without an
+ * adapter go to the backend of the calling thread's innermost Scope.
+ */
+class I2CBackend {
+public:
+    virtual ~I2CBackend() = default;
+    
+    // Makes a backend the calling thread's current() until destroyed
+    class Scope {
+    public:
+        explicit Scope(I2CBackend& backend) : prev_(current_) { current_ = &backend; }
+        ~Scope() { current_ = prev_; }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        I2CBackend* prev_;
+    };
+    
+    static I2CBackend* current() { return current_; }
+    
+    virtual int i2c_transfer(struct i2c_adapter* adapter, struct i2c_msg* msgs, int num) = 0;
+    virtual s32 i2c_smbus_read_byte_data(const struct i2c_client* client, u8 command) = 0;
+    virtual s32 i2c_smbus_write_byte_data(const struct i2c_client* client, u8 command, u8 value) = 0;
+    virtual s32 i2c_smbus_read_word_data(const struct i2c_client* client, u8 command) = 0;
+    virtual s32 i2c_smbus_write_word_data(const struct i2c_client* client, u8 command, u16 value) = 0;
+    virtual s32 i2c_smbus_read_i2c_block_data(const struct i2c_client* client, u8 command, u8 length, u8* values) = 0;
+    virtual s32 i2c_smbus_write_i2c_block_data(const struct i2c_client* client, u8 command, u8 length, const u8* values) = 0;
+    
+    void attach(struct i2c_adapter* adapter) { adapter->backend = this; }
+    
+private:
+    static inline thread_local I2CBackend* current_ = nullptr;
+};
+
 /**
  * @class MockI2CInterface
  * @brief Comprehensive mock for I2C operations
@@ -88,22 +141,34 @@ struct device {
  * This class provides a full mock implementation of I2C operations with
  * configurable behavior for testing various scenarios including success,
  * failure, and edge cases.
+ *
+ * Fixtures own an instance and select it with a Scope; getInstance() then
+ * returns it on the fixture's thread, and a process-wide default otherwise.
  */
-class MockI2CInterface {
+class MockI2CInterface : public I2CBackend {
 public:
+    MockI2CInterface() = default;
+    ~MockI2CInterface() override = default;
+    MockI2CInterface(const MockI2CInterface&) = delete;
+    MockI2CInterface& operator=(const MockI2CInterface&) = delete;
+    
+    // The mock of the calling thread's Scope, else the process-wide one
     static MockI2CInterface& getInstance() {
+        if (auto* mock = dynamic_cast<MockI2CInterface*>(current())) {
+            return *mock;
+        }
         static MockI2CInterface instance;
         return instance;
     }
     
     // Mock methods that will be called by the driver
-    MOCK_METHOD(int, i2c_transfer, (struct i2c_adapter* adapter, struct i2c_msg* msgs, int num));
-    MOCK_METHOD(s32, i2c_smbus_read_byte_data, (const struct i2c_client* client, u8 command));
-    MOCK_METHOD(s32, i2c_smbus_write_byte_data, (const struct i2c_client* client, u8 command, u8 value));
-    MOCK_METHOD(s32, i2c_smbus_read_word_data, (const struct i2c_client* client, u8 command));
-    MOCK_METHOD(s32, i2c_smbus_write_word_data, (const struct i2c_client* client, u8 command, u16 value));
-    MOCK_METHOD(s32, i2c_smbus_read_i2c_block_data, (const struct i2c_client* client, u8 command, u8 length, u8* values));
-    MOCK_METHOD(s32, i2c_smbus_write_i2c_block_data, (const struct i2c_client* client, u8 command, u8 length, const u8* values));
+    MOCK_METHOD(int, i2c_transfer, (struct i2c_adapter* adapter, struct i2c_msg* msgs, int num), (override));
+    MOCK_METHOD(s32, i2c_smbus_read_byte_data, (const struct i2c_client* client, u8 command), (override));
+    MOCK_METHOD(s32, i2c_smbus_write_byte_data, (const struct i2c_client* client, u8 command, u8 value), (override));
+    MOCK_METHOD(s32, i2c_smbus_read_word_data, (const struct i2c_client* client, u8 command), (override));
+    MOCK_METHOD(s32, i2c_smbus_write_word_data, (const struct i2c_client* client, u8 command, u16 value), (override));
+    MOCK_METHOD(s32, i2c_smbus_read_i2c_block_data, (const struct i2c_client* client, u8 command, u8 length, u8* values), (override));
+    MOCK_METHOD(s32, i2c_smbus_write_i2c_block_data, (const struct i2c_client* client, u8 command, u8 length, const u8* values), (override));
     
     // Configuration methods for test setup
     void setDefaultBehavior();
@@ -155,18 +220,14 @@ private:
     mutable int read_count_ = 0;
     mutable int write_count_ = 0;
     
-    MockI2CInterface() = default;
-    ~MockI2CInterface() = default;
-    MockI2CInterface(const MockI2CInterface&) = delete;
-    MockI2CInterface& operator=(const MockI2CInterface&) = delete;
-    
     // Internal helper methods
     bool shouldInjectError() const;
+    u8 readRegisterByte(u8 reg);
     u8 addNoise(u8 value) const;
     s16 addNoise(s16 value) const;
 };
 
-// C function wrappers that delegate to the mock
+// C function wrappers that delegate to the adapter's backend, or to the mock
 extern "C" {
     int mock_i2c_transfer(struct i2c_adapter* adapter, struct i2c_msg* msgs, int num);
     s32 mock_i2c_smbus_read_byte_data(const struct i2c_client* client, u8 command);
@@ -216,6 +277,9 @@ namespace MPU6050_Registers {
     constexpr u8 GYRO_YOUT_L = 0x46;
     constexpr u8 GYRO_ZOUT_H = 0x47;
     constexpr u8 GYRO_ZOUT_L = 0x48;
+    constexpr u8 FIFO_COUNTH = 0x72;
+    constexpr u8 FIFO_COUNTL = 0x73;
+    constexpr u8 FIFO_R_W = 0x74;
     
     // Expected values
     constexpr u8 WHO_AM_I_VALUE = 0x68;
@@ -18,6 +18,7 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 #include <thread>
+#include <array>
 #include <atomic>
 #include <chrono>
 #include <vector>
@@ -25,12 +26,17 @@
 #include <random>
 #include <algorithm>
 #include <numeric>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
 #include <queue>
 #include <condition_variable>
 #include <mutex>
 #include <future>
 #include "../mocks/mock_i2c.h"
+#include "../mocks/fast_i2c.h"
 #include "../utils/test_helpers.h"
+#include "../../lib/histogram.hpp"
 
 extern "C" {
     int mpu6050_probe(struct i2c_client* client, const struct i2c_device_id* id);
@@ -67,132 +73,315 @@ struct mpu6050_scaled_data {
     s32 temp;
 };
 
+/**
+ * @class LatencyHistogram
+ * @brief One thread's latencies of one operation, in nanoseconds
+ *
+ * The buckets are libmpu6050's SharedHistogram, so reports can merge them
+ * while the owning thread records; success counts and the time span sit
+ * beside it with the same single-writer relaxed updates.
+ */
+class LatencyHistogram {
+public:
+    void record(bool success, uint64_t latency_ns, uint64_t start_ns, uint64_t end_ns) {
+        latency_.add(latency_ns);
+        std::atomic<uint64_t>& outcome = success ? successes_ : errors_;
+        outcome.store(outcome.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (start_ns < first_ns_.load(std::memory_order_relaxed)) {
+            first_ns_.store(start_ns, std::memory_order_relaxed);
+        }
+        last_ns_.store(end_ns, std::memory_order_relaxed);
+    }
+    
+    // Only while no thread records
+    void clear() {
+        latency_.clear();
+        successes_.store(0, std::memory_order_relaxed);
+        errors_.store(0, std::memory_order_relaxed);
+        first_ns_.store(UINT64_MAX, std::memory_order_relaxed);
+        last_ns_.store(0, std::memory_order_relaxed);
+    }
+    
+private:
+    friend struct LatencySummary;
+    
+    mpu6050::SharedHistogram latency_;
+    std::atomic<uint64_t> successes_{0};
+    std::atomic<uint64_t> errors_{0};
+    std::atomic<uint64_t> first_ns_{UINT64_MAX};
+    std::atomic<uint64_t> last_ns_{0};
+};
+
+/**
+ * @struct LatencySummary
+ * @brief Per-thread histograms of one operation merged for reporting
+ *
+ * Percentiles and moments come from the buckets, so they are exact to the
+ * bucket width and cost the same for ten or ten million operations.
+ */
+struct LatencySummary {
+    mpu6050::Histogram latency;
+    uint64_t successes = 0;
+    uint64_t errors = 0;
+    uint64_t first_ns = UINT64_MAX;
+    uint64_t last_ns = 0;
+    
+    void merge(const LatencyHistogram& histogram) {
+        latency.merge(histogram.latency_);
+        successes += histogram.successes_.load(std::memory_order_relaxed);
+        errors += histogram.errors_.load(std::memory_order_relaxed);
+        first_ns = std::min(first_ns, histogram.first_ns_.load(std::memory_order_relaxed));
+        last_ns = std::max(last_ns, histogram.last_ns_.load(std::memory_order_relaxed));
+    }
+    
+    uint64_t count() const { return latency.count(); }
+    double minUs() const { return latency.min() / 1000.0; }
+    double maxUs() const { return latency.max() / 1000.0; }
+    double averageUs() const { return latency.mean() / 1000.0; }
+    double stddevUs() const { return latency.stddev() / 1000.0; }
+    
+    // Latency at quantile @q (0-1), within the observed range
+    double percentileUs(double q) const { return latency.percentile(q) / 1000.0; }
+    
+    // Operations further than @distance_us from the mean
+    uint64_t countOutside(double distance_us) const {
+        double mean = averageUs();
+        uint64_t outside = 0;
+        for (unsigned i = 0; i < mpu6050::Histogram::nr_buckets; i++) {
+            if (std::abs(mpu6050::Histogram::midpoint(i) / 1000.0 - mean) > distance_us) {
+                outside += latency.at(i);
+            }
+        }
+        return outside;
+    }
+};
+
 /**
  * @class PerformanceMetrics
  * @brief Collects and analyzes performance metrics
+ *
+ * Recording is wait-free: operation names are interned to small ids up
+ * front, and each thread records into its own preallocated histograms.
+ * Threads take the registry lock once, to claim a recorder on their first
+ * operation; a recorder returns to the pool when its thread exits or records
+ * into another instance and keeps its counts, so memory stays bounded by the
+ * peak thread count. Reports merge all recorders without stopping the
+ * threads. Each test fixture owns its instance.
  */
 class PerformanceMetrics {
 public:
-    struct OperationMetrics {
-        std::string operation_name;
-        std::vector<double> latencies_us;  // Latencies in microseconds
-        std::atomic<int> success_count{0};
-        std::atomic<int> error_count{0};
-        std::chrono::steady_clock::time_point start_time;
-        std::chrono::steady_clock::time_point end_time;
-        
-        OperationMetrics(const std::string& name) : operation_name(name) {}
-    };
+    using OperationId = size_t;
+    using Clock = std::chrono::steady_clock;
+    static constexpr size_t kMaxOperations = 64;
     
-    static PerformanceMetrics& getInstance() {
-        static PerformanceMetrics instance;
-        return instance;
+    PerformanceMetrics() = default;
+    PerformanceMetrics(const PerformanceMetrics&) = delete;
+    PerformanceMetrics& operator=(const PerformanceMetrics&) = delete;
+    
+    // Id for @operation, registering it on first use. Not for hot paths.
+    OperationId intern(const std::string& operation) {
+        std::lock_guard<std::mutex> lock(names_mutex_);
+        auto it = std::find(names_.begin(), names_.end(), operation);
+        if (it != names_.end()) {
+            return static_cast<OperationId>(it - names_.begin());
+        }
+        if (names_.size() == kMaxOperations) {
+            throw std::length_error("too many operations: " + operation);
+        }
+        names_.push_back(operation);
+        return names_.size() - 1;
     }
     
     void startOperation(const std::string& operation) {
-        std::lock_guard<std::mutex> lock(metrics_mutex_);
-        if (operations_.find(operation) == operations_.end()) {
-            operations_[operation] = std::make_unique<OperationMetrics>(operation);
+        OperationId id = intern(operation);
+        uint64_t now = toNs(Clock::now());
+        uint64_t expected = start_ns_[id].load(std::memory_order_relaxed);
+        while ((expected == 0 || now < expected) &&
+               !start_ns_[id].compare_exchange_weak(expected, now, std::memory_order_relaxed)) {
         }
-        operations_[operation]->start_time = std::chrono::steady_clock::now();
+    }
+    
+    void recordOperation(OperationId id, bool success, Clock::time_point start, Clock::time_point end) {
+        uint64_t start_ns = toNs(start);
+        uint64_t end_ns = toNs(end);
+        localRecorder().histogram(id).record(success, end_ns - start_ns, start_ns, end_ns);
     }
     
     void recordOperation(const std::string& operation, bool success, double latency_us) {
-        std::lock_guard<std::mutex> lock(metrics_mutex_);
-        if (operations_.find(operation) == operations_.end()) {
-            operations_[operation] = std::make_unique<OperationMetrics>(operation);
+        auto end = Clock::now();
+        auto latency = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double, std::micro>(latency_us));
+        recordOperation(intern(operation), success, end - latency, end);
+    }
+    
+    LatencySummary summary(OperationId id) const {
+        LatencySummary merged;
+        std::lock_guard<std::mutex> lock(recorders_mutex_);
+        for (const auto& recorder : recorders_) {
+            const LatencyHistogram* histogram = recorder->ops[id].load(std::memory_order_acquire);
+            if (histogram) {
+                merged.merge(*histogram);
+            }
         }
-        
-        auto& op = operations_[operation];
-        op->latencies_us.push_back(latency_us);
-        
-        if (success) {
-            op->success_count++;
-        } else {
-            op->error_count++;
+        uint64_t start_ns = start_ns_[id].load(std::memory_order_relaxed);
+        if (start_ns) {
+            merged.first_ns = std::min(merged.first_ns, start_ns);
         }
-        
-        op->end_time = std::chrono::steady_clock::now();
+        return merged;
     }
     
     void generateReport() const {
-        std::lock_guard<std::mutex> lock(metrics_mutex_);
+        std::vector<std::string> names;
+        {
+            std::lock_guard<std::mutex> lock(names_mutex_);
+            names = names_;
+        }
         
         std::cout << "\n=== Performance Analysis Report ===" << std::endl;
         
-        for (const auto& op : operations_) {
-            const auto& metrics = *op.second;
-            
-            if (metrics.latencies_us.empty()) continue;
+        for (OperationId id = 0; id < names.size(); id++) {
+            LatencySummary metrics = summary(id);
+            uint64_t total = metrics.count();
             
-            // Calculate statistics
-            auto latencies = metrics.latencies_us;
-            std::sort(latencies.begin(), latencies.end());
-            
-            double min_latency = latencies.front();
-            double max_latency = latencies.back();
-            double avg_latency = std::accumulate(latencies.begin(), latencies.end(), 0.0) / latencies.size();
-            double median_latency = latencies[latencies.size() / 2];
-            double p95_latency = latencies[static_cast<size_t>(latencies.size() * 0.95)];
-            double p99_latency = latencies[static_cast<size_t>(latencies.size() * 0.99)];
+            if (total == 0) continue;
             
             // Calculate throughput
-            auto duration = std::chrono::duration_cast<std::chrono::microseconds>(
-                metrics.end_time - metrics.start_time);
-            double ops_per_second = (metrics.success_count + metrics.error_count) * 1000000.0 / duration.count();
+            double duration_us = (metrics.last_ns - metrics.first_ns) / 1000.0;
+            double ops_per_second = duration_us > 0 ? total * 1000000.0 / duration_us : 0.0;
             
-            std::cout << "\n--- " << metrics.operation_name << " ---" << std::endl;
-            std::cout << "Operations: " << (metrics.success_count + metrics.error_count) << std::endl;
-            std::cout << "Success: " << metrics.success_count << " (" 
-                      << (100.0 * metrics.success_count / (metrics.success_count + metrics.error_count)) 
+            std::cout << "\n--- " << names[id] << " ---" << std::endl;
+            std::cout << "Operations: " << total << std::endl;
+            std::cout << "Success: " << metrics.successes << " ("
+                      << (100.0 * metrics.successes / total)
                       << "%)" << std::endl;
-            std::cout << "Errors: " << metrics.error_count << std::endl;
+            std::cout << "Errors: " << metrics.errors << std::endl;
             std::cout << "Throughput: " << std::fixed << std::setprecision(1) << ops_per_second << " ops/sec" << std::endl;
             
             std::cout << "\nLatency Statistics (μs):" << std::endl;
-            std::cout << "  Min: " << std::fixed << std::setprecision(2) << min_latency << std::endl;
-            std::cout << "  Avg: " << avg_latency << std::endl;
-            std::cout << "  Median: " << median_latency << std::endl;
-            std::cout << "  95th: " << p95_latency << std::endl;
-            std::cout << "  99th: " << p99_latency << std::endl;
-            std::cout << "  Max: " << max_latency << std::endl;
+            std::cout << "  Min: " << std::fixed << std::setprecision(2) << metrics.minUs() << std::endl;
+            std::cout << "  Avg: " << metrics.averageUs() << std::endl;
+            std::cout << "  Median: " << metrics.percentileUs(0.50) << std::endl;
+            std::cout << "  95th: " << metrics.percentileUs(0.95) << std::endl;
+            std::cout << "  99th: " << metrics.percentileUs(0.99) << std::endl;
+            std::cout << "  Max: " << metrics.maxUs() << std::endl;
         }
         
         std::cout << "======================================" << std::endl;
     }
     
+    // Only while no thread records
     void reset() {
-        std::lock_guard<std::mutex> lock(metrics_mutex_);
-        operations_.clear();
+        std::lock_guard<std::mutex> lock(recorders_mutex_);
+        for (auto& recorder : recorders_) {
+            for (auto& op : recorder->ops) {
+                LatencyHistogram* histogram = op.load(std::memory_order_relaxed);
+                if (histogram) {
+                    histogram->clear();
+                }
+            }
+        }
+        for (auto& start : start_ns_) {
+            start.store(0, std::memory_order_relaxed);
+        }
     }
     
     double getAverageLatency(const std::string& operation) const {
-        std::lock_guard<std::mutex> lock(metrics_mutex_);
-        auto it = operations_.find(operation);
-        if (it == operations_.end() || it->second->latencies_us.empty()) {
-            return 0.0;
-        }
-        
-        const auto& latencies = it->second->latencies_us;
-        return std::accumulate(latencies.begin(), latencies.end(), 0.0) / latencies.size();
+        OperationId id;
+        return lookup(operation, id) ? summary(id).averageUs() : 0.0;
     }
     
     double getSuccessRate(const std::string& operation) const {
-        std::lock_guard<std::mutex> lock(metrics_mutex_);
-        auto it = operations_.find(operation);
-        if (it == operations_.end()) {
+        OperationId id;
+        if (!lookup(operation, id)) {
             return 0.0;
         }
-        
-        int total = it->second->success_count + it->second->error_count;
-        return total > 0 ? (100.0 * it->second->success_count / total) : 0.0;
+        LatencySummary metrics = summary(id);
+        return metrics.count() > 0 ? (100.0 * metrics.successes / metrics.count()) : 0.0;
     }
 
 private:
-    mutable std::mutex metrics_mutex_;
-    std::map<std::string, std::unique_ptr<OperationMetrics>> operations_;
+    // One thread's histograms, allocated on the thread's first use of an id
+    struct ThreadRecorder {
+        std::atomic<bool> in_use{true};
+        std::array<std::atomic<LatencyHistogram*>, kMaxOperations> ops{};
+        
+        LatencyHistogram& histogram(OperationId id) {
+            LatencyHistogram* histogram = ops[id].load(std::memory_order_relaxed);
+            if (!histogram) {
+                histogram = new LatencyHistogram();
+                ops[id].store(histogram, std::memory_order_release);
+            }
+            return *histogram;
+        }
+        
+        ~ThreadRecorder() {
+            for (auto& op : ops) {
+                delete op.load(std::memory_order_relaxed);
+            }
+        }
+    };
     
-    PerformanceMetrics() = default;
+    // Hands the recorder back to the pool when its thread exits or moves to
+    // another instance. Shared ownership keeps it valid if the instance
+    // that pooled it is destroyed first.
+    struct RecorderLease {
+        uint64_t owner = 0;
+        std::shared_ptr<ThreadRecorder> recorder;
+        
+        void release() {
+            if (recorder) {
+                recorder->in_use.store(false, std::memory_order_release);
+                recorder.reset();
+            }
+        }
+        ~RecorderLease() { release(); }
+    };
+    
+    ThreadRecorder& localRecorder() {
+        thread_local RecorderLease lease;
+        if (lease.owner != id_ || !lease.recorder) {
+            lease.release();
+            lease.owner = id_;
+            std::lock_guard<std::mutex> lock(recorders_mutex_);
+            for (auto& recorder : recorders_) {
+                bool expected = false;
+                if (recorder->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                    lease.recorder = recorder;
+                    break;
+                }
+            }
+            if (!lease.recorder) {
+                recorders_.push_back(std::make_shared<ThreadRecorder>());
+                lease.recorder = recorders_.back();
+            }
+        }
+        return *lease.recorder;
+    }
+    
+    bool lookup(const std::string& operation, OperationId& id) const {
+        std::lock_guard<std::mutex> lock(names_mutex_);
+        auto it = std::find(names_.begin(), names_.end(), operation);
+        if (it == names_.end()) {
+            return false;
+        }
+        id = static_cast<OperationId>(it - names_.begin());
+        return true;
+    }
+    
+    static uint64_t toNs(Clock::time_point time) {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            time.time_since_epoch()).count());
+    }
+    
+    mutable std::mutex names_mutex_;
+    std::vector<std::string> names_;
+    mutable std::mutex recorders_mutex_;
+    std::vector<std::shared_ptr<ThreadRecorder>> recorders_;
+    std::array<std::atomic<uint64_t>, kMaxOperations> start_ns_{};
+    
+    // Never reused, unlike addresses, so a stale lease cannot match
+    static inline std::atomic<uint64_t> next_id_{1};
+    const uint64_t id_ = next_id_.fetch_add(1, std::memory_order_relaxed);
 };
 
 /**
@@ -202,23 +391,23 @@ private:
 class PerformanceTestBase : public ::testing::Test {
 protected:
     void SetUp() override {
-        MockI2CInterface::getInstance().clearRegisterValues();
-        MockI2CInterface::getInstance().resetStatistics();
-        MockI2CInterface::getInstance().setDefaultBehavior();
-        MockI2CInterface::getInstance().setupMPU6050Defaults();
-        MockI2CInterface::getInstance().simulateDevicePresent(true);
-        
-        PerformanceMetrics::getInstance().reset();
+        // Behaviour only, no expectations: use the flat-array backend so
+        // mock overhead stays out of the measurements
+        backend_.setupMPU6050Defaults();
         
         setupTestEnvironment();
+        backend_.attach(&test_adapter_);
     }
     
     void TearDown() override {
-        PerformanceMetrics::getInstance().generateReport();
-        MockI2CInterface::getInstance().clearRegisterValues();
-        MockI2CInterface::getInstance().resetStatistics();
+        metrics_.generateReport();
     }
     
+    // Owned by this test; the backend is reached through test_adapter_
+    FastI2CBackend backend_;
+    I2CBackend::Scope backend_scope_{backend_};
+    PerformanceMetrics metrics_;
+    
     struct i2c_client test_client_{};
     struct i2c_adapter test_adapter_{};
     struct device test_device_{};
@@ -244,19 +433,16 @@ protected:
         test_file_.private_data = &test_client_;
     }
     
-    // Timing utility
+    // Timing utility; intern @operation_id once, outside the timed loop
     template<typename Func>
-    double timeOperation(const std::string& operation_name, Func&& operation) {
-        auto start = std::chrono::high_resolution_clock::now();
+    double timeOperation(PerformanceMetrics::OperationId operation_id, Func&& operation) {
+        auto start = PerformanceMetrics::Clock::now();
         bool success = operation();
-        auto end = std::chrono::high_resolution_clock::now();
-        
-        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
-        double latency_us = static_cast<double>(duration.count());
+        auto end = PerformanceMetrics::Clock::now();
         
-        PerformanceMetrics::getInstance().recordOperation(operation_name, success, latency_us);
+        metrics_.recordOperation(operation_id, success, start, end);
         
-        return latency_us;
+        return std::chrono::duration<double, std::micro>(end - start).count();
     }
 };
 
@@ -266,7 +452,7 @@ protected:
 class HighFrequencyTests : public PerformanceTestBase {};
 
 TEST_F(HighFrequencyTests, HighFrequencyDataReading) {
-    MockI2CInterface::getInstance().simulateSensorData(1000, 2000, 16000, 100, 200, 300, 8000);
+    backend_.simulateSensorData(1000, 2000, 16000, 100, 200, 300, 8000);
     
     const int OPERATIONS = 10000;
     const double MAX_AVERAGE_LATENCY_US = 500.0;  // 500 microseconds
@@ -280,8 +466,9 @@ TEST_F(HighFrequencyTests, HighFrequencyDataReading) {
     
     std::cout << "Starting high-frequency data reading test (" << OPERATIONS << " operations)..." << std::endl;
     
+    auto high_freq_read_id = metrics_.intern("high_freq_read");
     for (int i = 0; i < OPERATIONS; i++) {
-        timeOperation("high_freq_read", [&]() {
+        timeOperation(high_freq_read_id, [&]() {
             mpu6050_raw_data data;
             int result = mpu6050_read_raw_data(&test_client_, &data);
             return result == 0;
@@ -293,8 +480,8 @@ TEST_F(HighFrequencyTests, HighFrequencyDataReading) {
         }
     }
     
-    double avg_latency = PerformanceMetrics::getInstance().getAverageLatency("high_freq_read");
-    double success_rate = PerformanceMetrics::getInstance().getSuccessRate("high_freq_read");
+    double avg_latency = metrics_.getAverageLatency("high_freq_read");
+    double success_rate = metrics_.getSuccessRate("high_freq_read");
     
     EXPECT_LT(avg_latency, MAX_AVERAGE_LATENCY_US)
         << "Average latency too high: " << avg_latency << "μs";
@@ -311,6 +498,7 @@ TEST_F(HighFrequencyTests, SustainedConfigurationChanges) {
     std::uniform_int_distribution<u8> range_dist(0, 3);
     std::uniform_int_distribution<u8> rate_dist(0, 255);
     
+    auto config_change_id = metrics_.intern("config_change");
     for (int i = 0; i < OPERATIONS; i++) {
         mpu6050_config config;
         config.sample_rate_div = rate_dist(gen);
@@ -318,13 +506,13 @@ TEST_F(HighFrequencyTests, SustainedConfigurationChanges) {
         config.gyro_range = range_dist(gen);
         config.dlpf_cfg = range_dist(gen) % 8;
         
-        timeOperation("config_change", [&]() {
+        timeOperation(config_change_id, [&]() {
             int result = mpu6050_set_config(&test_client_, &config);
             return result == 0;
         });
     }
     
-    double avg_latency = PerformanceMetrics::getInstance().getAverageLatency("config_change");
+    double avg_latency = metrics_.getAverageLatency("config_change");
     EXPECT_LT(avg_latency, MAX_AVERAGE_LATENCY_US)
         << "Configuration change latency too high: " << avg_latency << "μs";
 }
@@ -405,9 +593,9 @@ TEST_F(ResourceExhaustionTests, I2CResourceExhaustion) {
     const int OPERATIONS = 5000;
     
     // Enable intermittent errors to simulate resource exhaustion
-    MockI2CInterface::getInstance().enableErrorInjection(true);
-    MockI2CInterface::getInstance().setErrorInjectionRate(0.1);  // 10% error rate
-    MockI2CInterface::getInstance().simulateI2CError(EBUSY);     // Bus busy errors
+    backend_.enableErrorInjection(true);
+    backend_.setErrorInjectionRate(0.1);  // 10% error rate
+    backend_.simulateI2CError(EBUSY);     // Bus busy errors
     
     std::atomic<int> busy_errors{0};
     std::atomic<int> recoveries{0};
@@ -443,7 +631,7 @@ TEST_F(ResourceExhaustionTests, I2CResourceExhaustion) {
     // Should recover from most errors
     EXPECT_GT(recoveries.load(), busy_errors * 0.7);   // At least 70% recovery rate
     
-    MockI2CInterface::getInstance().enableErrorInjection(false);
+    backend_.enableErrorInjection(false);
 }
 
 /**
@@ -456,12 +644,13 @@ TEST_F(ConcurrentStressTests, MassiveConcurrentReads) {
     const int OPERATIONS_PER_THREAD = 500;
     const double MIN_OVERALL_SUCCESS_RATE = 85.0;
     
-    MockI2CInterface::getInstance().simulateSensorData(1000, 2000, 16000, 100, 200, 300, 8000);
+    backend_.simulateSensorData(1000, 2000, 16000, 100, 200, 300, 8000);
     
     std::cout << "Starting massive concurrent reads test (" 
               << NUM_THREADS << " threads, " << OPERATIONS_PER_THREAD << " ops each)..." << std::endl;
     
     std::vector<std::future<std::pair<int, int>>> futures;
+    auto concurrent_read_id = metrics_.intern("concurrent_read");
     
     for (int t = 0; t < NUM_THREADS; t++) {
         futures.push_back(std::async(std::launch::async, [&, t]() {
@@ -472,7 +661,11 @@ TEST_F(ConcurrentStressTests, MassiveConcurrentReads) {
                 total++;
                 
                 mpu6050_raw_data data;
-                int result = mpu6050_read_raw_data(&test_client_, &data);
+                int result = -1;
+                timeOperation(concurrent_read_id, [&]() {
+                    result = mpu6050_read_raw_data(&test_client_, &data);
+                    return result == 0;
+                });
                 
                 if (result == 0) {
                     successful++;
@@ -605,69 +798,46 @@ class LatencyAnalysisTests : public PerformanceTestBase {};
 
 TEST_F(LatencyAnalysisTests, LatencyDistributionAnalysis) {
     const int OPERATIONS = 10000;
-    MockI2CInterface::getInstance().simulateSensorData(1000, 2000, 16000, 100, 200, 300, 8000);
-    
-    std::vector<double> latencies;
-    latencies.reserve(OPERATIONS);
+    backend_.simulateSensorData(1000, 2000, 16000, 100, 200, 300, 8000);
     
     std::cout << "Collecting latency samples (" << OPERATIONS << " operations)..." << std::endl;
     
+    auto distribution_read_id = metrics_.intern("distribution_read");
     for (int i = 0; i < OPERATIONS; i++) {
-        auto start = std::chrono::high_resolution_clock::now();
-        
-        mpu6050_raw_data data;
-        int result = mpu6050_read_raw_data(&test_client_, &data);
-        
-        auto end = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
-        
-        if (result == 0) {
-            latencies.push_back(static_cast<double>(duration.count()));
-        }
+        timeOperation(distribution_read_id, [&]() {
+            mpu6050_raw_data data;
+            return mpu6050_read_raw_data(&test_client_, &data) == 0;
+        });
     }
     
-    if (!latencies.empty()) {
-        std::sort(latencies.begin(), latencies.end());
-        
-        double min_lat = latencies.front();
-        double max_lat = latencies.back();
-        double avg_lat = std::accumulate(latencies.begin(), latencies.end(), 0.0) / latencies.size();
-        double median_lat = latencies[latencies.size() / 2];
-        double p90_lat = latencies[static_cast<size_t>(latencies.size() * 0.90)];
-        double p95_lat = latencies[static_cast<size_t>(latencies.size() * 0.95)];
-        double p99_lat = latencies[static_cast<size_t>(latencies.size() * 0.99)];
+    LatencySummary latencies = metrics_.summary(distribution_read_id);
+    
+    if (latencies.count() > 0) {
+        double avg_lat = latencies.averageUs();
+        double p95_lat = latencies.percentileUs(0.95);
+        double p99_lat = latencies.percentileUs(0.99);
         
         std::cout << "\nLatency Distribution Analysis:" << std::endl;
-        std::cout << "  Samples: " << latencies.size() << std::endl;
-        std::cout << "  Min: " << std::fixed << std::setprecision(2) << min_lat << " μs" << std::endl;
+        std::cout << "  Samples: " << latencies.count() << std::endl;
+        std::cout << "  Min: " << std::fixed << std::setprecision(2) << latencies.minUs() << " μs" << std::endl;
         std::cout << "  Average: " << avg_lat << " μs" << std::endl;
-        std::cout << "  Median: " << median_lat << " μs" << std::endl;
-        std::cout << "  90th percentile: " << p90_lat << " μs" << std::endl;
+        std::cout << "  Median: " << latencies.percentileUs(0.50) << " μs" << std::endl;
+        std::cout << "  90th percentile: " << latencies.percentileUs(0.90) << " μs" << std::endl;
         std::cout << "  95th percentile: " << p95_lat << " μs" << std::endl;
         std::cout << "  99th percentile: " << p99_lat << " μs" << std::endl;
-        std::cout << "  Max: " << max_lat << " μs" << std::endl;
+        std::cout << "  Max: " << latencies.maxUs() << " μs" << std::endl;
         
         // Performance requirements
         EXPECT_LT(avg_lat, 500.0) << "Average latency should be < 500μs";
         EXPECT_LT(p95_lat, 1000.0) << "95th percentile latency should be < 1ms";
         EXPECT_LT(p99_lat, 2000.0) << "99th percentile latency should be < 2ms";
         
-        // Check for outliers (values > 3 standard deviations from mean)
-        double variance = 0.0;
-        for (double lat : latencies) {
-            variance += (lat - avg_lat) * (lat - avg_lat);
-        }
-        variance /= latencies.size();
-        double stddev = std::sqrt(variance);
-        
-        int outliers = 0;
-        for (double lat : latencies) {
-            if (std::abs(lat - avg_lat) > 3 * stddev) {
-                outliers++;
-            }
-        }
+        // Check for outliers (values > 3 standard deviations from mean),
+        // both taken from the histogram buckets
+        double stddev = latencies.stddevUs();
+        uint64_t outliers = latencies.countOutside(3 * stddev);
         
-        double outlier_percentage = 100.0 * outliers / latencies.size();
+        double outlier_percentage = 100.0 * outliers / latencies.count();
         std::cout << "  Outliers (>3σ): " << outliers << " (" << outlier_percentage << "%)" << std::endl;
         
         EXPECT_LT(outlier_percentage, 1.0) << "Too many latency outliers detected";
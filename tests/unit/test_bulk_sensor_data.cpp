@@ -0,0 +1,94 @@
+/**
+ * @file test_bulk_sensor_data.cpp
+ * @brief Tests for the BulkSensorData fixture
+ *
+ * The property and stress suites take their inputs from BulkSensorData, so
+ * check that a stream yields the same samples whatever its chunk size, that
+ * a cached corpus maps back the samples it was generated from, and that the
+ * waveforms and noise follow the MockSensorData patterns.
+ */
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+#include "../fixtures/BulkSensorData.hpp"
+
+using Pattern = MockSensorData::Pattern;
+
+class BulkSensorDataTest : public ::testing::Test {
+protected:
+    static constexpr size_t kCount = 100000;
+
+    void SetUp() override {
+        ASSERT_NE(mkdtemp(cache_dir_), nullptr);
+        setenv("MPU6050_TEST_DATA_CACHE", cache_dir_, 1);
+
+        for (size_t c = 0; c < BulkSensorData::kChannels; c++) {
+            out_.chan[c] = &whole_[c * kCount];
+        }
+    }
+
+    void TearDown() override {
+        unsetenv("MPU6050_TEST_DATA_CACHE");
+        std::filesystem::remove_all(cache_dir_);
+    }
+
+    const int16_t* column(size_t c) const { return &whole_[c * kCount]; }
+
+    char cache_dir_[32] = "/tmp/mpu6050-bulk-XXXXXX";
+    std::vector<int16_t> whole_ = std::vector<int16_t>(BulkSensorData::kChannels * kCount);
+    BulkSensorData::Columns out_;
+};
+
+TEST_F(BulkSensorDataTest, StreamsAndCachesMatchOnePass) {
+    for (auto pattern : {Pattern::NORMAL, Pattern::SINE_WAVE,
+                         Pattern::RANDOM_WALK, Pattern::STEP_FUNCTION}) {
+        BulkSensorData gen(pattern, 7, kCount);
+
+        ASSERT_EQ(gen.fill(out_, kCount + 1), kCount);
+        EXPECT_EQ(gen.fill(out_, 1), 0u);
+
+        // Chunked output matches one pass, odd chunk sizes included
+        BulkSensorData::Stream stream(BulkSensorData(pattern, 7, kCount), 999);
+        size_t seen = 0, got;
+        while ((got = stream.next())) {
+            for (size_t c = 0; c < BulkSensorData::kChannels; c++) {
+                ASSERT_EQ(memcmp(stream.column(c), column(c) + seen, got * sizeof(int16_t)), 0);
+            }
+            seen += got;
+        }
+        EXPECT_EQ(seen, kCount);
+
+        // The second load maps the file the first one generated
+        for (int pass = 0; pass < 2; pass++) {
+            auto corpus = BulkSensorData::Corpus::load(pattern, 7, kCount);
+            ASSERT_EQ(corpus.size(), kCount);
+            for (size_t c = 0; c < BulkSensorData::kChannels; c++) {
+                ASSERT_EQ(memcmp(corpus.column(c), column(c), kCount * sizeof(int16_t)), 0);
+            }
+        }
+    }
+}
+
+TEST_F(BulkSensorDataTest, WaveformsAndNoiseFollowPatterns) {
+    // Waveforms track sin()
+    BulkSensorData sine(Pattern::SINE_WAVE, 1, kCount);
+    sine.fill(out_, kCount);
+    for (size_t i = 0; i < kCount; i += 997) {
+        EXPECT_NEAR(column(0)[i], 8000 * std::sin(i / 10.0), 1.5);
+    }
+
+    // Noise has the requested spread
+    BulkSensorData normal(Pattern::NORMAL, 1, kCount);
+    normal.fill(out_, kCount);
+    double sum = 0, sq = 0;
+    for (size_t i = 0; i < kCount; i++) {
+        sum += column(0)[i];
+        sq += static_cast<double>(column(0)[i]) * column(0)[i];
+    }
+    EXPECT_NEAR(sum / kCount, 0, 30);
+    EXPECT_NEAR(std::sqrt(sq / kCount - (sum / kCount) * (sum / kCount)), 2000, 30);
+}
@@ -0,0 +1,502 @@
+/**
+ * @file test_libmpu6050.cpp
+ * @brief Unit tests for libmpu6050 decoders, merge, SIMD, fusion, captures
+ *	  and latency histograms
+ *
+ * Builds packed records the way the driver lays them out and checks that
+ * the compile-time and run-time decoders recover every field for every
+ * channel mask, that multi-sensor runs merge in timestamp order, that
+ * every SIMD kernel matches the driver's scalar conversion bit for bit,
+ * that the fusion filters track known motion in both float and fixed
+ * point, that captures round-trip and replay, and that latency histograms
+ * report quantiles within their bucket width. Needs no device.
+ */
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+#include <unistd.h>
+#include "../../lib/mpu6050.hpp"
+#include "../../lib/capture.hpp"
+#include "../../lib/fusion.hpp"
+#include "../../lib/histogram.hpp"
+#include "../../lib/simd.hpp"
+#include "../fixtures/MockSensorData.hpp"
+#include "../fixtures/CaptureReplay.hpp"
+
+namespace {
+
+/* Pack @n records of @layout with channel n of record i set to i * 16 + n */
+std::vector<u8> pack_records(const mpu6050::Layout &layout, size_t n)
+{
+	size_t size = layout.record_size();
+	std::vector<u8> buf(n * size);
+
+	for (size_t i = 0; i < n; i++) {
+		u8 *rec = &buf[i * size];
+		s64 ts = 1000000 * (s64)i;
+		u32 seq = 100 + i;
+		u16 flags = i & 1;
+		size_t off = offsetof(struct mpu6050_record, data);
+
+		memcpy(rec, &ts, sizeof(ts));
+		memcpy(rec + 8, &seq, sizeof(seq));
+		memcpy(rec + 12, &flags, sizeof(flags));
+		for (unsigned c = 0; c < MPU6050_NUM_CHANNELS; c++) {
+			s16 val = -(s16)(i * 16 + c);
+
+			if (!(layout.channels & BIT(c)))
+				continue;
+			memcpy(rec + off, &val, sizeof(val));
+			off += 2;
+		}
+		for (unsigned e = 0; e < layout.ext_len; e++)
+			rec[off + e] = 0xa0 + e;
+	}
+	return buf;
+}
+
+void expect_samples(const mpu6050::Layout &layout,
+		    const std::vector<mpu6050::Sample> &samples)
+{
+	for (size_t i = 0; i < samples.size(); i++) {
+		const mpu6050::Sample &s = samples[i];
+
+		EXPECT_EQ(s.timestamp, 1000000 * (s64)i);
+		EXPECT_EQ(s.seq, 100 + i);
+		EXPECT_EQ(s.flags, i & 1);
+		for (unsigned c = 0; c < MPU6050_NUM_CHANNELS; c++) {
+			s16 want = layout.channels & BIT(c) ? -(s16)(i * 16 + c) : 0;
+
+			EXPECT_EQ(mpu6050_raw_chan(&s.raw, c), want)
+				<< "mask " << layout.channels << " channel " << c;
+		}
+		ASSERT_EQ(s.ext_len, layout.ext_len);
+		for (unsigned e = 0; e < layout.ext_len; e++)
+			EXPECT_EQ(s.ext[e], 0xa0 + e);
+	}
+}
+
+} /* namespace */
+
+TEST(LibMpu6050Test, RecordSizeMatchesDriverLayout)
+{
+	mpu6050::Layout all;
+
+	EXPECT_EQ(all.record_size(), sizeof(struct mpu6050_sample));
+	EXPECT_EQ(mpu6050::record_max_size,
+		  MPU6050_RECORD_EXT_SIZE(MPU6050_NUM_CHANNELS, MPU6050_EXT_DATA_SIZE));
+	EXPECT_EQ((mpu6050::RecordDecoder<MPU6050_CHAN_ACCEL, 6>::record_size),
+		  MPU6050_RECORD_EXT_SIZE(3, 6));
+
+	/* Merged group records only claim a reserved byte of the sample */
+	EXPECT_EQ(sizeof(struct mpu6050_group_sample), sizeof(struct mpu6050_sample));
+	EXPECT_EQ(offsetof(struct mpu6050_group_sample, sensor),
+		  offsetof(struct mpu6050_sample, reserved));
+}
+
+TEST(LibMpu6050Test, RuntimeDecoderHandlesEveryMask)
+{
+	for (u32 mask = 1; mask <= MPU6050_CHAN_ALL; mask++) {
+		for (u32 ext : {0u, 5u, (u32)MPU6050_EXT_DATA_SIZE}) {
+			mpu6050::Layout layout{mask, ext};
+			std::vector<u8> buf = pack_records(layout, 4);
+			std::vector<mpu6050::Sample> samples(4);
+			mpu6050::Decoder dec(layout);
+
+			ASSERT_EQ(dec.record_size(), layout.record_size());
+			ASSERT_EQ(dec.decode(buf.data(), 4, samples.data()), 4u);
+			expect_samples(layout, samples);
+		}
+	}
+}
+
+TEST(LibMpu6050Test, CompileTimeDecoderMatchesRuntime)
+{
+	constexpr u32 mask = MPU6050_CHAN_ACCEL | MPU6050_CHAN_GYRO_Z;
+	using Dec = mpu6050::RecordDecoder<mask, 3>;
+	std::vector<u8> buf = pack_records(Dec::layout, 8);
+	std::vector<mpu6050::Sample> samples(8);
+
+	ASSERT_EQ(Dec::decode(buf.data(), 8, samples.data()), 8u);
+	expect_samples(Dec::layout, samples);
+}
+
+TEST(LibMpu6050Test, InvalidLayoutIsRejected)
+{
+	EXPECT_THROW(mpu6050::Decoder(mpu6050::Layout{0, 0}), std::system_error);
+	EXPECT_THROW(mpu6050::Decoder(mpu6050::Layout{BIT(7), 0}),
+		     std::system_error);
+	EXPECT_THROW(mpu6050::Decoder(mpu6050::Layout{MPU6050_CHAN_ALL,
+						      MPU6050_EXT_DATA_SIZE + 1}),
+		     std::system_error);
+}
+
+TEST(LibMpu6050Test, MergeOrdersSensorsByTimestamp)
+{
+	std::vector<mpu6050::Sample> a(3), b(2);
+	mpu6050::MergedSample out[8];
+	mpu6050::SampleRun runs[2];
+
+	/* 1 kHz and 500 Hz sensors, both sampling at 2 ms */
+	for (size_t i = 0; i < a.size(); i++)
+		a[i] = {(s64)(i + 1) * 1000000, (u32)i, 0, {}, 0, nullptr};
+	for (size_t i = 0; i < b.size(); i++)
+		b[i] = {(s64)(i + 1) * 2000000, (u32)i, 0, {}, 0, nullptr};
+
+	/* 1 2 2 3 ms, the tie going to sensor 0, until sensor 0 runs dry */
+	runs[0] = {a.data(), a.data() + a.size()};
+	runs[1] = {b.data(), b.data() + b.size()};
+	ASSERT_EQ(mpu6050::merge(runs, 2, out, 8), 4u);
+	EXPECT_EQ(out[0].sensor, 0u);
+	EXPECT_EQ(out[1].sensor, 0u);
+	EXPECT_EQ(out[1].sample.timestamp, 2000000);
+	EXPECT_EQ(out[2].sensor, 1u);
+	EXPECT_EQ(out[2].sample.timestamp, 2000000);
+	EXPECT_EQ(out[3].sample.seq, 2u);
+
+	/* Sensor 0's next batch may still be older than sensor 1's 4 ms */
+	EXPECT_EQ(mpu6050::merge(runs, 2, out, 8), 0u);
+
+	/* Flushing releases what the other sensors hold */
+	ASSERT_EQ(mpu6050::merge(runs, 2, out, 8, true), 1u);
+	EXPECT_EQ(out[0].sensor, 1u);
+	EXPECT_EQ(out[0].sample.timestamp, 4000000);
+	EXPECT_EQ(runs[1].begin, runs[1].end);
+
+	/* The output limit is honoured */
+	runs[0] = {a.data(), a.data() + a.size()};
+	runs[1] = {b.data(), b.data() + b.size()};
+	EXPECT_EQ(mpu6050::merge(runs, 2, out, 2), 2u);
+	EXPECT_EQ(runs[0].begin, a.data() + 2);
+	EXPECT_EQ(runs[1].begin, b.data());
+}
+
+TEST(LibMpu6050Test, ScaleMatchesDriverUnits)
+{
+	mpu6050_config config = {0, MPU6050_GYRO_FS_250, MPU6050_ACCEL_FS_2G, 1};
+	mpu6050_scale scale = mpu6050::make_scale(config);
+	mpu6050_raw_data raw = {16384, -16384, 0, 0, 13100, 0, -13100};
+	mpu6050_scaled_data out;
+
+	mpu6050_scale_raw(&raw, &scale, &out);
+	EXPECT_EQ(out.accel_x, 999);		/* 16384 * 61 ug */
+	EXPECT_EQ(out.accel_y, -999);
+	EXPECT_EQ(out.temp, 3653);		/* 36.53 degrees C */
+	EXPECT_EQ(out.gyro_x, 100);		/* 13100 * 7633 / 10^6 */
+	EXPECT_EQ(out.gyro_z, -100);
+}
+
+TEST(LibMpu6050Test, SimdKernelsMatchScalar)
+{
+	mpu6050_config config = {0, MPU6050_GYRO_FS_2000, MPU6050_ACCEL_FS_16G, 1};
+	mpu6050_calibration calib = {{300, -300, 7}, {-40, 0, 40},
+				     {MPU6050_CALIB_MAX_SCALE_PPM, 0,
+				      -MPU6050_CALIB_MAX_SCALE_PPM},
+				     {1000, -1000, 0}};
+	mpu6050_scale scale = mpu6050::make_scale(config, &calib);
+	std::mt19937 rng(42);
+
+	for (u32 mask : {(u32)MPU6050_CHAN_ALL, (u32)MPU6050_CHAN_ACCEL,
+			 (u32)MPU6050_CHAN_TEMP,
+			 (u32)(MPU6050_CHAN_ACCEL_Y | MPU6050_CHAN_GYRO)}) {
+		for (size_t n : {1u, 7u, 8u, 9u, 63u, 1000u, 2051u}) {
+			size_t stride = 2 * __builtin_popcount(mask);
+			std::vector<u8> fifo(n * stride);
+			std::vector<s16> raw_ref(7 * n), raw(7 * n);
+			std::vector<s32> ref(7 * n), out(7 * n);
+			mpu6050::RawSoa rref = {}, rout = {};
+			mpu6050::ScaledSoa sref = {}, sout = {};
+
+			for (u8 &b : fifo)
+				b = rng();
+			for (unsigned c = 0; c < MPU6050_NUM_CHANNELS; c++) {
+				if (!(mask & BIT(c)))
+					continue;
+				rref.chan[c] = &raw_ref[c * n];
+				rout.chan[c] = &raw[c * n];
+				sref.chan[c] = &ref[c * n];
+				sout.chan[c] = &out[c * n];
+			}
+			mpu6050::fifo_to_soa(fifo.data(), n, mask, rref,
+					     mpu6050::Isa::scalar);
+			mpu6050::scale_soa(rref, n, scale, sref,
+					   mpu6050::Isa::scalar);
+
+			/* The scalar kernels are the driver's own conversion */
+			for (size_t i = 0; i < n; i++) {
+				unsigned slot = 0;
+
+				for (unsigned c = 0; c < MPU6050_NUM_CHANNELS; c++) {
+					const u8 *f = &fifo[i * stride + 2 * slot];
+
+					if (!(mask & BIT(c)))
+						continue;
+					slot++;
+					ASSERT_EQ(raw_ref[c * n + i],
+						  (s16)(f[0] << 8 | f[1]));
+					ASSERT_EQ(ref[c * n + i],
+						  mpu6050_scale_chan(&scale, c,
+								     raw_ref[c * n + i]));
+				}
+			}
+
+			for (mpu6050::Isa isa : {mpu6050::Isa::sse41,
+						 mpu6050::Isa::avx2,
+						 mpu6050::Isa::neon}) {
+				if (!mpu6050::isa_supported(isa))
+					continue;
+				std::fill(raw.begin(), raw.end(), 0);
+				std::fill(out.begin(), out.end(), 0);
+				mpu6050::fifo_to_soa(fifo.data(), n, mask, rout, isa);
+				mpu6050::scale_soa(rout, n, scale, sout, isa);
+				EXPECT_EQ(raw, raw_ref) << mpu6050::isa_name(isa)
+							<< " mask " << mask << " n " << n;
+				EXPECT_EQ(out, ref) << mpu6050::isa_name(isa)
+						    << " mask " << mask << " n " << n;
+
+				std::fill(out.begin(), out.end(), 0);
+				mpu6050::fifo_to_scaled_soa(fifo.data(), n, mask,
+							    scale, sout, isa);
+				EXPECT_EQ(out, ref) << mpu6050::isa_name(isa)
+						    << " fused, mask " << mask;
+			}
+		}
+	}
+}
+
+namespace {
+
+double to_double(float v)
+{
+	return v;
+}
+
+double to_double(mpu6050::Fixed v)
+{
+	return v.to_double();
+}
+
+/* 1 kHz samples of a level sensor turning about z at @dps */
+std::vector<mpu6050::Sample> yaw_samples(size_t n, double dps, s16 accel_y)
+{
+	std::vector<mpu6050::Sample> samples(n);
+
+	for (size_t i = 0; i < n; i++) {
+		samples[i] = {};
+		samples[i].timestamp = 1000000 * (s64)(i + 1);
+		samples[i].seq = i;
+		samples[i].raw.accel_y = accel_y;
+		samples[i].raw.accel_z = accel_y ? 0 : 16384;
+		samples[i].raw.gyro_z = (s16)(dps * 131);
+	}
+	return samples;
+}
+
+template <typename T, typename Filter>
+void expect_yaw(double gain)
+{
+	/* 90 dps for one second in batches of 100 */
+	std::vector<mpu6050::Sample> samples = yaw_samples(1001, 90, 0);
+	std::vector<mpu6050::Quat<T>> out(100);
+	mpu6050::Fusion<T, Filter> fusion(2, gain);
+	mpu6050::Quat<T> q;
+
+	fusion.update(1, samples.data(), 1, nullptr);
+	for (size_t i = 1; i < samples.size(); i += 100)
+		ASSERT_EQ(fusion.update(1, &samples[i], 100, out.data()), 100u);
+	q = fusion.orientation(1);
+
+	EXPECT_EQ(out[99].seq, 1000u);
+	EXPECT_NEAR(to_double(q.w), std::sqrt(0.5), 2e-3);
+	EXPECT_NEAR(to_double(q.z), std::sqrt(0.5), 2e-3);
+	EXPECT_NEAR(to_double(q.x), 0, 1e-3);
+	EXPECT_NEAR(to_double(q.y), 0, 1e-3);
+
+	/* The other sensor of the bank is untouched */
+	EXPECT_EQ(to_double(fusion.orientation(0).w), 1.0);
+}
+
+template <typename T, typename Filter>
+void expect_tilt(double gain)
+{
+	/* Gravity along +y: the filter converges to -90 degrees about x */
+	std::vector<mpu6050::Sample> samples = yaw_samples(20000, 0, 16384);
+	mpu6050::Fusion<T, Filter> fusion(1, gain);
+	mpu6050::Quat<T> q;
+
+	fusion.update(0, samples.data(), samples.size(), nullptr);
+	q = fusion.orientation(0);
+
+	EXPECT_NEAR(std::fabs(to_double(q.w)), std::sqrt(0.5), 1e-2);
+	EXPECT_NEAR(std::fabs(to_double(q.x)), std::sqrt(0.5), 1e-2);
+	EXPECT_NEAR(to_double(q.y), 0, 1e-2);
+	EXPECT_NEAR(to_double(q.z), 0, 1e-2);
+}
+
+} /* namespace */
+
+TEST(LibMpu6050Test, FusionIntegratesGyro)
+{
+	expect_yaw<float, mpu6050::Madgwick>(0.05);
+	expect_yaw<mpu6050::Fixed, mpu6050::Madgwick>(0.05);
+	expect_yaw<float, mpu6050::Complementary>(1.0);
+	expect_yaw<mpu6050::Fixed, mpu6050::Complementary>(1.0);
+}
+
+TEST(LibMpu6050Test, FusionConvergesToGravity)
+{
+	expect_tilt<float, mpu6050::Madgwick>(0.5);
+	expect_tilt<mpu6050::Fixed, mpu6050::Madgwick>(0.5);
+	expect_tilt<float, mpu6050::Complementary>(2.0);
+	expect_tilt<mpu6050::Fixed, mpu6050::Complementary>(2.0);
+}
+
+TEST(LibMpu6050Test, CaptureRoundTripsAndSeeks)
+{
+	mpu6050_config config = {4, MPU6050_GYRO_FS_500, MPU6050_ACCEL_FS_4G, 3};
+	u32 period = mpu6050::sample_period_ns(config);
+	mpu6050::Layout layout{MPU6050_CHAN_ACCEL | MPU6050_CHAN_GYRO, 2};
+	char path[] = "/tmp/test_libmpu6050_XXXXXX";
+	std::vector<mpu6050::Sample> in(3000);
+	u8 ext[] = {0x12, 0x34};
+	int fd = mkstemp(path);
+	size_t n = 0;
+
+	ASSERT_GE(fd, 0);
+	close(fd);
+	EXPECT_EQ(period, 5000000u);
+
+	/* A slow rotation with jitter, one dropped sample and one overflow */
+	for (size_t i = 0; i < in.size(); i++) {
+		mpu6050::Sample &s = in[i];
+		double t = i * 5e-3;
+
+		s = {};
+		s.seq = i + (i >= 1200);
+		s.timestamp = (s64)s.seq * period + (i % 7) * 1000;
+		s.flags = i == 1200 ? MPU6050_SAMPLE_FIFO_OVERFLOW : 0;
+		s.raw.accel_x = 8000 * std::sin(t);
+		s.raw.accel_y = 8000 * std::cos(t);
+		s.raw.accel_z = 6000;
+		s.raw.gyro_z = i == 2000 ? -32768 : 650;
+		s.ext_len = sizeof(ext);
+		s.ext = ext;
+	}
+
+	{
+		mpu6050::CaptureWriter writer(path, config, layout, period, 256);
+
+		writer.write(in.data(), in.data() + 1000);
+		writer.write(in.data() + 1000, in.data() + in.size());
+		EXPECT_EQ(writer.size(), in.size());
+		writer.close();
+
+		/* Less than half the raw samples, timestamps included */
+		EXPECT_LT(writer.bytes(), in.size() * sizeof(mpu6050_sample) / 2);
+	}
+
+	mpu6050::CaptureReader reader(path, 100);
+
+	EXPECT_EQ(reader.samples(), in.size());
+	EXPECT_EQ(reader.header().nr_chunks, 12u);
+	EXPECT_EQ(reader.config().gyro_range, MPU6050_GYRO_FS_500);
+	EXPECT_EQ(reader.layout().channels, layout.channels);
+	while (reader.read()) {
+		for (const mpu6050::Sample &s : reader) {
+			const mpu6050::Sample &e = in[n++];
+
+			ASSERT_EQ(s.timestamp, e.timestamp);
+			ASSERT_EQ(s.seq, e.seq);
+			ASSERT_EQ(s.flags, e.flags);
+			ASSERT_EQ(memcmp(&s.raw, &e.raw, sizeof(s.raw)), 0);
+			ASSERT_EQ(s.ext_len, 2u);
+			ASSERT_EQ(memcmp(s.ext, ext, sizeof(ext)), 0);
+		}
+	}
+	EXPECT_EQ(n, in.size());
+
+	/* By number, in the middle of a chunk */
+	reader.seek(1300);
+	ASSERT_EQ(reader.read(), 100u);
+	EXPECT_EQ(reader.begin()->seq, in[1300].seq);
+
+	/* By time, between two samples */
+	EXPECT_EQ(reader.seek_time(in[2100].timestamp - 1), 2100u);
+	ASSERT_EQ(reader.read(), 100u);
+	EXPECT_EQ(reader.begin()->timestamp, in[2100].timestamp);
+	EXPECT_EQ(reader.seek_time(0), 0u);
+	EXPECT_EQ(reader.seek_time(in.back().timestamp + 1), in.size());
+	EXPECT_EQ(reader.read(), 0u);
+
+	unlink(path);
+}
+
+TEST(LibMpu6050Test, CaptureFixtureReplaysRawData)
+{
+	std::string dir = __FILE__;
+	std::vector<MockSensorData::SensorReading> readings;
+	std::vector<mpu6050_raw_data> raw(1000);
+	FILE *f;
+
+	dir = dir.substr(0, dir.rfind('/')) + "/../fixtures/";
+	f = fopen((dir + "sensor_data.bin").c_str(), "rb");
+	ASSERT_NE(f, nullptr);
+	ASSERT_EQ(fread(raw.data(), sizeof(raw[0]), raw.size(), f), raw.size());
+	fclose(f);
+
+	/* One second at 1 kHz, replayed at 100 times the recorded rate */
+	auto start = std::chrono::steady_clock::now();
+	readings = replayCapture(dir + "sensor_data.cap", 100);
+	EXPECT_GE(std::chrono::steady_clock::now() - start,
+		  std::chrono::milliseconds(9));
+
+	ASSERT_EQ(readings.size(), raw.size());
+	for (size_t i = 0; i < raw.size(); i++) {
+		ASSERT_EQ(readings[i].accel_x, raw[i].accel_x);
+		ASSERT_EQ(readings[i].temp, raw[i].temp);
+		ASSERT_EQ(readings[i].gyro_z, raw[i].gyro_z);
+	}
+	EXPECT_EQ(replayCapture(dir + "sensor_data.cap", 0, 10).size(), 10u);
+}
+
+TEST(LibMpu6050Test, HistogramQuantilesAndMerge)
+{
+	mpu6050::Histogram odd, all;
+	mpu6050::SharedHistogram even;
+	const u64 n = 100000;
+
+	/* 1..n us, split over a plain and a shared histogram */
+	for (u64 v = 1; v <= n; v++) {
+		if (v % 2)
+			odd.add(v * 1000);
+		else
+			even.add(v * 1000);
+	}
+	all.merge(odd);
+	all.merge(even);
+
+	EXPECT_EQ(all.count(), n);
+	EXPECT_EQ(all.min(), 1000u);
+	EXPECT_EQ(all.max(), n * 1000);
+	EXPECT_DOUBLE_EQ(all.mean(), (n + 1) * 500.0);
+	for (double q : {0.01, 0.5, 0.9, 0.99, 0.999})
+		EXPECT_NEAR(all.percentile(q), q * n * 1000, q * n * 1000 * 0.03);
+	EXPECT_NEAR(all.stddev(), n * 1000 / std::sqrt(12.0), n * 1000 * 0.001);
+
+	/* Small values are exact and large ones saturate */
+	mpu6050::Histogram h;
+	EXPECT_EQ(h.percentile(0.5), 0u);
+	for (u64 v = 0; v < mpu6050::Histogram::sub_count; v++)
+		EXPECT_EQ(mpu6050::Histogram::midpoint(mpu6050::Histogram::bucket(v)), v);
+	h.add(UINT64_MAX);
+	EXPECT_EQ(h.max(), mpu6050::Histogram::max_value);
+	EXPECT_EQ(mpu6050::Histogram::bucket(h.max()), mpu6050::Histogram::nr_buckets - 1);
+}
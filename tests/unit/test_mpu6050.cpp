@@ -12,6 +12,7 @@
 #include "../mocks/mock_i2c.h"
 #include "../utils/test_helpers.h"
 #include "../fixtures/sensor_data.h"
+#include "../bench/bench_device.h"
 
 // Include the driver header (would normally be included)
 // For testing, we'll define the interface we expect the driver to provide
@@ -62,6 +63,7 @@ protected:
         // Set up test adapter
         test_adapter_.nr = 1;
         test_adapter_.name = "test-i2c-adapter";
+        mock_.attach(&test_adapter_);
         
         // Set up test device
         test_device_.init_name = "mpu6050-test";
@@ -73,6 +75,10 @@ protected:
         MockI2CInterface::getInstance().resetStatistics();
     }
     
+    // Mock owned by this test; getInstance() returns it while in scope
+    MockI2CInterface mock_;
+    MockI2CInterface::Scope mock_scope_{mock_};
+    
     // Test objects
     struct i2c_client test_client_{};
     struct i2c_adapter test_adapter_{};
@@ -475,6 +481,87 @@ TEST_F(MPU6050DriverTest, DeviceNotPresentDetection) {
     EXPECT_FALSE(present);
 }
 
+// =============================================================================
+// FIFO Bulk Transfer Tests
+// =============================================================================
+
+/**
+ * @class MPU6050FifoDrainTest
+ * @brief Drives the driver's FIFO drain path on an in-memory bus
+ *
+ * mpu6050_read_fifo() from drivers/mpu6050_main.c runs against the kernel
+ * shim in tests/bench/kernel. The device's FIFO image is a sawtooth of
+ * 16-bit words, so frame k holds words 7k to 7k + 6 with every channel
+ * enabled.
+ */
+class MPU6050FifoDrainTest : public ::testing::Test {
+protected:
+    // A full FIFO of whole frames with every channel enabled
+    static constexpr unsigned int kFrameSize = 14;
+    static constexpr unsigned int kFrames = MPU6050_FIFO_SIZE / kFrameSize;
+
+    void TearDown() override {
+        if (device_) {
+            bench_device_destroy(device_);
+        }
+    }
+
+    std::vector<mpu6050_raw_data> drainFullFifo() {
+        std::vector<mpu6050_raw_data> samples(kFrames);
+
+        mpu6050_lock(device_);
+        EXPECT_EQ(mpu6050_read_fifo(device_, samples.data(), kFrames), 0);
+        bench_device_unlock(device_);
+        return samples;
+    }
+
+    static void expectSawtooth(const std::vector<mpu6050_raw_data>& samples) {
+        for (size_t k = 0; k < samples.size(); k++) {
+            const mpu6050_raw_data& s = samples[k];
+            const s16 got[] = { s.accel_x, s.accel_y, s.accel_z, s.temp,
+                                s.gyro_x, s.gyro_y, s.gyro_z };
+
+            for (size_t j = 0; j < 7; j++) {
+                ASSERT_EQ(got[j], static_cast<s16>((k * 7 + j) * 97 - 12000))
+                    << "frame " << k << " word " << j;
+            }
+        }
+    }
+
+    mpu6050_data* device_ = nullptr;
+};
+
+TEST_F(MPU6050FifoDrainTest, FifoDrainSingleI2CTransfer) {
+    device_ = bench_device_create_on(I2C_FUNC_I2C | I2C_FUNC_SMBUS_BYTE_DATA |
+                                     I2C_FUNC_SMBUS_I2C_BLOCK);
+    ASSERT_NE(device_, nullptr);
+
+    std::vector<mpu6050_raw_data> samples = drainFullFifo();
+
+    // One address write plus repeated-start read for the whole FIFO
+    bench_bus_stats stats;
+    bench_device_bus_stats(device_, &stats);
+    EXPECT_EQ(stats.transfers, 1u);
+    EXPECT_EQ(stats.block_reads, 0u);
+    expectSawtooth(samples);
+}
+
+TEST_F(MPU6050FifoDrainTest, FifoDrainChunkedOnSMBusAdapter) {
+    device_ = bench_device_create_on(I2C_FUNC_SMBUS_BYTE_DATA | I2C_FUNC_SMBUS_I2C_BLOCK);
+    ASSERT_NE(device_, nullptr);
+
+    std::vector<mpu6050_raw_data> samples = drainFullFifo();
+
+    // No raw transfers; regmap splits the burst into SMBus block reads
+    bench_bus_stats stats;
+    bench_device_bus_stats(device_, &stats);
+    EXPECT_EQ(stats.transfers, 0u);
+    EXPECT_EQ(stats.block_reads,
+              (kFrames * kFrameSize + I2C_SMBUS_BLOCK_MAX - 1) / I2C_SMBUS_BLOCK_MAX);
+    EXPECT_EQ(stats.max_block_len, static_cast<size_t>(I2C_SMBUS_BLOCK_MAX));
+    expectSawtooth(samples);
+}
+
 // =============================================================================
 // Performance and Stress Tests
 // =============================================================================
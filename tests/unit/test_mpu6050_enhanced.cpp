@@ -125,6 +125,7 @@ protected:
         
         test_adapter_.nr = 1;
         test_adapter_.name = "test-adapter";
+        mock_.attach(&test_adapter_);
         
         test_device_.init_name = "mpu6050-test";
         
@@ -137,6 +138,10 @@ protected:
         MockI2CInterface::getInstance().resetStatistics();
     }
     
+    // Mock owned by this test; getInstance() returns it while in scope
+    MockI2CInterface mock_;
+    MockI2CInterface::Scope mock_scope_{mock_};
+    
     // Test objects
     struct i2c_client test_client_{};
     struct i2c_adapter test_adapter_{};
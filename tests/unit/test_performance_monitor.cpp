@@ -0,0 +1,164 @@
+/**
+ * @file test_performance_monitor.cpp
+ * @brief Tests for the streaming statistics of the performance monitor
+ *
+ * Feeds perf_stream_* and the session statistics distributions whose
+ * moments and quantiles are known in closed form, and checks that merged
+ * streams agree with a single stream over the same values.
+ */
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstring>
+#include "../utils/performance_monitor.h"
+
+class PerfStreamTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        perf_stream_reset(&stats_);
+    }
+
+    // Percentiles are accurate to the bucket width, about 3%
+    static void expectPercentileNear(const struct perf_stream_stats* stats, double percentile,
+                                     double expected) {
+        EXPECT_NEAR(static_cast<double>(perf_stream_percentile(stats, percentile)), expected,
+                    expected * 0.03)
+            << "percentile " << percentile;
+    }
+
+    struct perf_stream_stats stats_;
+};
+
+TEST_F(PerfStreamTest, UniformStreamHasKnownMomentsAndQuantiles) {
+    const uint64_t n = 100000;
+
+    for (uint64_t v = 1; v <= n; v++) {
+        perf_stream_add(&stats_, v, v % 10 != 0);
+    }
+
+    EXPECT_EQ(stats_.count, n);
+    EXPECT_EQ(stats_.successes, n - n / 10);
+    EXPECT_EQ(stats_.failures, n / 10);
+    EXPECT_EQ(stats_.min, 1u);
+    EXPECT_EQ(stats_.max, n);
+    EXPECT_EQ(stats_.total, n * (n + 1) / 2);
+    EXPECT_DOUBLE_EQ(stats_.mean, (n + 1) / 2.0);
+
+    // Population stddev of 1..n is sqrt((n^2 - 1) / 12)
+    EXPECT_NEAR(perf_stream_stddev(&stats_), std::sqrt((n * n - 1) / 12.0), 1e-6 * n);
+
+    for (double p : {1.0, 25.0, 50.0, 90.0, 99.0, 99.9}) {
+        expectPercentileNear(&stats_, p, p / 100.0 * n);
+    }
+    EXPECT_LE(perf_stream_percentile(&stats_, 100.0), n);
+    expectPercentileNear(&stats_, 100.0, n);
+}
+
+TEST_F(PerfStreamTest, SmallValuesAndPointMassesAreExact) {
+    // Values below 64 have a bucket each
+    for (uint64_t v = 0; v < 64; v++) {
+        perf_stream_add(&stats_, v, 1);
+    }
+    EXPECT_EQ(perf_stream_percentile(&stats_, 50.0), 31u);
+    EXPECT_EQ(perf_stream_percentile(&stats_, 100.0), 63u);
+
+    // A constant stream reports that value everywhere, with no spread
+    perf_stream_reset(&stats_);
+    for (int i = 0; i < 1000; i++) {
+        perf_stream_add(&stats_, 5000, 1);
+    }
+    EXPECT_EQ(perf_stream_stddev(&stats_), 0.0);
+    for (double p : {0.0, 50.0, 100.0}) {
+        EXPECT_EQ(perf_stream_percentile(&stats_, p), 5000u);
+    }
+
+    // Bimodal: 90% at 100, 10% at 10000
+    perf_stream_reset(&stats_);
+    for (int i = 0; i < 1000; i++) {
+        perf_stream_add(&stats_, i % 10 ? 100 : 10000, 1);
+    }
+    expectPercentileNear(&stats_, 50.0, 100);
+    expectPercentileNear(&stats_, 90.0, 100);
+    EXPECT_EQ(perf_stream_percentile(&stats_, 95.0), 10000u);
+
+    // An empty stream reports zeros
+    perf_stream_reset(&stats_);
+    EXPECT_EQ(perf_stream_percentile(&stats_, 50.0), 0u);
+    EXPECT_EQ(perf_stream_stddev(&stats_), 0.0);
+}
+
+TEST_F(PerfStreamTest, MergeMatchesSingleStream) {
+    struct perf_stream_stats low, high, merged;
+
+    perf_stream_reset(&low);
+    perf_stream_reset(&high);
+    perf_stream_reset(&merged);
+
+    // Two disjoint uniform ranges of different sizes
+    for (uint64_t v = 1; v <= 30000; v++) {
+        perf_stream_add(&low, v, 1);
+        perf_stream_add(&stats_, v, 1);
+    }
+    for (uint64_t v = 1000000; v < 1070000; v++) {
+        perf_stream_add(&high, v, 0);
+        perf_stream_add(&stats_, v, 0);
+    }
+
+    perf_stream_merge(&merged, &low);     // Into an empty stream
+    perf_stream_merge(&merged, &high);
+    perf_stream_merge(&merged, &low);
+    perf_stream_merge(&low, &high);
+
+    // low now holds both ranges, merged holds low twice and high once
+    EXPECT_EQ(low.count, stats_.count);
+    EXPECT_EQ(low.successes, stats_.successes);
+    EXPECT_EQ(low.failures, stats_.failures);
+    EXPECT_EQ(low.total, stats_.total);
+    EXPECT_EQ(low.min, stats_.min);
+    EXPECT_EQ(low.max, stats_.max);
+    EXPECT_NEAR(low.mean, stats_.mean, 1e-9 * stats_.mean);
+    EXPECT_NEAR(perf_stream_stddev(&low), perf_stream_stddev(&stats_),
+                1e-9 * perf_stream_stddev(&stats_));
+    EXPECT_EQ(memcmp(low.histogram, stats_.histogram, sizeof(low.histogram)), 0);
+    for (double p : {10.0, 30.0, 50.0, 99.0}) {
+        EXPECT_EQ(perf_stream_percentile(&low, p), perf_stream_percentile(&stats_, p));
+    }
+
+    EXPECT_EQ(merged.count, 2 * 30000u + 70000u);
+    EXPECT_EQ(merged.min, 1u);
+    EXPECT_EQ(merged.max, 1069999u);
+
+    // Merging an empty stream changes nothing
+    struct perf_stream_stats empty;
+    perf_stream_reset(&empty);
+    perf_stream_merge(&low, &empty);
+    EXPECT_EQ(low.count, stats_.count);
+    EXPECT_NEAR(low.mean, stats_.mean, 1e-9 * stats_.mean);
+}
+
+TEST(PerfMonitorTest, SessionStatisticsFlagOutliers) {
+    perf_monitor_init();
+
+    // 990 operations of 1 ms and 10 of 100 ms
+    for (int i = 0; i < 1000; i++) {
+        struct performance_measurement m = {};
+        m.duration_us = i % 100 ? 1000 : 100000;
+        m.success = 1;
+        perf_monitor_record_measurement(&m);
+    }
+
+    // Mean 1990 us, variance (990 * 990^2 + 10 * 98010^2) / 1000
+    double stddev = std::sqrt((990.0 * 990 * 990 + 10.0 * 98010 * 98010) / 1000);
+    EXPECT_NEAR(perf_monitor_calculate_stddev(), stddev, 1e-6 * stddev);
+    EXPECT_EQ(perf_monitor_calculate_percentile(50.0), 1000u);
+    EXPECT_NEAR(static_cast<double>(perf_monitor_calculate_percentile(100.0)), 100000, 3000);
+    EXPECT_EQ(perf_monitor_detect_anomalies(3.0), 10);
+    EXPECT_EQ(perf_monitor_detect_anomalies(20.0), 0);
+
+    struct performance_stats stats = perf_monitor_get_stats();
+    EXPECT_EQ(stats.total_operations, 1000u);
+    EXPECT_EQ(stats.min_duration_us, 1000u);
+    EXPECT_EQ(stats.max_duration_us, 100000u);
+
+    perf_monitor_cleanup();
+}
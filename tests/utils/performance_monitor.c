@@ -8,6 +8,7 @@
  * Copyright (C) 2025 Murray Kopit <murr2k@gmail.com>
  */
 
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -20,11 +21,16 @@
 
 #include "performance_monitor.h"
 
-/* Global performance monitoring state */
+/*
+ * Global performance monitoring state. The measurement array only keeps
+ * recent history for printing; statistics come from the streams, which
+ * cover the whole session in fixed memory.
+ */
 static struct {
     int monitoring_enabled;
     struct timeval session_start;
-    struct performance_stats cumulative_stats;
+    struct perf_stream_stats durations;                       /* us */
+    struct perf_stream_stats operations[BENCHMARK_OP_COUNT];  /* ns */
     struct performance_measurement measurements[MAX_MEASUREMENTS];
     int measurement_count;
     int current_measurement_index;
@@ -64,6 +70,174 @@ static uint64_t get_time_us(void)
     return (uint64_t)tv.tv_sec * 1000000ULL + (uint64_t)tv.tv_usec;
 }
 
+/* Get monotonic time in nanoseconds */
+static uint64_t get_time_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* Map a value to its histogram bucket */
+static int perf_hist_index(uint64_t value)
+{
+    if (value < 2 * PERF_HIST_SUB_BUCKETS) {
+        return (int)value;
+    }
+    
+    int exponent = 63 - __builtin_clzll(value);
+    if (exponent >= PERF_HIST_MAX_EXPONENT) {
+        return PERF_HIST_BUCKETS - 1;
+    }
+    
+    int shift = exponent - PERF_HIST_SUB_BITS;
+    return (shift + 1) * PERF_HIST_SUB_BUCKETS + (int)(value >> shift) - PERF_HIST_SUB_BUCKETS;
+}
+
+/* Lowest value that lands in a histogram bucket */
+static uint64_t perf_hist_lower(int index)
+{
+    if (index < 2 * PERF_HIST_SUB_BUCKETS) {
+        return (uint64_t)index;
+    }
+    
+    int shift = index / PERF_HIST_SUB_BUCKETS - 1;
+    return (uint64_t)(index % PERF_HIST_SUB_BUCKETS + PERF_HIST_SUB_BUCKETS) << shift;
+}
+
+/* Width of a histogram bucket */
+static uint64_t perf_hist_width(int index)
+{
+    if (index < 2 * PERF_HIST_SUB_BUCKETS) {
+        return 1;
+    }
+    return 1ULL << (index / PERF_HIST_SUB_BUCKETS - 1);
+}
+
+/* Reset a stream to empty */
+void perf_stream_reset(struct perf_stream_stats *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+}
+
+/* Add one value to a stream */
+void perf_stream_add(struct perf_stream_stats *stats, uint64_t value, int success)
+{
+    if (stats->count == 0 || value < stats->min) {
+        stats->min = value;
+    }
+    if (value > stats->max) {
+        stats->max = value;
+    }
+    
+    stats->count++;
+    stats->total += value;
+    if (success) {
+        stats->successes++;
+    } else {
+        stats->failures++;
+    }
+    
+    /* Welford's update */
+    double delta = (double)value - stats->mean;
+    stats->mean += delta / stats->count;
+    stats->m2 += delta * ((double)value - stats->mean);
+    
+    stats->histogram[perf_hist_index(value)]++;
+}
+
+/* Fold src into dst (Chan et al. for the moments) */
+void perf_stream_merge(struct perf_stream_stats *dst, const struct perf_stream_stats *src)
+{
+    if (src->count == 0) {
+        return;
+    }
+    if (dst->count == 0) {
+        *dst = *src;
+        return;
+    }
+    
+    uint64_t count = dst->count + src->count;
+    double delta = src->mean - dst->mean;
+    
+    dst->m2 += src->m2 + delta * delta * ((double)dst->count * src->count / count);
+    dst->mean += delta * src->count / count;
+    dst->count = count;
+    dst->successes += src->successes;
+    dst->failures += src->failures;
+    dst->total += src->total;
+    if (src->min < dst->min) {
+        dst->min = src->min;
+    }
+    if (src->max > dst->max) {
+        dst->max = src->max;
+    }
+    
+    for (int i = 0; i < PERF_HIST_BUCKETS; i++) {
+        dst->histogram[i] += src->histogram[i];
+    }
+}
+
+/* Population standard deviation of a stream */
+double perf_stream_stddev(const struct perf_stream_stats *stats)
+{
+    if (stats->count == 0) {
+        return 0.0;
+    }
+    return sqrt(stats->m2 / stats->count);
+}
+
+/* Value at a percentile (0-100), accurate to the bucket width */
+uint64_t perf_stream_percentile(const struct perf_stream_stats *stats, double percentile)
+{
+    if (stats->count == 0) {
+        return 0;
+    }
+    
+    uint64_t rank = (uint64_t)ceil(percentile / 100.0 * stats->count);
+    if (rank < 1) {
+        rank = 1;
+    }
+    
+    uint64_t seen = 0;
+    for (int i = 0; i < PERF_HIST_BUCKETS; i++) {
+        seen += stats->histogram[i];
+        if (seen >= rank) {
+            uint64_t value = perf_hist_lower(i) + perf_hist_width(i) / 2;
+            if (value < stats->min) {
+                value = stats->min;
+            }
+            if (value > stats->max) {
+                value = stats->max;
+            }
+            return value;
+        }
+    }
+    
+    return stats->max;
+}
+
+/* Write non-empty buckets as "label,lower,upper,count" CSV lines */
+int perf_stream_export_histogram(const struct perf_stream_stats *stats,
+                                 const char *label, FILE *out)
+{
+    for (int i = 0; i < PERF_HIST_BUCKETS; i++) {
+        if (stats->histogram[i] == 0) {
+            continue;
+        }
+        
+        uint64_t lower = perf_hist_lower(i);
+        if (fprintf(out, "%s,%llu,%llu,%llu\n", label,
+                    (unsigned long long)lower,
+                    (unsigned long long)(lower + perf_hist_width(i) - 1),
+                    (unsigned long long)stats->histogram[i]) < 0) {
+            return -EIO;
+        }
+    }
+    
+    return 0;
+}
+
 /* Start a performance measurement */
 struct performance_timer perf_timer_start(const char *operation_name)
 {
@@ -129,34 +303,51 @@ void perf_monitor_record_measurement(const struct performance_measurement *measu
     }
     
     /* Update cumulative statistics */
-    perf_state.cumulative_stats.total_operations++;
-    perf_state.cumulative_stats.total_time_us += measurement->duration_us;
-    
-    if (measurement->success) {
-        perf_state.cumulative_stats.successful_operations++;
-    } else {
-        perf_state.cumulative_stats.failed_operations++;
+    perf_stream_add(&perf_state.durations, measurement->duration_us, measurement->success);
+}
+
+/* Record one operation's latency in its per-operation slot */
+void perf_monitor_record_operation(enum benchmark_operation operation,
+                                   uint64_t latency_ns, int success)
+{
+    if (!perf_state.monitoring_enabled ||
+        operation < 0 || operation >= BENCHMARK_OP_COUNT) {
+        return;
     }
     
-    /* Update min/max durations */
-    if (perf_state.cumulative_stats.min_duration_us == 0 || 
-        measurement->duration_us < perf_state.cumulative_stats.min_duration_us) {
-        perf_state.cumulative_stats.min_duration_us = measurement->duration_us;
+    perf_stream_add(&perf_state.operations[operation], latency_ns, success);
+}
+
+/* Get the session statistics of one operation type */
+const struct perf_stream_stats *perf_monitor_get_operation_stats(enum benchmark_operation operation)
+{
+    if (operation < 0 || operation >= BENCHMARK_OP_COUNT) {
+        return NULL;
     }
     
-    if (measurement->duration_us > perf_state.cumulative_stats.max_duration_us) {
-        perf_state.cumulative_stats.max_duration_us = measurement->duration_us;
-    }
+    return &perf_state.operations[operation];
 }
 
 /* Get current performance statistics */
 struct performance_stats perf_monitor_get_stats(void)
 {
-    struct performance_stats stats = perf_state.cumulative_stats;
+    const struct perf_stream_stats *durations = &perf_state.durations;
+    struct performance_stats stats = {0};
+    
+    stats.total_operations = durations->count;
+    stats.successful_operations = durations->successes;
+    stats.failed_operations = durations->failures;
+    stats.total_time_us = durations->total;
+    stats.min_duration_us = durations->min;
+    stats.max_duration_us = durations->max;
     
     /* Calculate derived statistics */
     if (stats.total_operations > 0) {
         stats.average_duration_us = stats.total_time_us / stats.total_operations;
+        stats.p50_duration_us = perf_stream_percentile(durations, 50.0);
+        stats.p95_duration_us = perf_stream_percentile(durations, 95.0);
+        stats.p99_duration_us = perf_stream_percentile(durations, 99.0);
+        stats.stddev_duration_us = perf_stream_stddev(durations);
         stats.success_rate = (double)stats.successful_operations / stats.total_operations;
     }
     
@@ -177,7 +368,10 @@ struct performance_stats perf_monitor_get_stats(void)
 /* Reset performance statistics */
 void perf_monitor_reset_stats(void)
 {
-    memset(&perf_state.cumulative_stats, 0, sizeof(perf_state.cumulative_stats));
+    perf_stream_reset(&perf_state.durations);
+    for (int i = 0; i < BENCHMARK_OP_COUNT; i++) {
+        perf_stream_reset(&perf_state.operations[i]);
+    }
     perf_state.measurement_count = 0;
     perf_state.current_measurement_index = 0;
     gettimeofday(&perf_state.session_start, NULL);
@@ -200,6 +394,9 @@ void perf_monitor_print_stats(void)
     printf("  Average Duration: %.3f ms\n", stats.average_duration_us / 1000.0);
     printf("  Min Duration: %.3f ms\n", stats.min_duration_us / 1000.0);
     printf("  Max Duration: %.3f ms\n", stats.max_duration_us / 1000.0);
+    printf("  Std Deviation: %.3f ms\n", stats.stddev_duration_us / 1000.0);
+    printf("  P50/P95/P99: %.3f / %.3f / %.3f ms\n", stats.p50_duration_us / 1000.0,
+           stats.p95_duration_us / 1000.0, stats.p99_duration_us / 1000.0);
     printf("==============================\n\n");
 }
 
@@ -231,7 +428,7 @@ void perf_monitor_print_history(int max_entries)
                m->operation_name, 
                duration_ms,
                m->success ? "Yes" : "No",
-               timestamp_ms);
+               (unsigned long long)timestamp_ms);
     }
     
     printf("======================================\n\n");
@@ -259,6 +456,7 @@ struct io_benchmark_result perf_monitor_benchmark_io(const char *device_path,
     
     for (int i = 0; i < num_iterations; i++) {
         int success = 0;
+        uint64_t op_start = get_time_ns();
         
         switch (operation) {
         case BENCHMARK_READ: {
@@ -285,8 +483,15 @@ struct io_benchmark_result perf_monitor_benchmark_io(const char *device_path,
             success = (ioctl_result >= 0);
             break;
         }
+        default:
+            errno = EINVAL;
+            break;
         }
         
+        uint64_t latency_ns = get_time_ns() - op_start;
+        perf_stream_add(&result.latency_ns, latency_ns, success);
+        perf_monitor_record_operation(operation, latency_ns, success);
+        
         if (success) {
             result.successful_operations++;
         } else {
@@ -336,6 +541,18 @@ void perf_monitor_print_io_benchmark(const struct io_benchmark_result *result)
     printf("Average Duration: %.3f ms\n", result->average_duration_us / 1000.0);
     printf("Operations per Second: %.2f\n", result->operations_per_second);
     
+    if (result->latency_ns.count > 0) {
+        const struct perf_stream_stats *latency = &result->latency_ns;
+        printf("Latency (us): min %.3f, mean %.3f, stddev %.3f, max %.3f\n",
+               latency->min / 1000.0, latency->mean / 1000.0,
+               perf_stream_stddev(latency) / 1000.0, latency->max / 1000.0);
+        printf("Latency (us): p50 %.3f, p95 %.3f, p99 %.3f, p99.9 %.3f\n",
+               perf_stream_percentile(latency, 50.0) / 1000.0,
+               perf_stream_percentile(latency, 95.0) / 1000.0,
+               perf_stream_percentile(latency, 99.0) / 1000.0,
+               perf_stream_percentile(latency, 99.9) / 1000.0);
+    }
+    
     if (result->bytes_transferred > 0) {
         printf("Bytes Transferred: %lu\n", result->bytes_transferred);
         printf("Bytes per Second: %.2f\n", result->bytes_per_second);
@@ -415,6 +632,8 @@ void perf_monitor_generate_report(const char *filename)
     fprintf(report_file, "  Average Latency: %.3f ms\n", stats.average_duration_us / 1000.0);
     fprintf(report_file, "  Min Latency: %.3f ms\n", stats.min_duration_us / 1000.0);
     fprintf(report_file, "  Max Latency: %.3f ms\n", stats.max_duration_us / 1000.0);
+    fprintf(report_file, "  P95 Latency: %.3f ms\n", stats.p95_duration_us / 1000.0);
+    fprintf(report_file, "  P99 Latency: %.3f ms\n", stats.p99_duration_us / 1000.0);
     
     fprintf(report_file, "\nMemory Usage:\n");
     fprintf(report_file, "  Current RSS: %.2f MB\n", memory.rss_kb / 1024.0);
@@ -424,4 +643,61 @@ void perf_monitor_generate_report(const char *filename)
         fclose(report_file);
         printf("Performance report written to: %s\n", filename);
     }
-}
\ No newline at end of file
+}
+
+/* Export session histograms as CSV for cross-run comparison */
+int perf_monitor_export_histograms(const char *filename)
+{
+    static const char *const operation_labels[BENCHMARK_OP_COUNT] = {
+        "read_ns", "write_ns", "ioctl_ns"
+    };
+    
+    FILE *out = fopen(filename, "w");
+    if (!out) {
+        return -errno;
+    }
+    
+    fprintf(out, "stream,lower,upper,count\n");
+    int ret = perf_stream_export_histogram(&perf_state.durations, "measurement_us", out);
+    for (int i = 0; i < BENCHMARK_OP_COUNT && ret == 0; i++) {
+        ret = perf_stream_export_histogram(&perf_state.operations[i], operation_labels[i], out);
+    }
+    
+    if (fclose(out) != 0 && ret == 0) {
+        ret = -errno;
+    }
+    return ret;
+}
+
+/* Standard deviation of all measurement durations this session */
+double perf_monitor_calculate_stddev(void)
+{
+    return perf_stream_stddev(&perf_state.durations);
+}
+
+/* Percentile (0-100) of all measurement durations this session */
+uint64_t perf_monitor_calculate_percentile(double percentile)
+{
+    return perf_stream_percentile(&perf_state.durations, percentile);
+}
+
+/* Count measurements more than threshold_factor standard deviations from the mean */
+int perf_monitor_detect_anomalies(double threshold_factor)
+{
+    const struct perf_stream_stats *durations = &perf_state.durations;
+    double limit = threshold_factor * perf_stream_stddev(durations);
+    uint64_t anomalies = 0;
+    
+    for (int i = 0; i < PERF_HIST_BUCKETS; i++) {
+        if (durations->histogram[i] == 0) {
+            continue;
+        }
+        
+        double value = perf_hist_lower(i) + perf_hist_width(i) / 2.0;
+        if (fabs(value - durations->mean) > limit) {
+            anomalies += durations->histogram[i];
+        }
+    }
+    
+    return anomalies > INT32_MAX ? INT32_MAX : (int)anomalies;
+}
@@ -12,6 +12,7 @@
 #define PERFORMANCE_MONITOR_H
 
 #include <stdint.h>
+#include <stdio.h>
 #include <sys/time.h>
 
 #ifdef __cplusplus
@@ -21,6 +22,18 @@ extern "C" {
 #define MAX_MEASUREMENTS 1000
 #define MAX_OPERATION_NAME 64
 
+/*
+ * Streaming histogram layout: values below 2 * PERF_HIST_SUB_BUCKETS get a
+ * bucket each, above that every power of two is split into
+ * PERF_HIST_SUB_BUCKETS linear buckets (about 3% relative error). Values of
+ * 2^PERF_HIST_MAX_EXPONENT and up share the last bucket.
+ */
+#define PERF_HIST_SUB_BITS 5
+#define PERF_HIST_SUB_BUCKETS (1 << PERF_HIST_SUB_BITS)
+#define PERF_HIST_MAX_EXPONENT 40
+#define PERF_HIST_BUCKETS \
+    ((PERF_HIST_MAX_EXPONENT - PERF_HIST_SUB_BITS + 1) * PERF_HIST_SUB_BUCKETS)
+
 /* Performance timer structure */
 struct performance_timer {
     char operation_name[MAX_OPERATION_NAME];
@@ -47,7 +60,11 @@ struct performance_stats {
     uint64_t min_duration_us;
     uint64_t max_duration_us;
     uint64_t average_duration_us;
+    uint64_t p50_duration_us;
+    uint64_t p95_duration_us;
+    uint64_t p99_duration_us;
     uint64_t session_duration_us;
+    double stddev_duration_us;
     double success_rate;
     double operations_per_second;
 };
@@ -60,11 +77,30 @@ struct memory_usage {
     unsigned long peak_vsize_kb; /* Peak Virtual Memory */
 };
 
+/*
+ * Constant-memory statistics over an unbounded stream of values: Welford
+ * mean/variance, min/max and a log-bucketed histogram for quantiles. The
+ * unit is the caller's; an all-zero struct is an empty stream, and two
+ * streams merge exactly, so runs can be combined or compared afterwards.
+ */
+struct perf_stream_stats {
+    uint64_t count;
+    uint64_t successes;
+    uint64_t failures;
+    uint64_t total;
+    uint64_t min;
+    uint64_t max;
+    double mean;
+    double m2;                              /* Sum of squared deviations */
+    uint64_t histogram[PERF_HIST_BUCKETS];
+};
+
 /* Benchmark operation types */
 enum benchmark_operation {
     BENCHMARK_READ = 0,
     BENCHMARK_WRITE = 1,
-    BENCHMARK_IOCTL = 2
+    BENCHMARK_IOCTL = 2,
+    BENCHMARK_OP_COUNT
 };
 
 /* I/O benchmark result */
@@ -82,6 +118,7 @@ struct io_benchmark_result {
     double bytes_per_second;
     int error_code;
     char error_message[256];
+    struct perf_stream_stats latency_ns;    /* Per-iteration latency */
 };
 
 /* Core monitoring functions */
@@ -110,6 +147,21 @@ struct io_benchmark_result perf_monitor_benchmark_io(const char *device_path,
                                                    enum benchmark_operation operation);
 void perf_monitor_print_io_benchmark(const struct io_benchmark_result *result);
 
+/* Per-operation statistics (nanoseconds), independent of the history buffer */
+void perf_monitor_record_operation(enum benchmark_operation operation,
+                                   uint64_t latency_ns, int success);
+const struct perf_stream_stats *perf_monitor_get_operation_stats(enum benchmark_operation operation);
+int perf_monitor_export_histograms(const char *filename);
+
+/* Streaming statistics */
+void perf_stream_reset(struct perf_stream_stats *stats);
+void perf_stream_add(struct perf_stream_stats *stats, uint64_t value, int success);
+void perf_stream_merge(struct perf_stream_stats *dst, const struct perf_stream_stats *src);
+double perf_stream_stddev(const struct perf_stream_stats *stats);
+uint64_t perf_stream_percentile(const struct perf_stream_stats *stats, double percentile);
+int perf_stream_export_histogram(const struct perf_stream_stats *stats,
+                                 const char *label, FILE *out);
+
 /* Memory monitoring */
 struct memory_usage perf_monitor_get_memory_usage(void);
 void perf_monitor_print_memory_usage(void);
@@ -199,12 +251,13 @@ void perf_monitor_print_memory_usage(void);
 double perf_monitor_calculate_stddev(void);
 
 /**
- * Calculate percentile of measurement durations
+ * Calculate percentile (0-100) of measurement durations
  */
 uint64_t perf_monitor_calculate_percentile(double percentile);
 
 /**
- * Detect performance anomalies (measurements outside normal range)
+ * Detect performance anomalies (measurements more than threshold_factor
+ * standard deviations from the mean)
  */
 int perf_monitor_detect_anomalies(double threshold_factor);
 